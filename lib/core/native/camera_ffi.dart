@@ -22,6 +22,671 @@ typedef CameraGetFrameDart = int Function(Pointer<Pointer<Uint8>>, Pointer<Uint6
 typedef CameraFreeBufferNative = Void Function(Pointer<Uint8>);
 typedef CameraFreeBufferDart = void Function(Pointer<Uint8>);
 
+typedef CameraRegisterConsumerNative = Int32 Function();
+typedef CameraRegisterConsumerDart = int Function();
+
+typedef CameraUnregisterConsumerNative = Int32 Function(Int32);
+typedef CameraUnregisterConsumerDart = int Function(int);
+
+typedef CameraGetFrameForNative = Int32 Function(Int32, Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<Uint64>);
+typedef CameraGetFrameForDart = int Function(int, Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<Uint64>);
+
+typedef CameraGetFrameExNative = Int32 Function(Int32, Uint64, Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<CameraFrameDesc>);
+typedef CameraGetFrameExDart = int Function(int, int, Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<CameraFrameDesc>);
+
+/// Mirrors CameraFrameDesc in camera_ffi.h (version 1)
+final class CameraFrameDesc extends Struct {
+  @Uint32()
+  external int structSize;
+
+  @Uint32()
+  external int version;
+
+  @Uint64()
+  external int sequence;
+
+  @Uint64()
+  external int capturedUs;
+
+  @Uint64()
+  external int downloadUs;
+
+  @Uint64()
+  external int framesMissed;
+
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+
+  @Uint32()
+  external int flags;
+
+  @Uint32()
+  external int reserved;
+}
+
+/// Metadata delivered with every live view frame
+class FrameInfo {
+  static const int flagDuplicate = 0x1;
+  static const int flagWake = 0x2;
+  static const int flagReplay = 0x4;
+
+  final int sequence;
+  final int capturedUs;
+  final int downloadUs;
+  final int framesMissed;
+  final int width;
+  final int height;
+  final int flags;
+
+  const FrameInfo({
+    required this.sequence,
+    required this.capturedUs,
+    required this.downloadUs,
+    required this.framesMissed,
+    required this.width,
+    required this.height,
+    required this.flags,
+  });
+
+  FrameInfo.fromDesc(CameraFrameDesc desc)
+      : sequence = desc.sequence,
+        capturedUs = desc.capturedUs,
+        downloadUs = desc.downloadUs,
+        framesMissed = desc.framesMissed,
+        width = desc.width,
+        height = desc.height,
+        flags = desc.flags;
+
+  bool get isDuplicate => (flags & flagDuplicate) != 0;
+}
+
+typedef CameraGetFrameIntoNative = Int32 Function(Int32, Uint64, Pointer<Uint8>, Uint64, Pointer<Uint64>, Pointer<CameraFrameDesc>);
+typedef CameraGetFrameIntoDart = int Function(int, int, Pointer<Uint8>, int, Pointer<Uint64>, Pointer<CameraFrameDesc>);
+
+/// Session-long native buffer for [CameraFFI.getFrameInto]. Holds the frame
+/// bytes, the length and the descriptor, so fetching a frame allocates
+/// nothing on either side of the FFI boundary.
+class NativeFrameBuffer {
+  Pointer<Uint8> _data;
+  int _capacity;
+  Uint8List _storage;
+  final Pointer<Uint64> _length = calloc<Uint64>();
+  final Pointer<CameraFrameDesc> _desc = calloc<CameraFrameDesc>();
+
+  NativeFrameBuffer([int capacity = 512 * 1024])
+      : _capacity = capacity,
+        _data = malloc<Uint8>(capacity),
+        _storage = Uint8List(0) {
+    _storage = _data.asTypedList(capacity);
+    _desc.ref.structSize = sizeOf<CameraFrameDesc>();
+  }
+
+  /// Bytes of the last fetched frame live in storage[0, length).
+  /// Only valid until the next fetch into this buffer.
+  Uint8List get storage => _storage;
+  int get length => _length.value;
+  int get capacity => _capacity;
+
+  /// Descriptor of the last fetched frame
+  CameraFrameDesc get desc => _desc.ref;
+
+  void _grow(int required) {
+    malloc.free(_data);
+    // Leave headroom so a slowly growing frame size does not regrow each time
+    _capacity = required + required ~/ 4;
+    _data = malloc<Uint8>(_capacity);
+    _storage = _data.asTypedList(_capacity);
+  }
+
+  void dispose() {
+    malloc.free(_data);
+    calloc.free(_length);
+    calloc.free(_desc);
+  }
+}
+
+typedef CameraAckFrameNative = Int32 Function(Int32, Uint64);
+typedef CameraAckFrameDart = int Function(int, int);
+
+typedef CameraSetFrameIntervalNative = Int32 Function(Int32, Int32);
+typedef CameraSetFrameIntervalDart = int Function(int, int);
+
+typedef CameraSetCpuBudgetNative = Int32 Function(Int32);
+typedef CameraSetCpuBudgetDart = int Function(int);
+
+typedef CameraSetIdleModeNative = Int32 Function(Int32, Int32, Int32);
+typedef CameraSetIdleModeDart = int Function(int, int, int);
+
+typedef CameraWakeNative = Int32 Function();
+typedef CameraWakeDart = int Function();
+
+typedef CameraSetPrerollNative = Int32 Function(Int32, Int32);
+typedef CameraSetPrerollDart = int Function(int, int);
+
+typedef CameraStartBoomerangNative = Int32 Function(Pointer<Utf16>, Int32, Int32, Int32);
+typedef CameraStartBoomerangDart = int Function(Pointer<Utf16>, int, int, int);
+
+typedef CameraGetBoomerangStatusNative = Int32 Function(Pointer<Uint64>);
+typedef CameraGetBoomerangStatusDart = int Function(Pointer<Uint64>);
+
+typedef CameraStartRecordingNative = Int32 Function(Pointer<Utf16>, Int32);
+typedef CameraStartRecordingDart = int Function(Pointer<Utf16>, int);
+
+typedef CameraStopRecordingNative = Int32 Function();
+typedef CameraStopRecordingDart = int Function();
+
+typedef CameraGetRecordingStatsNative = Int32 Function(Pointer<CameraRecordingStats>);
+typedef CameraGetRecordingStatsDart = int Function(Pointer<CameraRecordingStats>);
+
+/// Mirrors CameraRecordingStats in camera_ffi.h
+final class CameraRecordingStats extends Struct {
+  @Uint64()
+  external int framesWritten;
+
+  @Uint64()
+  external int framesRepeated;
+
+  @Uint64()
+  external int framesDropped;
+
+  @Uint64()
+  external int bytesWritten;
+
+  @Int32()
+  external int recording;
+}
+
+typedef CameraInitializeReplayNative = Int32 Function(Pointer<Utf16>, Int32);
+typedef CameraInitializeReplayDart = int Function(Pointer<Utf16>, int);
+
+typedef CameraSetMotionSensitivityNative = Int32 Function(Int32, Int32);
+typedef CameraSetMotionSensitivityDart = int Function(int, int);
+
+typedef CameraGetIdleStatsNative = Int32 Function(Pointer<CameraIdleStats>);
+typedef CameraGetIdleStatsDart = int Function(Pointer<CameraIdleStats>);
+
+/// Mirrors CameraIdleStats in camera_ffi.h
+final class CameraIdleStats extends Struct {
+  @Uint64()
+  external int framesCaptured;
+
+  @Uint64()
+  external int framesPublished;
+
+  @Uint64()
+  external int framesSkipped;
+
+  @Uint64()
+  external int wakeCount;
+
+  @Uint64()
+  external int idleMsTotal;
+
+  @Uint64()
+  external int lastWakeLatencyUs;
+
+  @Int32()
+  external int idle;
+}
+
+typedef CameraEnableSharedFramesNative = Int32 Function(Pointer<Utf8>, Int32, Int32);
+typedef CameraEnableSharedFramesDart = int Function(Pointer<Utf8>, int, int);
+
+typedef CameraDisableSharedFramesNative = Int32 Function();
+typedef CameraDisableSharedFramesDart = int Function();
+
+typedef CameraSetStillSpoolNative = Int32 Function(Pointer<Utf16>);
+typedef CameraSetStillSpoolDart = int Function(Pointer<Utf16>);
+
+typedef CameraTakePictureNative = Int64 Function();
+typedef CameraTakePictureDart = int Function();
+
+typedef CameraGetStillNative = Int32 Function(Pointer<CameraStillInfo>, Pointer<Pointer<Uint8>>, Pointer<Uint64>);
+typedef CameraGetStillDart = int Function(Pointer<CameraStillInfo>, Pointer<Pointer<Uint8>>, Pointer<Uint64>);
+
+typedef CameraStartCountdownCaptureNative = Int32 Function(Int32, Int32);
+typedef CameraStartCountdownCaptureDart = int Function(int, int);
+
+typedef CameraCancelCountdownNative = Int32 Function();
+typedef CameraCancelCountdownDart = int Function();
+
+typedef CameraGetCountdownStatusNative = Int32 Function(Pointer<CameraCountdownReport>);
+typedef CameraGetCountdownStatusDart = int Function(Pointer<CameraCountdownReport>);
+
+typedef CameraStartBurstNative = Int32 Function(Int32, Int32, Int32, Int32);
+typedef CameraStartBurstDart = int Function(int, int, int, int);
+
+typedef CameraCancelBurstNative = Int32 Function();
+typedef CameraCancelBurstDart = int Function();
+
+typedef CameraGetBurstStatusNative = Int32 Function(Pointer<CameraBurstStatus>);
+typedef CameraGetBurstStatusDart = int Function(Pointer<CameraBurstStatus>);
+
+typedef CameraSetWorkerThreadsNative = Int32 Function(Int32);
+typedef CameraSetWorkerThreadsDart = int Function(int);
+
+typedef CameraRegisterFanoutConsumerNative = Int32 Function(Int32, Int32, Int32, Int32, Int32);
+typedef CameraRegisterFanoutConsumerDart = int Function(int, int, int, int, int);
+
+typedef CameraUnregisterFanoutConsumerNative = Int32 Function(Int32);
+typedef CameraUnregisterFanoutConsumerDart = int Function(int);
+
+typedef CameraGetFanoutFrameNative = Int32 Function(Int32, Uint64, Pointer<Uint8>, Uint64, Pointer<Uint64>, Pointer<CameraFanoutFrame>);
+typedef CameraGetFanoutFrameDart = int Function(int, int, Pointer<Uint8>, int, Pointer<Uint64>, Pointer<CameraFanoutFrame>);
+
+typedef CameraGetFanoutStatsNative = Int32 Function(Pointer<CameraFanoutStats>);
+typedef CameraGetFanoutStatsDart = int Function(Pointer<CameraFanoutStats>);
+
+/// Fan-out consumer formats (CAMERA_FANOUT_* in camera_ffi.h)
+class FanoutFormat {
+  static const int jpeg = 0;
+  static const int bgra = 1;
+  static const int gray = 2;
+}
+
+/// Fan-out orientation (CAMERA_ROTATE_* / CAMERA_MIRROR in camera_ffi.h).
+/// Clockwise rotation, optionally combined with [mirror]: rotate90 | mirror
+class FanoutTransform {
+  static const int rotate0 = 0;
+  static const int rotate90 = 1;
+  static const int rotate180 = 2;
+  static const int rotate270 = 3;
+  static const int mirror = 4;
+}
+
+/// Mirrors CameraFanoutFrame in camera_ffi.h
+final class CameraFanoutFrame extends Struct {
+  @Uint64()
+  external int sequence;
+
+  @Uint64()
+  external int capturedUs;
+
+  @Int32()
+  external int format;
+
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+
+  @Int32()
+  external int stride;
+}
+
+/// Mirrors CameraFanoutStats in camera_ffi.h
+final class CameraFanoutStats extends Struct {
+  @Uint64()
+  external int framesSubmitted;
+
+  @Uint64()
+  external int framesProcessed;
+
+  @Uint64()
+  external int decodes;
+
+  @Uint64()
+  external int resizes;
+
+  @Uint64()
+  external int conversions;
+
+  @Uint64()
+  external int transforms;
+
+  @Uint64()
+  external int deliveries;
+
+  @Uint64()
+  external int grades;
+}
+
+typedef CameraGetPixelIsaNative = Int32 Function();
+typedef CameraGetPixelIsaDart = int Function();
+
+/// Pixel kernel instruction sets (CAMERA_ISA_* in camera_ffi.h)
+class PixelIsa {
+  static const int scalar = 0;
+  static const int sse41 = 1;
+  static const int avx2 = 2;
+}
+
+typedef CameraStartPrintNative = Int32 Function(Pointer<Uint8>, Uint64, Pointer<CameraPrintLayout>, Pointer<Utf16>);
+typedef CameraStartPrintDart = int Function(Pointer<Uint8>, int, Pointer<CameraPrintLayout>, Pointer<Utf16>);
+
+typedef CameraGetPrintStatusNative = Int32 Function(Pointer<CameraPrintReport>);
+typedef CameraGetPrintStatusDart = int Function(Pointer<CameraPrintReport>);
+
+/// Mirrors CameraPrintLayout in camera_ffi.h
+final class CameraPrintLayout extends Struct {
+  @Double()
+  external double widthIn;
+
+  @Double()
+  external double heightIn;
+
+  @Int32()
+  external int dpi;
+
+  @Int32()
+  external int autoRotate;
+}
+
+/// Mirrors CameraPrintReport in camera_ffi.h
+final class CameraPrintReport extends Struct {
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+
+  @Int32()
+  external int dpiX;
+
+  @Int32()
+  external int dpiY;
+
+  @Uint64()
+  external int decodeUs;
+
+  @Uint64()
+  external int resampleUs;
+
+  @Uint64()
+  external int convertUs;
+
+  @Uint64()
+  external int spoolUs;
+
+  @Uint64()
+  external int totalUs;
+
+  @Int32()
+  external int cacheHit;
+
+  @Uint64()
+  external int peakBytes;
+
+  @Int32()
+  external int colorManaged;
+
+  @Uint64()
+  external int colorUs;
+
+  @Uint64()
+  external int ditherUs;
+}
+
+/// Mirrors CameraSheetCell in camera_ffi.h
+final class CameraSheetCell extends Struct {
+  @Double()
+  external double xIn;
+
+  @Double()
+  external double yIn;
+
+  @Double()
+  external double widthIn;
+
+  @Double()
+  external double heightIn;
+
+  @Int32()
+  external int source;
+}
+
+typedef CameraStartPrintSheetNative = Int32 Function(Pointer<Pointer<Uint8>>, Pointer<Uint64>, Int32,
+    Pointer<CameraSheetCell>, Int32, Pointer<CameraPrintLayout>, Uint32, Pointer<Utf16>);
+typedef CameraStartPrintSheetDart = int Function(Pointer<Pointer<Uint8>>, Pointer<Uint64>, int,
+    Pointer<CameraSheetCell>, int, Pointer<CameraPrintLayout>, int, Pointer<Utf16>);
+
+typedef CameraSetPrintCacheNative = Int32 Function(Pointer<Utf16>, Uint64);
+typedef CameraSetPrintCacheDart = int Function(Pointer<Utf16>, int);
+
+typedef CameraGetPrintCacheStatsNative = Int32 Function(Pointer<CameraPrintCacheStats>);
+typedef CameraGetPrintCacheStatsDart = int Function(Pointer<CameraPrintCacheStats>);
+
+typedef CameraSetPrintColorManagementNative = Int32 Function(Int32, Int32, Pointer<Utf16>);
+typedef CameraSetPrintColorManagementDart = int Function(int, int, Pointer<Utf16>);
+
+typedef CameraSetColorTransformCacheNative = Int32 Function(Pointer<Utf16>);
+typedef CameraSetColorTransformCacheDart = int Function(Pointer<Utf16>);
+
+typedef CameraSetPrintDitherNative = Int32 Function(Int32, Int32);
+typedef CameraSetPrintDitherDart = int Function(int, int);
+
+/// Dithering for low-bit printers (DitherMode in print_dither.h)
+class PrintDitherMode {
+  static const int none = 0;
+  static const int floydSteinberg = 1;
+  static const int blueNoise = 2;
+}
+
+/// Mirrors CameraPrintCacheStats in camera_ffi.h
+final class CameraPrintCacheStats extends Struct {
+  @Uint64()
+  external int hits;
+
+  @Uint64()
+  external int misses;
+
+  @Uint64()
+  external int entries;
+
+  @Uint64()
+  external int bytes;
+}
+
+typedef CameraValidateImageNative = Int32 Function(Pointer<Uint8>, Uint64, Int32, Pointer<CameraImageInfo>);
+typedef CameraValidateImageDart = int Function(Pointer<Uint8>, int, int, Pointer<CameraImageInfo>);
+
+typedef CameraLoadOverlayTemplateNative = Int32 Function(Pointer<Utf16>);
+typedef CameraLoadOverlayTemplateDart = int Function(Pointer<Utf16>);
+
+typedef CameraClearOverlayTemplateNative = Int32 Function();
+typedef CameraClearOverlayTemplateDart = int Function();
+
+typedef CameraApplyOverlayBgraNative = Int32 Function(Pointer<Uint8>, Int32, Int32, Int32);
+typedef CameraApplyOverlayBgraDart = int Function(Pointer<Uint8>, int, int, int);
+
+typedef CameraSetTemplateCacheNative = Int32 Function(Pointer<Utf16>);
+typedef CameraSetTemplateCacheDart = int Function(Pointer<Utf16>);
+
+typedef CameraGetTemplateCacheStatsNative = Int32 Function(Pointer<CameraTemplateCacheStats>);
+typedef CameraGetTemplateCacheStatsDart = int Function(Pointer<CameraTemplateCacheStats>);
+
+typedef CameraLoadColorLutNative = Int32 Function(Pointer<Utf16>);
+typedef CameraLoadColorLutDart = int Function(Pointer<Utf16>);
+
+typedef CameraClearColorLutNative = Int32 Function();
+typedef CameraClearColorLutDart = int Function();
+
+typedef CameraApplyColorLutBgraNative = Int32 Function(Pointer<Uint8>, Int32, Int32, Int32);
+typedef CameraApplyColorLutBgraDart = int Function(Pointer<Uint8>, int, int, int);
+
+typedef CameraEncodeJpegBgraNative = Int32 Function(Pointer<Uint8>, Int32, Int32, Int32, Pointer<CameraJpegOptions>,
+    Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<CameraJpegReport>);
+typedef CameraEncodeJpegBgraDart = int Function(Pointer<Uint8>, int, int, int, Pointer<CameraJpegOptions>,
+    Pointer<Pointer<Uint8>>, Pointer<Uint64>, Pointer<CameraJpegReport>);
+
+/// Mirrors CameraJpegOptions in camera_ffi.h
+final class CameraJpegOptions extends Struct {
+  @Int32()
+  external int quality;
+
+  @Int32()
+  external int optimizeHuffman;
+
+  @Int32()
+  external int subsampleChroma;
+
+  @Int32()
+  external int dpi;
+
+  @Uint64()
+  external int targetBytes;
+}
+
+/// Mirrors CameraJpegReport in camera_ffi.h
+final class CameraJpegReport extends Struct {
+  @Int32()
+  external int quality;
+
+  @Int32()
+  external int segments;
+
+  @Int32()
+  external int trials;
+
+  @Int32()
+  external int targetMet;
+
+  @Uint64()
+  external int bytes;
+
+  @Uint64()
+  external int encodeUs;
+}
+
+/// Mirrors CameraTemplateCacheStats in camera_ffi.h
+final class CameraTemplateCacheStats extends Struct {
+  @Uint64()
+  external int hits;
+
+  @Uint64()
+  external int misses;
+
+  @Uint64()
+  external int entries;
+
+  @Uint64()
+  external int bytes;
+}
+
+/// Image containers (CAMERA_IMAGE_* in camera_ffi.h)
+class ImageContainer {
+  static const int unknown = 0;
+  static const int jpeg = 1;
+  static const int png = 2;
+}
+
+/// Mirrors CameraImageInfo in camera_ffi.h
+final class CameraImageInfo extends Struct {
+  @Int32()
+  external int format;
+
+  @Int32()
+  external int width;
+
+  @Int32()
+  external int height;
+}
+
+/// Mirrors CameraBurstStatus in camera_ffi.h
+final class CameraBurstStatus extends Struct {
+  @Int64()
+  external int maxFireErrorUs;
+
+  @Uint64()
+  external int elapsedUs;
+
+  @Int32()
+  external int count;
+
+  @Int32()
+  external int fired;
+
+  @Int32()
+  external int failed;
+}
+
+/// Mirrors CameraCountdownReport in camera_ffi.h
+final class CameraCountdownReport extends Struct {
+  @Uint64()
+  external int shotId;
+
+  @Uint64()
+  external int prefocusUs;
+
+  @Int64()
+  external int fireErrorUs;
+
+  @Uint64()
+  external int shutterLagUs;
+
+  @Uint64()
+  external int lagCompensationUs;
+
+  @Int64()
+  external int zeroToReleaseUs;
+
+  @Int32()
+  external int prefocused;
+
+  @Int32()
+  external int error;
+}
+
+/// Mirrors CameraStillInfo in camera_ffi.h
+final class CameraStillInfo extends Struct {
+  @Uint64()
+  external int shotId;
+
+  @Uint64()
+  external int shutterToEventUs;
+
+  @Uint64()
+  external int downloadUs;
+
+  @Uint64()
+  external int totalUs;
+
+  @Int32()
+  external int error;
+
+  @Int32()
+  external int burstIndex;
+
+  @Array(256)
+  external Array<Uint8> fileName;
+
+  @Array(260)
+  external Array<Uint16> path;
+}
+
+/// A still transferred from the camera
+class StillShot {
+  final int shotId;
+  final int error;
+  final int burstIndex;
+  final String fileName;
+  final Uint8List? data;
+
+  /// Spool file when stills are transferred to disk (data is null then)
+  final String? path;
+  final Duration shutterToEvent;
+  final Duration download;
+  final Duration total;
+
+  const StillShot({
+    required this.shotId,
+    required this.error,
+    required this.burstIndex,
+    required this.fileName,
+    required this.data,
+    this.path,
+    required this.shutterToEvent,
+    required this.download,
+    required this.total,
+  });
+
+  bool get isOk => error == 0 && (data != null || path != null);
+}
+
 class CameraFFI {
   late final DynamicLibrary _lib;
   late final CameraInitializeDart _initialize;
@@ -30,6 +695,62 @@ class CameraFFI {
   late final CameraStopLiveviewDart _stopLiveview;
   late final CameraGetFrameDart _getFrame;
   late final CameraFreeBufferDart _freeBuffer;
+  late final CameraRegisterConsumerDart _registerConsumer;
+  late final CameraUnregisterConsumerDart _unregisterConsumer;
+  late final CameraGetFrameForDart _getFrameFor;
+  late final CameraGetFrameExDart _getFrameEx;
+  late final CameraGetFrameIntoDart _getFrameInto;
+  late final CameraAckFrameDart _ackFrame;
+  late final CameraSetFrameIntervalDart _setFrameInterval;
+  late final CameraSetCpuBudgetDart _setCpuBudget;
+  late final CameraSetIdleModeDart _setIdleMode;
+  late final CameraWakeDart _wake;
+  late final CameraInitializeReplayDart _initializeReplay;
+  late final CameraSetMotionSensitivityDart _setMotionSensitivity;
+  late final CameraGetIdleStatsDart _getIdleStats;
+  late final CameraSetPrerollDart _setPreroll;
+  late final CameraStartBoomerangDart _startBoomerang;
+  late final CameraGetBoomerangStatusDart _getBoomerangStatus;
+  late final CameraStartRecordingDart _startRecording;
+  late final CameraStopRecordingDart _stopRecording;
+  late final CameraGetRecordingStatsDart _getRecordingStats;
+  late final CameraEnableSharedFramesDart _enableSharedFrames;
+  late final CameraDisableSharedFramesDart _disableSharedFrames;
+  late final CameraSetStillSpoolDart _setStillSpool;
+  late final CameraTakePictureDart _takePicture;
+  late final CameraGetStillDart _getStill;
+  late final CameraStartCountdownCaptureDart _startCountdownCapture;
+  late final CameraCancelCountdownDart _cancelCountdown;
+  late final CameraGetCountdownStatusDart _getCountdownStatus;
+  late final CameraStartBurstDart _startBurst;
+  late final CameraCancelBurstDart _cancelBurst;
+  late final CameraGetBurstStatusDart _getBurstStatus;
+  late final CameraSetWorkerThreadsDart _setWorkerThreads;
+  late final CameraRegisterFanoutConsumerDart _registerFanoutConsumer;
+  late final CameraUnregisterFanoutConsumerDart _unregisterFanoutConsumer;
+  late final CameraGetFanoutFrameDart _getFanoutFrame;
+  late final CameraGetFanoutStatsDart _getFanoutStats;
+  late final CameraGetPixelIsaDart _getPixelIsa;
+  late final CameraStartPrintDart _startPrint;
+  late final CameraStartPrintDart _startPrintToFile;
+  late final CameraGetPrintStatusDart _getPrintStatus;
+  late final CameraStartPrintSheetDart _startPrintSheet;
+  late final CameraStartPrintSheetDart _startPrintSheetToFile;
+  late final CameraSetPrintCacheDart _setPrintCache;
+  late final CameraGetPrintCacheStatsDart _getPrintCacheStats;
+  late final CameraValidateImageDart _validateImage;
+  late final CameraLoadOverlayTemplateDart _loadOverlayTemplate;
+  late final CameraClearOverlayTemplateDart _clearOverlayTemplate;
+  late final CameraApplyOverlayBgraDart _applyOverlayBgra;
+  late final CameraSetTemplateCacheDart _setTemplateCache;
+  late final CameraGetTemplateCacheStatsDart _getTemplateCacheStats;
+  late final CameraLoadColorLutDart _loadColorLut;
+  late final CameraClearColorLutDart _clearColorLut;
+  late final CameraApplyColorLutBgraDart _applyColorLutBgra;
+  late final CameraSetPrintColorManagementDart _setPrintColorManagement;
+  late final CameraSetColorTransformCacheDart _setColorTransformCache;
+  late final CameraSetPrintDitherDart _setPrintDither;
+  late final CameraEncodeJpegBgraDart _encodeJpegBgra;
 
   static CameraFFI? _instance;
 
@@ -65,86 +786,322 @@ class CameraFFI {
     _freeBuffer = _lib
         .lookup<NativeFunction<CameraFreeBufferNative>>('camera_free_buffer')
         .asFunction();
-  }
 
-  static CameraFFI get instance {
-    _instance ??= CameraFFI._internal();
-    return _instance!;
-  }
+    _registerConsumer = _lib
+        .lookup<NativeFunction<CameraRegisterConsumerNative>>('camera_register_consumer')
+        .asFunction();
 
-  /// Initialize the camera system
-  /// Returns 0 on success, negative on error
-  int initialize() {
-    try {
-      return _initialize();
-    } catch (e) {
-      print('[ERROR] Camera initialize failed: $e');
-      return -999;
-    }
-  }
+    _unregisterConsumer = _lib
+        .lookup<NativeFunction<CameraUnregisterConsumerNative>>('camera_unregister_consumer')
+        .asFunction();
 
-  /// Terminate the camera system
-  /// Returns 0 on success, negative on error
-  int terminate() {
-    try {
-      return _terminate();
-    } catch (e) {
-      print('[ERROR] Camera terminate failed: $e');
-      return -999;
-    }
-  }
+    _getFrameFor = _lib
+        .lookup<NativeFunction<CameraGetFrameForNative>>('camera_get_frame_for')
+        .asFunction();
 
-  /// Start live view
-  /// Returns 0 on success, negative on error
-  int startLiveview() {
-    try {
-      return _startLiveview();
-    } catch (e) {
-      print('[ERROR] Camera start liveview failed: $e');
-      return -999;
-    }
-  }
+    _getFrameEx = _lib
+        .lookup<NativeFunction<CameraGetFrameExNative>>('camera_get_frame_ex')
+        .asFunction();
 
-  /// Stop live view
-  /// Returns 0 on success, negative on error
-  int stopLiveview() {
-    try {
-      return _stopLiveview();
-    } catch (e) {
-      print('[ERROR] Camera stop liveview failed: $e');
-      return -999;
-    }
-  }
+    _getFrameInto = _lib
+        .lookup<NativeFunction<CameraGetFrameIntoNative>>('camera_get_frame_into')
+        .asFunction();
 
-  /// Get a frame from live view
-  /// Returns null on error, Uint8List on success (JPEG data)
-  Uint8List? getFrame() {
-    try {
-      final bufferPtr = calloc<Pointer<Uint8>>();
-      final sizePtr = calloc<Uint64>();
+    _ackFrame = _lib
+        .lookup<NativeFunction<CameraAckFrameNative>>('camera_ack_frame')
+        .asFunction();
 
-      final result = _getFrame(bufferPtr, sizePtr);
+    _setFrameInterval = _lib
+        .lookup<NativeFunction<CameraSetFrameIntervalNative>>('camera_set_frame_interval')
+        .asFunction();
 
-      if (result != 0) {
-        calloc.free(bufferPtr);
-        calloc.free(sizePtr);
-        return null;
-      }
+    _setCpuBudget = _lib
+        .lookup<NativeFunction<CameraSetCpuBudgetNative>>('camera_set_cpu_budget')
+        .asFunction();
 
-      final buffer = bufferPtr.value;
-      final size = sizePtr.value;
+    _setIdleMode = _lib
+        .lookup<NativeFunction<CameraSetIdleModeNative>>('camera_set_idle_mode')
+        .asFunction();
 
-      if (buffer == nullptr || size == 0) {
-        calloc.free(bufferPtr);
-        calloc.free(sizePtr);
-        return null;
-      }
+    _wake = _lib
+        .lookup<NativeFunction<CameraWakeNative>>('camera_wake')
+        .asFunction();
 
-      // Copy data to Dart
-      final frameData = Uint8List(size);
-      for (int i = 0; i < size; i++) {
-        frameData[i] = buffer[i];
-      }
+    _enableSharedFrames = _lib
+        .lookup<NativeFunction<CameraEnableSharedFramesNative>>('camera_enable_shared_frames')
+        .asFunction();
+
+    _disableSharedFrames = _lib
+        .lookup<NativeFunction<CameraDisableSharedFramesNative>>('camera_disable_shared_frames')
+        .asFunction();
+
+    _setStillSpool = _lib
+        .lookup<NativeFunction<CameraSetStillSpoolNative>>('camera_set_still_spool')
+        .asFunction();
+
+    _takePicture = _lib
+        .lookup<NativeFunction<CameraTakePictureNative>>('camera_take_picture')
+        .asFunction();
+
+    _getStill = _lib
+        .lookup<NativeFunction<CameraGetStillNative>>('camera_get_still')
+        .asFunction();
+
+    _startCountdownCapture = _lib
+        .lookup<NativeFunction<CameraStartCountdownCaptureNative>>('camera_start_countdown_capture')
+        .asFunction();
+
+    _cancelCountdown = _lib
+        .lookup<NativeFunction<CameraCancelCountdownNative>>('camera_cancel_countdown')
+        .asFunction();
+
+    _getCountdownStatus = _lib
+        .lookup<NativeFunction<CameraGetCountdownStatusNative>>('camera_get_countdown_status')
+        .asFunction();
+
+    _startBurst = _lib
+        .lookup<NativeFunction<CameraStartBurstNative>>('camera_start_burst')
+        .asFunction();
+
+    _cancelBurst = _lib
+        .lookup<NativeFunction<CameraCancelBurstNative>>('camera_cancel_burst')
+        .asFunction();
+
+    _getBurstStatus = _lib
+        .lookup<NativeFunction<CameraGetBurstStatusNative>>('camera_get_burst_status')
+        .asFunction();
+
+    _setWorkerThreads = _lib
+        .lookup<NativeFunction<CameraSetWorkerThreadsNative>>('camera_set_worker_threads')
+        .asFunction();
+
+    _registerFanoutConsumer = _lib
+        .lookup<NativeFunction<CameraRegisterFanoutConsumerNative>>('camera_register_fanout_consumer')
+        .asFunction();
+
+    _unregisterFanoutConsumer = _lib
+        .lookup<NativeFunction<CameraUnregisterFanoutConsumerNative>>('camera_unregister_fanout_consumer')
+        .asFunction();
+
+    _getFanoutFrame = _lib
+        .lookup<NativeFunction<CameraGetFanoutFrameNative>>('camera_get_fanout_frame')
+        .asFunction();
+
+    _getFanoutStats = _lib
+        .lookup<NativeFunction<CameraGetFanoutStatsNative>>('camera_get_fanout_stats')
+        .asFunction();
+
+    _getPixelIsa = _lib
+        .lookup<NativeFunction<CameraGetPixelIsaNative>>('camera_get_pixel_isa')
+        .asFunction();
+
+    _startPrint = _lib
+        .lookup<NativeFunction<CameraStartPrintNative>>('camera_start_print')
+        .asFunction();
+
+    _startPrintToFile = _lib
+        .lookup<NativeFunction<CameraStartPrintNative>>('camera_start_print_to_file')
+        .asFunction();
+
+    _getPrintStatus = _lib
+        .lookup<NativeFunction<CameraGetPrintStatusNative>>('camera_get_print_status')
+        .asFunction();
+
+    _startPrintSheet = _lib
+        .lookup<NativeFunction<CameraStartPrintSheetNative>>('camera_start_print_sheet')
+        .asFunction();
+
+    _startPrintSheetToFile = _lib
+        .lookup<NativeFunction<CameraStartPrintSheetNative>>('camera_start_print_sheet_to_file')
+        .asFunction();
+
+    _setPrintCache = _lib
+        .lookup<NativeFunction<CameraSetPrintCacheNative>>('camera_set_print_cache')
+        .asFunction();
+
+    _getPrintCacheStats = _lib
+        .lookup<NativeFunction<CameraGetPrintCacheStatsNative>>('camera_get_print_cache_stats')
+        .asFunction();
+
+    _validateImage = _lib
+        .lookup<NativeFunction<CameraValidateImageNative>>('camera_validate_image')
+        .asFunction();
+
+    _loadOverlayTemplate = _lib
+        .lookup<NativeFunction<CameraLoadOverlayTemplateNative>>('camera_load_overlay_template')
+        .asFunction();
+
+    _clearOverlayTemplate = _lib
+        .lookup<NativeFunction<CameraClearOverlayTemplateNative>>('camera_clear_overlay_template')
+        .asFunction();
+
+    _applyOverlayBgra = _lib
+        .lookup<NativeFunction<CameraApplyOverlayBgraNative>>('camera_apply_overlay_bgra')
+        .asFunction();
+
+    _setTemplateCache = _lib
+        .lookup<NativeFunction<CameraSetTemplateCacheNative>>('camera_set_template_cache')
+        .asFunction();
+
+    _getTemplateCacheStats = _lib
+        .lookup<NativeFunction<CameraGetTemplateCacheStatsNative>>('camera_get_template_cache_stats')
+        .asFunction();
+
+    _loadColorLut = _lib
+        .lookup<NativeFunction<CameraLoadColorLutNative>>('camera_load_color_lut')
+        .asFunction();
+
+    _clearColorLut = _lib
+        .lookup<NativeFunction<CameraClearColorLutNative>>('camera_clear_color_lut')
+        .asFunction();
+
+    _applyColorLutBgra = _lib
+        .lookup<NativeFunction<CameraApplyColorLutBgraNative>>('camera_apply_color_lut_bgra')
+        .asFunction();
+
+    _setPrintColorManagement = _lib
+        .lookup<NativeFunction<CameraSetPrintColorManagementNative>>('camera_set_print_color_management')
+        .asFunction();
+
+    _setColorTransformCache = _lib
+        .lookup<NativeFunction<CameraSetColorTransformCacheNative>>('camera_set_color_transform_cache')
+        .asFunction();
+
+    _setPrintDither = _lib
+        .lookup<NativeFunction<CameraSetPrintDitherNative>>('camera_set_print_dither')
+        .asFunction();
+
+    _encodeJpegBgra = _lib
+        .lookup<NativeFunction<CameraEncodeJpegBgraNative>>('camera_encode_jpeg_bgra')
+        .asFunction();
+
+    _initializeReplay = _lib
+        .lookup<NativeFunction<CameraInitializeReplayNative>>('camera_initialize_replay')
+        .asFunction();
+
+    _setMotionSensitivity = _lib
+        .lookup<NativeFunction<CameraSetMotionSensitivityNative>>('camera_set_motion_sensitivity')
+        .asFunction();
+
+    _getIdleStats = _lib
+        .lookup<NativeFunction<CameraGetIdleStatsNative>>('camera_get_idle_stats')
+        .asFunction();
+
+    _setPreroll = _lib
+        .lookup<NativeFunction<CameraSetPrerollNative>>('camera_set_preroll')
+        .asFunction();
+
+    _startBoomerang = _lib
+        .lookup<NativeFunction<CameraStartBoomerangNative>>('camera_start_boomerang')
+        .asFunction();
+
+    _getBoomerangStatus = _lib
+        .lookup<NativeFunction<CameraGetBoomerangStatusNative>>('camera_get_boomerang_status')
+        .asFunction();
+
+    _startRecording = _lib
+        .lookup<NativeFunction<CameraStartRecordingNative>>('camera_start_recording')
+        .asFunction();
+
+    _stopRecording = _lib
+        .lookup<NativeFunction<CameraStopRecordingNative>>('camera_stop_recording')
+        .asFunction();
+
+    _getRecordingStats = _lib
+        .lookup<NativeFunction<CameraGetRecordingStatsNative>>('camera_get_recording_stats')
+        .asFunction();
+  }
+
+  static CameraFFI get instance {
+    _instance ??= CameraFFI._internal();
+    return _instance!;
+  }
+
+  /// Initialize the camera system
+  /// Returns 0 on success, negative on error
+  int initialize() {
+    try {
+      return _initialize();
+    } catch (e) {
+      print('[ERROR] Camera initialize failed: $e');
+      return -999;
+    }
+  }
+
+  /// Open the replay backend instead of a camera: the JPEG frames in
+  /// [directory] are served in name order every [frameIntervalMs], looping.
+  /// Returns 0 on success, -1 if a session is open, -3 if there are no frames
+  int initializeReplay(String directory, {int frameIntervalMs = 33}) {
+    final dirPtr = directory.toNativeUtf16();
+    try {
+      return _initializeReplay(dirPtr, frameIntervalMs);
+    } catch (e) {
+      print('[ERROR] Camera initialize replay failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dirPtr);
+    }
+  }
+
+  /// Terminate the camera system
+  /// Returns 0 on success, negative on error
+  int terminate() {
+    try {
+      return _terminate();
+    } catch (e) {
+      print('[ERROR] Camera terminate failed: $e');
+      return -999;
+    }
+  }
+
+  /// Start live view
+  /// Returns 0 on success, negative on error
+  int startLiveview() {
+    try {
+      return _startLiveview();
+    } catch (e) {
+      print('[ERROR] Camera start liveview failed: $e');
+      return -999;
+    }
+  }
+
+  /// Stop live view
+  /// Returns 0 on success, negative on error
+  int stopLiveview() {
+    try {
+      return _stopLiveview();
+    } catch (e) {
+      print('[ERROR] Camera stop liveview failed: $e');
+      return -999;
+    }
+  }
+
+  /// Get a frame from live view
+  /// Returns null on error, Uint8List on success (JPEG data)
+  Uint8List? getFrame() {
+    try {
+      final bufferPtr = calloc<Pointer<Uint8>>();
+      final sizePtr = calloc<Uint64>();
+
+      final result = _getFrame(bufferPtr, sizePtr);
+
+      if (result != 0) {
+        calloc.free(bufferPtr);
+        calloc.free(sizePtr);
+        return null;
+      }
+
+      final buffer = bufferPtr.value;
+      final size = sizePtr.value;
+
+      if (buffer == nullptr || size == 0) {
+        calloc.free(bufferPtr);
+        calloc.free(sizePtr);
+        return null;
+      }
+
+      // Copy data to Dart
+      final frameData = Uint8List.fromList(buffer.asTypedList(size));
 
       // Free native buffer
       _freeBuffer(buffer);
@@ -158,4 +1115,1062 @@ class CameraFFI {
       return null;
     }
   }
-}
\ No newline at end of file
+
+  /// Register a frame consumer for native pacing
+  /// Returns consumer id (> 0)
+  int registerConsumer() {
+    try {
+      return _registerConsumer();
+    } catch (e) {
+      print('[ERROR] Camera register consumer failed: $e');
+      return -999;
+    }
+  }
+
+  /// Unregister a frame consumer
+  int unregisterConsumer(int consumerId) {
+    try {
+      return _unregisterConsumer(consumerId);
+    } catch (e) {
+      print('[ERROR] Camera unregister consumer failed: $e');
+      return -999;
+    }
+  }
+
+  /// Get the latest frame if it is newer than [lastSequence]
+  /// Returns null when there is no newer frame or on error
+  ({Uint8List data, int sequence})? getFrameFor(int consumerId, int lastSequence) {
+    final bufferPtr = calloc<Pointer<Uint8>>();
+    final sizePtr = calloc<Uint64>();
+    final seqPtr = calloc<Uint64>();
+
+    try {
+      seqPtr.value = lastSequence;
+      final result = _getFrameFor(consumerId, bufferPtr, sizePtr, seqPtr);
+      if (result != 0) {
+        return null;
+      }
+
+      final buffer = bufferPtr.value;
+      final size = sizePtr.value;
+      if (buffer == nullptr || size == 0) {
+        return null;
+      }
+
+      // Copy data to Dart
+      final frameData = Uint8List.fromList(buffer.asTypedList(size));
+
+      // Free native buffer
+      _freeBuffer(buffer);
+
+      return (data: frameData, sequence: seqPtr.value);
+
+    } catch (e) {
+      print('[ERROR] Camera get frame failed: $e');
+      return null;
+    } finally {
+      calloc.free(bufferPtr);
+      calloc.free(sizePtr);
+      calloc.free(seqPtr);
+    }
+  }
+
+  /// Get the latest frame newer than [lastSequence] with its metadata
+  /// Returns null when there is no newer frame or on error
+  ({Uint8List data, FrameInfo info})? getFrameEx(int consumerId, int lastSequence) {
+    final bufferPtr = calloc<Pointer<Uint8>>();
+    final sizePtr = calloc<Uint64>();
+    final descPtr = calloc<CameraFrameDesc>();
+
+    try {
+      descPtr.ref.structSize = sizeOf<CameraFrameDesc>();
+      final result = _getFrameEx(consumerId, lastSequence, bufferPtr, sizePtr, descPtr);
+      if (result != 0) {
+        return null;
+      }
+
+      final buffer = bufferPtr.value;
+      final size = sizePtr.value;
+      if (buffer == nullptr || size == 0) {
+        return null;
+      }
+
+      // Copy data to Dart
+      final frameData = Uint8List.fromList(buffer.asTypedList(size));
+
+      // Free native buffer
+      _freeBuffer(buffer);
+
+      return (data: frameData, info: FrameInfo.fromDesc(descPtr.ref));
+
+    } catch (e) {
+      print('[ERROR] Camera get frame failed: $e');
+      return null;
+    } finally {
+      calloc.free(bufferPtr);
+      calloc.free(sizePtr);
+      calloc.free(descPtr);
+    }
+  }
+
+  /// Copy the latest frame newer than [lastSequence] into [buffer]
+  /// (grown once if the frame does not fit).
+  /// Returns 0 on success, 1 when there is no newer frame, negative on error
+  int getFrameInto(NativeFrameBuffer buffer, int consumerId, int lastSequence) {
+    try {
+      var result = _getFrameInto(consumerId, lastSequence, buffer._data, buffer._capacity,
+          buffer._length, buffer._desc);
+      if (result == -8) {
+        buffer._grow(buffer._length.value);
+        result = _getFrameInto(consumerId, lastSequence, buffer._data, buffer._capacity,
+            buffer._length, buffer._desc);
+      }
+      return result;
+    } catch (e) {
+      print('[ERROR] Camera get frame into failed: $e');
+      return -999;
+    }
+  }
+
+  /// Tell the native pipeline that [sequence] has been displayed
+  int ackFrame(int consumerId, int sequence) {
+    try {
+      return _ackFrame(consumerId, sequence);
+    } catch (e) {
+      print('[ERROR] Camera ack frame failed: $e');
+      return -999;
+    }
+  }
+
+  /// Bound the native capture interval (ms)
+  int setFrameInterval(int minIntervalMs, int maxIntervalMs) {
+    try {
+      return _setFrameInterval(minIntervalMs, maxIntervalMs);
+    } catch (e) {
+      print('[ERROR] Camera set frame interval failed: $e');
+      return -999;
+    }
+  }
+
+  /// Cap live view CPU usage: capture plus fan-out decoding and grading
+  /// (% of one core)
+  int setCpuBudget(int percent) {
+    try {
+      return _setCpuBudget(percent);
+    } catch (e) {
+      print('[ERROR] Camera set cpu budget failed: $e');
+      return -999;
+    }
+  }
+
+  /// Configure motion-gated idle mode
+  int setIdleMode(bool enabled, int idleAfterMs, int trickleIntervalMs) {
+    try {
+      return _setIdleMode(enabled ? 1 : 0, idleAfterMs, trickleIntervalMs);
+    } catch (e) {
+      print('[ERROR] Camera set idle mode failed: $e');
+      return -999;
+    }
+  }
+
+  /// Leave idle mode immediately
+  int wake() {
+    try {
+      return _wake();
+    } catch (e) {
+      print('[ERROR] Camera wake failed: $e');
+      return -999;
+    }
+  }
+
+  /// Motion test for idle mode: a grid cell changes when its mean luma moves
+  /// by more than [cellThreshold] (1-255); motion needs [minChangedPermille]
+  /// (1-1000) changed cells
+  int setMotionSensitivity(int cellThreshold, int minChangedPermille) {
+    try {
+      return _setMotionSensitivity(cellThreshold, minChangedPermille);
+    } catch (e) {
+      print('[ERROR] Camera set motion sensitivity failed: $e');
+      return -999;
+    }
+  }
+
+  ({
+    int framesCaptured,
+    int framesPublished,
+    int framesSkipped,
+    int wakeCount,
+    int idleMsTotal,
+    int lastWakeLatencyUs,
+    bool idle,
+  })? getIdleStats() {
+    final statsPtr = calloc<CameraIdleStats>();
+    try {
+      if (_getIdleStats(statsPtr) != 0) {
+        return null;
+      }
+      final stats = statsPtr.ref;
+      return (
+        framesCaptured: stats.framesCaptured,
+        framesPublished: stats.framesPublished,
+        framesSkipped: stats.framesSkipped,
+        wakeCount: stats.wakeCount,
+        idleMsTotal: stats.idleMsTotal,
+        lastWakeLatencyUs: stats.lastWakeLatencyUs,
+        idle: stats.idle != 0,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get idle stats failed: $e');
+      return null;
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  /// Keep the last [seconds] of live view (at most [maxMegabytes]) for
+  /// boomerang clips; 0 seconds disables the buffer
+  int setPreroll(int seconds, int maxMegabytes) {
+    try {
+      return _setPreroll(seconds, maxMegabytes);
+    } catch (e) {
+      print('[ERROR] Camera set preroll failed: $e');
+      return -999;
+    }
+  }
+
+  /// Encode the last [seconds] of pre-roll into a forward+reverse GIF at
+  /// [outputPath] in the background; poll [getBoomerangStatus].
+  /// [maxSide] and [fps] <= 0 keep the native defaults (480 px, 15 fps).
+  /// Returns 0 if started, -1 if the pre-roll is empty, -3 if busy
+  int startBoomerang(String outputPath, int seconds, {int maxSide = 0, int fps = 0}) {
+    final pathPtr = outputPath.toNativeUtf16();
+    try {
+      return _startBoomerang(pathPtr, seconds, maxSide, fps);
+    } catch (e) {
+      print('[ERROR] Camera start boomerang failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  /// Boomerang state: 1 encoding, 0 done, -1 no job, -4 failed
+  ({int state, int encodeUs}) getBoomerangStatus() {
+    final usPtr = calloc<Uint64>();
+    try {
+      final state = _getBoomerangStatus(usPtr);
+      return (state: state, encodeUs: usPtr.value);
+    } catch (e) {
+      print('[ERROR] Camera get boomerang status failed: $e');
+      return (state: -999, encodeUs: 0);
+    } finally {
+      calloc.free(usPtr);
+    }
+  }
+
+  /// Record live view to an MJPEG AVI at [outputPath] at a constant [fps].
+  /// The camera's JPEG frames are written as they are, without re-encoding.
+  /// Returns 0 on success, -3 if already recording, -4 if the file cannot be created
+  int startRecording(String outputPath, int fps) {
+    final pathPtr = outputPath.toNativeUtf16();
+    try {
+      return _startRecording(pathPtr, fps);
+    } catch (e) {
+      print('[ERROR] Camera start recording failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  /// Finish the AVI. Returns 0 on success, -1 if not recording
+  int stopRecording() {
+    try {
+      return _stopRecording();
+    } catch (e) {
+      print('[ERROR] Camera stop recording failed: $e');
+      return -999;
+    }
+  }
+
+  ({int framesWritten, int framesRepeated, int framesDropped, int bytesWritten, bool recording})?
+      getRecordingStats() {
+    final statsPtr = calloc<CameraRecordingStats>();
+    try {
+      if (_getRecordingStats(statsPtr) != 0) {
+        return null;
+      }
+      final stats = statsPtr.ref;
+      return (
+        framesWritten: stats.framesWritten,
+        framesRepeated: stats.framesRepeated,
+        framesDropped: stats.framesDropped,
+        bytesWritten: stats.bytesWritten,
+        recording: stats.recording != 0,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get recording stats failed: $e');
+      return null;
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  /// Publish live view frames to shared memory [name] for other processes
+  /// Returns 0 on success
+  int enableSharedFrames(String name, int slotCount, int slotMegabytes) {
+    final namePtr = name.toNativeUtf8();
+    try {
+      return _enableSharedFrames(namePtr, slotCount, slotMegabytes);
+    } catch (e) {
+      print('[ERROR] Camera enable shared frames failed: $e');
+      return -999;
+    } finally {
+      calloc.free(namePtr);
+    }
+  }
+
+  /// Stop publishing frames to shared memory
+  int disableSharedFrames() {
+    try {
+      return _disableSharedFrames();
+    } catch (e) {
+      print('[ERROR] Camera disable shared frames failed: $e');
+      return -999;
+    }
+  }
+
+  /// Transfer stills into files under [directory] instead of memory
+  /// (null switches back to memory). Returns 0 on success
+  int setStillSpool(String? directory) {
+    final dirPtr = (directory ?? '').toNativeUtf16();
+    try {
+      return _setStillSpool(dirPtr);
+    } catch (e) {
+      print('[ERROR] Camera set still spool failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dirPtr);
+    }
+  }
+
+  /// Fire the shutter; the file arrives later via [getStill]
+  /// Returns shot id (> 0), negative on error
+  int takePicture() {
+    try {
+      return _takePicture();
+    } catch (e) {
+      print('[ERROR] Camera take picture failed: $e');
+      return -999;
+    }
+  }
+
+  /// Get the oldest finished still, null if none is ready
+  StillShot? getStill() {
+    final infoPtr = calloc<CameraStillInfo>();
+    final bufferPtr = calloc<Pointer<Uint8>>();
+    final sizePtr = calloc<Uint64>();
+
+    try {
+      final result = _getStill(infoPtr, bufferPtr, sizePtr);
+      if (result != 0) {
+        return null;
+      }
+
+      final info = infoPtr.ref;
+      final nameBytes = <int>[];
+      for (int i = 0; i < 256 && info.fileName[i] != 0; i++) {
+        nameBytes.add(info.fileName[i]);
+      }
+      final pathUnits = <int>[];
+      for (int i = 0; i < 260 && info.path[i] != 0; i++) {
+        pathUnits.add(info.path[i]);
+      }
+
+      Uint8List? data;
+      final buffer = bufferPtr.value;
+      if (buffer != nullptr) {
+        data = Uint8List.fromList(buffer.asTypedList(sizePtr.value));
+        _freeBuffer(buffer);
+      }
+
+      return StillShot(
+        shotId: info.shotId,
+        error: info.error,
+        burstIndex: info.burstIndex,
+        fileName: String.fromCharCodes(nameBytes),
+        data: data,
+        path: pathUnits.isEmpty ? null : String.fromCharCodes(pathUnits),
+        shutterToEvent: Duration(microseconds: info.shutterToEventUs),
+        download: Duration(microseconds: info.downloadUs),
+        total: Duration(microseconds: info.totalUs),
+      );
+
+    } catch (e) {
+      print('[ERROR] Camera get still failed: $e');
+      return null;
+    } finally {
+      calloc.free(infoPtr);
+      calloc.free(bufferPtr);
+      calloc.free(sizePtr);
+    }
+  }
+
+  /// Start a native countdown that fires on zero, half-pressing
+  /// [prefocusLeadMs] before it. Returns 0 on success
+  int startCountdownCapture(int countdownMs, int prefocusLeadMs) {
+    try {
+      return _startCountdownCapture(countdownMs, prefocusLeadMs);
+    } catch (e) {
+      print('[ERROR] Camera start countdown failed: $e');
+      return -999;
+    }
+  }
+
+  /// Abort a running countdown (releases a half-press)
+  int cancelCountdown() {
+    try {
+      return _cancelCountdown();
+    } catch (e) {
+      print('[ERROR] Camera cancel countdown failed: $e');
+      return -999;
+    }
+  }
+
+  /// Countdown state: 1 counting, 0 fired, -1 none, -4 failed
+  ({int state, int shotId, int error, bool prefocused, int shutterLagUs, int zeroToReleaseUs})
+      getCountdownStatus() {
+    final reportPtr = calloc<CameraCountdownReport>();
+    try {
+      final state = _getCountdownStatus(reportPtr);
+      final report = reportPtr.ref;
+      return (
+        state: state,
+        shotId: report.shotId,
+        error: report.error,
+        prefocused: report.prefocused != 0,
+        shutterLagUs: report.shutterLagUs,
+        zeroToReleaseUs: report.zeroToReleaseUs,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get countdown status failed: $e');
+      return (state: -999, shotId: 0, error: -999, prefocused: false, shutterLagUs: 0, zeroToReleaseUs: 0);
+    } finally {
+      calloc.free(reportPtr);
+    }
+  }
+
+  /// Queue [count] shots every [intervalMs] after [firstDelayMs]
+  /// Returns 0 on success
+  int startBurst(int count, int intervalMs, int firstDelayMs, int prefocusLeadMs) {
+    try {
+      return _startBurst(count, intervalMs, firstDelayMs, prefocusLeadMs);
+    } catch (e) {
+      print('[ERROR] Camera start burst failed: $e');
+      return -999;
+    }
+  }
+
+  /// Stop firing the remaining burst shots
+  int cancelBurst() {
+    try {
+      return _cancelBurst();
+    } catch (e) {
+      print('[ERROR] Camera cancel burst failed: $e');
+      return -999;
+    }
+  }
+
+  /// Burst state: 1 running, 0 all fired, -1 none, -4 cancelled
+  ({int state, int count, int fired, int failed, int elapsedUs}) getBurstStatus() {
+    final statusPtr = calloc<CameraBurstStatus>();
+    try {
+      final state = _getBurstStatus(statusPtr);
+      final status = statusPtr.ref;
+      return (
+        state: state,
+        count: status.count,
+        fired: status.fired,
+        failed: status.failed,
+        elapsedUs: status.elapsedUs,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get burst status failed: $e');
+      return (state: -999, count: 0, fired: 0, failed: 0, elapsedUs: 0);
+    } finally {
+      calloc.free(statusPtr);
+    }
+  }
+
+  /// Size the shared native worker pool (0 = cores - 1). Only effective
+  /// before the first parallel job; returns -3 afterwards
+  int setWorkerThreads(int count) {
+    try {
+      return _setWorkerThreads(count);
+    } catch (e) {
+      print('[ERROR] Camera set worker threads failed: $e');
+      return -999;
+    }
+  }
+
+  /// Register a consumer that receives live view as [format] (see
+  /// [FanoutFormat]) scaled to fit [maxWidth] x [maxHeight] (0 = unbounded)
+  /// at most [maxFps] times a second (0 = every frame), oriented by
+  /// [transform] (see [FanoutTransform]; applied during decode, so a mirrored
+  /// or rotated preview costs nothing extra).
+  /// Returns the consumer id (> 0) or a negative error code
+  int registerFanoutConsumer(int format,
+      {int maxWidth = 0, int maxHeight = 0, int maxFps = 0, int transform = FanoutTransform.rotate0}) {
+    try {
+      return _registerFanoutConsumer(format, maxWidth, maxHeight, maxFps, transform);
+    } catch (e) {
+      print('[ERROR] Camera register fanout consumer failed: $e');
+      return -999;
+    }
+  }
+
+  int unregisterFanoutConsumer(int consumerId) {
+    try {
+      return _unregisterFanoutConsumer(consumerId);
+    } catch (e) {
+      print('[ERROR] Camera unregister fanout consumer failed: $e');
+      return -999;
+    }
+  }
+
+  /// Copy the consumer's latest frame newer than [lastSequence] into
+  /// [buffer] (grown once if needed). Pixels are in storage[0, length).
+  /// Returns null when there is no newer frame or on error
+  ({int sequence, int format, int width, int height, int stride})? getFanoutFrame(
+      NativeFrameBuffer buffer, int consumerId, int lastSequence) {
+    final framePtr = calloc<CameraFanoutFrame>();
+    try {
+      var result = _getFanoutFrame(consumerId, lastSequence, buffer._data, buffer._capacity,
+          buffer._length, framePtr);
+      if (result == -8) {
+        buffer._grow(buffer._length.value);
+        result = _getFanoutFrame(consumerId, lastSequence, buffer._data, buffer._capacity,
+            buffer._length, framePtr);
+      }
+      if (result != 0) {
+        return null;
+      }
+      final frame = framePtr.ref;
+      return (
+        sequence: frame.sequence,
+        format: frame.format,
+        width: frame.width,
+        height: frame.height,
+        stride: frame.stride,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get fanout frame failed: $e');
+      return null;
+    } finally {
+      calloc.free(framePtr);
+    }
+  }
+
+  /// Fan-out work counters: shared decodes/resizes versus deliveries show how
+  /// much the consumers save by sharing one pipeline
+  ({
+    int framesSubmitted,
+    int framesProcessed,
+    int decodes,
+    int resizes,
+    int conversions,
+    int transforms,
+    int deliveries,
+    int grades,
+  })? getFanoutStats() {
+    final statsPtr = calloc<CameraFanoutStats>();
+    try {
+      if (_getFanoutStats(statsPtr) != 0) {
+        return null;
+      }
+      final stats = statsPtr.ref;
+      return (
+        framesSubmitted: stats.framesSubmitted,
+        framesProcessed: stats.framesProcessed,
+        decodes: stats.decodes,
+        resizes: stats.resizes,
+        conversions: stats.conversions,
+        transforms: stats.transforms,
+        deliveries: stats.deliveries,
+        grades: stats.grades,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get fanout stats failed: $e');
+      return null;
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  /// Instruction set the native pixel kernels run on (see [PixelIsa])
+  int getPixelIsa() {
+    try {
+      return _getPixelIsa();
+    } catch (e) {
+      print('[ERROR] Camera get pixel ISA failed: $e');
+      return -999;
+    }
+  }
+
+  int _startPrintJob(CameraStartPrintDart start, Uint8List bytes, double widthIn, double heightIn, int dpi,
+      bool autoRotate, String target) {
+    final dataPtr = calloc<Uint8>(bytes.length);
+    final layoutPtr = calloc<CameraPrintLayout>();
+    final targetPtr = target.toNativeUtf16();
+    try {
+      dataPtr.asTypedList(bytes.length).setAll(0, bytes);
+      layoutPtr.ref
+        ..widthIn = widthIn
+        ..heightIn = heightIn
+        ..dpi = dpi
+        ..autoRotate = autoRotate ? 1 : 0;
+      return start(dataPtr, bytes.length, layoutPtr, targetPtr);
+    } catch (e) {
+      print('[ERROR] Camera start print failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dataPtr);
+      calloc.free(layoutPtr);
+      calloc.free(targetPtr);
+    }
+  }
+
+  /// Print an encoded photo borderless on [printerName] (null = default
+  /// printer), rendered natively at the printer's own resolution. Paper is
+  /// [widthIn] x [heightIn] inches, landscape when wider. Runs in the
+  /// background; poll [getPrintStatus]. Returns 0 on start, -3 if busy
+  int startPrint(Uint8List bytes,
+      {double widthIn = 6, double heightIn = 4, bool autoRotate = true, String? printerName}) {
+    return _startPrintJob(_startPrint, bytes, widthIn, heightIn, 0, autoRotate, printerName ?? '');
+  }
+
+  /// Same page written to a 24-bit BMP at [dpi] instead of a printer
+  int startPrintToFile(Uint8List bytes, String outputPath,
+      {double widthIn = 6, double heightIn = 4, int dpi = 300, bool autoRotate = true}) {
+    return _startPrintJob(_startPrintToFile, bytes, widthIn, heightIn, dpi, autoRotate, outputPath);
+  }
+
+  int _startSheetJob(CameraStartPrintSheetDart start, List<Uint8List> images,
+      List<({double x, double y, double width, double height, int image})> cells, double widthIn,
+      double heightIn, int dpi, bool autoRotate, int background, String target) {
+    final imagesPtr = calloc<Pointer<Uint8>>(images.length);
+    final sizesPtr = calloc<Uint64>(images.length);
+    final cellsPtr = calloc<CameraSheetCell>(cells.length);
+    final layoutPtr = calloc<CameraPrintLayout>();
+    final targetPtr = target.toNativeUtf16();
+    try {
+      for (var i = 0; i < images.length; i++) {
+        final data = calloc<Uint8>(images[i].length);
+        data.asTypedList(images[i].length).setAll(0, images[i]);
+        imagesPtr[i] = data;
+        sizesPtr[i] = images[i].length;
+      }
+      for (var i = 0; i < cells.length; i++) {
+        cellsPtr[i]
+          ..xIn = cells[i].x
+          ..yIn = cells[i].y
+          ..widthIn = cells[i].width
+          ..heightIn = cells[i].height
+          ..source = cells[i].image;
+      }
+      layoutPtr.ref
+        ..widthIn = widthIn
+        ..heightIn = heightIn
+        ..dpi = dpi
+        ..autoRotate = autoRotate ? 1 : 0;
+      return start(imagesPtr, sizesPtr, images.length, cellsPtr, cells.length, layoutPtr, background, targetPtr);
+    } catch (e) {
+      print('[ERROR] Camera start print sheet failed: $e');
+      return -999;
+    } finally {
+      for (var i = 0; i < images.length; i++) {
+        if (imagesPtr[i] != nullptr) {
+          calloc.free(imagesPtr[i]);
+        }
+      }
+      calloc.free(imagesPtr);
+      calloc.free(sizesPtr);
+      calloc.free(cellsPtr);
+      calloc.free(layoutPtr);
+      calloc.free(targetPtr);
+    }
+  }
+
+  /// Print several photos on one sheet (photo strip, 4-up grid). Each cell
+  /// places `images[cell.image]` at x/y/width/height inches from the top-left
+  /// paper corner, filled edge to edge; [background] (0xRRGGBB) shows around
+  /// and between cells. Rendered natively in bands, so memory stays small
+  /// whatever the sheet size. Poll [getPrintStatus]
+  int startPrintSheet(List<Uint8List> images,
+      List<({double x, double y, double width, double height, int image})> cells,
+      {double widthIn = 2, double heightIn = 6, bool autoRotate = true, int background = 0xFFFFFF,
+      String? printerName}) {
+    return _startSheetJob(_startPrintSheet, images, cells, widthIn, heightIn, 0, autoRotate, background,
+        printerName ?? '');
+  }
+
+  /// Same sheet written to a 24-bit BMP at [dpi] instead of a printer
+  int startPrintSheetToFile(List<Uint8List> images,
+      List<({double x, double y, double width, double height, int image})> cells, String outputPath,
+      {double widthIn = 2, double heightIn = 6, int dpi = 300, bool autoRotate = true, int background = 0xFFFFFF}) {
+    return _startSheetJob(_startPrintSheetToFile, images, cells, widthIn, heightIn, dpi, autoRotate, background,
+        outputPath);
+  }
+
+  /// Print state: 1 printing, 0 spooled, -1 none, -4 image unreadable,
+  /// -5 printer unavailable, -6 spool or file write failed
+  ({
+    int state,
+    int width,
+    int height,
+    int dpiX,
+    int dpiY,
+    int totalUs,
+    bool cacheHit,
+    int peakBytes,
+    bool colorManaged,
+  }) getPrintStatus() {
+    final reportPtr = calloc<CameraPrintReport>();
+    try {
+      final state = _getPrintStatus(reportPtr);
+      final report = reportPtr.ref;
+      return (
+        state: state,
+        width: report.width,
+        height: report.height,
+        dpiX: report.dpiX,
+        dpiY: report.dpiY,
+        totalUs: report.totalUs,
+        cacheHit: report.cacheHit != 0,
+        peakBytes: report.peakBytes,
+        colorManaged: report.colorManaged != 0,
+      );
+    } catch (e) {
+      print('[ERROR] Camera get print status failed: $e');
+      return (
+        state: -999,
+        width: 0,
+        height: 0,
+        dpiX: 0,
+        dpiY: 0,
+        totalUs: 0,
+        cacheHit: false,
+        peakBytes: 0,
+        colorManaged: false,
+      );
+    } finally {
+      calloc.free(reportPtr);
+    }
+  }
+
+  /// Keep finished print rasters in [directory] (null = off), at most
+  /// [maxBytes] on disk, so a reprint of the same photo and page goes straight
+  /// to the spooler. Entries from earlier runs are reused
+  int setPrintCache(String? directory, {int maxBytes = 1024 * 1024 * 1024}) {
+    final dirPtr = (directory ?? '').toNativeUtf16();
+    try {
+      return _setPrintCache(dirPtr, maxBytes);
+    } catch (e) {
+      print('[ERROR] Camera set print cache failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dirPtr);
+    }
+  }
+
+  ({int hits, int misses, int entries, int bytes})? getPrintCacheStats() {
+    final statsPtr = calloc<CameraPrintCacheStats>();
+    try {
+      if (_getPrintCacheStats(statsPtr) != 0) {
+        return null;
+      }
+      final stats = statsPtr.ref;
+      return (hits: stats.hits, misses: stats.misses, entries: stats.entries, bytes: stats.bytes);
+    } catch (e) {
+      print('[ERROR] Camera get print cache stats failed: $e');
+      return null;
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  /// Convert prints and sheets from sRGB to the printer's ICC profile, or to
+  /// [profilePath] (.icc/.icm) when given. [intent]: 0 perceptual,
+  /// 1 relative colorimetric, 2 saturation, 3 absolute colorimetric. The
+  /// transform is built on the first print that needs it
+  int setPrintColorManagement({bool enabled = true, int intent = 0, String? profilePath}) {
+    final pathPtr = (profilePath ?? '').toNativeUtf16();
+    try {
+      return _setPrintColorManagement(enabled ? 1 : 0, intent, pathPtr);
+    } catch (e) {
+      print('[ERROR] Camera set print color management failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  /// Keep built printer colour transforms in [directory] (null = memory
+  /// only), so later runs reuse them
+  int setColorTransformCache(String? directory) {
+    final dirPtr = (directory ?? '').toNativeUtf16();
+    try {
+      return _setColorTransformCache(dirPtr);
+    } catch (e) {
+      print('[ERROR] Camera set color transform cache failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dirPtr);
+    }
+  }
+
+  /// Dither prints and sheets to 2^[bits] gray levels (1-4 bits) for sticker
+  /// and receipt printers that take low-bit input, instead of leaving it to
+  /// the driver. [mode] is a [PrintDitherMode]; none turns it off
+  int setPrintDither(int mode, {int bits = 1}) {
+    try {
+      return _setPrintDither(mode, bits);
+    } catch (e) {
+      print('[ERROR] Camera set print dither failed: $e');
+      return -999;
+    }
+  }
+
+  /// Check that [bytes] is a complete JPEG or PNG without decoding it.
+  /// [verify] also scans JPEG markers and PNG CRCs through the whole file.
+  /// State: 0 valid, -4 not JPEG/PNG, -5 truncated, -6 malformed, -7 bad CRC
+  ({int state, int format, int width, int height}) validateImage(Uint8List bytes, {bool verify = false}) {
+    if (bytes.isEmpty) {
+      return (state: -2, format: ImageContainer.unknown, width: 0, height: 0);
+    }
+    final dataPtr = calloc<Uint8>(bytes.length);
+    final infoPtr = calloc<CameraImageInfo>();
+    try {
+      dataPtr.asTypedList(bytes.length).setAll(0, bytes);
+      final state = _validateImage(dataPtr, bytes.length, verify ? 1 : 0, infoPtr);
+      final info = infoPtr.ref;
+      return (state: state, format: info.format, width: info.width, height: info.height);
+    } catch (e) {
+      print('[ERROR] Camera validate image failed: $e');
+      return (state: -999, format: ImageContainer.unknown, width: 0, height: 0);
+    } finally {
+      calloc.free(dataPtr);
+      calloc.free(infoPtr);
+    }
+  }
+
+  /// Composite the frame template at [path] over every print and sheet
+  /// until [clearOverlayTemplate]. Returns the layer count, or -4 when the
+  /// template or its artwork cannot be read (the previous one stays)
+  int loadOverlayTemplate(String path) {
+    final pathPtr = path.toNativeUtf16();
+    try {
+      return _loadOverlayTemplate(pathPtr);
+    } catch (e) {
+      print('[ERROR] Camera load overlay template failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  int clearOverlayTemplate() {
+    try {
+      return _clearOverlayTemplate();
+    } catch (e) {
+      print('[ERROR] Camera clear overlay template failed: $e');
+      return -999;
+    }
+  }
+
+  /// Composite the loaded template over tightly packed BGRA [pixels] in
+  /// place, e.g. for the framed preview. 0 = done, -1 = no template
+  int applyOverlay(Uint8List pixels, int width, int height) {
+    if (width <= 0 || height <= 0 || pixels.length < width * height * 4) {
+      return -2;
+    }
+    final pixelsPtr = calloc<Uint8>(pixels.length);
+    try {
+      final native = pixelsPtr.asTypedList(pixels.length);
+      native.setAll(0, pixels);
+      final state = _applyOverlayBgra(pixelsPtr, width, height, width * 4);
+      if (state == 0) {
+        pixels.setAll(0, native);
+      }
+      return state;
+    } catch (e) {
+      print('[ERROR] Camera apply overlay failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pixelsPtr);
+    }
+  }
+
+  /// Keep template artwork converted in [directory] (null = off), so a
+  /// template whose PNGs were loaded before needs no decoding at all
+  int setTemplateCache(String? directory) {
+    final dirPtr = (directory ?? '').toNativeUtf16();
+    try {
+      return _setTemplateCache(dirPtr);
+    } catch (e) {
+      print('[ERROR] Camera set template cache failed: $e');
+      return -999;
+    } finally {
+      calloc.free(dirPtr);
+    }
+  }
+
+  ({int hits, int misses, int entries, int bytes})? getTemplateCacheStats() {
+    final statsPtr = calloc<CameraTemplateCacheStats>();
+    try {
+      if (_getTemplateCacheStats(statsPtr) != 0) {
+        return null;
+      }
+      final stats = statsPtr.ref;
+      return (hits: stats.hits, misses: stats.misses, entries: stats.entries, bytes: stats.bytes);
+    } catch (e) {
+      print('[ERROR] Camera get template cache stats failed: $e');
+      return null;
+    } finally {
+      calloc.free(statsPtr);
+    }
+  }
+
+  /// Grade live view and every print and sheet with the .cube LUT at [path]
+  /// until [clearColorLut]. Returns the LUT size, or -4 when the file cannot
+  /// be read or is not a 3D .cube (the previous look stays)
+  int loadColorLut(String path) {
+    final pathPtr = path.toNativeUtf16();
+    try {
+      return _loadColorLut(pathPtr);
+    } catch (e) {
+      print('[ERROR] Camera load color LUT failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  int clearColorLut() {
+    try {
+      return _clearColorLut();
+    } catch (e) {
+      print('[ERROR] Camera clear color LUT failed: $e');
+      return -999;
+    }
+  }
+
+  /// Grade tightly packed BGRA [pixels] in place with the loaded LUT, e.g.
+  /// a captured still shown before printing. 0 = done, -1 = no LUT
+  int applyColorLut(Uint8List pixels, int width, int height) {
+    if (width <= 0 || height <= 0 || pixels.length < width * height * 4) {
+      return -2;
+    }
+    final pixelsPtr = calloc<Uint8>(pixels.length);
+    try {
+      final native = pixelsPtr.asTypedList(pixels.length);
+      native.setAll(0, pixels);
+      final state = _applyColorLutBgra(pixelsPtr, width, height, width * 4);
+      if (state == 0) {
+        pixels.setAll(0, native);
+      }
+      return state;
+    } catch (e) {
+      print('[ERROR] Camera apply color LUT failed: $e');
+      return -999;
+    } finally {
+      calloc.free(pixelsPtr);
+    }
+  }
+
+  /// Encode tightly packed BGRA [pixels] to JPEG on the native worker pool.
+  /// [optimizeHuffman] fits the tables to the image (a few % smaller);
+  /// [targetBytes] > 0 picks the highest quality up to [quality] whose file
+  /// fits. [dpi] is written to the JFIF header. Null on failure, including a
+  /// [targetBytes] that even quality 1 cannot meet
+  Uint8List? encodeJpeg(Uint8List pixels, int width, int height,
+      {int quality = 90,
+      bool optimizeHuffman = false,
+      bool subsampleChroma = true,
+      int dpi = 0,
+      int targetBytes = 0}) {
+    if (width <= 0 || height <= 0 || pixels.length < width * height * 4) {
+      return null;
+    }
+    final pixelsPtr = calloc<Uint8>(pixels.length);
+    final optionsPtr = calloc<CameraJpegOptions>();
+    final bufferPtr = calloc<Pointer<Uint8>>();
+    final sizePtr = calloc<Uint64>();
+    final reportPtr = calloc<CameraJpegReport>();
+    try {
+      pixelsPtr.asTypedList(pixels.length).setAll(0, pixels);
+      optionsPtr.ref
+        ..quality = quality
+        ..optimizeHuffman = optimizeHuffman ? 1 : 0
+        ..subsampleChroma = subsampleChroma ? 1 : 0
+        ..dpi = dpi
+        ..targetBytes = targetBytes;
+      final state = _encodeJpegBgra(pixelsPtr, width, height, width * 4, optionsPtr, bufferPtr, sizePtr, reportPtr);
+      if (state == -8) {
+        print('[ERROR] Camera encode JPEG missed its target: ${reportPtr.ref.bytes} bytes at quality 1, '
+            'target $targetBytes');
+        return null;
+      }
+      if (state != 0) {
+        return null;
+      }
+      final buffer = bufferPtr.value;
+      final jpeg = Uint8List.fromList(buffer.asTypedList(sizePtr.value));
+      _freeBuffer(buffer);
+      return jpeg;
+    } catch (e) {
+      print('[ERROR] Camera encode JPEG failed: $e');
+      return null;
+    } finally {
+      calloc.free(pixelsPtr);
+      calloc.free(optionsPtr);
+      calloc.free(bufferPtr);
+      calloc.free(sizePtr);
+      calloc.free(reportPtr);
+    }
+  }
+
+  /// [startPrint] and wait until the page is spooled. Returns the final state
+  Future<int> printPhoto(Uint8List bytes,
+      {double widthIn = 6, double heightIn = 4, bool autoRotate = true, String? printerName}) async {
+    final started =
+        startPrint(bytes, widthIn: widthIn, heightIn: heightIn, autoRotate: autoRotate, printerName: printerName);
+    if (started != 0) {
+      return started;
+    }
+    return _waitForPrint();
+  }
+
+  /// [startPrintSheet] and wait until the sheet is spooled
+  Future<int> printSheet(List<Uint8List> images,
+      List<({double x, double y, double width, double height, int image})> cells,
+      {double widthIn = 2, double heightIn = 6, bool autoRotate = true, int background = 0xFFFFFF,
+      String? printerName}) async {
+    final started = startPrintSheet(images, cells,
+        widthIn: widthIn, heightIn: heightIn, autoRotate: autoRotate, background: background, printerName: printerName);
+    if (started != 0) {
+      return started;
+    }
+    return _waitForPrint();
+  }
+
+  Future<int> _waitForPrint() async {
+    while (true) {
+      await Future.delayed(const Duration(milliseconds: 50));
+      final status = getPrintStatus();
+      if (status.state != 1) {
+        return status.state;
+      }
+    }
+  }
+}
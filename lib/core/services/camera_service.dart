@@ -14,9 +14,51 @@ class CameraService {
   bool _isInitialized = false;
   bool _isLiveviewActive = false;
 
+  // Native pacing: frames are only pushed once the previous one was painted.
+  int _consumerId = 0;
+  int _lastSequence = 0;
+  bool _awaitingAck = false;
+  DateTime _deliveredAt = DateTime.fromMillisecondsSinceEpoch(0);
+  static const Duration _ackTimeout = Duration(milliseconds: 500);
+  FrameInfo? _lastFrameInfo;
+  int _framesMissed = 0;
+
+  // Frames go out as views of two native buffers, fetched into alternately.
+  // A buffer is only refilled once the frame shown from it was painted or
+  // dropped, so the UI never sees bytes change under it. Kept until dispose():
+  // the last views may still be referenced after live view stops.
+  final List<NativeFrameBuffer> _frameBuffers = [];
+  final List<Uint8List?> _framesInUse = [null, null];
+  Uint8List? _latestFrame;
+
+  // Stills are transferred natively in the background; poll until they land.
+  final Map<int, Completer<StillShot?>> _pendingStills = {};
+  final StreamController<StillShot> _stillController = StreamController<StillShot>.broadcast();
+  Timer? _stillTimer;
+  static const Duration _stillPollInterval = Duration(milliseconds: 20);
+
+  // Burst in progress: stills tagged with a burst index go here, in order.
+  StreamController<StillShot>? _burstController;
+  int _burstDelivered = 0;
+
+  // Live view is kept natively for this long so a boomerang can be cut from
+  // what just happened.
+  Duration _prerollWindow = const Duration(seconds: 4);
+  int _prerollMegabytes = 64;
+  static const Duration _boomerangPollInterval = Duration(milliseconds: 50);
+
   /// Stream of JPEG frames from live view
   Stream<Uint8List> get frameStream => _frameController.stream;
 
+  /// Every finished still, including shots fired from the camera body
+  Stream<StillShot> get stillStream => _stillController.stream;
+
+  /// Metadata of the most recent frame on [frameStream]
+  FrameInfo? get lastFrameInfo => _lastFrameInfo;
+
+  /// Frames the native side published that this service never fetched
+  int get framesMissed => _framesMissed;
+
   /// Check if camera is initialized
   bool get isInitialized => _isInitialized;
 
@@ -41,6 +83,19 @@ class CameraService {
     }
   }
 
+  /// Run on recorded live view frames from [directory] instead of a camera
+  /// (demos, benchmarks); everything else behaves as with a camera
+  Future<bool> initializeReplay(String directory, {int frameIntervalMs = 33}) async {
+    final result = _cameraFFI.initializeReplay(directory, frameIntervalMs: frameIntervalMs);
+    if (result != 0) {
+      print('[ERROR] Replay initialization failed with code: $result');
+      return false;
+    }
+    _isInitialized = true;
+    print('[OK] Replay initialized successfully');
+    return true;
+  }
+
   /// Terminate camera system
   Future<bool> terminate() async {
     try {
@@ -81,6 +136,15 @@ class CameraService {
       }
 
       _isLiveviewActive = true;
+      _cameraFFI.setPreroll(_prerollWindow.inSeconds, _prerollMegabytes);
+      if (_frameBuffers.isEmpty) {
+        _frameBuffers.addAll([NativeFrameBuffer(), NativeFrameBuffer()]);
+      }
+      _framesInUse.fillRange(0, _framesInUse.length, null);
+      _latestFrame = null;
+      _consumerId = _cameraFFI.registerConsumer();
+      _awaitingAck = false;
+      _cameraFFI.setFrameInterval((1000 / frameRateHz).round(), 500);
 
       // Start frame capture timer with initial delay
       Future.delayed(const Duration(seconds: 1), () {
@@ -113,6 +177,11 @@ class CameraService {
       _frameTimer?.cancel();
       _frameTimer = null;
 
+      if (_consumerId > 0) {
+        _cameraFFI.unregisterConsumer(_consumerId);
+        _consumerId = 0;
+      }
+
       final result = _cameraFFI.stopLiveview();
       _isLiveviewActive = false;
 
@@ -137,20 +206,387 @@ class CameraService {
       return;
     }
 
+    // Previous frame not painted yet: don't queue another one behind it
+    if (_awaitingAck && DateTime.now().difference(_deliveredAt) < _ackTimeout) {
+      return;
+    }
+
+    // Both buffers still on screen (acks timed out): wait for one to free up
+    final slot = _framesInUse.indexOf(null);
+    if (slot < 0 || slot >= _frameBuffers.length) {
+      return;
+    }
+
     try {
-      final frameData = _cameraFFI.getFrame();
-      if (frameData != null && frameData.isNotEmpty) {
-        _frameController.add(frameData);
+      final buffer = _frameBuffers[slot];
+      if (_cameraFFI.getFrameInto(buffer, _consumerId, _lastSequence) != 0) {
+        return;
+      }
+
+      final info = FrameInfo.fromDesc(buffer.desc);
+      _lastSequence = info.sequence;
+      _lastFrameInfo = info;
+      _framesMissed += info.framesMissed;
+      // Nothing changed on screen; skip the decode and repaint
+      if (info.isDuplicate) {
+        _cameraFFI.ackFrame(_consumerId, _lastSequence);
+        return;
       }
+      _awaitingAck = true;
+      _deliveredAt = DateTime.now();
+      final frame = Uint8List.sublistView(buffer.storage, 0, buffer.length);
+      _framesInUse[slot] = frame;
+      _latestFrame = frame;
+      _frameController.add(frame);
     } catch (e) {
       print('[ERROR] Frame capture exception: $e');
     }
   }
 
+  /// Call once [frame] from [frameStream] has been painted. Its buffer is
+  /// refilled afterwards, so the bytes must not be read again.
+  void acknowledgeFrame(Uint8List frame) {
+    releaseFrame(frame);
+    if (!_awaitingAck || !identical(frame, _latestFrame)) {
+      return;
+    }
+    _awaitingAck = false;
+    if (_consumerId > 0) {
+      _cameraFFI.ackFrame(_consumerId, _lastSequence);
+    }
+  }
+
+  /// Call for a frame from [frameStream] that will not be painted (replaced
+  /// before it was shown, or its view went away); frees its buffer.
+  void releaseFrame(Uint8List frame) {
+    for (var i = 0; i < _framesInUse.length; i++) {
+      if (identical(_framesInUse[i], frame)) {
+        _framesInUse[i] = null;
+      }
+    }
+  }
+
+
+  /// Throttle live view while nobody is in front of the booth.
+  /// After [idleAfter] without motion only one frame per [trickle] is
+  /// captured and nothing is delivered until motion returns.
+  bool setIdleMode({
+    required bool enabled,
+    Duration idleAfter = const Duration(seconds: 30),
+    Duration trickle = const Duration(seconds: 1),
+  }) {
+    final result = _cameraFFI.setIdleMode(
+      enabled,
+      idleAfter.inMilliseconds,
+      trickle.inMilliseconds,
+    );
+    if (result != 0) {
+      print('[ERROR] Set idle mode failed with code: $result');
+      return false;
+    }
+    return true;
+  }
+
+  /// Leave idle mode right away (e.g. on touch)
+  void wake() {
+    _cameraFFI.wake();
+  }
+
+  /// How much change counts as motion for idle mode. Raise [cellThreshold]
+  /// for noisy scenes (flicker, dim light); lower [minChangedPermille] to
+  /// wake on smaller movements far from the camera.
+  bool setMotionSensitivity({int cellThreshold = 10, int minChangedPermille = 8}) {
+    final result = _cameraFFI.setMotionSensitivity(cellThreshold, minChangedPermille);
+    if (result != 0) {
+      print('[ERROR] Set motion sensitivity failed with code: $result');
+      return false;
+    }
+    return true;
+  }
+
+  /// Idle mode counters, e.g. for the operator screen
+  ({
+    int framesCaptured,
+    int framesPublished,
+    int framesSkipped,
+    int wakeCount,
+    int idleMsTotal,
+    int lastWakeLatencyUs,
+    bool idle,
+  })? get idleStats => _cameraFFI.getIdleStats();
+
+  /// How much live view [boomerang] can reach back into (0 disables it).
+  /// Applies now and to every later live view session.
+  bool setPreroll({required Duration window, int maxMegabytes = 64}) {
+    final result = _cameraFFI.setPreroll(window.inSeconds, maxMegabytes);
+    if (result != 0) {
+      print('[ERROR] Set preroll failed with code: $result');
+      return false;
+    }
+    _prerollWindow = window;
+    _prerollMegabytes = maxMegabytes;
+    return true;
+  }
+
+  /// Turn the last [length] of live view into a looping forward+reverse GIF
+  /// at [outputPath]. Encoding runs natively in the background while live
+  /// view continues. Completes with the path, or null on failure.
+  Future<String?> boomerang(
+    String outputPath, {
+    Duration length = const Duration(seconds: 2),
+    int maxSide = 480,
+    int fps = 15,
+  }) async {
+    if (!_isLiveviewActive) {
+      print('[ERROR] Live view not active');
+      return null;
+    }
+
+    final result = _cameraFFI.startBoomerang(outputPath, length.inSeconds, maxSide: maxSide, fps: fps);
+    if (result != 0) {
+      print('[ERROR] Boomerang failed with code: $result');
+      return null;
+    }
+
+    var status = _cameraFFI.getBoomerangStatus();
+    while (status.state == 1) {
+      await Future.delayed(_boomerangPollInterval);
+      status = _cameraFFI.getBoomerangStatus();
+    }
+    if (status.state != 0) {
+      print('[ERROR] Boomerang encode failed with code: ${status.state}');
+      return null;
+    }
+
+    print('[OK] Boomerang encoded in ${status.encodeUs ~/ 1000} ms');
+    return outputPath;
+  }
+
+  /// Record live view to an MJPEG AVI at [outputPath] until [stopRecording].
+  /// Frames are stored as the camera sent them, so recording costs no
+  /// encoding and does not slow live view down.
+  bool startRecording(String outputPath, {int fps = 30}) {
+    if (!_isLiveviewActive) {
+      print('[ERROR] Live view not active');
+      return false;
+    }
+    final result = _cameraFFI.startRecording(outputPath, fps);
+    if (result != 0) {
+      print('[ERROR] Start recording failed with code: $result');
+      return false;
+    }
+    return true;
+  }
+
+  /// Finish the recording started with [startRecording]
+  bool stopRecording() {
+    final result = _cameraFFI.stopRecording();
+    if (result != 0) {
+      print('[ERROR] Stop recording failed with code: $result');
+      return false;
+    }
+    final stats = _cameraFFI.getRecordingStats();
+    if (stats != null) {
+      print('[OK] Recording finished: ${stats.framesWritten} frames '
+          '(${stats.framesRepeated} repeated, ${stats.framesDropped} dropped), ${stats.bytesWritten} bytes');
+    }
+    return true;
+  }
+
+  /// Counters of the current or last recording
+  ({int framesWritten, int framesRepeated, int framesDropped, int bytesWritten, bool recording})?
+      get recordingStats => _cameraFFI.getRecordingStats();
+
+  /// Mirror live view into shared memory so a second-screen or analytics
+  /// process can read frames without touching the camera
+  bool enableSharedFrames({String name = 'sface_evf', int slotCount = 4, int slotMegabytes = 2}) {
+    final result = _cameraFFI.enableSharedFrames(name, slotCount, slotMegabytes);
+    if (result != 0) {
+      print('[ERROR] Enable shared frames failed with code: $result');
+      return false;
+    }
+    return true;
+  }
+
+  /// Spool stills to [directory] instead of memory: [StillShot.path] is set
+  /// and [StillShot.data] stays null. Pass null to go back to memory.
+  bool setStillSpool(String? directory) {
+    final result = _cameraFFI.setStillSpool(directory);
+    if (result != 0) {
+      print('[ERROR] Set still spool failed with code: $result');
+      return false;
+    }
+    return true;
+  }
+
+  /// Take a full-resolution picture while live view keeps running.
+  /// Completes with the transferred file, or null on failure.
+  Future<StillShot?> takePicture() {
+    if (!_isInitialized) {
+      print('[ERROR] Camera not initialized');
+      return Future.value(null);
+    }
+
+    final shotId = _cameraFFI.takePicture();
+    if (shotId <= 0) {
+      print('[ERROR] Take picture failed with code: $shotId');
+      return Future.value(null);
+    }
+
+    final completer = Completer<StillShot?>();
+    _pendingStills[shotId] = completer;
+    _stillTimer ??= Timer.periodic(_stillPollInterval, _pollStills);
+    return completer.future;
+  }
+
+  /// Take a picture on the end of a [countdown] shown by the UI. The native
+  /// side half-presses [prefocusLead] before zero and releases on zero,
+  /// compensating for the body's shutter lag.
+  Future<StillShot?> countdownCapture({
+    required Duration countdown,
+    Duration prefocusLead = const Duration(milliseconds: 800),
+  }) async {
+    if (!_isInitialized) {
+      print('[ERROR] Camera not initialized');
+      return null;
+    }
+
+    final result = _cameraFFI.startCountdownCapture(
+      countdown.inMilliseconds,
+      prefocusLead.inMilliseconds,
+    );
+    if (result != 0) {
+      print('[ERROR] Countdown capture failed with code: $result');
+      return null;
+    }
+
+    var status = _cameraFFI.getCountdownStatus();
+    while (status.state == 1) {
+      await Future.delayed(_stillPollInterval);
+      status = _cameraFFI.getCountdownStatus();
+    }
+    if (status.state != 0 || status.shotId <= 0) {
+      print('[ERROR] Countdown capture failed with code: ${status.error}');
+      return null;
+    }
+
+    print('[OK] Countdown shot ${status.shotId}: release ${status.zeroToReleaseUs} us from zero '
+        '(shutter lag ${status.shutterLagUs} us, prefocused: ${status.prefocused})');
+
+    final completer = Completer<StillShot?>();
+    _pendingStills[status.shotId] = completer;
+    _stillTimer ??= Timer.periodic(_stillPollInterval, _pollStills);
+    return completer.future;
+  }
+
+  /// Abort a running countdown capture
+  void cancelCountdown() {
+    _cameraFFI.cancelCountdown();
+  }
+
+  /// Photo-strip burst: [count] shots, the first after [firstDelay] and then
+  /// every [interval]. Each transfer overlaps the next countdown; stills are
+  /// emitted in shot order as they land and the stream closes after the last.
+  Stream<StillShot> burstCapture({
+    required int count,
+    required Duration interval,
+    Duration firstDelay = Duration.zero,
+    Duration prefocusLead = const Duration(milliseconds: 800),
+  }) {
+    final controller = StreamController<StillShot>();
+    if (!_isInitialized || _burstController != null) {
+      controller.addError(StateError('Camera not ready for a burst'));
+      controller.close();
+      return controller.stream;
+    }
+
+    final result = _cameraFFI.startBurst(
+      count,
+      interval.inMilliseconds,
+      firstDelay.inMilliseconds,
+      prefocusLead.inMilliseconds,
+    );
+    if (result != 0) {
+      print('[ERROR] Burst capture failed with code: $result');
+      controller.addError(StateError('Burst capture failed with code: $result'));
+      controller.close();
+      return controller.stream;
+    }
+
+    _burstController = controller;
+    _burstDelivered = 0;
+    _stillTimer ??= Timer.periodic(_stillPollInterval, _pollStills);
+    return controller.stream;
+  }
+
+  /// Stop a running burst; stills already fired are still delivered
+  void cancelBurst() {
+    _cameraFFI.cancelBurst();
+  }
+
+  void _finishBurstIfDone() {
+    final controller = _burstController;
+    if (controller == null) {
+      return;
+    }
+    final status = _cameraFFI.getBurstStatus();
+    if (status.state == 1 || _burstDelivered < status.fired) {
+      return;
+    }
+    print('[OK] Burst finished: ${status.fired}/${status.count} shots, '
+        'releases spanned ${status.elapsedUs ~/ 1000} ms');
+    _burstController = null;
+    controller.close();
+  }
+
+  void _pollStills(Timer timer) {
+    StillShot? shot;
+    while ((shot = _cameraFFI.getStill()) != null) {
+      final still = shot!;
+      if (still.burstIndex >= 0 && _burstController != null) {
+        _burstDelivered++;
+        if (still.isOk) {
+          _burstController!.add(still);
+        } else {
+          print('[ERROR] Burst shot ${still.burstIndex + 1} failed with code: ${still.error}');
+        }
+        continue;
+      }
+      if (still.isOk) {
+        print('[OK] Still ${still.shotId} ready in ${still.total.inMilliseconds} ms '
+            '(shutter ${still.shutterToEvent.inMilliseconds} ms, '
+            'download ${still.download.inMilliseconds} ms)');
+        _stillController.add(still);
+      } else {
+        print('[ERROR] Still ${still.shotId} failed with code: ${still.error}');
+      }
+      _pendingStills.remove(still.shotId)?.complete(still.isOk ? still : null);
+    }
+
+    _finishBurstIfDone();
+
+    if (_pendingStills.isEmpty && _burstController == null) {
+      timer.cancel();
+      _stillTimer = null;
+    }
+  }
+
   /// Dispose resources
   void dispose() {
     _frameTimer?.cancel();
+    _stillTimer?.cancel();
+    for (final completer in _pendingStills.values) {
+      completer.complete(null);
+    }
+    _pendingStills.clear();
+    _burstController?.close();
+    _burstController = null;
+    _stillController.close();
     _frameController.close();
+    for (final buffer in _frameBuffers) {
+      buffer.dispose();
+    }
+    _frameBuffers.clear();
     if (_isInitialized) {
       terminate();
     }
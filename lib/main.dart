@@ -1,12 +1,24 @@
+import 'dart:io';
+
 import 'package:dio/dio.dart';
 import 'package:flutter/material.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:flutter_dotenv/flutter_dotenv.dart';
+import 'core/native/camera_ffi.dart';
 import 'presentation/screens/main_screen.dart';
 
 void main() async {
   WidgetsFlutterBinding.ensureInitialized();
   await dotenv.load();
+  if (Platform.isWindows) {
+    // 재인쇄 시 렌더링 없이 바로 스풀되도록 인쇄 래스터 캐시 사용
+    CameraFFI.instance.setPrintCache('${Directory.systemTemp.path}\\sface_print_cache');
+    // 템플릿 PNG는 한 번만 변환해 두고 이후에는 디코딩 없이 매핑해서 사용
+    CameraFFI.instance.setTemplateCache('${Directory.systemTemp.path}\\sface_template_cache');
+    // 프린터 ICC 프로파일로 색 변환 (변환 테이블은 한 번 만들어 캐시)
+    CameraFFI.instance.setColorTransformCache('${Directory.systemTemp.path}\\sface_color_cache');
+    CameraFFI.instance.setPrintColorManagement();
+  }
   runApp(const ProviderScope(child: MyApp()));
 }
 
@@ -1,4 +1,5 @@
 import 'package:flutter/material.dart';
+import 'dart:io';
 import 'dart:typed_data';
 import '../../core/services/camera_service.dart';
 
@@ -15,6 +16,7 @@ class _DSLRCameraScreenState extends State<DSLRCameraScreen> {
   bool _isConnecting = false;
   bool _isConnected = false;
   bool _isLive = false;
+  bool _isMakingBoomerang = false;
   String _statusMessage = '카메라 연결을 시작하려면 아래 버튼을 누르세요';
   String _cameraName = 'Canon DSLR Camera';
 
@@ -61,11 +63,11 @@ class _DSLRCameraScreenState extends State<DSLRCameraScreen> {
                   children: [
                     // Full Screen Live View
                     Positioned.fill(
-                      child: Image.memory(
-                        snapshot.data!,
-                        fit: BoxFit.contain, // 전체 화면에 맞춤
-                        gaplessPlayback: true,
-                        filterQuality: FilterQuality.medium,
+                      // 프레임이 디코딩되고 실제로 그려진 뒤 네이티브에 알림 (backpressure)
+                      child: _LiveViewFrame(
+                        bytes: snapshot.data!,
+                        onPainted: _cameraService.acknowledgeFrame,
+                        onDropped: _cameraService.releaseFrame,
                       ),
                     ),
                 // Overlay Controls - Top
@@ -102,6 +104,16 @@ class _DSLRCameraScreenState extends State<DSLRCameraScreen> {
                         icon: const Icon(Icons.stop, color: Colors.white),
                         label: const Text('라이브뷰 정지', style: TextStyle(color: Colors.white)),
                       ),
+                      FloatingActionButton.extended(
+                        heroTag: "boomerang",
+                        onPressed: _isMakingBoomerang ? null : _makeBoomerang,
+                        backgroundColor: Colors.purple.withOpacity(_isMakingBoomerang ? 0.5 : 0.9),
+                        icon: const Icon(Icons.all_inclusive, color: Colors.white),
+                        label: Text(
+                          _isMakingBoomerang ? '부메랑 생성 중...' : '부메랑',
+                          style: const TextStyle(color: Colors.white),
+                        ),
+                      ),
                       FloatingActionButton.extended(
                         heroTag: "disconnect",
                         onPressed: _disconnectCamera,
@@ -381,6 +393,26 @@ class _DSLRCameraScreenState extends State<DSLRCameraScreen> {
     }
   }
 
+  // 방금 지나간 라이브뷰(pre-roll)로 부메랑 GIF 생성
+  Future<void> _makeBoomerang() async {
+    setState(() => _isMakingBoomerang = true);
+    try {
+      final path = '${Directory.systemTemp.path}${Platform.pathSeparator}'
+          'boomerang_${DateTime.now().millisecondsSinceEpoch}.gif';
+      final result = await _cameraService.boomerang(path);
+      if (!mounted) return;
+      if (result == null) {
+        _showErrorSnack('부메랑 생성 실패');
+      } else {
+        ScaffoldMessenger.of(context).showSnackBar(SnackBar(content: Text('부메랑 저장됨: $result')));
+      }
+    } finally {
+      if (mounted) {
+        setState(() => _isMakingBoomerang = false);
+      }
+    }
+  }
+
   Future<void> _disconnectCamera() async {
     try {
       await _cameraService.terminate();
@@ -410,3 +442,107 @@ class _DSLRCameraScreenState extends State<DSLRCameraScreen> {
     ScaffoldMessenger.of(context).showSnackBar(SnackBar(content: Text(msg)));
   }
 }
+
+/// 라이브뷰 프레임 한 장을 표시하고, 디코딩이 끝나 화면에 그려진 뒤
+/// [onPainted]를 호출한다. 빌드 시점이 아니라 표시 시점을 알려야
+/// 네이티브 FrameGovernor의 속도 조절이 실제 화면 속도를 따른다.
+/// 그려지기 전에 다음 프레임으로 바뀌거나 위젯이 사라지면 [onDropped].
+/// 어느 쪽이든 호출 뒤에는 [bytes]의 버퍼가 다시 채워질 수 있다.
+class _LiveViewFrame extends StatefulWidget {
+  const _LiveViewFrame({
+    required this.bytes,
+    required this.onPainted,
+    required this.onDropped,
+  });
+
+  final Uint8List bytes;
+  final ValueChanged<Uint8List> onPainted;
+  final ValueChanged<Uint8List> onDropped;
+
+  @override
+  State<_LiveViewFrame> createState() => _LiveViewFrameState();
+}
+
+class _LiveViewFrameState extends State<_LiveViewFrame> {
+  ImageStream? _stream;
+  ImageStreamListener? _listener;
+  Uint8List? _pending; // 아직 그려졌다고 알리지 않은 프레임
+
+  @override
+  void initState() {
+    super.initState();
+    _listen();
+  }
+
+  @override
+  void didUpdateWidget(covariant _LiveViewFrame oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (!identical(oldWidget.bytes, widget.bytes)) {
+      _listen();
+    }
+  }
+
+  @override
+  void dispose() {
+    _stopListening();
+    _drop();
+    super.dispose();
+  }
+
+  void _drop() {
+    final pending = _pending;
+    _pending = null;
+    if (pending != null) {
+      widget.onDropped(pending);
+    }
+  }
+
+  // 아래 Image와 같은 MemoryImage 키라 ImageCache에서 같은 디코딩을 공유한다
+  void _listen() {
+    _stopListening();
+    _drop();
+    final bytes = widget.bytes;
+    final onPainted = widget.onPainted;
+    _pending = bytes;
+    void done() {
+      _stopListening();
+      if (identical(_pending, bytes)) {
+        _pending = null;
+        onPainted(bytes);
+      }
+    }
+
+    final listener = ImageStreamListener(
+      (_, __) {
+        _stopListening();
+        // 디코딩 완료 → 다음 프레임에서 그려진 뒤 알림
+        WidgetsBinding.instance.addPostFrameCallback((_) => done());
+      },
+      // 깨진 프레임도 처리는 끝났으므로 파이프라인을 막지 않는다
+      onError: (_, __) => done(),
+    );
+    final stream = MemoryImage(bytes).resolve(ImageConfiguration.empty);
+    _stream = stream;
+    _listener = listener;
+    stream.addListener(listener); // 이미 디코딩된 프레임이면 바로 호출된다
+  }
+
+  void _stopListening() {
+    final listener = _listener;
+    if (listener != null) {
+      _stream?.removeListener(listener);
+    }
+    _stream = null;
+    _listener = null;
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return Image(
+      image: MemoryImage(widget.bytes),
+      fit: BoxFit.contain, // 전체 화면에 맞춤
+      gaplessPlayback: true,
+      filterQuality: FilterQuality.medium,
+    );
+  }
+}
@@ -12,6 +12,7 @@ import 'package:pdf/widgets.dart' as pw;
 import 'package:printing/printing.dart';
 
 import '../../data/models/photogoods/search_photogoods.dart';
+import '../../utils/jpeg_encode.dart';
 import 'print_preview_dialog_simple.dart';
 
 class PhotoDetailDialog extends StatefulWidget {
@@ -408,9 +409,7 @@ class _PhotoDetailDialogState extends State<PhotoDetailDialog> {
         height: targetH,
         interpolation: img.Interpolation.cubic,
       );
-      final Uint8List outJpg = Uint8List.fromList(
-        img.encodeJpg(resized, quality: 100),
-      );
+      final Uint8List outJpg = encodePhotoJpeg(resized, quality: 100, dpi: 600);
       // Windows: 직접 프린터로 전송 (UI 없이)
       if (Platform.isWindows) {
         final Directory tempDir = Directory.systemTemp;
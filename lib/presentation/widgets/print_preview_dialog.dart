@@ -6,9 +6,9 @@ import 'package:dio/dio.dart';
 import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
 import 'package:image/image.dart' as img;
-import 'package:pdf/pdf.dart';
-import 'package:pdf/widgets.dart' as pw;
-import 'package:printing/printing.dart';
+
+import '../../core/native/camera_ffi.dart';
+import '../../utils/jpeg_encode.dart';
 
 class PrintPreviewDialog extends StatefulWidget {
   final String imageUrl;
@@ -20,6 +20,7 @@ class PrintPreviewDialog extends StatefulWidget {
 }
 
 class _PrintPreviewDialogState extends State<PrintPreviewDialog> {
+  Uint8List? originalImageBytes;
   Uint8List? processedImageBytes;
   bool isProcessing = true;
   String? errorMessage;
@@ -30,57 +31,6 @@ class _PrintPreviewDialogState extends State<PrintPreviewDialog> {
     _processImage();
   }
 
-  Future<void> kioskPrintFillNoMargin(
-    Uint8List imageBytes, {
-    double inchWidth = 6,
-    double inchHeight = 4,
-  }) async {
-    // 1) 대상 프린터 선택 (기본 프린터 또는 이름 힌트로 검색)
-    final printers = await Printing.listPrinters();
-    Printer? target;
-
-    // 힌트가 없으면 기본 프린터 → 없으면 첫 번째
-    target = printers.firstWhere(
-      (p) => p.isDefault,
-      orElse: () => printers.first,
-    );
-
-    // 2) PDF 페이지 포맷: 정확히 6x4 inch, 여백 0
-    final PdfPageFormat pageFormat = PdfPageFormat(
-      inchWidth * PdfPageFormat.inch,
-      inchHeight * PdfPageFormat.inch,
-      marginAll: 0,
-
-    );
-
-    // 3) 문서 생성
-    final doc = pw.Document();
-
-    // 4) 이미지 로드
-    final memImage = pw.MemoryImage(imageBytes);
-
-    // 5) 페이지에 "FILL(cover)"로 이미지를 채움
-    doc.addPage(
-      pw.Page(
-        pageFormat: pageFormat,
-        build: (_) => pw.Stack(
-          children: [
-            // FILL: 종이를 가득 채움 (잘림 감수)
-            pw.Positioned.fill(child: pw.Image(memImage, fit: pw.BoxFit.cover)),
-            // 만약 잘림 없이 전체가 꼭 보여야 하면 BoxFit.contain을 쓰고,
-            // 대신 위/아래 또는 좌/우에 여백이 생길 수 있음.
-          ],
-        ),
-      ),
-    );
-    await Printing.directPrintPdf(
-      printer: target, // 특정 프린터로 전송
-      format: pageFormat, // 인치 기반 용지 크기(여백 0)
-      onLayout: (_) async => doc.save(),
-      name: 'kiosk-6x4-fill', // 인쇄 작업 이름(선택)
-    );
-  }
-
   Future<void> _processImage() async {
     try {
       setState(() {
@@ -144,13 +94,12 @@ class _PrintPreviewDialogState extends State<PrintPreviewDialog> {
         interpolation: img.Interpolation.cubic,
       );
 
-      // JPEG로 인코딩 (고품질)
-      final Uint8List outJpg = Uint8List.fromList(
-        img.encodeJpg(resized, quality: 95),
-      );
+      // JPEG로 인코딩 (고품질, Windows는 네이티브 병렬 인코더)
+      final Uint8List outJpg = encodePhotoJpeg(resized, quality: 95, dpi: 300);
 
       if (mounted) {
         setState(() {
+          originalImageBytes = bytes;
           processedImageBytes = outJpg;
           isProcessing = false;
         });
@@ -167,15 +116,18 @@ class _PrintPreviewDialogState extends State<PrintPreviewDialog> {
   }
 
   Future<void> _printImage() async {
-    if (processedImageBytes == null) return;
+    if (originalImageBytes == null) return;
 
     try {
-      // kioskPrintFillNoMargin 함수를 사용하여 6x4 inch (152x101mm) 크기로 프린트
-      await kioskPrintFillNoMargin(
-        processedImageBytes!,
-        inchWidth: 6, // 6 inch 가로 (152mm)
-        inchHeight: 4, // 4 inch 세로 (101mm)
+      // 원본을 네이티브로 6x4 inch (152x101mm) 테두리 없이 프린터 해상도에 맞춰 인쇄
+      final int state = await CameraFFI.instance.printPhoto(
+        originalImageBytes!,
+        widthIn: 6, // 6 inch 가로 (152mm)
+        heightIn: 4, // 4 inch 세로 (101mm)
       );
+      if (state != 0) {
+        throw Exception('프린트 실패 (코드 $state)');
+      }
 
       if (!mounted) return;
       Navigator.of(context).pop(); // 프리뷰 다이얼로그 닫기
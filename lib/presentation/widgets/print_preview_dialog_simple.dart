@@ -1,14 +1,11 @@
 import 'dart:developer';
-import 'dart:io';
 import 'dart:typed_data';
 
 import 'package:dio/dio.dart';
 import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
-import 'package:image/image.dart' as img;
-import 'package:pdf/pdf.dart';
-import 'package:pdf/widgets.dart' as pw;
-import 'package:printing/printing.dart';
+
+import '../../core/native/camera_ffi.dart';
 
 class PrintPreviewDialogSimple extends StatefulWidget {
   final String imageUrl;
@@ -21,6 +18,10 @@ class PrintPreviewDialogSimple extends StatefulWidget {
 }
 
 class _PrintPreviewDialogSimpleState extends State<PrintPreviewDialogSimple> {
+  // 재인쇄 시 다시 다운로드하지 않도록 최근 원본을 보관 (URL 기준)
+  static final Map<String, Uint8List> _downloaded = {};
+  static const int _maxDownloaded = 8;
+
   Uint8List? originalImageBytes;
   bool isProcessing = true;
   String? errorMessage;
@@ -39,6 +40,16 @@ class _PrintPreviewDialogSimpleState extends State<PrintPreviewDialogSimple> {
         errorMessage = null;
       });
 
+      final Uint8List? cached = _downloaded.remove(widget.imageUrl);
+      if (cached != null) {
+        _downloaded[widget.imageUrl] = cached; // 최근 사용으로 갱신
+        setState(() {
+          originalImageBytes = cached;
+          isProcessing = false;
+        });
+        return;
+      }
+
       // 이미지 다운로드만 함
       final Response<List<int>> res = await Dio().get<List<int>>(
         widget.imageUrl,
@@ -49,10 +60,15 @@ class _PrintPreviewDialogSimpleState extends State<PrintPreviewDialogSimple> {
       );
       final Uint8List bytes = Uint8List.fromList(res.data ?? <int>[]);
 
-      // 이미지가 유효한지만 확인
-      final img.Image? testImage = img.decodeImage(bytes);
-      if (testImage == null) {
-        throw Exception('이미지를 디코딩할 수 없습니다');
+      // 이미지가 유효한지만 확인 (헤더 구조만 검사, 디코딩 없음)
+      final check = CameraFFI.instance.validateImage(bytes);
+      if (check.state != 0) {
+        throw Exception('이미지를 디코딩할 수 없습니다 (코드 ${check.state})');
+      }
+
+      _downloaded[widget.imageUrl] = bytes;
+      if (_downloaded.length > _maxDownloaded) {
+        _downloaded.remove(_downloaded.keys.first);
       }
 
       // 원본 바이트를 그대로 저장
@@ -73,287 +89,21 @@ class _PrintPreviewDialogSimpleState extends State<PrintPreviewDialogSimple> {
     }
   }
 
-  // 기본 프린터 이름을 가져오는 함수
-  Future<String?> _getDefaultPrinterName() async {
-    try {
-      // 방법 1: PowerShell Get-CimInstance 사용 (최신 방법)
-      try {
-        final ProcessResult psResult = await Process.run('powershell', [
-          '-Command',
-          'Get-CimInstance -ClassName Win32_Printer | Where-Object {.Default -eq true} | Select-Object -ExpandProperty Name',
-        ]);
-
-        if (psResult.exitCode == 0) {
-          final String printerName = psResult.stdout.toString().trim();
-          if (printerName.isNotEmpty) {
-            log(
-              'Found default printer via PowerShell Get-CimInstance: $printerName',
-            );
-            return printerName;
-          }
-        }
-      } catch (e) {
-        log('PowerShell Get-CimInstance failed: $e');
-      }
-
-      // 방법 2: PowerShell Get-WmiObject 사용 (구버전 호환)
-      try {
-        final ProcessResult psResult = await Process.run('powershell', [
-          '-Command',
-          'Get-WmiObject -Class Win32_Printer | Where-Object Default -eq true | Select-Object -ExpandProperty Name',
-        ]);
-
-        if (psResult.exitCode == 0) {
-          final String printerName = psResult.stdout.toString().trim();
-          if (printerName.isNotEmpty) {
-            log(
-              'Found default printer via PowerShell Get-WmiObject: $printerName',
-            );
-            return printerName;
-          }
-        }
-      } catch (e) {
-        log('PowerShell Get-WmiObject failed: $e');
-      }
-
-      // 방법 3: 레지스트리에서 기본 프린터 확인
-      try {
-        final ProcessResult regResult = await Process.run('reg', [
-          'query',
-          'HKEY_CURRENT_USER\\Software\\Microsoft\\Windows NT\\CurrentVersion\\Windows',
-          '/v',
-          'Device',
-        ]);
-
-        if (regResult.exitCode == 0) {
-          final String output = regResult.stdout.toString();
-          final RegExp devicePattern = RegExp(r'Device\s+REG_SZ\s+(.+)');
-          final Match? match = devicePattern.firstMatch(output);
-          if (match != null) {
-            final String deviceInfo = match.group(1) ?? '';
-            // Device 값은 "프린터명,winspool,Ne00:" 형태
-            final List<String> parts = deviceInfo.split(',');
-            if (parts.isNotEmpty) {
-              final String printerName = parts[0].trim();
-              log('Found default printer via Registry: $printerName');
-              return printerName;
-            }
-          }
-        }
-      } catch (e) {
-        log('Registry query failed: $e');
-      }
-
-      // 방법 4: rundll32.exe로 프린터 목록 가져오기 (최후 수단)
-      try {
-        final ProcessResult printResult = await Process.run('powershell', [
-          '-Command',
-          'Get-Printer | Where-Object Type -eq "Local" | Select-Object -First 1 -ExpandProperty Name',
-        ]);
-
-        if (printResult.exitCode == 0) {
-          final String printerName = printResult.stdout.toString().trim();
-          if (printerName.isNotEmpty) {
-            log('Found first available printer: $printerName');
-            return printerName;
-          }
-        }
-      } catch (e) {
-        log('Get-Printer failed: $e');
-      }
-
-      log('All methods failed to find default printer');
-      return null;
-    } catch (e) {
-      log('Failed to get default printer: $e');
-      return null;
-    }
-  }
-
-  // IrfanView 설치 경로를 찾는 함수
-  Future<String?> _findIrfanViewPath() async {
-    final List<String> possiblePaths = [
-      'C:\\Program Files\\IrfanView\\i_view64.exe',
-      'C:\\Program Files (x86)\\IrfanView\\i_view32.exe',
-      'C:\\IrfanView\\i_view64.exe',
-      'C:\\IrfanView\\i_view32.exe',
-      'C:\\Programs\\IrfanView\\i_view64.exe',
-      'C:\\Programs\\IrfanView\\i_view32.exe',
-    ];
-
-    for (String path in possiblePaths) {
-      final File file = File(path);
-      if (await file.exists()) {
-        log('Found IrfanView at: $path');
-        return path;
-      }
-    }
-
-    // 레지스트리에서 IrfanView 설치 경로 찾기
-    try {
-      final ProcessResult regResult = await Process.run('reg', [
-        'query',
-        'HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Uninstall\\IrfanView',
-        '/v',
-        'InstallLocation',
-      ]);
-
-      if (regResult.exitCode == 0) {
-        final String output = regResult.stdout.toString();
-        final RegExp pathPattern = RegExp(r'InstallLocation\s+REG_SZ\s+(.+)');
-        final Match? match = pathPattern.firstMatch(output);
-        if (match != null) {
-          final String installPath = match.group(1)?.trim() ?? '';
-          final List<String> exeNames = ['i_view64.exe', 'i_view32.exe'];
-
-          for (String exeName in exeNames) {
-            final String fullPath = '$installPath\\$exeName';
-            if (await File(fullPath).exists()) {
-              log('Found IrfanView via registry at: $fullPath');
-              return fullPath;
-            }
-          }
-        }
-      }
-    } catch (e) {
-      log('Registry query for IrfanView failed: $e');
-    }
-
-    return null;
-  }
-
-  // IrfanView를 사용한 이미지 프린트
-  Future<void> printImageWithIrfanView(Uint8List imageBytes) async {
-    try {
-      // 1) IrfanView 경로 찾기
-      final String? irfanViewPath = await _findIrfanViewPath();
-
-      if (irfanViewPath == null) {
-        throw Exception('IrfanView가 설치되어 있지 않습니다');
-      }
-
-      // 2) 임시 이미지 파일 생성
-      final Directory tempDir = Directory.systemTemp;
-      final String filePath =
-          '${tempDir.path}\\sface_print_${DateTime.now().millisecondsSinceEpoch}.jpg';
-      final File file = File(filePath);
-      await file.writeAsBytes(imageBytes, flush: true);
-
-      // 3) 기본 프린터 이름 가져오기
-      final String? printerName = await _getDefaultPrinterName();
-
-      ProcessResult result;
-      if (printerName != null) {
-        // 4) 특정 프린터로 IrfanView 프린트
-        result = await Process.run(irfanViewPath, [
-          filePath,
-          '/print="$printerName"',
-        ]);
-        log(
-          'IrfanView print to specific printer result: exitCode=${result.exitCode}, stdout=${result.stdout}, stderr=${result.stderr}',
-        );
-      } else {
-        // 4) 기본 프린터로 IrfanView 프린트
-        result = await Process.run(irfanViewPath, [filePath, '/print']);
-        log(
-          'IrfanView print to default printer result: exitCode=${result.exitCode}, stdout=${result.stdout}, stderr=${result.stderr}',
-        );
-      }
-
-      // 잠시 대기 후 임시 파일 삭제
-      await Future.delayed(const Duration(seconds: 3));
-      try {
-        await file.delete();
-      } catch (e) {
-        log('Failed to delete temp file: $e');
-      }
-    } catch (e) {
-      log('IrfanView print error: $e');
-      rethrow;
-    }
-  }
-
-  // rundll32.exe를 사용한 직접 이미지 프린트
-  Future<void> printImageWithRundll32(Uint8List imageBytes) async {
-    try {
-      // 1) 임시 이미지 파일 생성
-      final Directory tempDir = Directory.systemTemp;
-      final String filePath =
-          '${tempDir.path}\\sface_print_${DateTime.now().millisecondsSinceEpoch}.jpg';
-      final File file = File(filePath);
-      await file.writeAsBytes(imageBytes, flush: true);
-
-      // 2) 기본 프린터 이름 가져오기
-      final String? printerName = await _getDefaultPrinterName();
-
-      if (printerName == null) {
-        // 프린터를 찾지 못한 경우 프린터 이름 없이 시도 (기본 프린터 사용)
-        log('No printer name found, trying without printer name parameter');
-        final ProcessResult result = await Process.run('rundll32.exe', [
-          'C:\\WINDOWS\\System32\\shimgvw.dll,ImageView_PrintTo',
-          filePath,
-          '', // 빈 문자열로 기본 프린터 사용
-        ]);
-
-        log(
-          'Rundll32 print result (no printer name): exitCode=${result.exitCode}, stdout=${result.stdout}, stderr=${result.stderr}',
-        );
-
-        // 그래도 실패하면 다른 방법 시도
-        if (result.exitCode != 0) {
-          log(
-            'Trying alternative: opening file with default image viewer for printing',
-          );
-          // Windows의 기본 이미지 뷰어로 열기 (사용자가 직접 프린트할 수 있음)
-          await Process.run('cmd', ['/c', 'start', '/wait', filePath]);
-        }
-      } else {
-        // 3) rundll32.exe로 이미지 프린트
-        final ProcessResult result = await Process.run('rundll32.exe', [
-          'C:\\WINDOWS\\System32\\shimgvw.dll,ImageView_PrintTo',
-          filePath,
-          printerName,
-        ]);
-
-        log(
-          'Rundll32 print result: exitCode=${result.exitCode}, stdout=${result.stdout}, stderr=${result.stderr}',
-        );
-      }
-
-      // 잠시 대기 후 임시 파일 삭제
-      await Future.delayed(const Duration(seconds: 3));
-      try {
-        await file.delete();
-      } catch (e) {
-        log('Failed to delete temp file: $e');
-      }
-    } catch (e) {
-      log('Rundll32 print error: $e');
-      rethrow;
-    }
-  }
-
   Future<void> _printImage() async {
     if (originalImageBytes == null) return;
 
     try {
-      String printMethod = '';
-
-      // 1) IrfanView 방식을 먼저 시도
-      try {
-        await printImageWithIrfanView(originalImageBytes!);
-        printMethod = 'IrfanView';
-      } catch (irfanError) {
-        log('IrfanView print failed, trying rundll32: $irfanError');
-
-        // 2) IrfanView 실패시 rundll32.exe 방식 시도
+      // 네이티브 프린트: 6x4 inch 테두리 없이 프린터 해상도로 바로 스풀
+      final int state = await CameraFFI.instance.printPhoto(originalImageBytes!);
+      if (state != 0) {
+        throw Exception('프린트 실패 (코드 $state)');
       }
 
       if (!mounted) return;
       Navigator.of(context).pop(); // 프리뷰 다이얼로그 닫기
       ScaffoldMessenger.of(context).showSnackBar(
-        SnackBar(
-          content: Text('$printMethod로 인쇄가 시작되었습니다'),
+        const SnackBar(
+          content: Text('6x4 inch 크기로 인쇄가 시작되었습니다'),
           backgroundColor: Colors.green,
         ),
       );
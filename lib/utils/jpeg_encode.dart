@@ -0,0 +1,29 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:image/image.dart' as img;
+
+import '../core/native/camera_ffi.dart';
+
+/// JPEG bytes of [image] for print files: the native parallel encoder on
+/// Windows (several times faster on a 6x4 in page), the Dart encoder on other
+/// platforms or when the native one is unavailable or fails
+Uint8List encodePhotoJpeg(img.Image image, {int quality = 95, int dpi = 0}) {
+  if (Platform.isWindows) {
+    try {
+      final Uint8List? jpeg = CameraFFI.instance.encodeJpeg(
+        image.convert(numChannels: 4).getBytes(order: img.ChannelOrder.bgra),
+        image.width,
+        image.height,
+        quality: quality,
+        dpi: dpi,
+      );
+      if (jpeg != null) {
+        return jpeg;
+      }
+    } catch (e) {
+      print('[ERROR] Native JPEG encoder unavailable: $e');
+    }
+  }
+  return Uint8List.fromList(img.encodeJpg(image, quality: quality));
+}
@@ -45,6 +45,16 @@ bool EdsdkBridge::Load(const std::wstring& dll_path) {
   EdsSendStatusCommand = reinterpret_cast<EdsError(*)(EdsCameraRef, EdsUInt32, EdsUInt32)>(sym("EdsSendStatusCommand"));
   EdsSetPropertyEventHandler = reinterpret_cast<PFN_EdsSetPropertyEventHandler>(GetProcAddress(dll_, "EdsSetPropertyEventHandler"));
 
+  EdsSetObjectEventHandler = reinterpret_cast<PFN_EdsSetObjectEventHandler>(sym("EdsSetObjectEventHandler"));
+  EdsSetCapacity          = reinterpret_cast<EdsError(*)(EdsCameraRef, EdsCapacity)>(sym("EdsSetCapacity"));
+  EdsGetDirectoryItemInfo = reinterpret_cast<EdsError(*)(EdsDirectoryItemRef, EdsDirectoryItemInfo*)>(sym("EdsGetDirectoryItemInfo"));
+  EdsDownload             = reinterpret_cast<EdsError(*)(EdsDirectoryItemRef, EdsUInt64, EdsStreamRef)>(sym("EdsDownload"));
+  EdsDownloadComplete     = reinterpret_cast<EdsError(*)(EdsDirectoryItemRef)>(sym("EdsDownloadComplete"));
+  EdsDownloadCancel       = reinterpret_cast<EdsError(*)(EdsDirectoryItemRef)>(sym("EdsDownloadCancel"));
+  EdsGetEvent             = reinterpret_cast<EdsError(*)()>(sym("EdsGetEvent"));
+  EdsCreateFileStream     = reinterpret_cast<EdsError(*)(const char*, EdsUInt32, EdsUInt32, EdsStreamRef*)>(sym("EdsCreateFileStream"));
+  EdsCreateFileStreamEx   = reinterpret_cast<EdsError(*)(const wchar_t*, EdsUInt32, EdsUInt32, EdsStreamRef*)>(sym("EdsCreateFileStreamEx"));
+
 
   // Hard-require the core ones:
   if (!EdsInitializeSDK || !EdsTerminateSDK || !EdsGetCameraList ||
@@ -56,7 +66,8 @@ bool EdsdkBridge::Load(const std::wstring& dll_path) {
     std::cerr << "[ERR] Required EDSDK symbols missing.\n";
     return false;
   }
-  // EdsSendCommand/EdsSendStatusCommand can be null (we guard before use)
+  // EdsSendCommand/EdsSendStatusCommand and the still-transfer functions
+  // can be null (we guard before use)
 
   return true;
 }
@@ -13,9 +13,13 @@ using EdsCameraListRef = void*;
 using EdsCameraRef     = void*;
 using EdsStreamRef     = void*;
 using EdsEvfImageRef   = void*;
+using EdsDirectoryItemRef = void*;
 using EdsVoid          = void*;
+using EdsBool          = int32_t;
 using EdsPropertyEventHandler = EdsError(__stdcall*)(EdsUInt32 inEvent, EdsUInt32 inPropertyID, EdsUInt32 inParam, EdsBaseRef inContext);
 using PFN_EdsSetPropertyEventHandler = EdsError(__stdcall*)(EdsCameraRef, EdsPropertyEventHandler, EdsBaseRef);
+using EdsObjectEventHandler = EdsError(__stdcall*)(EdsUInt32 inEvent, EdsBaseRef inRef, EdsVoid* inContext);
+using PFN_EdsSetObjectEventHandler = EdsError(__stdcall*)(EdsCameraRef, EdsUInt32, EdsObjectEventHandler, EdsVoid*);
 
 
 
@@ -34,9 +38,34 @@ constexpr EdsUInt32 kEdsCameraStatusCommand_UILock   = 0x00000001;
 constexpr EdsUInt32 kEdsCameraStatusCommand_UIUnLock = 0x00000002;
 
 // Shutter button command (optional wake)
+constexpr EdsUInt32 kEdsCameraCommand_TakePicture        = 0x00000000;
 constexpr EdsUInt32 kEdsCameraCommand_PressShutterButton = 0x00000004;
 constexpr EdsInt32  kEdsCameraCommand_ShutterButton_OFF     = 0;
 constexpr EdsInt32  kEdsCameraCommand_ShutterButton_Halfway = 1;
+constexpr EdsInt32  kEdsCameraCommand_ShutterButton_Completely = 3;
+constexpr EdsInt32  kEdsCameraCommand_ShutterButton_Halfway_NonAF    = 0x00010001;
+constexpr EdsInt32  kEdsCameraCommand_ShutterButton_Completely_NonAF = 0x00010003;
+
+// Object events (still capture -> host transfer)
+constexpr EdsUInt32 kEdsObjectEvent_All                    = 0x00000200;
+constexpr EdsUInt32 kEdsObjectEvent_DirItemCreated         = 0x00000204;
+constexpr EdsUInt32 kEdsObjectEvent_DirItemRequestTransfer = 0x00000208;
+
+// File streams (EdsCreateFileStream)
+constexpr EdsUInt32 kEdsFileCreateDisposition_CreateAlways = 1;
+constexpr EdsUInt32 kEdsAccess_ReadWrite = 2;
+
+// Directory item (file on the camera waiting for transfer)
+constexpr EdsUInt32 kEdsMaxNameLength = 256;
+struct EdsDirectoryItemInfo {
+  EdsUInt64 size;
+  EdsBool   isFolder;
+  EdsUInt32 groupID;
+  EdsUInt32 option;
+  char      szFileName[kEdsMaxNameLength];
+  EdsUInt32 format;
+  EdsUInt32 dateTime;
+};
 
 // Capacity structure (required when SaveTo=Host on some bodies)
 struct EdsCapacity {
@@ -86,6 +115,17 @@ public:
   EdsError (*EdsSendStatusCommand)(EdsCameraRef, EdsUInt32, EdsUInt32);
      // UILock/UIUnLock
   PFN_EdsSetPropertyEventHandler EdsSetPropertyEventHandler = nullptr;
+
+  // Still capture / transfer (optional; null when the DLL lacks them)
+  PFN_EdsSetObjectEventHandler EdsSetObjectEventHandler = nullptr;
+  EdsError (*EdsSetCapacity)(EdsCameraRef, EdsCapacity) = nullptr;
+  EdsError (*EdsGetDirectoryItemInfo)(EdsDirectoryItemRef, EdsDirectoryItemInfo*) = nullptr;
+  EdsError (*EdsDownload)(EdsDirectoryItemRef, EdsUInt64, EdsStreamRef) = nullptr;
+  EdsError (*EdsDownloadComplete)(EdsDirectoryItemRef) = nullptr;
+  EdsError (*EdsDownloadCancel)(EdsDirectoryItemRef) = nullptr;
+  EdsError (*EdsGetEvent)() = nullptr;
+  EdsError (*EdsCreateFileStream)(const char*, EdsUInt32, EdsUInt32, EdsStreamRef*) = nullptr;
+  EdsError (*EdsCreateFileStreamEx)(const wchar_t*, EdsUInt32, EdsUInt32, EdsStreamRef*) = nullptr;
 private:
   HMODULE dll_;
 };
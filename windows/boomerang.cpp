@@ -0,0 +1,132 @@
+#include "boomerang.h"
+#include "gif_encoder.h"
+#include "image_decode.h"
+#include "pixel_kernels.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+bool EncodeBoomerangGif(const std::vector<EvfRing::Frame>& frames, const std::wstring& path,
+                        const BoomerangOptions& options) {
+    if (frames.empty()) {
+        return false;
+    }
+
+    // Pick frames at the requested rate.
+    const auto min_gap = std::chrono::microseconds(1000000 / std::max(1, options.fps));
+    std::vector<const EvfRing::Frame*> picked;
+    for (const auto& f : frames) {
+        if (picked.empty() || f.captured_at - picked.back()->captured_at >= min_gap) {
+            picked.push_back(&f);
+        }
+    }
+    const int count = static_cast<int>(picked.size());
+
+    // Background lane: live view work on the shared pool runs first.
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int workers = options.workers;
+    auto parallel_for = [&](int n, auto fn) {
+        pool.ParallelFor(n, TaskScheduler::kBackground, fn, workers);
+    };
+
+    // 1) Decode (DCT-scaled) and bring every frame to the first frame's size.
+    std::vector<DecodedImage> images(count);
+    std::vector<char> decoded(count, 0);
+    parallel_for(count, [&](int i) {
+        WicDecoder decoder;
+        const auto& jpeg = *picked[i]->jpeg;
+        decoded[i] = decoder.ok() && decoder.DecodeBgra(jpeg.data(), jpeg.size(), options.max_side, images[i]);
+    });
+    if (!decoded[0]) {
+        std::cerr << "[ERR] Boomerang: first frame failed to decode\n";
+        return false;
+    }
+
+    int width = images[0].width;
+    int height = images[0].height;
+    const int longest = std::max(width, height);
+    if (options.max_side > 0 && longest > options.max_side) {
+        width = std::max(1, width * options.max_side / longest);
+        height = std::max(1, height * options.max_side / longest);
+    }
+    parallel_for(count, [&](int i) {
+        DecodedImage& img = images[i];
+        if (!decoded[i] || (img.width == width && img.height == height)) {
+            return;
+        }
+        DecodedImage resized;
+        resized.width = width;
+        resized.height = height;
+        resized.channels = 4;
+        resized.stride = width * 4;
+        resized.pixels.resize(static_cast<size_t>(resized.stride) * height);
+        ResizeBilinearBgra(img.pixels.data(), img.width, img.height, img.stride,
+                           resized.pixels.data(), width, height, resized.stride);
+        img = std::move(resized);
+    });
+
+    // 2) One global palette from per-frame histograms.
+    std::vector<GifHistogram> histograms(count);
+    parallel_for(count, [&](int i) {
+        if (decoded[i]) {
+            histograms[i].Add(images[i].pixels.data(), width, height, images[i].stride, 2);
+        }
+    });
+    GifHistogram merged;
+    for (const auto& h : histograms) {
+        merged.Merge(h);
+    }
+    histograms.clear();
+
+    GifPalette palette;
+    BuildPalette(merged, 256, palette);
+    const int kLutSlices = 32;
+    parallel_for(kLutSlices, [&](int slice) {
+        FillPaletteLut(palette, slice * 32768 / kLutSlices, (slice + 1) * 32768 / kLutSlices);
+    });
+
+    // 3) Index mapping + LZW per frame; undecodable frames repeat the previous one.
+    std::vector<std::vector<uint8_t>> encoded(count);
+    parallel_for(count, [&](int i) {
+        if (!decoded[i]) {
+            return;
+        }
+        std::vector<uint8_t> indices;
+        MapToPalette(images[i].pixels.data(), width, height, images[i].stride, palette,
+                     options.dither, indices);
+        images[i] = DecodedImage{};
+        encoded[i] = LzwEncodeFrame(indices.data(), indices.size());
+    });
+
+    // 4) Forward then reverse (without repeating the end frames), real timing.
+    std::vector<int> order;
+    for (int i = 0; i < count; ++i) order.push_back(i);
+    for (int i = count - 2; i > 0; --i) order.push_back(i);
+
+    std::vector<const std::vector<uint8_t>*> sequence;
+    std::vector<int> delays;
+    const std::vector<uint8_t>* last = &encoded[0];
+    for (size_t k = 0; k < order.size(); ++k) {
+        const int i = order[k];
+        if (!encoded[i].empty()) {
+            last = &encoded[i];
+        }
+        const int j = k + 1 < order.size() ? order[k + 1] : order[0];
+        auto gap = picked[std::max(i, j)]->captured_at - picked[std::min(i, j)]->captured_at;
+        if (i == j || gap <= std::chrono::steady_clock::duration::zero()) {
+            gap = min_gap;
+        }
+        sequence.push_back(last);
+        delays.push_back(static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(gap).count() / 10));
+    }
+
+    std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    if (!out || !WriteGif(out, width, height, palette, sequence, delays)) {
+        std::cerr << "[ERR] Boomerang: failed to write output\n";
+        return false;
+    }
+    return true;
+}
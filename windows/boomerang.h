@@ -0,0 +1,18 @@
+#pragma once
+#include "evf_ring.h"
+#include <string>
+#include <vector>
+
+struct BoomerangOptions {
+    int max_side = 480;  // output longest side in pixels
+    int fps = 15;        // frames per second taken from the ring
+    bool dither = true;  // ordered dithering before palette mapping
+    int workers = 0;     // max parallel tasks on the shared pool, 0 = all workers
+};
+
+// Turn pre-roll EVF frames into a forward+reverse looping GIF.
+// Decode, palette construction, index mapping and LZW run in parallel in the
+// background lane of the shared TaskScheduler, so live view work goes first;
+// reverse frames reuse the forward frames' compressed data.
+bool EncodeBoomerangGif(const std::vector<EvfRing::Frame>& frames, const std::wstring& path,
+                        const BoomerangOptions& options);
@@ -0,0 +1,116 @@
+#include "burst_capture.h"
+#include "precise_timer.h"
+#include <algorithm>
+#include <iostream>
+
+BurstCapture::~BurstCapture() {
+    Cancel();
+}
+
+bool BurstCapture::Start(StillCapture* still, int count, int interval_ms, int first_delay_ms,
+                         int prefocus_lead_ms) {
+    if (!still || count <= 0 || interval_ms <= 0 || first_delay_ms < 0 || prefocus_lead_ms < 0) {
+        return false;
+    }
+    if (state_ == 1) {
+        return false;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    const auto first = Clock::now() + std::chrono::milliseconds(first_delay_ms);
+    const int lead_ms = std::min({prefocus_lead_ms, interval_ms / 2, first_delay_ms});
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_ = false;
+        status_ = Status();
+        status_.count = count;
+    }
+    state_ = 1;
+    thread_ = std::thread(&BurstCapture::Run, this, still, count,
+                          Clock::duration(std::chrono::milliseconds(interval_ms)), first,
+                          Clock::duration(std::chrono::milliseconds(lead_ms)));
+    return true;
+}
+
+void BurstCapture::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+int BurstCapture::GetStatus(Status* status) const {
+    if (status) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *status = status_;
+    }
+    return state_;
+}
+
+// Interruptible wait that stops short of `deadline` by kCoarseMargin; the
+// caller (or TakePictureAt) does the precise part. Returns false if cancelled.
+bool BurstCapture::WaitUntil(Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !cv_.wait_until(lock, deadline - kCoarseMargin, [this] { return cancel_; });
+}
+
+void BurstCapture::Run(StillCapture* still, int count, Clock::duration interval, Clock::time_point first,
+                       Clock::duration lead) {
+    Clock::time_point first_release{};
+    bool cancelled = false;
+
+    for (int i = 0; i < count && !cancelled; ++i) {
+        const auto fire_at = first + interval * i;
+
+        bool prefocused = false;
+        if (lead > Clock::duration::zero()) {
+            if (!WaitUntil(fire_at - lead)) {
+                cancelled = true;
+                break;
+            }
+            SleepUntil(fire_at - lead);
+            prefocused = still->PressHalfway();
+        }
+        if (!WaitUntil(fire_at)) {
+            if (prefocused) {
+                still->ReleaseShutter();
+            }
+            cancelled = true;
+            break;
+        }
+
+        StillCapture::FireTiming timing;
+        const int64_t id = still->TakePictureAt(fire_at, !prefocused, &timing, i);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id <= 0) {
+            if (prefocused) {
+                still->ReleaseShutter();
+            }
+            ++status_.failed;
+            std::cerr << "[ERR] Burst shot " << i + 1 << "/" << count << " not fired: " << id << "\n";
+            continue;
+        }
+        if (status_.fired == 0) {
+            first_release = timing.issued_at;
+        }
+        ++status_.fired;
+        status_.max_fire_error_us = std::max<int64_t>(
+            status_.max_fire_error_us,
+            std::chrono::duration_cast<std::chrono::microseconds>(timing.issued_at - fire_at).count());
+        status_.elapsed_us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(timing.issued_at - first_release).count());
+    }
+
+    Status status;
+    GetStatus(&status);
+    std::cout << "[OK] Burst " << (cancelled ? "cancelled" : "done") << ": " << status.fired << "/"
+              << status.count << " fired, worst lateness " << status.max_fire_error_us << " us\n";
+    state_ = cancelled ? -4 : 0;
+}
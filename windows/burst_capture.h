@@ -0,0 +1,50 @@
+#pragma once
+#include "still_capture.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Photo-strip burst: N shots on a fixed schedule (first_delay, then every
+// interval). Firing never waits for transfers; StillCapture downloads shot k
+// while the countdown to shot k+1 runs, and shots complete in firing order
+// tagged with their burst index. The schedule is absolute, so a late
+// release does not push back the shots after it.
+class BurstCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Status {
+        int count = 0;
+        int fired = 0;
+        int failed = 0;                  // release command refused
+        int64_t max_fire_error_us = 0;   // worst lateness vs. schedule
+        uint64_t elapsed_us = 0;         // first to last release
+    };
+
+    ~BurstCapture();
+
+    // prefocus_lead_ms > 0 half-presses before each shot (capped at half the
+    // interval). Returns false if a burst is already running.
+    bool Start(StillCapture* still, int count, int interval_ms, int first_delay_ms, int prefocus_lead_ms);
+    void Cancel();
+
+    // 1 = running, 0 = all shots fired, -1 = nothing started, -4 = cancelled
+    int GetStatus(Status* status) const;
+
+private:
+    void Run(StillCapture* still, int count, Clock::duration interval, Clock::time_point first,
+             Clock::duration lead);
+    bool WaitUntil(Clock::time_point deadline);
+
+    static constexpr auto kCoarseMargin = std::chrono::milliseconds(100);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool cancel_ = false;
+    std::atomic<int> state_{-1};
+    Status status_;
+};
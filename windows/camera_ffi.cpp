@@ -1,19 +1,324 @@
 #include "camera_ffi.h"
+#include "boomerang.h"
+#include "burst_capture.h"
+#include "color_lut.h"
+#include "content_hash.h"
+#include "countdown_capture.h"
+#include "evf_ring.h"
+#include "frame_fanout.h"
+#include "frame_governor.h"
+#include "frame_shm.h"
+#include "image_probe.h"
+#include "image_decode.h"
+#include "jpeg_encoder.h"
+#include "mjpeg_recorder.h"
+#include "motion_detector.h"
+#include "overlay_template.h"
+#include "pixel_kernels.h"
+#include "precise_timer.h"
+#include "print_cache.h"
+#include "print_layout.h"
+#include "print_raster.h"
+#include "print_spool.h"
+#include "printer_color.h"
+#include "replay_source.h"
+#include "still_capture.h"
+#include "task_scheduler.h"
+#include "template_assets.h"
 #include "../native_probe/edsdk_bridge.h"
 #include <iostream>
+#include <functional>
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
 
 // Global state
 static std::unique_ptr<EdsdkBridge> g_sdk = nullptr;
 static EdsCameraRef g_camera = nullptr;
 static std::atomic<bool> g_liveview_active{false};
 static std::mutex g_frame_mutex;
-static std::vector<unsigned char> g_latest_frame;
+static JpegBytes g_latest_frame;
+static FrameInfo g_latest_info;             // guarded by g_frame_mutex
+static unsigned long long g_frame_seq = 0;  // guarded by g_frame_mutex
+
+// EDSDK is not safe to drive from several threads at once; every SDK call
+// made while the capture thread may be running goes through this lock.
+static std::mutex g_sdk_mutex;
+
+// Capture thread: downloads EVF frames into g_latest_frame at the rate the
+// governor allows, independent of how often consumers poll.
+static std::thread g_capture_thread;
+static std::mutex g_capture_mutex;
+static std::condition_variable g_capture_cv;
+static FrameGovernor g_governor;
+
+// Idle mode: when nobody moves in front of the booth for a while, capture
+// drops to a trickle and frames are no longer decoded or delivered.
+static IdleMonitor g_idle;
+static std::atomic<bool> g_wake_pending{false};
+static std::atomic<int> g_motion_threshold{10};
+static std::atomic<int> g_motion_min_permille{8};
+static constexpr int kMotionThumbnailSide = 64;
+
+// Pre-roll: the last few seconds of EVF JPEGs, for boomerang clips.
+static EvfRing g_preroll;
+static std::thread g_boomerang_thread;
+static std::atomic<int> g_boomerang_state{-1};  // -1 none, 1 running, 0 done, -4 failed
+static std::atomic<unsigned long long> g_boomerang_elapsed_us{0};
+
+// Session video: EVF JPEGs muxed as-is into an MJPEG AVI.
+static MjpegRecorder g_recorder;
+
+// Stills: shutter + chunked host transfer alongside live view.
+static StillCapture g_still;
+static CountdownCapture g_countdown;
+static BurstCapture g_burst;
+
+// Optional shared-memory ring so other local processes can follow live view.
+static std::mutex g_shm_mutex;
+static frame_shm::Writer g_shm;
+
+// Consumers that want live view decoded/scaled (decoded once per frame).
+static FrameFanout g_fanout;
+
+// Print jobs: one at a time, rendered and spooled off the caller's thread.
+static std::thread g_print_thread;
+static std::atomic<int> g_print_state{-1};  // see camera_get_print_status
+static std::mutex g_print_mutex;
+static CameraPrintReport g_print_report{};
+static PrintCache g_print_cache;
+
+// Frame template composited over prints and sheets; jobs keep the one that
+// was loaded when they started.
+static std::mutex g_overlay_mutex;
+static std::shared_ptr<OverlayTemplate> g_overlay;
+static TemplateAssetCache g_template_assets;  // converted artwork, mapped on later loads
+
+static std::shared_ptr<OverlayTemplate> CurrentOverlay() {
+    std::lock_guard<std::mutex> lock(g_overlay_mutex);
+    return g_overlay;
+}
+
+// Colour grade (event look) for live view and prints. The fan-out holds its
+// own reference; print jobs keep the one current when they started.
+static std::mutex g_look_mutex;
+static std::shared_ptr<const ColorLut> g_look;
+
+static std::shared_ptr<const ColorLut> CurrentLook() {
+    std::lock_guard<std::mutex> lock(g_look_mutex);
+    return g_look;
+}
+
+// Printer colour management: pages are converted from sRGB to the printer's
+// ICC profile (or an override) by a baked transform. Jobs use the settings
+// current when they started.
+struct PrintColorSettings {
+    bool enabled = false;
+    int intent = PrinterColorTransforms::kPerceptual;
+    std::wstring profile;  // override; empty = the printer's own
+};
+static std::mutex g_print_color_mutex;
+static PrintColorSettings g_print_color;
+static PrinterColorTransforms g_printer_transforms;
+
+static PrintColorSettings CurrentPrintColor() {
+    std::lock_guard<std::mutex> lock(g_print_color_mutex);
+    return g_print_color;
+}
+
+// Dithering of the finished page for low-bit printers (off by default)
+static std::mutex g_print_dither_mutex;
+static DitherSettings g_print_dither;
+
+static DitherSettings CurrentDither() {
+    std::lock_guard<std::mutex> lock(g_print_dither_mutex);
+    return g_print_dither;
+}
+
+// Replay backend: serves EVF frames from disk instead of a camera.
+static std::unique_ptr<ReplaySource> g_replay;
+
+static bool SessionOpen() {
+    return g_replay || (g_camera && g_sdk);
+}
+
+// Download one EVF JPEG into `out`. Returns 0 on success.
+static int DownloadEvfFrame(std::vector<unsigned char>& out) {
+    if (g_replay) {
+        return g_replay->Next(out) ? 0 : -5;
+    }
+
+    std::lock_guard<std::mutex> sdk_lock(g_sdk_mutex);
+    if (!g_camera || !g_sdk) {
+        return -1;
+    }
+
+    EdsStreamRef mem = nullptr;
+    EdsEvfImageRef evf = nullptr;
+
+    // Create memory stream
+    EdsError err = g_sdk->EdsCreateMemoryStream(0, &mem);
+    if (err != EDS_ERR_OK || !mem) {
+        return -3;
+    }
+
+    // Create EVF image reference
+    err = g_sdk->EdsCreateEvfImageRef(mem, &evf);
+    if (err != EDS_ERR_OK || !evf) {
+        g_sdk->EdsRelease(mem);
+        return -4;
+    }
+
+    // Download EVF image with retry logic
+    const int MAX_RETRY = 5;
+    for (int i = 0; i < MAX_RETRY; i++) {
+        err = g_sdk->EdsDownloadEvfImage(g_camera, evf);
+        if (err == EDS_ERR_OK) {
+            break;
+        }
+        if (err == EDS_ERR_OBJECT_NOTREADY || err == EDS_ERR_DEVICE_BUSY) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        // Other error
+        break;
+    }
+
+    if (err != EDS_ERR_OK) {
+        g_sdk->EdsRelease(evf);
+        g_sdk->EdsRelease(mem);
+        return -5;
+    }
+
+    // Get image data
+    EdsVoid* ptr = nullptr;
+    EdsUInt64 len = 0;
+    g_sdk->EdsGetPointer(mem, &ptr);
+    g_sdk->EdsGetLength(mem, &len);
+
+    if (!ptr || len == 0) {
+        g_sdk->EdsRelease(evf);
+        g_sdk->EdsRelease(mem);
+        return -6;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(ptr);
+    out.assign(bytes, bytes + len);
+
+    // Cleanup
+    g_sdk->EdsRelease(evf);
+    g_sdk->EdsRelease(mem);
+    return 0;
+}
+
+static void CaptureLoop() {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    const bool needUninit = SUCCEEDED(hr);
+
+    WicDecoder decoder;
+    MotionDetector motion;
+    DecodedImage thumbnail;
+
+    std::vector<unsigned char> scratch;
+    JpegBytes previous;
+    while (g_liveview_active) {
+        const auto wall_start = std::chrono::steady_clock::now();
+        const auto cpu_start = ThreadCpuTime();
+        const uint64_t fanout_cpu_start = g_fanout.cpu_us();
+
+        if (DownloadEvfFrame(scratch) == 0) {
+            const auto captured_at = std::chrono::steady_clock::now();
+            FrameInfo info;
+            info.captured_at = captured_at;
+            info.download_us = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(captured_at - wall_start).count());
+
+            // Only a 1/8-scale luma decode is spent on frames nobody may see.
+            bool moved = true;
+            if (g_idle.enabled() && decoder.ok() &&
+                decoder.DecodeGray(scratch.data(), scratch.size(), kMotionThumbnailSide, thumbnail)) {
+                motion.Configure(g_motion_threshold, g_motion_min_permille);
+                moved = motion.Update(thumbnail.pixels.data(), thumbnail.width,
+                                      thumbnail.height, thumbnail.stride);
+            }
+
+            if (g_idle.OnFrame(moved, captured_at)) {
+                auto frame = std::make_shared<const std::vector<unsigned char>>(std::move(scratch));
+                scratch = std::vector<unsigned char>();
+                g_preroll.Push(frame, captured_at);
+                g_recorder.Push(frame, captured_at);
+
+                ProbeJpegSize(frame->data(), frame->size(), info.width, info.height);
+                if (previous && *previous == *frame) {
+                    info.flags |= CAMERA_FRAME_FLAG_DUPLICATE;
+                }
+                if (g_idle.OnWakePublished(captured_at)) {
+                    info.flags |= CAMERA_FRAME_FLAG_WAKE;
+                }
+                if (g_replay) {
+                    info.flags |= CAMERA_FRAME_FLAG_REPLAY;
+                }
+                previous = frame;
+
+                unsigned long long seq = 0;
+                {
+                    std::lock_guard<std::mutex> lock(g_frame_mutex);
+                    g_latest_frame = frame;
+                    seq = ++g_frame_seq;
+                    info.sequence = seq;
+                    g_latest_info = info;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(g_shm_mutex);
+                    if (g_shm.is_open()) {
+                        g_shm.Publish(frame->data(), frame->size(), seq,
+                                      std::chrono::duration_cast<std::chrono::microseconds>(
+                                          captured_at.time_since_epoch()).count());
+                    }
+                }
+                g_fanout.Submit(frame, seq, captured_at);
+                g_governor.OnFramePublished(seq);
+            }
+        }
+
+        const auto wall_used = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - wall_start);
+        // The fan-out decodes and grades on its own worker, so its CPU counts
+        // against the same budget (it lags a frame, which the average absorbs)
+        const auto cpu_used = ThreadCpuTime() - cpu_start +
+                              std::chrono::microseconds(g_fanout.cpu_us() - fanout_cpu_start);
+        auto delay = g_governor.NextDelay(cpu_used, wall_used);
+        if (g_idle.idle()) {
+            delay = std::max(delay, std::chrono::milliseconds(g_idle.trickle_interval_ms()) -
+                                        std::chrono::duration_cast<std::chrono::milliseconds>(wall_used));
+        }
+
+        std::unique_lock<std::mutex> lock(g_capture_mutex);
+        g_capture_cv.wait_for(lock, delay, [] { return !g_liveview_active || g_wake_pending; });
+        g_wake_pending = false;
+    }
+
+    if (needUninit) CoUninitialize();
+}
+
+static void StopCaptureThread() {
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        g_liveview_active = false;
+    }
+    g_capture_cv.notify_all();
+    if (g_capture_thread.joinable()) {
+        g_capture_thread.join();
+    }
+}
 
 // Initialize EDSDK and camera
 extern "C" __declspec(dllexport) int camera_initialize() {
@@ -69,6 +374,12 @@ extern "C" __declspec(dllexport) int camera_initialize() {
             return -6;
         }
 
+        // Live view works without it, so a failure here is not fatal.
+        if (!g_still.Attach(g_sdk.get(), g_camera, &g_sdk_mutex)) {
+            std::cerr << "[ERR] Still capture unavailable\n";
+        }
+        g_countdown.ResetLag();
+
         std::cout << "[OK] Camera initialized successfully\n";
         return 0;
 
@@ -78,10 +389,52 @@ extern "C" __declspec(dllexport) int camera_initialize() {
     }
 }
 
+// Initialize the replay backend instead of a camera (benchmarks, demos)
+extern "C" __declspec(dllexport) int camera_initialize_replay(const wchar_t* directory, int frame_interval_ms) {
+    try {
+        if (!directory) {
+            return -2;
+        }
+        if (SessionOpen()) {
+            std::cerr << "[ERR] A camera session is already open\n";
+            return -1;
+        }
+
+        auto replay = std::make_unique<ReplaySource>();
+        if (!replay->Open(directory, frame_interval_ms)) {
+            return -3;
+        }
+        g_replay = std::move(replay);
+
+        std::cout << "[OK] Replay backend initialized successfully\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_initialize_replay: " << e.what() << "\n";
+        return -999;
+    }
+}
+
 // Terminate EDSDK and cleanup
 extern "C" __declspec(dllexport) int camera_terminate() {
     try {
-        g_liveview_active = false;
+        StopCaptureThread();
+        if (g_boomerang_thread.joinable()) {
+            g_boomerang_thread.join();
+        }
+        if (g_print_thread.joinable()) {
+            g_print_thread.join();
+        }
+        g_preroll.Clear();
+        g_recorder.Stop();
+        {
+            std::lock_guard<std::mutex> lock(g_shm_mutex);
+            g_shm.Close();
+        }
+        g_fanout.Shutdown();
+        g_countdown.Cancel();
+        g_burst.Cancel();
+        g_still.Detach();
 
         if (g_camera && g_sdk) {
             // Disable EVF
@@ -101,6 +454,8 @@ extern "C" __declspec(dllexport) int camera_terminate() {
             g_sdk.reset();
         }
 
+        g_replay.reset();
+
         std::cout << "[OK] Camera terminated successfully\n";
         return 0;
 
@@ -113,30 +468,47 @@ extern "C" __declspec(dllexport) int camera_terminate() {
 // Start live view
 extern "C" __declspec(dllexport) int camera_start_liveview() {
     try {
-        if (!g_camera || !g_sdk) {
+        if (!SessionOpen()) {
             std::cerr << "[ERR] Camera not initialized\n";
             return -1;
         }
 
-        // Get current EVF output device
-        EdsUInt32 device = 0;
-        EdsError err = g_sdk->EdsGetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
-        if (err != EDS_ERR_OK) {
-            std::cerr << "[ERR] EdsGetPropertyData(Evf_OutputDevice) failed: 0x"
-                      << std::hex << (unsigned)err << std::dec << "\n";
-            return -2;
+        if (g_capture_thread.joinable()) {
+            // Already running
+            return 0;
         }
 
-        // Enable PC output
-        device |= kEdsEvfOutputDevice_PC;
-        err = g_sdk->EdsSetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
-        if (err != EDS_ERR_OK) {
-            std::cerr << "[ERR] EdsSetPropertyData(Evf_OutputDevice=PC) failed: 0x"
-                      << std::hex << (unsigned)err << std::dec << "\n";
-            return -3;
+        if (!g_replay) {
+            // Get current EVF output device
+            EdsUInt32 device = 0;
+            EdsError err = g_sdk->EdsGetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
+            if (err != EDS_ERR_OK) {
+                std::cerr << "[ERR] EdsGetPropertyData(Evf_OutputDevice) failed: 0x"
+                          << std::hex << (unsigned)err << std::dec << "\n";
+                return -2;
+            }
+
+            // Enable PC output
+            device |= kEdsEvfOutputDevice_PC;
+            err = g_sdk->EdsSetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
+            if (err != EDS_ERR_OK) {
+                std::cerr << "[ERR] EdsSetPropertyData(Evf_OutputDevice=PC) failed: 0x"
+                          << std::hex << (unsigned)err << std::dec << "\n";
+                return -3;
+            }
         }
 
+        // Sequence numbers keep counting across restarts so consumers
+        // never mistake a new session's frame for one they already have.
+        {
+            std::lock_guard<std::mutex> lock(g_frame_mutex);
+            g_latest_frame.reset();
+        }
+        g_governor.Reset();
+        g_idle.Reset();
         g_liveview_active = true;
+        g_capture_thread = std::thread(CaptureLoop);
+
         std::cout << "[OK] Live view started successfully\n";
         return 0;
 
@@ -149,17 +521,20 @@ extern "C" __declspec(dllexport) int camera_start_liveview() {
 // Stop live view
 extern "C" __declspec(dllexport) int camera_stop_liveview() {
     try {
-        if (!g_camera || !g_sdk) {
+        if (!SessionOpen()) {
             return -1;
         }
 
-        g_liveview_active = false;
+        StopCaptureThread();
 
         // Disable PC output
-        EdsUInt32 device = 0;
-        if (g_sdk->EdsGetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device) == 0) {
-            device &= ~kEdsEvfOutputDevice_PC;
-            g_sdk->EdsSetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
+        if (!g_replay) {
+            std::lock_guard<std::mutex> sdk_lock(g_sdk_mutex);
+            EdsUInt32 device = 0;
+            if (g_sdk->EdsGetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device) == 0) {
+                device &= ~kEdsEvfOutputDevice_PC;
+                g_sdk->EdsSetPropertyData(g_camera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device), &device);
+            }
         }
 
         std::cout << "[OK] Live view stopped successfully\n";
@@ -171,10 +546,44 @@ extern "C" __declspec(dllexport) int camera_stop_liveview() {
     }
 }
 
+// Copy the latest frame into a malloc'd buffer for the caller.
+// Returns 1 when the latest frame is not newer than `newer_than`.
+static int CopyLatestFrame(unsigned long long newer_than, unsigned char** buffer,
+                           unsigned long long* size, unsigned long long* sequence,
+                           FrameInfo* info = nullptr) {
+    std::lock_guard<std::mutex> lock(g_frame_mutex);
+    if (!g_latest_frame || g_latest_frame->empty()) {
+        // No frame captured yet
+        return -5;
+    }
+    if (g_frame_seq <= newer_than) {
+        return 1;
+    }
+
+    // Allocate buffer for Dart side
+    unsigned char* frame_buffer = (unsigned char*)malloc(g_latest_frame->size());
+    if (!frame_buffer) {
+        return -7;
+    }
+
+    // Copy data
+    memcpy(frame_buffer, g_latest_frame->data(), g_latest_frame->size());
+
+    *buffer = frame_buffer;
+    *size = g_latest_frame->size();
+    if (sequence) {
+        *sequence = g_frame_seq;
+    }
+    if (info) {
+        *info = g_latest_info;
+    }
+    return 0;
+}
+
 // Get latest frame
 extern "C" __declspec(dllexport) int camera_get_frame(unsigned char** buffer, unsigned long long* size) {
     try {
-        if (!g_camera || !g_sdk || !g_liveview_active) {
+        if (!SessionOpen() || !g_liveview_active) {
             return -1;
         }
 
@@ -182,84 +591,1239 @@ extern "C" __declspec(dllexport) int camera_get_frame(unsigned char** buffer, un
             return -2;
         }
 
-        EdsStreamRef mem = nullptr;
-        EdsEvfImageRef evf = nullptr;
+        return CopyLatestFrame(0, buffer, size, nullptr);
 
-        // Create memory stream
-        EdsError err = g_sdk->EdsCreateMemoryStream(0, &mem);
-        if (err != EDS_ERR_OK || !mem) {
-            return -3;
-        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_get_frame: " << e.what() << "\n";
+        return -999;
+    }
+}
 
-        // Create EVF image reference
-        err = g_sdk->EdsCreateEvfImageRef(mem, &evf);
-        if (err != EDS_ERR_OK || !evf) {
-            g_sdk->EdsRelease(mem);
-            return -4;
+// Get latest frame on behalf of a registered consumer.
+// Returns 1 (and leaves outputs untouched) if the consumer already has it.
+extern "C" __declspec(dllexport) int camera_get_frame_for(int consumer_id, unsigned char** buffer,
+                                                         unsigned long long* size,
+                                                         unsigned long long* sequence) {
+    try {
+        if (!SessionOpen() || !g_liveview_active) {
+            return -1;
         }
 
-        // Download EVF image with retry logic
-        const int MAX_RETRY = 5;
-        for (int i = 0; i < MAX_RETRY; i++) {
-            err = g_sdk->EdsDownloadEvfImage(g_camera, evf);
-            if (err == EDS_ERR_OK) {
-                break;
-            }
-            if (err == 0xA102 || err == 0x0081) { // OBJECT_NOTREADY or DEVICE_BUSY
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                continue;
-            }
-            // Other error
-            break;
+        if (!buffer || !size || !sequence) {
+            return -2;
         }
 
-        if (err != EDS_ERR_OK) {
-            g_sdk->EdsRelease(evf);
-            g_sdk->EdsRelease(mem);
-            return -5;
+        const unsigned long long last = *sequence;
+        int rc = CopyLatestFrame(last, buffer, size, sequence);
+        if (rc == 0) {
+            g_governor.OnFrameDelivered(consumer_id, *sequence);
         }
+        return rc;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_get_frame_for: " << e.what() << "\n";
+        return -999;
+    }
+}
 
-        // Get image data
-        EdsVoid* ptr = nullptr;
-        EdsUInt64 len = 0;
-        g_sdk->EdsGetPointer(mem, &ptr);
-        g_sdk->EdsGetLength(mem, &len);
+// Write at most desc->struct_size bytes of the descriptor for `info`.
+static void FillFrameDesc(const FrameInfo& info, unsigned long long newer_than, CameraFrameDesc* desc) {
+    CameraFrameDesc full;
+    memset(&full, 0, sizeof(full));
+    full.struct_size = static_cast<unsigned int>(std::min<size_t>(desc->struct_size, sizeof(full)));
+    full.version = CAMERA_FRAME_DESC_VERSION;
+    full.sequence = info.sequence;
+    full.captured_us = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(info.captured_at.time_since_epoch()).count());
+    full.download_us = info.download_us;
+    full.frames_missed = newer_than > 0 && info.sequence > newer_than + 1 ? info.sequence - newer_than - 1 : 0;
+    full.width = info.width;
+    full.height = info.height;
+    full.flags = info.flags;
+    memcpy(desc, &full, full.struct_size);
+}
 
-        if (!ptr || len == 0) {
-            g_sdk->EdsRelease(evf);
-            g_sdk->EdsRelease(mem);
-            return -6;
+// Latest frame newer than `newer_than`, with its descriptor. consumer_id 0
+// fetches without pacing feedback. The caller sets desc->struct_size;
+// only that many bytes are written, so older callers keep working when
+// the descriptor grows. Returns 1 if there is no newer frame.
+extern "C" __declspec(dllexport) int camera_get_frame_ex(int consumer_id, unsigned long long newer_than,
+                                                        unsigned char** buffer, unsigned long long* size,
+                                                        CameraFrameDesc* desc) {
+    try {
+        if (!SessionOpen() || !g_liveview_active) {
+            return -1;
+        }
+        if (!buffer || !size || !desc || desc->struct_size < offsetof(CameraFrameDesc, sequence)) {
+            return -2;
         }
 
-        // Allocate buffer for Dart side
-        unsigned char* frame_buffer = (unsigned char*)malloc(len);
-        if (!frame_buffer) {
-            g_sdk->EdsRelease(evf);
-            g_sdk->EdsRelease(mem);
-            return -7;
+        unsigned long long seq = 0;
+        FrameInfo info;
+        int rc = CopyLatestFrame(newer_than, buffer, size, &seq, &info);
+        if (rc != 0) {
+            return rc;
+        }
+        if (consumer_id > 0) {
+            g_governor.OnFrameDelivered(consumer_id, seq);
         }
 
-        // Copy data
-        memcpy(frame_buffer, ptr, len);
+        FillFrameDesc(info, newer_than, desc);
+        return 0;
 
-        *buffer = frame_buffer;
-        *size = len;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_get_frame_ex: " << e.what() << "\n";
+        return -999;
+    }
+}
 
-        // Cleanup
-        g_sdk->EdsRelease(evf);
-        g_sdk->EdsRelease(mem);
+// Copy the latest frame newer than `newer_than` into the caller's buffer.
+// Nothing is allocated on either side: a consumer keeps one buffer for the
+// session. Returns -8 with *length = required size if it is too small
+// (nothing is consumed, retry with a bigger buffer), 1 if there is no newer
+// frame. desc may be null; otherwise its struct_size must be set.
+extern "C" __declspec(dllexport) int camera_get_frame_into(int consumer_id, unsigned long long newer_than,
+                                                          unsigned char* buffer, unsigned long long capacity,
+                                                          unsigned long long* length, CameraFrameDesc* desc) {
+    try {
+        if (!SessionOpen() || !g_liveview_active) {
+            return -1;
+        }
+        if (!length || (!buffer && capacity > 0) ||
+            (desc && desc->struct_size < offsetof(CameraFrameDesc, sequence))) {
+            return -2;
+        }
+
+        FrameInfo info;
+        {
+            std::lock_guard<std::mutex> lock(g_frame_mutex);
+            if (!g_latest_frame || g_latest_frame->empty()) {
+                return -5;
+            }
+            if (g_frame_seq <= newer_than) {
+                return 1;
+            }
+            *length = g_latest_frame->size();
+            if (g_latest_frame->size() > capacity) {
+                return -8;
+            }
+            memcpy(buffer, g_latest_frame->data(), g_latest_frame->size());
+            info = g_latest_info;
+        }
 
+        if (consumer_id > 0) {
+            g_governor.OnFrameDelivered(consumer_id, info.sequence);
+        }
+        if (desc) {
+            FillFrameDesc(info, newer_than, desc);
+        }
         return 0;
 
     } catch (const std::exception& e) {
-        std::cerr << "[ERR] Exception in camera_get_frame: " << e.what() << "\n";
+        std::cerr << "[ERR] Exception in camera_get_frame_into: " << e.what() << "\n";
         return -999;
     }
 }
 
+extern "C" __declspec(dllexport) int camera_register_consumer() {
+    return g_governor.RegisterConsumer();
+}
+
+extern "C" __declspec(dllexport) int camera_unregister_consumer(int consumer_id) {
+    return g_governor.UnregisterConsumer(consumer_id) ? 0 : -1;
+}
+
+extern "C" __declspec(dllexport) int camera_ack_frame(int consumer_id, unsigned long long sequence) {
+    return g_governor.OnFrameAcked(consumer_id, sequence) ? 0 : -1;
+}
+
+extern "C" __declspec(dllexport) int camera_set_frame_interval(int min_interval_ms, int max_interval_ms) {
+    if (min_interval_ms <= 0 || max_interval_ms < min_interval_ms) {
+        return -2;
+    }
+    g_governor.Configure(min_interval_ms, max_interval_ms);
+    return 0;
+}
+
+extern "C" __declspec(dllexport) int camera_set_cpu_budget(int percent) {
+    if (percent <= 0 || percent > 100) {
+        return -2;
+    }
+    g_governor.SetCpuBudget(percent);
+    return 0;
+}
+
+extern "C" __declspec(dllexport) int camera_get_frame_interval() {
+    return g_governor.CurrentIntervalMs();
+}
+
 // Free buffer allocated by camera_get_frame
 extern "C" __declspec(dllexport) void camera_free_buffer(unsigned char* buffer) {
     if (buffer) {
         free(buffer);
     }
-}
\ No newline at end of file
+}
+
+// Idle mode: after idle_after_ms without motion, capture drops to one frame
+// per trickle_interval_ms and frames are no longer delivered.
+extern "C" __declspec(dllexport) int camera_set_idle_mode(int enabled, int idle_after_ms, int trickle_interval_ms) {
+    if (idle_after_ms <= 0 || trickle_interval_ms <= 0) {
+        return -2;
+    }
+    g_idle.Configure(enabled != 0, idle_after_ms, trickle_interval_ms);
+    return 0;
+}
+
+extern "C" __declspec(dllexport) int camera_set_motion_sensitivity(int cell_threshold, int min_changed_permille) {
+    if (cell_threshold <= 0 || cell_threshold > 255 || min_changed_permille <= 0 || min_changed_permille > 1000) {
+        return -2;
+    }
+    g_motion_threshold = cell_threshold;
+    g_motion_min_permille = min_changed_permille;
+    return 0;
+}
+
+// Leave idle immediately (touch, button press, ...)
+extern "C" __declspec(dllexport) int camera_wake() {
+    g_idle.Wake();
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        g_wake_pending = true;
+    }
+    g_capture_cv.notify_all();
+    return 0;
+}
+
+extern "C" __declspec(dllexport) int camera_get_idle_stats(CameraIdleStats* stats) {
+    if (!stats) {
+        return -2;
+    }
+    const IdleMonitor::Stats s = g_idle.stats();
+    stats->frames_captured = s.frames_captured;
+    stats->frames_published = s.frames_published;
+    stats->frames_skipped = s.frames_skipped;
+    stats->wake_count = s.wake_count;
+    stats->idle_ms_total = s.idle_ms_total;
+    stats->last_wake_latency_us = s.last_wake_latency_us;
+    stats->idle = g_idle.idle() ? 1 : 0;
+    return 0;
+}
+
+// Keep the last `seconds` of live view (at most max_megabytes) as JPEG bytes.
+// seconds = 0 disables the pre-roll buffer.
+extern "C" __declspec(dllexport) int camera_set_preroll(int seconds, int max_megabytes) {
+    if (seconds < 0 || max_megabytes < 0) {
+        return -2;
+    }
+    g_preroll.Configure(seconds * 1000, static_cast<size_t>(max_megabytes) * 1024 * 1024);
+    return 0;
+}
+
+// Encode the last `seconds` of pre-roll into a forward+reverse GIF at
+// output_path in the background. Poll camera_get_boomerang_status().
+extern "C" __declspec(dllexport) int camera_start_boomerang(const wchar_t* output_path, int seconds,
+                                                           int max_side, int fps) {
+    try {
+        if (!output_path || seconds <= 0) {
+            return -2;
+        }
+        if (g_boomerang_state == 1) {
+            return -3;
+        }
+        if (g_boomerang_thread.joinable()) {
+            g_boomerang_thread.join();
+        }
+
+        std::vector<EvfRing::Frame> frames = g_preroll.Snapshot(seconds * 1000);
+        if (frames.empty()) {
+            std::cerr << "[ERR] Pre-roll buffer is empty\n";
+            return -1;
+        }
+
+        BoomerangOptions options;
+        if (max_side > 0) options.max_side = max_side;
+        if (fps > 0) options.fps = fps;
+
+        g_boomerang_state = 1;
+        g_boomerang_elapsed_us = 0;
+        g_boomerang_thread = std::thread([frames = std::move(frames), path = std::wstring(output_path), options]() {
+            const auto started = std::chrono::steady_clock::now();
+            const bool ok = EncodeBoomerangGif(frames, path, options);
+            g_boomerang_elapsed_us = static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started).count());
+            std::cout << (ok ? "[OK] Boomerang encoded in " : "[ERR] Boomerang failed after ")
+                      << g_boomerang_elapsed_us / 1000 << " ms\n";
+            g_boomerang_state = ok ? 0 : -4;
+        });
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_boomerang: " << e.what() << "\n";
+        g_boomerang_state = -4;
+        return -999;
+    }
+}
+
+// 1 = encoding, 0 = done, -1 = no job, -4 = failed. encode_us may be null.
+extern "C" __declspec(dllexport) int camera_get_boomerang_status(unsigned long long* encode_us) {
+    if (encode_us) {
+        *encode_us = g_boomerang_elapsed_us;
+    }
+    return g_boomerang_state;
+}
+
+static unsigned long long ElapsedUs(std::chrono::steady_clock::time_point since) {
+    return static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - since).count());
+}
+
+// Page size of a print job: the printer's physical page, or layout.dpi
+// (default 300) for file output. Returns 0 or -5 if the printer is unavailable.
+static int OpenPrintTarget(const CameraPrintLayout& layout, const std::wstring& printer,
+                           const std::wstring& output_path, PrinterPage& page, CameraPrintReport& report) {
+    if (output_path.empty()) {
+        if (!page.Open(printer, layout.width_in, layout.height_in)) {
+            return -5;
+        }
+        report.width = page.width();
+        report.height = page.height();
+        report.dpi_x = page.dpi_x();
+        report.dpi_y = page.dpi_y();
+    } else {
+        report.dpi_x = report.dpi_y = layout.dpi > 0 ? layout.dpi : 300;
+        report.width = static_cast<int>(std::lround(layout.width_in * report.dpi_x));
+        report.height = static_cast<int>(std::lround(layout.height_in * report.dpi_y));
+    }
+    return 0;
+}
+
+// The colour transform for a job's target, or null: the override profile, else
+// the printer's own (file output only converts with an override). Pages that
+// get one go out with the driver's colour matching off, so they are not
+// corrected twice.
+static std::shared_ptr<const ColorLut> PrinterTransform(const PrintColorSettings& color, PrinterPage& page,
+                                                        bool to_printer, CameraPrintReport& report) {
+    if (!color.enabled) {
+        return nullptr;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    const std::wstring profile = !color.profile.empty() ? color.profile : to_printer ? page.color_profile() : L"";
+    auto transform = profile.empty() ? nullptr : g_printer_transforms.Get(profile, color.intent);
+    if (transform && to_printer && !page.DisableDriverColor()) {
+        std::cerr << "[ERR] Printer driver colour matching could not be turned off\n";
+    }
+    report.color_managed = transform ? 1 : 0;
+    report.color_us = ElapsedUs(started);
+    return transform;
+}
+
+// Runs `job` on the print thread (COM initialized). The job fills in the
+// report and returns the final state for camera_get_print_status.
+static int LaunchPrintJob(std::function<int(CameraPrintReport&)> job) {
+    if (g_print_state == 1) {
+        return -3;
+    }
+    if (g_print_thread.joinable()) {
+        g_print_thread.join();
+    }
+
+    g_print_state = 1;
+    g_print_thread = std::thread([job = std::move(job)]() {
+        const auto started = std::chrono::steady_clock::now();
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        const bool needUninit = SUCCEEDED(hr);
+
+        CameraPrintReport report{};
+        const int state = job(report);
+        report.total_us = ElapsedUs(started);
+
+        if (state == 0) {
+            std::cout << "[OK] Print " << report.width << "x" << report.height
+                      << (report.cache_hit ? " (cached)" : "") << " spooled in " << report.total_us / 1000
+                      << " ms\n";
+        } else {
+            std::cerr << "[ERR] Print failed (" << state << ")\n";
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_print_mutex);
+            g_print_report = report;
+        }
+        g_print_state = state;
+        if (needUninit) CoUninitialize();
+    });
+    return 0;
+}
+
+// Render and spool one page on the print thread. An empty output path means
+// a printer (empty name: the default one).
+static int StartPrintJob(const unsigned char* data, unsigned long long size, const CameraPrintLayout* layout,
+                         const std::wstring& printer, const std::wstring& output_path) {
+    if (!data || size == 0 || !layout || layout->width_in <= 0.0 || layout->height_in <= 0.0) {
+        return -2;
+    }
+    return LaunchPrintJob([bytes = std::vector<uint8_t>(data, data + size), layout = *layout, printer,
+                           output_path, overlay = CurrentOverlay(), look = CurrentLook(),
+                           color = CurrentPrintColor(), dither = CurrentDither()](CameraPrintReport& report) {
+        WicDecoder decoder;
+        PrinterPage page;
+        int state = OpenPrintTarget(layout, printer, output_path, page, report);
+        const auto printer_transform = state == 0 ? PrinterTransform(color, page, output_path.empty(), report)
+                                                  : nullptr;
+
+        PrintCacheKey key;
+        key.source_hash = HashBytes(bytes.data(), bytes.size());
+        key.width = report.width;
+        key.height = report.height;
+        key.dpi_x = report.dpi_x;
+        key.dpi_y = report.dpi_y;
+        key.auto_rotate = layout.auto_rotate != 0;
+        key.profile = printer_transform ? printer_transform->id() : 0;
+        key.look = look ? look->id() : 0;
+        key.overlay = overlay ? overlay->id() : 0;
+        key.dither = dither.id();
+
+        PrintRaster raster;
+        PrintRenderTimings timings;
+        if (state == 0 && g_print_cache.Lookup(key, raster)) {
+            report.cache_hit = 1;
+        } else if (state == 0) {
+            const auto placed = overlay ? overlay->Place(report.width, report.height) : nullptr;
+            const PrintStages stages{look.get(), placed.get(), printer_transform.get(), dither};
+            if (RenderPrintRaster(decoder, bytes.data(), bytes.size(), report.width, report.height,
+                                  layout.auto_rotate != 0, raster, timings, stages)) {
+                g_print_cache.Store(key, raster);
+            } else {
+                state = -4;
+            }
+        }
+        report.decode_us = timings.decode_us;
+        report.resample_us = timings.resample_us;
+        report.convert_us = timings.convert_us;
+        report.dither_us = timings.dither_us;
+
+        if (state == 0) {
+            const auto spool_started = std::chrono::steady_clock::now();
+            const bool ok = output_path.empty() ? page.Spool(raster, L"SFace Kiosk photo")
+                                                : WritePrintBmp(output_path, raster, report.dpi_x);
+            report.spool_us = ElapsedUs(spool_started);
+            if (!ok) {
+                state = -6;
+            }
+        }
+        return state;
+    });
+}
+
+// Print an encoded photo borderless on `printer_name` (null or empty: the
+// default printer) at the printer's own resolution. Returns immediately;
+// poll camera_get_print_status.
+extern "C" __declspec(dllexport) int camera_start_print(const unsigned char* data, unsigned long long size,
+                                                      const CameraPrintLayout* layout, const wchar_t* printer_name) {
+    try {
+        return StartPrintJob(data, size, layout, printer_name ? printer_name : L"", L"");
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_print: " << e.what() << "\n";
+        g_print_state = -4;
+        return -999;
+    }
+}
+
+// Same page written to a 24-bit BMP at layout->dpi (default 300), for tests.
+extern "C" __declspec(dllexport) int camera_start_print_to_file(const unsigned char* data, unsigned long long size,
+                                                              const CameraPrintLayout* layout,
+                                                              const wchar_t* output_path) {
+    try {
+        if (!output_path || !*output_path) {
+            return -2;
+        }
+        return StartPrintJob(data, size, layout, L"", output_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_print_to_file: " << e.what() << "\n";
+        g_print_state = -4;
+        return -999;
+    }
+}
+
+// Multi-up sheet: the photos are composited band by band and each band goes
+// to the printer (or BMP) as soon as it is done.
+static int StartSheetJob(const unsigned char* const* images, const unsigned long long* sizes, int image_count,
+                         const CameraSheetCell* cells, int cell_count, const CameraPrintLayout* layout,
+                         unsigned int background, const std::wstring& printer, const std::wstring& output_path) {
+    constexpr double kSlackIn = 0.01;  // rounding in the caller's layout maths
+    if (!images || !sizes || image_count <= 0 || !cells || cell_count <= 0 || !layout ||
+        layout->width_in <= 0.0 || layout->height_in <= 0.0) {
+        return -2;
+    }
+    std::vector<std::vector<uint8_t>> photos(image_count);
+    for (int i = 0; i < image_count; ++i) {
+        if (!images[i] || sizes[i] == 0) {
+            return -2;
+        }
+        photos[i].assign(images[i], images[i] + sizes[i]);
+    }
+    for (int i = 0; i < cell_count; ++i) {
+        const CameraSheetCell& c = cells[i];
+        if (c.source < 0 || c.source >= image_count || c.width_in <= 0.0 || c.height_in <= 0.0 ||
+            c.x_in < -kSlackIn || c.y_in < -kSlackIn || c.x_in + c.width_in > layout->width_in + kSlackIn ||
+            c.y_in + c.height_in > layout->height_in + kSlackIn) {
+            return -2;
+        }
+    }
+
+    return LaunchPrintJob([photos = std::move(photos), cell_list = std::vector<CameraSheetCell>(cells, cells + cell_count),
+                           layout = *layout, background, printer, output_path,
+                           overlay = CurrentOverlay(), look = CurrentLook(),
+                           color = CurrentPrintColor(), dither = CurrentDither()](CameraPrintReport& report) {
+        PrinterPage page;
+        int state = OpenPrintTarget(layout, printer, output_path, page, report);
+        if (state != 0) {
+            return state;
+        }
+        const auto printer_transform = PrinterTransform(color, page, output_path.empty(), report);
+
+        SheetLayout sheet;
+        sheet.width = report.width;
+        sheet.height = report.height;
+        sheet.background[0] = static_cast<uint8_t>(background);
+        sheet.background[1] = static_cast<uint8_t>(background >> 8);
+        sheet.background[2] = static_cast<uint8_t>(background >> 16);
+        const auto to_px = [](double inches, double extent_in, int extent_px) {
+            return std::clamp(static_cast<int>(std::lround(inches * extent_px / extent_in)), 0, extent_px);
+        };
+        for (const CameraSheetCell& c : cell_list) {
+            SheetCell cell;
+            cell.x = to_px(c.x_in, layout.width_in, sheet.width);
+            cell.y = to_px(c.y_in, layout.height_in, sheet.height);
+            cell.width = to_px(c.x_in + c.width_in, layout.width_in, sheet.width) - cell.x;
+            cell.height = to_px(c.y_in + c.height_in, layout.height_in, sheet.height) - cell.y;
+            cell.source = c.source;
+            if (cell.width > 0 && cell.height > 0) {
+                sheet.cells.push_back(cell);
+            }
+        }
+        std::vector<SheetSource> sources;
+        for (const auto& photo : photos) {
+            sources.push_back({photo.data(), photo.size()});
+        }
+
+        const auto placed = overlay ? overlay->Place(sheet.width, sheet.height) : nullptr;
+        const PrintStages stages{look.get(), placed.get(), printer_transform.get(), dither};
+
+        PrintBmpWriter file;
+        const bool to_file = !output_path.empty();
+        const bool opened = to_file ? file.Open(output_path, sheet.width, sheet.height, report.dpi_x)
+                                    : page.BeginPage(L"SFace Kiosk sheet");
+        if (!opened) {
+            return -6;
+        }
+        bool sink_ok = true;
+        SheetRenderStats stats;
+        const bool rendered = RenderSheet(sheet, sources, layout.auto_rotate != 0, 0,
+            [&](const uint8_t* bgr, int stride, int y, int rows) {
+                sink_ok = to_file ? file.Write(bgr, stride, rows)
+                                  : page.DrawBand(bgr, stride, sheet.width, sheet.height, y, rows);
+                return sink_ok;
+            }, stats, stages);
+        const bool finished = to_file ? file.Close() : page.FinishPage(rendered && sink_ok);
+
+        report.decode_us = stats.decode_us;
+        report.resample_us = stats.render_us;
+        report.spool_us = stats.sink_us;
+        report.dither_us = stats.dither_us;
+        report.peak_bytes = stats.peak_bytes;
+        if (!rendered && sink_ok) {
+            state = -4;
+        } else if (!rendered || !finished) {
+            state = -6;
+        }
+        return state;
+    });
+}
+
+// Print several photos on one sheet (strip, grid) at the printer's own
+// resolution. cells place images[cell.source] in inches from the top-left
+// paper corner, filled edge to edge; background is 0xRRGGBB. Poll
+// camera_get_print_status.
+extern "C" __declspec(dllexport) int camera_start_print_sheet(const unsigned char* const* images,
+                                                            const unsigned long long* sizes, int image_count,
+                                                            const CameraSheetCell* cells, int cell_count,
+                                                            const CameraPrintLayout* layout, unsigned int background,
+                                                            const wchar_t* printer_name) {
+    try {
+        return StartSheetJob(images, sizes, image_count, cells, cell_count, layout, background,
+                             printer_name ? printer_name : L"", L"");
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_print_sheet: " << e.what() << "\n";
+        g_print_state = -4;
+        return -999;
+    }
+}
+
+// Same sheet streamed to a 24-bit BMP at layout->dpi (default 300).
+extern "C" __declspec(dllexport) int camera_start_print_sheet_to_file(const unsigned char* const* images,
+                                                                    const unsigned long long* sizes, int image_count,
+                                                                    const CameraSheetCell* cells, int cell_count,
+                                                                    const CameraPrintLayout* layout,
+                                                                    unsigned int background,
+                                                                    const wchar_t* output_path) {
+    try {
+        if (!output_path || !*output_path) {
+            return -2;
+        }
+        return StartSheetJob(images, sizes, image_count, cells, cell_count, layout, background, L"", output_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_print_sheet_to_file: " << e.what() << "\n";
+        g_print_state = -4;
+        return -999;
+    }
+}
+
+// 1 = printing, 0 = spooled, -1 = no job, -4 = image could not be rendered,
+// -5 = printer unavailable, -6 = spooler or file write failed. report may be
+// null; it is filled once the job has finished.
+extern "C" __declspec(dllexport) int camera_get_print_status(CameraPrintReport* report) {
+    const int state = g_print_state;
+    if (report && state != 1) {
+        std::lock_guard<std::mutex> lock(g_print_mutex);
+        *report = g_print_report;
+    }
+    return state;
+}
+
+// Keep finished print rasters in `directory` (null or "" = off), at most
+// max_bytes on disk, so reprinting a photo on the same page skips rendering.
+extern "C" __declspec(dllexport) int camera_set_print_cache(const wchar_t* directory, unsigned long long max_bytes) {
+    try {
+        if (directory && *directory && max_bytes == 0) {
+            return -2;
+        }
+        return g_print_cache.Configure(directory ? directory : L"", max_bytes) ? 0 : -3;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_set_print_cache: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Convert prints and sheets from sRGB to the printer's ICC profile, or to
+// `profile_path` (.icc/.icm, null or "" = the profile Windows associates with
+// the printer). intent: 0 perceptual, 1 relative colorimetric, 2 saturation,
+// 3 absolute colorimetric. The transform is baked on the first print that
+// needs it. 0 = set, -2 = bad args.
+extern "C" __declspec(dllexport) int camera_set_print_color_management(int enabled, int intent,
+                                                                     const wchar_t* profile_path) {
+    try {
+        if (intent < PrinterColorTransforms::kPerceptual || intent > PrinterColorTransforms::kAbsoluteColorimetric) {
+            return -2;
+        }
+        std::lock_guard<std::mutex> lock(g_print_color_mutex);
+        g_print_color.enabled = enabled != 0;
+        g_print_color.intent = intent;
+        g_print_color.profile = profile_path ? profile_path : L"";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_set_print_color_management: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Dither prints and sheets to 2^bits gray levels (bits 1-4) for printers that
+// take 1- to 4-bit input. mode: 0 off, 1 Floyd-Steinberg, 2 blue-noise
+// ordered. 0 = set, -2 = bad args.
+extern "C" __declspec(dllexport) int camera_set_print_dither(int mode, int bits) {
+    if (mode < static_cast<int>(DitherMode::kNone) || mode > static_cast<int>(DitherMode::kBlueNoise) || bits < 1 ||
+        bits > 4) {
+        return -2;
+    }
+    std::lock_guard<std::mutex> lock(g_print_dither_mutex);
+    g_print_dither.mode = static_cast<DitherMode>(mode);
+    g_print_dither.bits = bits;
+    return 0;
+}
+
+// Keep baked printer colour transforms in `directory` (null or "" = memory
+// only), so later runs skip building them.
+extern "C" __declspec(dllexport) int camera_set_color_transform_cache(const wchar_t* directory) {
+    try {
+        return g_printer_transforms.Configure(directory ? directory : L"") ? 0 : -3;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_set_color_transform_cache: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_get_print_cache_stats(CameraPrintCacheStats* stats) {
+    if (!stats) {
+        return -2;
+    }
+    const PrintCache::Stats s = g_print_cache.stats();
+    stats->hits = s.hits;
+    stats->misses = s.misses;
+    stats->entries = s.entries;
+    stats->bytes = s.bytes;
+    return 0;
+}
+
+// Composite a frame template over every print and sheet until cleared. See
+// overlay_template.h for the file format. Returns the layer count, -2 = bad
+// args, -4 = template or artwork unreadable (the previous one stays).
+extern "C" __declspec(dllexport) int camera_load_overlay_template(const wchar_t* path) {
+    try {
+        if (!path || !*path) {
+            return -2;
+        }
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        const bool needUninit = SUCCEEDED(hr);
+        auto overlay = std::make_shared<OverlayTemplate>();
+        bool loaded = false;
+        {
+            WicDecoder decoder;
+            loaded = decoder.ok() && overlay->Load(path, decoder, &g_template_assets);
+        }
+        if (needUninit) CoUninitialize();
+        if (!loaded) {
+            return -4;
+        }
+        std::lock_guard<std::mutex> lock(g_overlay_mutex);
+        g_overlay = overlay;
+        return overlay->layer_count();
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_load_overlay_template: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_clear_overlay_template() {
+    std::lock_guard<std::mutex> lock(g_overlay_mutex);
+    g_overlay.reset();
+    return 0;
+}
+
+// Keep template artwork converted to premultiplied tiles in `directory`
+// (null or "" = off), so loading a template seen before decodes nothing.
+extern "C" __declspec(dllexport) int camera_set_template_cache(const wchar_t* directory) {
+    try {
+        return g_template_assets.Configure(directory ? directory : L"") ? 0 : -3;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_set_template_cache: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_get_template_cache_stats(CameraTemplateCacheStats* stats) {
+    if (!stats) {
+        return -2;
+    }
+    const TemplateAssetCache::Stats s = g_template_assets.stats();
+    stats->hits = s.hits;
+    stats->misses = s.misses;
+    stats->entries = s.entries;
+    stats->bytes = s.bytes;
+    return 0;
+}
+
+// Composite the loaded template over a BGRA image in place (the framed
+// preview on screen uses the same artwork as the print). 0 = done, -1 = no
+// template, -2 = bad args.
+extern "C" __declspec(dllexport) int camera_apply_overlay_bgra(unsigned char* pixels, int width, int height,
+                                                             int stride) {
+    try {
+        if (!pixels || width <= 0 || height <= 0 || stride < width * 4) {
+            return -2;
+        }
+        const auto overlay = CurrentOverlay();
+        const auto placed = overlay ? overlay->Place(width, height) : nullptr;
+        if (!placed) {
+            return -1;
+        }
+        placed->Apply(pixels, stride);
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_apply_overlay_bgra: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Grade live view (fan-out pixel consumers) and every print and sheet with a
+// .cube 3D LUT until cleared. Returns the LUT size (points per axis), -2 =
+// bad args, -4 = unreadable or not a supported .cube (the previous one stays).
+extern "C" __declspec(dllexport) int camera_load_color_lut(const wchar_t* path) {
+    try {
+        if (!path || !*path) {
+            return -2;
+        }
+        auto look = std::make_shared<ColorLut>();
+        if (!look->LoadCube(path)) {
+            return -4;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_look_mutex);
+            g_look = look;
+        }
+        g_fanout.SetLut(look);
+        return look->size();
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_load_color_lut: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_clear_color_lut() {
+    {
+        std::lock_guard<std::mutex> lock(g_look_mutex);
+        g_look.reset();
+    }
+    g_fanout.SetLut(nullptr);
+    return 0;
+}
+
+// Grade a BGRA image in place with the loaded LUT (stills shown on screen
+// get the same look as the print). 0 = done, -1 = no LUT, -2 = bad args.
+extern "C" __declspec(dllexport) int camera_apply_color_lut_bgra(unsigned char* pixels, int width, int height,
+                                                               int stride) {
+    try {
+        if (!pixels || width <= 0 || height <= 0 || stride < width * 4) {
+            return -2;
+        }
+        const auto look = CurrentLook();
+        if (!look) {
+            return -1;
+        }
+        look->Apply(pixels, width, height, stride);
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_apply_color_lut_bgra: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Encode a BGRA image (alpha ignored) to JPEG. options may be null (quality
+// 90, standard tables, 4:2:0). *buffer is malloc'd (free with
+// camera_free_buffer). 0 = done, -2 = bad args, -4 = encode failed, -8 =
+// target_bytes cannot be met (no buffer; report->bytes is the smallest size
+// reachable, at quality 1). report may be null.
+extern "C" __declspec(dllexport) int camera_encode_jpeg_bgra(const unsigned char* pixels, int width, int height,
+                                                           int stride, const CameraJpegOptions* options,
+                                                           unsigned char** buffer, unsigned long long* size,
+                                                           CameraJpegReport* report) {
+    try {
+        if (!pixels || !buffer || !size || width <= 0 || height <= 0 || stride < width * 4) {
+            return -2;
+        }
+        *buffer = nullptr;
+        *size = 0;
+        JpegEncodeOptions encode;
+        if (options) {
+            encode.quality = options->quality;
+            encode.optimize_huffman = options->optimize_huffman != 0;
+            encode.subsample_chroma = options->subsample_chroma != 0;
+            encode.dpi = options->dpi;
+            encode.target_bytes = options->target_bytes;
+        }
+        std::vector<uint8_t> jpeg;
+        JpegEncodeStats stats;
+        if (!EncodeJpegBgra(pixels, width, height, stride, encode, jpeg, &stats)) {
+            std::cerr << "[ERR] JPEG encode failed: " << width << "x" << height << "\n";
+            return -4;
+        }
+        if (report) {
+            report->quality = stats.quality;
+            report->segments = stats.segments;
+            report->trials = stats.trials;
+            report->target_met = stats.target_met ? 1 : 0;
+            report->bytes = jpeg.size();
+            report->encode_us = stats.encode_us;
+        }
+        if (!stats.target_met) {
+            std::cerr << "[ERR] JPEG target of " << encode.target_bytes << " bytes not met: " << jpeg.size()
+                      << " bytes at quality 1\n";
+            return -8;
+        }
+        unsigned char* out = (unsigned char*)malloc(jpeg.size());
+        if (!out) {
+            return -4;
+        }
+        memcpy(out, jpeg.data(), jpeg.size());
+        *buffer = out;
+        *size = jpeg.size();
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_encode_jpeg_bgra: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Check that `data` is a complete JPEG or PNG and report its size, reading
+// only headers (verify = 0) or also JPEG scan markers and PNG CRCs (verify =
+// 1). 0 = valid, -2 = bad args, -4 = not JPEG/PNG, -5 = truncated,
+// -6 = malformed, -7 = CRC mismatch. info may be null.
+extern "C" __declspec(dllexport) int camera_validate_image(const unsigned char* data, unsigned long long size,
+                                                         int verify, CameraImageInfo* info) {
+    if (!data || size == 0) {
+        return -2;
+    }
+    ImageFormat format = kImageUnknown;
+    int width = 0, height = 0;
+    const ImageCheck check = ValidateImage(data, static_cast<size_t>(size), verify != 0, format, width, height);
+    if (info) {
+        info->format = format;
+        info->width = width;
+        info->height = height;
+    }
+    switch (check) {
+    case kImageOk:
+        return 0;
+    case kImageUnsupported:
+        return -4;
+    case kImageTruncated:
+        return -5;
+    case kImageMalformed:
+        return -6;
+    case kImageBadCrc:
+        return -7;
+    }
+    return -6;
+}
+
+// Record live view to an MJPEG AVI (no re-encode). fps is the file timebase.
+extern "C" __declspec(dllexport) int camera_start_recording(const wchar_t* output_path, int fps) {
+    try {
+        if (!output_path || fps <= 0) {
+            return -2;
+        }
+        if (g_recorder.recording()) {
+            return -3;
+        }
+        if (!g_recorder.Start(output_path, fps)) {
+            return -4;
+        }
+        std::cout << "[OK] Recording started\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_recording: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_stop_recording() {
+    try {
+        if (!g_recorder.recording()) {
+            return -1;
+        }
+        if (!g_recorder.Stop()) {
+            std::cerr << "[ERR] Recording could not be finalized\n";
+            return -4;
+        }
+        std::cout << "[OK] Recording stopped\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_stop_recording: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_get_recording_stats(CameraRecordingStats* stats) {
+    if (!stats) {
+        return -2;
+    }
+    const MjpegRecorder::Stats s = g_recorder.stats();
+    stats->frames_written = s.frames_written;
+    stats->frames_repeated = s.frames_repeated;
+    stats->frames_dropped = s.frames_dropped;
+    stats->bytes_written = s.bytes_written;
+    stats->recording = g_recorder.recording() ? 1 : 0;
+    return 0;
+}
+
+// Spool stills into `directory` instead of memory (null or "" = memory).
+// Spooled stills are returned as a path by camera_get_still().
+extern "C" __declspec(dllexport) int camera_set_still_spool(const wchar_t* directory) {
+    try {
+        return g_still.SetSpoolDirectory(directory ? directory : L"") ? 0 : -3;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_set_still_spool: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Fire the shutter. The file is transferred to the host in the background;
+// collect it with camera_get_still(). Returns the shot id (> 0).
+extern "C" __declspec(dllexport) long long camera_take_picture() {
+    try {
+        if (!g_camera || !g_sdk) {
+            return -1;
+        }
+        if (!g_still.attached()) {
+            return -2;
+        }
+        return g_still.TakePicture();
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_take_picture: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Pop the oldest finished still. Returns 1 if none is ready. On success
+// *buffer is malloc'd (free with camera_free_buffer), or null when the still
+// was spooled to info->path or info->error reports a failed shot.
+extern "C" __declspec(dllexport) int camera_get_still(CameraStillInfo* info, unsigned char** buffer,
+                                                     unsigned long long* size) {
+    try {
+        if (!info || !buffer || !size) {
+            return -2;
+        }
+
+        StillCapture::Shot shot;
+        if (!g_still.PopCompleted(shot)) {
+            return 1;
+        }
+
+        memset(info, 0, sizeof(*info));
+        info->shot_id = shot.id;
+        info->shutter_to_event_us = shot.shutter_to_event_us;
+        info->download_us = shot.download_us;
+        info->total_us = shot.total_us;
+        info->error = shot.error;
+        info->burst_index = shot.burst_index;
+        const size_t name_len = std::min(shot.file_name.size(), sizeof(info->file_name) - 1);
+        memcpy(info->file_name, shot.file_name.data(), name_len);
+        if (shot.path.size() < sizeof(info->path) / sizeof(info->path[0])) {
+            std::copy(shot.path.begin(), shot.path.end(), info->path);
+        } else {
+            info->error = -8;  // spooled, but the path does not fit
+        }
+
+        *buffer = nullptr;
+        *size = 0;
+        if (shot.data && !shot.data->empty()) {
+            unsigned char* copy = (unsigned char*)malloc(shot.data->size());
+            if (!copy) {
+                return -7;
+            }
+            memcpy(copy, shot.data->data(), shot.data->size());
+            *buffer = copy;
+            *size = shot.data->size();
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_get_still: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+// Count down `countdown_ms`, half-press `prefocus_lead_ms` before zero and
+// release on zero (compensated by the body's measured shutter lag). The
+// still arrives through camera_get_still() like any other shot.
+extern "C" __declspec(dllexport) int camera_start_countdown_capture(int countdown_ms, int prefocus_lead_ms) {
+    try {
+        if (countdown_ms < 0 || prefocus_lead_ms < 0) {
+            return -2;
+        }
+        if (!g_still.attached()) {
+            return -1;
+        }
+        if (!g_countdown.Start(&g_still, countdown_ms, prefocus_lead_ms)) {
+            return -3;
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_countdown_capture: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_cancel_countdown() {
+    g_countdown.Cancel();
+    return 0;
+}
+
+// 1 = counting down, 0 = fired, -1 = none, -4 = failed. report may be null.
+extern "C" __declspec(dllexport) int camera_get_countdown_status(CameraCountdownReport* report) {
+    CountdownCapture::Report r;
+    const int state = g_countdown.Status(&r);
+    if (report) {
+        report->shot_id = r.shot_id;
+        report->prefocus_us = r.prefocus_us;
+        report->fire_error_us = r.fire_error_us;
+        report->shutter_lag_us = r.shutter_lag_us;
+        report->lag_compensation_us = r.lag_compensation_us;
+        report->zero_to_release_us = r.zero_to_release_us;
+        report->prefocused = r.prefocused ? 1 : 0;
+        report->error = r.error;
+    }
+    return state;
+}
+
+// Fire `count` shots, the first after first_delay_ms and then every
+// interval_ms. Transfers overlap the following shots; stills arrive in
+// order through camera_get_still() with info->burst_index set.
+extern "C" __declspec(dllexport) int camera_start_burst(int count, int interval_ms, int first_delay_ms,
+                                                       int prefocus_lead_ms) {
+    try {
+        if (count <= 0 || interval_ms <= 0 || first_delay_ms < 0 || prefocus_lead_ms < 0) {
+            return -2;
+        }
+        if (!g_still.attached()) {
+            return -1;
+        }
+        if (!g_burst.Start(&g_still, count, interval_ms, first_delay_ms, prefocus_lead_ms)) {
+            return -3;
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_start_burst: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_cancel_burst() {
+    g_burst.Cancel();
+    return 0;
+}
+
+// 1 = running, 0 = all fired, -1 = none, -4 = cancelled. status may be null.
+extern "C" __declspec(dllexport) int camera_get_burst_status(CameraBurstStatus* status) {
+    BurstCapture::Status s;
+    const int state = g_burst.GetStatus(&s);
+    if (status) {
+        status->count = s.count;
+        status->fired = s.fired;
+        status->failed = s.failed;
+        status->max_fire_error_us = s.max_fire_error_us;
+        status->elapsed_us = s.elapsed_us;
+    }
+    return state;
+}
+
+// Publish every live view frame into shared memory `name` (slot_count
+// slots of slot_megabytes each). Readers use frame_shm::Reader.
+extern "C" __declspec(dllexport) int camera_enable_shared_frames(const char* name, int slot_count,
+                                                                int slot_megabytes) {
+    try {
+        if (!name || !*name || slot_count < 2 || slot_megabytes <= 0) {
+            return -2;
+        }
+        std::lock_guard<std::mutex> lock(g_shm_mutex);
+        if (!g_shm.Create(name, static_cast<uint32_t>(slot_count),
+                          static_cast<uint64_t>(slot_megabytes) * 1024 * 1024)) {
+            std::cerr << "[ERR] Shared frame ring could not be created\n";
+            return -3;
+        }
+        std::cout << "[OK] Publishing frames to shared memory '" << name << "'\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_enable_shared_frames: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_disable_shared_frames() {
+    std::lock_guard<std::mutex> lock(g_shm_mutex);
+    g_shm.Close();
+    return 0;
+}
+
+// Size of the shared native worker pool (<= 0: one less than the number of
+// cores). Must be called before any parallel job; returns -3 once it runs.
+extern "C" __declspec(dllexport) int camera_set_worker_threads(int count) {
+    return TaskScheduler::Instance().Configure(count) ? 0 : -3;
+}
+
+// Register a fan-out consumer: `format` is CAMERA_FANOUT_*, the image is
+// scaled to fit max_width x max_height (0 = unbounded, never upscaled) and
+// prepared at most max_fps times a second (<= 0: every frame). `transform`
+// is CAMERA_ROTATE_* | CAMERA_MIRROR, applied during decode (JPEG consumers
+// get an EXIF orientation tag).
+extern "C" __declspec(dllexport) int camera_register_fanout_consumer(int format, int max_width, int max_height,
+                                                                    int max_fps, int transform) {
+    try {
+        return g_fanout.Register(static_cast<FrameFanout::Format>(format), max_width, max_height, max_fps,
+                                 transform);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_register_fanout_consumer: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_unregister_fanout_consumer(int consumer_id) {
+    return g_fanout.Unregister(consumer_id) ? 0 : -1;
+}
+
+// Copy the consumer's latest prepared frame newer than `newer_than` into the
+// caller's buffer. Same contract as camera_get_frame_into: -8 with *length =
+// required size if the buffer is too small, 1 if there is nothing newer.
+extern "C" __declspec(dllexport) int camera_get_fanout_frame(int consumer_id, unsigned long long newer_than,
+                                                            unsigned char* buffer, unsigned long long capacity,
+                                                            unsigned long long* length, CameraFanoutFrame* frame) {
+    try {
+        if (!length || (!buffer && capacity > 0)) {
+            return -2;
+        }
+
+        FrameFanout::Frame f;
+        const int rc = g_fanout.Get(consumer_id, newer_than, f);
+        if (rc != 0) {
+            return rc;
+        }
+
+        const uint8_t* data = f.jpeg ? f.jpeg->data() : f.pixels->pixels.data();
+        const size_t size = f.jpeg ? f.jpeg->size() : f.pixels->pixels.size();
+        *length = size;
+        if (size > capacity) {
+            return -8;
+        }
+        memcpy(buffer, data, size);
+
+        if (frame) {
+            frame->sequence = f.sequence;
+            frame->captured_us = static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(f.captured_at.time_since_epoch()).count());
+            frame->format = f.format;
+            frame->width = f.pixels ? f.pixels->width : 0;
+            frame->height = f.pixels ? f.pixels->height : 0;
+            frame->stride = f.pixels ? f.pixels->stride : 0;
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in camera_get_fanout_frame: " << e.what() << "\n";
+        return -999;
+    }
+}
+
+extern "C" __declspec(dllexport) int camera_get_fanout_stats(CameraFanoutStats* stats) {
+    if (!stats) {
+        return -2;
+    }
+    const FrameFanout::Stats s = g_fanout.stats();
+    stats->frames_submitted = s.frames_submitted;
+    stats->frames_processed = s.frames_processed;
+    stats->decodes = s.decodes;
+    stats->resizes = s.resizes;
+    stats->conversions = s.conversions;
+    stats->transforms = s.transforms;
+    stats->deliveries = s.deliveries;
+    stats->grades = s.grades;
+    return 0;
+}
+
+extern "C" __declspec(dllexport) int camera_get_pixel_isa() {
+    return static_cast<int>(ActivePixelIsa());
+}
@@ -4,14 +4,318 @@
 extern "C" {
 #endif
 
+// Frame descriptor returned by camera_get_frame_ex. Versioned POD: the
+// caller sets struct_size = sizeof(CameraFrameDesc) as it was compiled; new
+// fields are only ever appended, and the library writes no more than
+// struct_size bytes.
+#define CAMERA_FRAME_DESC_VERSION 1
+
+#define CAMERA_FRAME_FLAG_DUPLICATE 0x1u  // same bytes as the previous frame
+#define CAMERA_FRAME_FLAG_WAKE      0x2u  // first frame after leaving idle
+#define CAMERA_FRAME_FLAG_REPLAY    0x4u  // from the replay backend, not a camera
+
+typedef struct CameraFrameDesc {
+    unsigned int struct_size;            // in: sizeof as known to the caller
+    unsigned int version;                // out: CAMERA_FRAME_DESC_VERSION
+    unsigned long long sequence;
+    unsigned long long captured_us;      // monotonic (QueryPerformanceCounter) time the download finished
+    unsigned long long download_us;      // EVF download duration
+    unsigned long long frames_missed;    // published since `newer_than` but never fetched
+    int width;                           // from the JPEG header, 0 if unknown
+    int height;
+    unsigned int flags;                  // CAMERA_FRAME_FLAG_*
+    unsigned int reserved;
+} CameraFrameDesc;
+
+// Idle-mode counters (see camera_set_idle_mode)
+typedef struct CameraIdleStats {
+    unsigned long long frames_captured;
+    unsigned long long frames_published;
+    unsigned long long frames_skipped;
+    unsigned long long wake_count;
+    unsigned long long idle_ms_total;
+    unsigned long long last_wake_latency_us;
+    int idle;
+} CameraIdleStats;
+
+// MJPEG recorder counters (see camera_start_recording)
+typedef struct CameraRecordingStats {
+    unsigned long long frames_written;
+    unsigned long long frames_repeated;
+    unsigned long long frames_dropped;
+    unsigned long long bytes_written;
+    int recording;
+} CameraRecordingStats;
+
+// One finished still (see camera_take_picture)
+typedef struct CameraStillInfo {
+    unsigned long long shot_id;              // 0 if fired from the camera body
+    unsigned long long shutter_to_event_us;  // shutter command -> transfer request
+    unsigned long long download_us;          // transfer request -> file on host
+    unsigned long long total_us;
+    int error;                               // 0 ok, negative: shot failed
+    int burst_index;                         // -1 unless part of a burst
+    char file_name[256];                     // name on the camera
+    wchar_t path[260];                       // spool file, empty for in-memory stills
+} CameraStillInfo;
+
+// Timing of one countdown capture (see camera_start_countdown_capture)
+typedef struct CameraCountdownReport {
+    unsigned long long shot_id;
+    unsigned long long prefocus_us;          // half-press round trip
+    long long fire_error_us;                 // release issued vs. planned
+    unsigned long long shutter_lag_us;       // measured on this shot
+    unsigned long long lag_compensation_us;  // applied from earlier shots
+    long long zero_to_release_us;            // estimated release vs. countdown zero
+    int prefocused;
+    int error;
+} CameraCountdownReport;
+
+// Progress of a burst (see camera_start_burst)
+typedef struct CameraBurstStatus {
+    long long max_fire_error_us;   // worst lateness vs. schedule
+    unsigned long long elapsed_us; // first to last release
+    int count;
+    int fired;
+    int failed;
+} CameraBurstStatus;
+
+// Fan-out consumers (see camera_register_fanout_consumer)
+#define CAMERA_FANOUT_JPEG 0  // EVF JPEG as received
+#define CAMERA_FANOUT_BGRA 1  // 8-bit B, G, R, A (A = 255)
+#define CAMERA_FANOUT_GRAY 2  // 8-bit luma
+
+// Fan-out orientation: clockwise rotation, optionally OR'd with
+// CAMERA_MIRROR (left-right flip after rotating, for a selfie preview)
+#define CAMERA_ROTATE_0 0
+#define CAMERA_ROTATE_90 1
+#define CAMERA_ROTATE_180 2
+#define CAMERA_ROTATE_270 3
+#define CAMERA_MIRROR 4
+
+typedef struct CameraFanoutFrame {
+    unsigned long long sequence;
+    unsigned long long captured_us;
+    int format;                     // CAMERA_FANOUT_*
+    int width;                      // 0 for JPEG
+    int height;
+    int stride;                     // bytes per row, 0 for JPEG
+} CameraFanoutFrame;
+
+typedef struct CameraFanoutStats {
+    unsigned long long frames_submitted;
+    unsigned long long frames_processed;
+    unsigned long long decodes;
+    unsigned long long resizes;
+    unsigned long long conversions;
+    unsigned long long transforms;
+    unsigned long long deliveries;
+    unsigned long long grades;      // colour LUT passes (camera_load_color_lut)
+} CameraFanoutStats;
+
+// Instruction set of the pixel kernels (see camera_get_pixel_isa)
+#define CAMERA_ISA_SCALAR 0
+#define CAMERA_ISA_SSE41 1
+#define CAMERA_ISA_AVX2 2
+
+// Borderless print page (see camera_start_print)
+typedef struct CameraPrintLayout {
+    double width_in;                // paper, e.g. 6 x 4 (landscape) or 4 x 6
+    double height_in;
+    int dpi;                        // file output only; printers use their own
+    int auto_rotate;                // turn the photo to the paper orientation
+} CameraPrintLayout;
+
+typedef struct CameraPrintReport {
+    int width;                      // raster in device pixels
+    int height;
+    int dpi_x;
+    int dpi_y;
+    unsigned long long decode_us;
+    unsigned long long resample_us;
+    unsigned long long convert_us;
+    unsigned long long spool_us;    // handing the page to the spooler / file
+    unsigned long long total_us;
+    int cache_hit;                  // 1 when the raster came from the print cache
+    unsigned long long peak_bytes;  // sheets: band buffers + decoded cells, at most
+    int color_managed;              // 1 when converted to the printer's ICC profile
+    unsigned long long color_us;    // getting the printer transform (baked on first use)
+    unsigned long long dither_us;   // 0 unless dithering is on
+} CameraPrintReport;
+
+// One photo slot of a print sheet, in inches from the top-left paper corner
+typedef struct CameraSheetCell {
+    double x_in;
+    double y_in;
+    double width_in;
+    double height_in;
+    int source;                     // index into the sheet's images
+} CameraSheetCell;
+
+typedef struct CameraPrintCacheStats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long entries;
+    unsigned long long bytes;       // on disk
+} CameraPrintCacheStats;
+
+typedef struct CameraTemplateCacheStats {
+    unsigned long long hits;        // artwork mapped without decoding
+    unsigned long long misses;      // decoded and converted
+    unsigned long long entries;
+    unsigned long long bytes;       // on disk
+} CameraTemplateCacheStats;
+
+// Image container (see camera_validate_image)
+#define CAMERA_IMAGE_UNKNOWN 0
+#define CAMERA_IMAGE_JPEG 1
+#define CAMERA_IMAGE_PNG 2
+
+typedef struct CameraImageInfo {
+    int format;                     // CAMERA_IMAGE_*
+    int width;
+    int height;
+} CameraImageInfo;
+
+// JPEG encode of BGRA images (see camera_encode_jpeg_bgra)
+typedef struct CameraJpegOptions {
+    int quality;                    // 1-100; the upper bound with target_bytes
+    int optimize_huffman;           // 1 = tables fitted to the image (smaller, one more pass)
+    int subsample_chroma;           // 1 = 4:2:0, 0 = 4:4:4
+    int dpi;                        // JFIF density, 0 = none
+    unsigned long long target_bytes;  // > 0: highest quality whose file fits
+} CameraJpegOptions;
+
+typedef struct CameraJpegReport {
+    int quality;                    // used, after size targeting
+    int segments;                   // restart intervals, encoded in parallel
+    int trials;                     // size estimates for target_bytes
+    int target_met;                 // 0: even quality 1 is over target_bytes
+    unsigned long long bytes;       // file size; on a missed target, the smallest possible
+    unsigned long long encode_us;
+} CameraJpegReport;
+
 // FFI-compatible function exports
 __declspec(dllexport) int camera_initialize();
+__declspec(dllexport) int camera_initialize_replay(const wchar_t* directory, int frame_interval_ms);
 __declspec(dllexport) int camera_terminate();
 __declspec(dllexport) int camera_start_liveview();
 __declspec(dllexport) int camera_stop_liveview();
 __declspec(dllexport) int camera_get_frame(unsigned char** buffer, unsigned long long* size);
 __declspec(dllexport) void camera_free_buffer(unsigned char* buffer);
 
+// Consumer pacing: the native capture thread slows down when registered
+// consumers stop acknowledging frames and speeds up again when they catch up.
+__declspec(dllexport) int camera_register_consumer();
+__declspec(dllexport) int camera_unregister_consumer(int consumer_id);
+__declspec(dllexport) int camera_get_frame_for(int consumer_id, unsigned char** buffer,
+                                               unsigned long long* size, unsigned long long* sequence);
+__declspec(dllexport) int camera_get_frame_ex(int consumer_id, unsigned long long newer_than,
+                                              unsigned char** buffer, unsigned long long* size,
+                                              CameraFrameDesc* desc);
+__declspec(dllexport) int camera_get_frame_into(int consumer_id, unsigned long long newer_than,
+                                                unsigned char* buffer, unsigned long long capacity,
+                                                unsigned long long* length, CameraFrameDesc* desc);
+__declspec(dllexport) int camera_ack_frame(int consumer_id, unsigned long long sequence);
+__declspec(dllexport) int camera_set_frame_interval(int min_interval_ms, int max_interval_ms);
+__declspec(dllexport) int camera_set_cpu_budget(int percent);
+__declspec(dllexport) int camera_get_frame_interval();
+
+// Idle mode: motion-gated live view for unattended booths
+__declspec(dllexport) int camera_set_idle_mode(int enabled, int idle_after_ms, int trickle_interval_ms);
+__declspec(dllexport) int camera_set_motion_sensitivity(int cell_threshold, int min_changed_permille);
+__declspec(dllexport) int camera_wake();
+__declspec(dllexport) int camera_get_idle_stats(CameraIdleStats* stats);
+
+// Pre-roll ring and boomerang (forward+reverse GIF) clips
+__declspec(dllexport) int camera_set_preroll(int seconds, int max_megabytes);
+__declspec(dllexport) int camera_start_boomerang(const wchar_t* output_path, int seconds, int max_side, int fps);
+__declspec(dllexport) int camera_get_boomerang_status(unsigned long long* encode_us);
+
+// Zero-transcode MJPEG AVI recording of live view
+__declspec(dllexport) int camera_start_recording(const wchar_t* output_path, int fps);
+__declspec(dllexport) int camera_stop_recording();
+__declspec(dllexport) int camera_get_recording_stats(CameraRecordingStats* stats);
+
+// Still capture, transferred to the host while live view keeps running
+__declspec(dllexport) int camera_set_still_spool(const wchar_t* directory);
+__declspec(dllexport) long long camera_take_picture();
+__declspec(dllexport) int camera_get_still(CameraStillInfo* info, unsigned char** buffer,
+                                           unsigned long long* size);
+
+// Countdown capture with half-press prefocus and shutter lag compensation
+__declspec(dllexport) int camera_start_countdown_capture(int countdown_ms, int prefocus_lead_ms);
+__declspec(dllexport) int camera_cancel_countdown();
+__declspec(dllexport) int camera_get_countdown_status(CameraCountdownReport* report);
+
+// Burst (photo strip): N shots on a fixed schedule, transfers pipelined
+__declspec(dllexport) int camera_start_burst(int count, int interval_ms, int first_delay_ms, int prefocus_lead_ms);
+__declspec(dllexport) int camera_cancel_burst();
+__declspec(dllexport) int camera_get_burst_status(CameraBurstStatus* status);
+
+// Shared-memory frame ring for out-of-process readers (see frame_shm.h)
+__declspec(dllexport) int camera_enable_shared_frames(const char* name, int slot_count, int slot_megabytes);
+__declspec(dllexport) int camera_disable_shared_frames();
+
+// Shared native worker pool (see task_scheduler.h)
+__declspec(dllexport) int camera_set_worker_threads(int count);
+
+// Fan-out: one decode per frame, shared by consumers with different format,
+// size and rate needs
+__declspec(dllexport) int camera_register_fanout_consumer(int format, int max_width, int max_height, int max_fps,
+                                                          int transform);
+__declspec(dllexport) int camera_unregister_fanout_consumer(int consumer_id);
+__declspec(dllexport) int camera_get_fanout_frame(int consumer_id, unsigned long long newer_than,
+                                                  unsigned char* buffer, unsigned long long capacity,
+                                                  unsigned long long* length, CameraFanoutFrame* frame);
+__declspec(dllexport) int camera_get_fanout_stats(CameraFanoutStats* stats);
+
+// Native print path: decode, cover-crop, resample at printer DPI, spool
+__declspec(dllexport) int camera_start_print(const unsigned char* data, unsigned long long size,
+                                             const CameraPrintLayout* layout, const wchar_t* printer_name);
+__declspec(dllexport) int camera_start_print_to_file(const unsigned char* data, unsigned long long size,
+                                                     const CameraPrintLayout* layout, const wchar_t* output_path);
+__declspec(dllexport) int camera_start_print_sheet(const unsigned char* const* images,
+                                                   const unsigned long long* sizes, int image_count,
+                                                   const CameraSheetCell* cells, int cell_count,
+                                                   const CameraPrintLayout* layout, unsigned int background,
+                                                   const wchar_t* printer_name);
+__declspec(dllexport) int camera_start_print_sheet_to_file(const unsigned char* const* images,
+                                                           const unsigned long long* sizes, int image_count,
+                                                           const CameraSheetCell* cells, int cell_count,
+                                                           const CameraPrintLayout* layout, unsigned int background,
+                                                           const wchar_t* output_path);
+__declspec(dllexport) int camera_get_print_status(CameraPrintReport* report);
+__declspec(dllexport) int camera_set_print_cache(const wchar_t* directory, unsigned long long max_bytes);
+__declspec(dllexport) int camera_get_print_cache_stats(CameraPrintCacheStats* stats);
+__declspec(dllexport) int camera_set_print_color_management(int enabled, int intent, const wchar_t* profile_path);
+__declspec(dllexport) int camera_set_color_transform_cache(const wchar_t* directory);
+__declspec(dllexport) int camera_set_print_dither(int mode, int bits);
+
+// Frame/sticker template composited over prints, sheets and BGRA images
+__declspec(dllexport) int camera_load_overlay_template(const wchar_t* path);
+__declspec(dllexport) int camera_clear_overlay_template();
+__declspec(dllexport) int camera_apply_overlay_bgra(unsigned char* pixels, int width, int height, int stride);
+__declspec(dllexport) int camera_set_template_cache(const wchar_t* directory);
+__declspec(dllexport) int camera_get_template_cache_stats(CameraTemplateCacheStats* stats);
+
+// 3D LUT colour grade (.cube) on live view pixels, prints, sheets and BGRA images
+__declspec(dllexport) int camera_load_color_lut(const wchar_t* path);
+__declspec(dllexport) int camera_clear_color_lut();
+__declspec(dllexport) int camera_apply_color_lut_bgra(unsigned char* pixels, int width, int height, int stride);
+
+// Parallel baseline JPEG encoder for composed BGRA images (uploads, print files)
+__declspec(dllexport) int camera_encode_jpeg_bgra(const unsigned char* pixels, int width, int height, int stride,
+                                                  const CameraJpegOptions* options, unsigned char** buffer,
+                                                  unsigned long long* size, CameraJpegReport* report);
+
+// Header-only JPEG/PNG validation (no pixel decode)
+__declspec(dllexport) int camera_validate_image(const unsigned char* data, unsigned long long size, int verify,
+                                                CameraImageInfo* info);
+
+// SIMD pixel kernels: active instruction set
+__declspec(dllexport) int camera_get_pixel_isa();
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
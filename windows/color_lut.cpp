@@ -0,0 +1,192 @@
+#include "color_lut.h"
+#include "content_hash.h"
+#include "pixel_kernels.h"
+#include "pixel_kernels_impl.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x554C4653;  // "SFLU"
+constexpr uint32_t kVersion = 1;
+
+struct LutFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t size;
+    uint32_t reserved;
+    uint64_t id;
+};
+
+uint64_t TableId(const std::vector<int16_t>& entries, int size) {
+    return HashBytes(entries.data(), entries.size() * sizeof(int16_t), static_cast<uint64_t>(size));
+}
+
+bool IsDataLine(const std::string& keyword) {
+    const char c = keyword[0];
+    return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+}
+
+// DOMAIN_MIN 0 0 0 / DOMAIN_MAX 1 1 1 are the only domains the kernel maps
+bool ReadDomain(std::istringstream& fields, float expected) {
+    float r = 0, g = 0, b = 0;
+    return static_cast<bool>(fields >> r >> g >> b) && r == expected && g == expected && b == expected;
+}
+
+}  // namespace
+
+bool ColorLut::LoadCube(const std::wstring& path) {
+    std::ifstream in(std::filesystem::path(path), std::ios::binary);
+    if (!in) {
+        std::cerr << "[ERR] Colour LUT not readable\n";
+        return false;
+    }
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return ParseCube(text);
+}
+
+bool ColorLut::ParseCube(const std::string& text) {
+    std::istringstream in(text);
+    std::string line;
+    std::string title;
+    int size = 0;
+    std::vector<float> rgb;
+    for (int number = 1; std::getline(in, line); ++number) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        bool ok = false;
+        if (IsDataLine(keyword)) {
+            std::istringstream values(line);
+            float r = 0, g = 0, b = 0;
+            std::string extra;
+            ok = size > 0 && rgb.size() < static_cast<size_t>(size) * size * size * 3 &&
+                 static_cast<bool>(values >> r >> g >> b) && !(values >> extra) && std::isfinite(r) &&
+                 std::isfinite(g) && std::isfinite(b);
+            if (ok) {
+                rgb.insert(rgb.end(), {r, g, b});
+            }
+        } else if (keyword == "TITLE") {
+            ok = static_cast<bool>(fields >> std::quoted(title));
+        } else if (keyword == "LUT_3D_SIZE") {
+            ok = size == 0 && static_cast<bool>(fields >> size) && size >= lut3d::kMinSize && size <= lut3d::kMaxSize;
+            if (ok) {
+                rgb.reserve(static_cast<size_t>(size) * size * size * 3);
+            }
+        } else if (keyword == "DOMAIN_MIN") {
+            ok = ReadDomain(fields, 0.0f);
+        } else if (keyword == "DOMAIN_MAX") {
+            ok = ReadDomain(fields, 1.0f);
+        } else if (keyword == "LUT_3D_INPUT_RANGE") {
+            float low = 0, high = 0;
+            ok = static_cast<bool>(fields >> low >> high) && low == 0.0f && high == 1.0f;
+        }
+        if (!ok) {
+            std::cerr << "[ERR] Colour LUT line " << number << " rejected: " << line << "\n";
+            return false;
+        }
+    }
+    if (size == 0 || rgb.size() != static_cast<size_t>(size) * size * size * 3) {
+        std::cerr << "[ERR] Colour LUT needs LUT_3D_SIZE and size^3 entries\n";
+        return false;
+    }
+    if (!Build(size, rgb)) {
+        return false;
+    }
+    title_ = title;
+    std::cout << "[OK] Colour LUT loaded: " << size << "^3" << (title.empty() ? "" : " ") << title << "\n";
+    return true;
+}
+
+bool ColorLut::Build(int size, const std::vector<float>& rgb) {
+    const size_t count = static_cast<size_t>(size) * size * size;
+    if (size < lut3d::kMinSize || size > lut3d::kMaxSize || rgb.size() != count * 3) {
+        return false;
+    }
+    // (r, g, b) floats to the kernel's (B, G, R, 0) int16 entries
+    std::vector<int16_t> entries(count * 4, 0);
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const float v = rgb[i * 3 + c];
+            const float clamped = v > 0.0f ? std::min(v, 1.0f) : 0.0f;  // NaN to 0
+            entries[i * 4 + 2 - c] = static_cast<int16_t>(std::lround(clamped * 255.0f * lut3d::kEntryScale));
+        }
+    }
+    entries_.swap(entries);
+    size_ = size;
+    title_.clear();
+    id_ = TableId(entries_, size);
+    return true;
+}
+
+bool ColorLut::Save(const std::wstring& path) const {
+    if (empty()) {
+        return false;
+    }
+    LutFileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.size = size_;
+    header.id = id_;
+    std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries_.data()),
+              static_cast<std::streamsize>(entries_.size() * sizeof(int16_t)));
+    // The last bytes only reach the disk on close
+    out.close();
+    return !out.fail();
+}
+
+bool ColorLut::Load(const std::wstring& path) {
+    std::ifstream in(std::filesystem::path(path), std::ios::binary);
+    LutFileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != kMagic || header.version != kVersion || header.size < lut3d::kMinSize ||
+        header.size > lut3d::kMaxSize) {
+        return false;
+    }
+    std::vector<int16_t> entries(static_cast<size_t>(header.size) * header.size * header.size * 4);
+    in.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(int16_t)));
+    if (!in || in.peek() != std::char_traits<char>::eof() || TableId(entries, header.size) != header.id) {
+        return false;  // truncated, trailing bytes or damaged
+    }
+    entries_.swap(entries);
+    size_ = header.size;
+    id_ = header.id;
+    title_.clear();
+    return true;
+}
+
+void ColorLut::ApplyRows(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst,
+                         int dst_stride) const {
+    if (!empty()) {
+        ApplyLut3dBgra(src, width, height, src_stride, dst, dst_stride, entries_.data(), size_);
+    }
+}
+
+void ColorLut::Apply(uint8_t* bgra, int width, int height, int stride) const {
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int bands = std::min(height, pool.worker_count() * 2);
+    if (empty() || bands <= 0) {
+        return;
+    }
+    pool.ParallelFor(bands, TaskScheduler::kHigh, [&](int band) {
+        const int begin = height * band / bands;
+        const int end = height * (band + 1) / bands;
+        uint8_t* rows = bgra + static_cast<size_t>(begin) * stride;
+        ApplyRows(rows, width, end - begin, stride, rows, stride);
+    });
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit content hash (XXH64) for cache keys: source photos, overlay
+// artwork, baked assets. Chain pieces by passing the previous hash as seed.
+uint64_t HashBytes(const void* data, size_t len, uint64_t seed = 0);
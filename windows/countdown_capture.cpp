@@ -0,0 +1,141 @@
+#include "countdown_capture.h"
+#include "precise_timer.h"
+#include <algorithm>
+#include <iostream>
+
+static int64_t SignedMicros(CountdownCapture::Clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+CountdownCapture::~CountdownCapture() {
+    Cancel();
+}
+
+bool CountdownCapture::Start(StillCapture* still, int countdown_ms, int prefocus_lead_ms) {
+    if (!still || countdown_ms < 0 || prefocus_lead_ms < 0) {
+        return false;
+    }
+    if (state_ == 1) {
+        return false;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    const auto zero = Clock::now() + std::chrono::milliseconds(countdown_ms);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_ = false;
+        report_ = Report();
+    }
+    state_ = 1;
+    thread_ = std::thread(&CountdownCapture::Run, this, still, zero,
+                          std::chrono::milliseconds(std::min(prefocus_lead_ms, countdown_ms)));
+    return true;
+}
+
+void CountdownCapture::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void CountdownCapture::ResetLag() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lag_estimate_us_ = 0;
+}
+
+int CountdownCapture::Status(Report* report) const {
+    if (report) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *report = report_;
+    }
+    return state_;
+}
+
+// Interruptible coarse wait, then a precise one for the final stretch.
+// Returns false if cancelled.
+bool CountdownCapture::WaitUntil(Clock::time_point deadline) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cv_.wait_until(lock, deadline - kCoarseMargin, [this] { return cancel_; })) {
+            return false;
+        }
+    }
+    SleepUntil(deadline);
+    return true;
+}
+
+void CountdownCapture::Run(StillCapture* still, Clock::time_point zero, Clock::duration lead) {
+    Report report;
+    uint64_t lag_us = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lag_us = lag_estimate_us_;
+    }
+
+    bool ok = true;
+    if (lead > Clock::duration::zero()) {
+        ok = WaitUntil(zero - lead);
+        if (ok) {
+            const auto pressed_at = Clock::now();
+            report.prefocused = still->PressHalfway();
+            report.prefocus_us = static_cast<uint64_t>(SignedMicros(Clock::now() - pressed_at));
+        }
+    }
+
+    // Issue the release early by the expected lag. TakePictureAt() grabs the
+    // SDK lock ahead of fire time itself; only the countdown wait is ours.
+    const auto fire_at = zero - std::chrono::microseconds(lag_us);
+    if (ok) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ok = !cv_.wait_until(lock, fire_at - kCoarseMargin, [this] { return cancel_; });
+    }
+
+    if (!ok) {
+        if (report.prefocused) {
+            still->ReleaseShutter();
+        }
+        report.error = -5;
+        std::lock_guard<std::mutex> lock(mutex_);
+        report_ = report;
+        state_ = -4;
+        return;
+    }
+
+    StillCapture::FireTiming timing;
+    const int64_t id = still->TakePictureAt(fire_at, !report.prefocused, &timing);
+    if (id <= 0) {
+        if (report.prefocused) {
+            still->ReleaseShutter();
+        }
+        report.error = static_cast<int>(id);
+        std::lock_guard<std::mutex> lock(mutex_);
+        report_ = report;
+        state_ = -4;
+        return;
+    }
+
+    report.shot_id = static_cast<uint64_t>(id);
+    report.fire_error_us = SignedMicros(timing.issued_at - fire_at);
+    report.shutter_lag_us = timing.command_us;
+    report.lag_compensation_us = lag_us;
+    report.zero_to_release_us = SignedMicros(timing.issued_at + std::chrono::microseconds(timing.command_us) - zero);
+
+    std::cout << "[OK] Countdown shot " << report.shot_id << ": release " << report.zero_to_release_us
+              << " us from zero (lag " << report.shutter_lag_us << " us, timer error "
+              << report.fire_error_us << " us)\n";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // EWMA, alpha = 1/4: follows a body change within a few shots without
+    // chasing one slow release.
+    lag_estimate_us_ = lag_estimate_us_ == 0 ? timing.command_us
+                                             : (lag_estimate_us_ * 3 + timing.command_us) / 4;
+    report_ = report;
+    state_ = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "still_capture.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Countdown capture with prefocus. `prefocus_lead_ms` before zero the shutter
+// is half-pressed so AF/AE are settled, then the full press (without AF) is
+// issued early by the shutter lag measured on previous shots of this body,
+// so the release lands on zero instead of one lag later.
+//
+// The lag is the release command round trip: the body answers once the
+// shutter has been released, which is as close to exposure as EDSDK lets us
+// observe. It is smoothed across shots (EWMA) and reset per session.
+class CountdownCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Report {
+        uint64_t shot_id = 0;
+        int error = 0;
+        bool prefocused = false;
+        uint64_t prefocus_us = 0;         // half-press round trip
+        int64_t fire_error_us = 0;        // command issued vs. planned (timer accuracy)
+        uint64_t shutter_lag_us = 0;      // measured on this shot
+        uint64_t lag_compensation_us = 0; // applied (estimate before this shot)
+        int64_t zero_to_release_us = 0;   // estimated release vs. countdown zero
+    };
+
+    ~CountdownCapture();
+
+    // Starts the countdown now. Returns false if one is already running.
+    bool Start(StillCapture* still, int countdown_ms, int prefocus_lead_ms);
+    void Cancel();
+    // Forget the learned lag (new body / session).
+    void ResetLag();
+
+    // 1 = counting down, 0 = fired, -1 = nothing started, -4 = failed/cancelled
+    int Status(Report* report) const;
+
+private:
+    void Run(StillCapture* still, Clock::time_point zero, Clock::duration lead);
+    bool WaitUntil(Clock::time_point deadline);
+
+    static constexpr auto kCoarseMargin = std::chrono::milliseconds(100);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool cancel_ = false;
+    std::atomic<int> state_{-1};
+    Report report_;
+    uint64_t lag_estimate_us_ = 0;
+};
@@ -0,0 +1,63 @@
+#include "disk_cache.h"
+#include <cwchar>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static constexpr wchar_t kTempExtension[] = L".tmp";
+
+std::wstring DiskCachePath(const std::wstring& directory, uint64_t key, const wchar_t* extension) {
+    wchar_t name[17];
+    std::swprintf(name, 17, L"%016llx", static_cast<unsigned long long>(key));
+    return (fs::path(directory) / (std::wstring(name) + extension)).wstring();
+}
+
+bool ParseDiskCacheName(const fs::path& path, const wchar_t* extension, uint64_t& key) {
+    const std::wstring stem = path.stem().wstring();
+    if (path.extension() != extension || stem.size() != 16) {
+        return false;
+    }
+    wchar_t* parsed = nullptr;
+    key = std::wcstoull(stem.c_str(), &parsed, 16);
+    return parsed == stem.c_str() + 16;
+}
+
+bool PrepareDiskCacheDirectory(const std::wstring& directory) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!fs::is_directory(directory, ec)) {
+        return false;
+    }
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == kTempExtension) {
+            std::error_code ignored;
+            fs::remove(it->path(), ignored);  // interrupted write
+        }
+    }
+    return true;
+}
+
+bool ReplaceDiskCacheEntry(const std::wstring& path, const std::function<bool(const std::wstring& temp)>& write) {
+    const std::wstring temp = path + kTempExtension;
+    std::error_code ec;
+    if (write(temp)) {
+        fs::rename(temp, path, ec);  // e.g. fails while another process maps `path`
+        if (!ec) {
+            return true;
+        }
+    }
+    fs::remove(temp, ec);
+    return false;
+}
+
+bool WriteDiskCacheEntry(const std::wstring& path, std::initializer_list<DiskCacheChunk> chunks) {
+    return ReplaceDiskCacheEntry(path, [&](const std::wstring& temp) {
+        std::ofstream out(fs::path(temp), std::ios::binary | std::ios::trunc);
+        for (const DiskCacheChunk& chunk : chunks) {
+            out.write(static_cast<const char*>(chunk.data), static_cast<std::streamsize>(chunk.size));
+        }
+        out.close();  // before the rename, and so a failed flush counts
+        return static_cast<bool>(out);
+    });
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <string>
+
+// File handling shared by the on-disk caches (print rasters, template tiles,
+// printer colour tables). Each entry is one file named after its 64-bit key,
+// written aside and renamed into place, so a crash never leaves a
+// half-written entry under a valid name.
+
+// `directory`\<key as 16 hex digits><extension>
+std::wstring DiskCachePath(const std::wstring& directory, uint64_t key, const wchar_t* extension);
+
+// The key of a file named by DiskCachePath; false for any other file.
+bool ParseDiskCacheName(const std::filesystem::path& path, const wchar_t* extension, uint64_t& key);
+
+// Creates `directory` if needed and deletes the .tmp files interrupted
+// writes left in it. False if it is not a usable directory.
+bool PrepareDiskCacheDirectory(const std::wstring& directory);
+
+// Replaces the entry at `path`: `write` fills the temporary file it is given,
+// which is then renamed over `path`. On any failure the temporary file is
+// removed and whatever was at `path` before is left as it was.
+bool ReplaceDiskCacheEntry(const std::wstring& path, const std::function<bool(const std::wstring& temp)>& write);
+
+struct DiskCacheChunk {
+    const void* data;
+    size_t size;
+};
+
+// ReplaceDiskCacheEntry writing `chunks` back to back.
+bool WriteDiskCacheEntry(const std::wstring& path, std::initializer_list<DiskCacheChunk> chunks);
@@ -0,0 +1,67 @@
+#include "evf_ring.h"
+
+void EvfRing::Configure(int window_ms, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_ms_ = window_ms > 0 ? window_ms : 0;
+    max_bytes_ = max_bytes;
+    if (window_ms_ == 0) {
+        frames_.clear();
+        bytes_ = 0;
+        return;
+    }
+    EvictLocked(Clock::now());
+}
+
+bool EvfRing::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return window_ms_ > 0;
+}
+
+void EvfRing::Push(const JpegBytes& jpeg, Clock::time_point captured_at) {
+    if (!jpeg || jpeg->empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (window_ms_ == 0) {
+        return;
+    }
+    bytes_ += jpeg->size();
+    frames_.push_back(Frame{jpeg, captured_at});
+    EvictLocked(captured_at);
+}
+
+void EvfRing::EvictLocked(Clock::time_point now) {
+    const auto horizon = now - std::chrono::milliseconds(window_ms_);
+    while (!frames_.empty() &&
+           (frames_.front().captured_at < horizon || (max_bytes_ > 0 && bytes_ > max_bytes_))) {
+        bytes_ -= frames_.front().jpeg->size();
+        frames_.pop_front();
+    }
+}
+
+std::vector<EvfRing::Frame> EvfRing::Snapshot(int window_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Frame> out;
+    if (frames_.empty()) {
+        return out;
+    }
+    const auto horizon = frames_.back().captured_at - std::chrono::milliseconds(window_ms);
+    for (const Frame& f : frames_) {
+        if (window_ms <= 0 || f.captured_at >= horizon) {
+            out.push_back(f);
+        }
+    }
+    return out;
+}
+
+size_t EvfRing::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+void EvfRing::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_.clear();
+    bytes_ = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "frame_types.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Pre-roll buffer of the most recent EVF frames, kept as the JPEG bytes the
+// camera sent (never decoded). Bounded both by time window and total bytes;
+// the oldest frames are evicted first. Snapshot() hands out shared
+// references, so an encoder can work on a snapshot while capture continues.
+class EvfRing {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        JpegBytes jpeg;
+        Clock::time_point captured_at;
+    };
+
+    // window_ms <= 0 disables the ring and drops what it holds.
+    void Configure(int window_ms, size_t max_bytes);
+    bool enabled() const;
+
+    void Push(const JpegBytes& jpeg, Clock::time_point captured_at);
+
+    // Frames captured within the last `window_ms`, oldest first.
+    std::vector<Frame> Snapshot(int window_ms) const;
+
+    size_t bytes() const;
+    void Clear();
+
+private:
+    void EvictLocked(Clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::deque<Frame> frames_;
+    size_t bytes_ = 0;
+    int window_ms_ = 0;
+    size_t max_bytes_ = 0;
+};
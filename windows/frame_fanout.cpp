@@ -0,0 +1,374 @@
+#include "frame_fanout.h"
+#include "image_probe.h"
+#include "pixel_kernels.h"
+#include "precise_timer.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+FrameFanout::~FrameFanout() {
+    Shutdown();
+}
+
+// Largest size that fits max_width x max_height with the source aspect,
+// never bigger than the source.
+static void FitSize(int src_w, int src_h, int max_w, int max_h, int& w, int& h) {
+    double scale = 1.0;
+    if (max_w > 0) scale = std::min(scale, static_cast<double>(max_w) / src_w);
+    if (max_h > 0) scale = std::min(scale, static_cast<double>(max_h) / src_h);
+    w = std::max(1, static_cast<int>(std::lround(src_w * scale)));
+    h = std::max(1, static_cast<int>(std::lround(src_h * scale)));
+}
+
+// EXIF orientation (1-8) that makes a viewer display the image with
+// `transform` applied, indexed by PixelTransform.
+static const uint8_t kExifOrientation[8] = {1, 6, 3, 8, 2, 5, 4, 7};
+
+// Copy of `jpeg` with a minimal EXIF APP1 segment carrying the orientation,
+// placed after SOI (and JFIF APP0, if any). The entropy-coded data is not
+// touched. Returns the input unchanged if it already has EXIF.
+static JpegBytes WithOrientationTag(const JpegBytes& jpeg, int transform) {
+    const std::vector<uint8_t>& in = *jpeg;
+    if (in.size() < 4 || in[0] != 0xFF || in[1] != 0xD8) {
+        return jpeg;
+    }
+
+    size_t insert_at = 2;
+    for (size_t pos = 2; pos + 4 <= in.size() && in[pos] == 0xFF && in[pos + 1] >= 0xE0 && in[pos + 1] <= 0xEF;) {
+        const size_t seg_len = (static_cast<size_t>(in[pos + 2]) << 8) | in[pos + 3];
+        if (in[pos + 1] == 0xE1 && pos + 10 <= in.size() && std::memcmp(&in[pos + 4], "Exif\0", 5) == 0) {
+            return jpeg;
+        }
+        if (in[pos + 1] == 0xE0 && pos == 2) {
+            insert_at = pos + 2 + seg_len;
+        }
+        pos += 2 + seg_len;
+    }
+    if (insert_at > in.size()) {
+        return jpeg;
+    }
+
+    // APP1, "Exif\0\0", little-endian TIFF header, IFD0 with one entry:
+    // Orientation (0x0112), SHORT, count 1
+    const uint8_t segment[] = {
+        0xFF, 0xE1, 0x00, 0x22, 'E', 'x', 'i', 'f', 0x00, 0x00,
+        'I', 'I', 0x2A, 0x00, 0x08, 0x00, 0x00, 0x00,
+        0x01, 0x00,
+        0x12, 0x01, 0x03, 0x00, 0x01, 0x00, 0x00, 0x00, kExifOrientation[transform & 7], 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+    };
+    auto out = std::make_shared<std::vector<uint8_t>>();
+    out->reserve(in.size() + sizeof(segment));
+    out->insert(out->end(), in.begin(), in.begin() + insert_at);
+    out->insert(out->end(), segment, segment + sizeof(segment));
+    out->insert(out->end(), in.begin() + insert_at, in.end());
+    return out;
+}
+
+int FrameFanout::Register(Format format, int max_width, int max_height, int max_fps, int transform) {
+    if (format < kJpeg || format > kGray || max_width < 0 || max_height < 0 ||
+        transform < 0 || transform > (kRotate270 | kMirror)) {
+        return -2;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Consumer c;
+    c.format = format;
+    c.max_width = max_width;
+    c.max_height = max_height;
+    c.transform = transform;
+    c.interval = max_fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / max_fps
+                             : Clock::duration::zero();
+    const int id = next_id_++;
+    consumers_.emplace(id, std::move(c));
+    consumer_count_ = static_cast<int>(consumers_.size());
+
+    if (!worker_.joinable()) {
+        stop_ = false;
+        worker_ = std::thread(&FrameFanout::WorkerLoop, this);
+    }
+    return id;
+}
+
+bool FrameFanout::Unregister(int consumer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool erased = consumers_.erase(consumer_id) > 0;
+    consumer_count_ = static_cast<int>(consumers_.size());
+    return erased;
+}
+
+void FrameFanout::SetLut(std::shared_ptr<const ColorLut> lut) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lut_ = std::move(lut);
+}
+
+void FrameFanout::Submit(const JpegBytes& jpeg, uint64_t sequence, Clock::time_point captured_at) {
+    if (!jpeg || consumer_count_ == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = jpeg;
+        pending_seq_ = sequence;
+        pending_at_ = captured_at;
+        ++stats_.frames_submitted;
+    }
+    cv_.notify_one();
+}
+
+int FrameFanout::Get(int consumer_id, uint64_t newer_than, Frame& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = consumers_.find(consumer_id);
+    if (it == consumers_.end()) {
+        return -1;
+    }
+    if (it->second.latest.sequence == 0 || it->second.latest.sequence <= newer_than) {
+        return 1;
+    }
+    out = it->second.latest;
+    return 0;
+}
+
+void FrameFanout::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumers_.clear();
+    consumer_count_ = 0;
+    pending_.reset();
+}
+
+FrameFanout::Stats FrameFanout::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FrameFanout::WorkerLoop() {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    const bool needUninit = SUCCEEDED(hr);
+
+    {
+        WicDecoder decoder;
+        if (!decoder.ok()) {
+            std::cerr << "[ERR] Frame fan-out: WIC unavailable, only JPEG consumers are served\n";
+        }
+
+        while (true) {
+            JpegBytes jpeg;
+            uint64_t seq = 0;
+            Clock::time_point captured_at;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || pending_; });
+                if (stop_) {
+                    break;
+                }
+                jpeg = std::move(pending_);
+                pending_.reset();
+                seq = pending_seq_;
+                captured_at = pending_at_;
+            }
+
+            const auto cpu_start = ThreadCpuTime();
+            int width = 0, height = 0;
+            if (!ProbeJpegSize(jpeg->data(), jpeg->size(), width, height) &&
+                !(decoder.ok() && decoder.GetSize(jpeg->data(), jpeg->size(), width, height))) {
+                width = height = 0;
+            }
+            Process(jpeg, seq, captured_at, decoder, width, height);
+            cpu_us_ += static_cast<uint64_t>((ThreadCpuTime() - cpu_start).count());
+        }
+    }
+
+    if (needUninit) CoUninitialize();
+}
+
+void FrameFanout::Process(const JpegBytes& jpeg, uint64_t sequence, Clock::time_point captured_at,
+                          WicDecoder& decoder, int src_width, int src_height) {
+    // Pick the consumers that are due and the shape each of them wants
+    std::vector<Job> jobs;
+    std::shared_ptr<const ColorLut> lut;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lut = lut_;
+        const auto now = Clock::now();
+        for (auto& [id, c] : consumers_) {
+            if (now < c.next_due) {
+                continue;
+            }
+            c.next_due = std::max(c.next_due + c.interval, now);
+            Job job{id, c.format, 0, 0, c.transform};
+            if (c.format != kJpeg) {
+                if (src_width <= 0 || src_height <= 0 || !decoder.ok()) {
+                    continue;
+                }
+                int oriented_w = 0, oriented_h = 0;
+                TransformedSize(c.transform, src_width, src_height, oriented_w, oriented_h);
+                FitSize(oriented_w, oriented_h, c.max_width, c.max_height, job.width, job.height);
+            }
+            jobs.push_back(job);
+        }
+    }
+    if (jobs.empty()) {
+        return;
+    }
+
+    // One decode, at the smallest DCT scale that still covers every request,
+    // written out in the orientation of the largest request
+    int decode_side = 0;
+    int base_transform = kRotate0;
+    bool need_pixels = false;
+    for (const Job& job : jobs) {
+        if (job.format != kJpeg && std::max(job.width, job.height) > decode_side) {
+            need_pixels = true;
+            decode_side = std::max(job.width, job.height);
+            base_transform = job.transform;
+        }
+    }
+
+    Stats local;
+    Pixels base;
+    if (need_pixels) {
+        auto decoded = std::make_shared<DecodedImage>();
+        if (decoder.DecodeBgra(jpeg->data(), jpeg->size(), decode_side, *decoded, base_transform)) {
+            ++local.decodes;
+            if (lut && !lut->empty()) {
+                // Graded before sharing: everything below derives from the graded frame.
+                // Bands run on pool threads are timed there; the worker's own
+                // bands are already in its thread time.
+                TaskScheduler& pool = TaskScheduler::Instance();
+                const int height = decoded->height;
+                const int bands = std::min(height, pool.worker_count() * 2);
+                const std::thread::id worker = std::this_thread::get_id();
+                pool.ParallelFor(bands, TaskScheduler::kHigh, [&](int band) {
+                    const auto band_start = ThreadCpuTime();
+                    const int begin = height * band / bands;
+                    const int end = height * (band + 1) / bands;
+                    uint8_t* rows = decoded->pixels.data() + static_cast<size_t>(begin) * decoded->stride;
+                    lut->ApplyRows(rows, decoded->width, end - begin, decoded->stride, rows, decoded->stride);
+                    if (std::this_thread::get_id() != worker) {
+                        cpu_us_ += static_cast<uint64_t>((ThreadCpuTime() - band_start).count());
+                    }
+                });
+                ++local.grades;
+            }
+            base = std::move(decoded);
+        }
+    }
+
+    // Every distinct shape is produced once and shared by all who asked for it
+    std::map<std::tuple<int, int, int, int>, Pixels> derived;
+    std::function<Pixels(int, int, int)> bgra_at = [&](int w, int h, int transform) -> Pixels {
+        auto key = std::make_tuple(static_cast<int>(kBgra), w, h, transform);
+        auto it = derived.find(key);
+        if (it != derived.end()) {
+            return it->second;
+        }
+        auto img = std::make_shared<DecodedImage>();
+        Pixels out;
+        if (transform != base_transform) {
+            // Consumers disagree on orientation: scale in the decoded
+            // orientation, then turn the (smaller) result
+            const int relative = RelativeTransform(base_transform, transform);
+            int bw = 0, bh = 0;
+            TransformedSize(relative, w, h, bw, bh);
+            Pixels scaled = bgra_at(bw, bh, base_transform);
+            img->width = w;
+            img->height = h;
+            img->channels = 4;
+            img->stride = w * 4;
+            img->pixels.resize(static_cast<size_t>(img->stride) * h);
+            TransformImage(scaled->pixels.data(), bw, bh, scaled->stride, 4, relative,
+                           img->pixels.data(), img->stride);
+            ++local.transforms;
+            out = std::move(img);
+        } else if (base->width == w && base->height == h) {
+            out = base;
+        } else {
+            img->width = w;
+            img->height = h;
+            img->channels = 4;
+            img->stride = w * 4;
+            img->pixels.resize(static_cast<size_t>(img->stride) * h);
+            ResizeBilinearBgra(base->pixels.data(), base->width, base->height, base->stride,
+                               img->pixels.data(), w, h, img->stride);
+            ++local.resizes;
+            out = std::move(img);
+        }
+        derived.emplace(key, out);
+        return out;
+    };
+    auto gray_at = [&](int w, int h, int transform) -> Pixels {
+        auto key = std::make_tuple(static_cast<int>(kGray), w, h, transform);
+        auto it = derived.find(key);
+        if (it != derived.end()) {
+            return it->second;
+        }
+        // Scale first, then convert the (smaller) result
+        Pixels bgra = bgra_at(w, h, transform);
+        auto img = std::make_shared<DecodedImage>();
+        img->width = w;
+        img->height = h;
+        img->channels = 1;
+        img->stride = w;
+        img->pixels.resize(static_cast<size_t>(w) * h);
+        BgraToGray(bgra->pixels.data(), w, h, bgra->stride, img->pixels.data(), img->stride);
+        ++local.conversions;
+        Pixels out = std::move(img);
+        derived.emplace(key, out);
+        return out;
+    };
+
+    JpegBytes tagged[8];
+    std::vector<std::pair<int, Frame>> ready;
+    ready.reserve(jobs.size());
+    for (const Job& job : jobs) {
+        Frame frame;
+        frame.sequence = sequence;
+        frame.captured_at = captured_at;
+        frame.format = job.format;
+        if (job.format == kJpeg) {
+            if (job.transform == kRotate0) {
+                frame.jpeg = jpeg;
+            } else {
+                if (!tagged[job.transform]) {
+                    tagged[job.transform] = WithOrientationTag(jpeg, job.transform);
+                }
+                frame.jpeg = tagged[job.transform];
+            }
+        } else if (!base) {
+            continue;
+        } else {
+            frame.pixels = job.format == kBgra ? bgra_at(job.width, job.height, job.transform)
+                                               : gray_at(job.width, job.height, job.transform);
+        }
+        ready.emplace_back(job.id, std::move(frame));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [id, frame] : ready) {
+        auto it = consumers_.find(id);
+        if (it != consumers_.end()) {
+            it->second.latest = std::move(frame);
+            ++stats_.deliveries;
+        }
+    }
+    ++stats_.frames_processed;
+    stats_.decodes += local.decodes;
+    stats_.resizes += local.resizes;
+    stats_.conversions += local.conversions;
+    stats_.transforms += local.transforms;
+    stats_.grades += local.grades;
+}
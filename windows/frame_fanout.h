@@ -0,0 +1,129 @@
+#pragma once
+#include "color_lut.h"
+#include "frame_types.h"
+#include "image_decode.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Fans live view out to consumers that want it in different shapes: raw
+// JPEG for a recorder, BGRA at screen size for a preview, a small luma
+// thumbnail for analysis, each at its own maximum rate.
+//
+// Per frame, only the consumers that are due are served. The JPEG is decoded
+// at most once, at the smallest DCT scale that covers the largest request;
+// every distinct (format, width, height) is then derived once from that and
+// handed out as a shared immutable buffer. Consumers asking for the same
+// shape share the same pixels, so another consumer only costs the
+// conversions nobody else needed.
+//
+// Each consumer can ask for its own orientation (rotation for portrait
+// mounts, mirror for a selfie preview). Pixels are decoded straight into the
+// orientation of the largest consumer, so that costs nothing extra; JPEG
+// consumers get the orientation as an EXIF tag instead of re-encoding.
+//
+// Submit() is called by the capture thread and never blocks on decoding; the
+// worker keeps only the newest frame, so a slow derivation drops frames
+// instead of queueing them.
+class FrameFanout {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Pixels = std::shared_ptr<const DecodedImage>;
+
+    enum Format { kJpeg = 0, kBgra = 1, kGray = 2 };
+
+    struct Frame {
+        uint64_t sequence = 0;
+        Clock::time_point captured_at{};
+        Format format = kJpeg;
+        JpegBytes jpeg;   // kJpeg
+        Pixels pixels;    // kBgra / kGray
+    };
+
+    struct Stats {
+        uint64_t frames_submitted = 0;
+        uint64_t frames_processed = 0;  // at least one consumer was due
+        uint64_t decodes = 0;
+        uint64_t resizes = 0;
+        uint64_t conversions = 0;       // BGRA -> luma
+        uint64_t transforms = 0;        // extra passes for a second orientation
+        uint64_t grades = 0;            // colour LUT passes
+        uint64_t deliveries = 0;
+    };
+
+    FrameFanout() = default;
+    ~FrameFanout();
+    FrameFanout(const FrameFanout&) = delete;
+    FrameFanout& operator=(const FrameFanout&) = delete;
+
+    // The image is scaled to fit max_width x max_height with its aspect kept
+    // (0 = no limit on that axis; never upscaled). max_fps <= 0 serves every
+    // frame. `transform` is a PixelTransform; the size limits apply to the
+    // transformed image. Returns the consumer id (> 0), or -2 on bad arguments.
+    int Register(Format format, int max_width, int max_height, int max_fps, int transform);
+    bool Unregister(int consumer_id);
+    bool has_consumers() const { return consumer_count_ > 0; }
+
+    // Grade pixel consumers with `lut` from the next frame on; null turns
+    // grading off.
+    void SetLut(std::shared_ptr<const ColorLut> lut);
+
+    void Submit(const JpegBytes& jpeg, uint64_t sequence, Clock::time_point captured_at);
+
+    // Latest frame prepared for `consumer_id` if newer than `newer_than`.
+    // Returns 0, 1 if there is nothing newer, -1 for an unknown consumer.
+    int Get(int consumer_id, uint64_t newer_than, Frame& out) const;
+
+    // Stops the worker and drops all consumers.
+    void Shutdown();
+
+    Stats stats() const;
+
+    // CPU time spent on frames so far, on the worker and on the pool threads
+    // that help grade, in microseconds. Only ever grows.
+    uint64_t cpu_us() const { return cpu_us_; }
+
+private:
+    struct Consumer {
+        Format format;
+        int max_width;
+        int max_height;
+        int transform;
+        Clock::duration interval;
+        Clock::time_point next_due{};
+        Frame latest;
+    };
+    struct Job {
+        int id;
+        Format format;
+        int width;
+        int height;
+        int transform;
+    };
+
+    void WorkerLoop();
+    void Process(const JpegBytes& jpeg, uint64_t sequence, Clock::time_point captured_at,
+                 WicDecoder& decoder, int src_width, int src_height);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<int, Consumer> consumers_;
+    int next_id_ = 1;
+    std::atomic<int> consumer_count_{0};
+    std::atomic<uint64_t> cpu_us_{0};
+    std::shared_ptr<const ColorLut> lut_;
+
+    // Newest frame not yet taken by the worker
+    JpegBytes pending_;
+    uint64_t pending_seq_ = 0;
+    Clock::time_point pending_at_{};
+
+    bool stop_ = false;
+    std::thread worker_;
+    Stats stats_;
+};
@@ -0,0 +1,141 @@
+#include "frame_governor.h"
+#include <algorithm>
+
+FrameGovernor::FrameGovernor() = default;
+
+void FrameGovernor::Configure(int min_interval_ms, int max_interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    min_interval_ms_ = std::max(1, min_interval_ms);
+    max_interval_ms_ = std::max(min_interval_ms_, max_interval_ms);
+    interval_ms_ = std::clamp(interval_ms_, min_interval_ms_, max_interval_ms_);
+}
+
+void FrameGovernor::SetCpuBudget(int percent) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpu_budget_percent_ = std::clamp(percent, 1, 100);
+}
+
+void FrameGovernor::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interval_ms_ = min_interval_ms_;
+    cpu_per_frame_us_ = 0.0;
+    const auto now = Clock::now();
+    for (auto& entry : consumers_) {
+        Consumer fresh;
+        fresh.delivered_seq = published_seq_;
+        fresh.acked_seq = published_seq_;
+        fresh.last_seen = now;
+        entry.second = fresh;
+    }
+}
+
+int FrameGovernor::RegisterConsumer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int id = next_consumer_id_++;
+    Consumer consumer;
+    consumer.delivered_seq = published_seq_;
+    consumer.acked_seq = published_seq_;
+    consumer.last_seen = Clock::now();
+    consumers_[id] = consumer;
+    return id;
+}
+
+bool FrameGovernor::UnregisterConsumer(int consumer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consumers_.erase(consumer_id) > 0;
+}
+
+void FrameGovernor::OnFramePublished(uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    published_seq_ = sequence;
+}
+
+void FrameGovernor::OnFrameDelivered(int consumer_id, uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = consumers_.find(consumer_id);
+    if (it == consumers_.end()) {
+        return;
+    }
+    it->second.delivered_seq = sequence;
+    it->second.delivered_at = Clock::now();
+}
+
+bool FrameGovernor::OnFrameAcked(int consumer_id, uint64_t sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = consumers_.find(consumer_id);
+    if (it == consumers_.end()) {
+        return false;
+    }
+
+    Consumer& c = it->second;
+    const auto now = Clock::now();
+    c.last_seen = now;
+    if (sequence <= c.acked_seq) {
+        return true;
+    }
+    c.acked_seq = sequence;
+
+    if (sequence == c.delivered_seq && c.delivered_at != Clock::time_point{}) {
+        const double latency_ms =
+            std::chrono::duration<double, std::milli>(now - c.delivered_at).count();
+        c.ack_latency_ms = c.ack_latency_ms == 0.0
+            ? latency_ms
+            : c.ack_latency_ms * 0.8 + latency_ms * 0.2;
+    }
+    return true;
+}
+
+std::chrono::milliseconds FrameGovernor::NextDelay(std::chrono::microseconds cpu_used,
+                                                   std::chrono::microseconds wall_used) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+
+    // Classify live consumers: anyone lagging or slow to paint holds us back.
+    bool any_live = false;
+    bool behind = false;
+    bool caught_up = true;
+    for (const auto& entry : consumers_) {
+        const Consumer& c = entry.second;
+        if (c.delivered_at == Clock::time_point{}) {
+            continue;  // registered but has not pulled a frame yet
+        }
+        const auto idle_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - c.last_seen).count();
+        if (idle_ms > stale_consumer_ms_) {
+            continue;
+        }
+        any_live = true;
+
+        const uint64_t lag = published_seq_ > c.acked_seq ? published_seq_ - c.acked_seq : 0;
+        if (lag > kMaxLagFrames || c.ack_latency_ms > interval_ms_) {
+            behind = true;
+        }
+        if (lag > 1 || c.ack_latency_ms * 2.0 > interval_ms_) {
+            caught_up = false;
+        }
+    }
+
+    if (behind) {
+        interval_ms_ = std::min(max_interval_ms_, interval_ms_ + interval_ms_ / 4 + 1);
+    } else if (!any_live || caught_up) {
+        interval_ms_ = std::max(min_interval_ms_, interval_ms_ - std::max(1, interval_ms_ / 16));
+    }
+
+    // CPU budget: a frame that costs C us of CPU may only start every
+    // C * 100 / budget us, whatever the consumers could take.
+    const double cpu_us = static_cast<double>(cpu_used.count());
+    cpu_per_frame_us_ = cpu_per_frame_us_ == 0.0
+        ? cpu_us
+        : cpu_per_frame_us_ * 0.9 + cpu_us * 0.1;
+    const double budget_floor_ms = cpu_per_frame_us_ * 100.0 / cpu_budget_percent_ / 1000.0;
+
+    const double period_ms = std::max(static_cast<double>(interval_ms_), budget_floor_ms);
+    const double spent_ms = static_cast<double>(wall_used.count()) / 1000.0;
+    const double remaining = period_ms - spent_ms;
+    return std::chrono::milliseconds(remaining > 0.0 ? static_cast<long long>(remaining) : 0);
+}
+
+int FrameGovernor::CurrentIntervalMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return interval_ms_;
+}
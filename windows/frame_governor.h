@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+// Paces the native EVF capture loop.
+// - Consumers (Dart UI, recorders, ...) acknowledge each frame once they have
+//   actually used it. When the slowest live consumer falls behind, the capture
+//   interval grows by a quarter per frame; once everyone keeps up, it shrinks
+//   by a sixteenth per frame. Both steps are proportional, so the rate backs
+//   off about 3.5 times faster than it recovers, at any interval.
+// - A CPU budget caps how much of one core live view may use (the capture
+//   thread plus the fan-out's decoding and grading), so the kiosk UI thread
+//   never starves.
+// - A consumer that stops acknowledging for `stale_consumer_ms` is ignored, so a
+//   dead screen cannot freeze the pipeline at the slowest rate forever.
+class FrameGovernor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FrameGovernor();
+
+    void Configure(int min_interval_ms, int max_interval_ms);
+    void SetCpuBudget(int percent);  // 1..100 (% of one core)
+    void Reset();
+
+    int RegisterConsumer();
+    bool UnregisterConsumer(int consumer_id);
+
+    // Called by the capture thread after a new frame became visible.
+    void OnFramePublished(uint64_t sequence);
+    // Called when `sequence` was handed to `consumer_id`.
+    void OnFrameDelivered(int consumer_id, uint64_t sequence);
+    // Called when `consumer_id` finished using `sequence` (e.g. painted it).
+    bool OnFrameAcked(int consumer_id, uint64_t sequence);
+
+    // Feed the cost of one capture iteration (CPU across all live view
+    // threads); returns how long the capture thread should sleep before
+    // starting the next one.
+    std::chrono::milliseconds NextDelay(std::chrono::microseconds cpu_used,
+                                        std::chrono::microseconds wall_used);
+
+    int CurrentIntervalMs() const;
+
+private:
+    struct Consumer {
+        uint64_t delivered_seq = 0;
+        uint64_t acked_seq = 0;
+        Clock::time_point delivered_at{};
+        Clock::time_point last_seen{};
+        double ack_latency_ms = 0.0;  // EWMA of delivery -> ack
+    };
+
+    // Frames a consumer may lag behind the newest one before we slow down.
+    static constexpr uint64_t kMaxLagFrames = 2;
+
+    mutable std::mutex mutex_;
+    std::map<int, Consumer> consumers_;
+    int next_consumer_id_ = 1;
+
+    uint64_t published_seq_ = 0;
+    int min_interval_ms_ = 33;
+    int max_interval_ms_ = 500;
+    int interval_ms_ = 33;
+    int cpu_budget_percent_ = 50;
+    int stale_consumer_ms_ = 2000;
+    double cpu_per_frame_us_ = 0.0;  // EWMA
+};
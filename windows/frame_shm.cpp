@@ -0,0 +1,183 @@
+#include "frame_shm.h"
+#include <cstring>
+#include <new>
+
+namespace frame_shm {
+
+static constexpr uint64_t kAlign = 64;
+
+static uint64_t AlignUp(uint64_t v) {
+    return (v + kAlign - 1) & ~(kAlign - 1);
+}
+
+bool Writer::Create(const std::string& name, uint32_t slot_count, uint64_t slot_capacity) {
+    Close();
+    if (slot_count < 2 || slot_capacity == 0) {
+        return false;
+    }
+    const uint64_t stride = AlignUp(sizeof(SlotHeader) + slot_capacity);
+    const uint64_t total = sizeof(RingHeader) + stride * slot_count;
+    if (!region_.Create(name, static_cast<size_t>(total))) {
+        return false;
+    }
+    if (region_.existed()) {
+        // The name is taken, by another program or by a ring this one did not
+        // close (Windows keeps it while readers are attached). Only a ring
+        // with exactly this layout is reused.
+        const RingHeader* old = header();
+        if (old->magic != kMagic || old->version != kVersion || old->slot_count != slot_count ||
+            old->slot_capacity != slot_capacity || old->slot_stride != stride) {
+            region_.Close();
+            return false;
+        }
+    }
+
+    // Fresh or recycled mapping: rebuild every header before readers can
+    // see a valid magic.
+    RingHeader* h = new (region_.data()) RingHeader();
+    h->version = kVersion;
+    h->slot_count = slot_count;
+    h->reserved = 0;
+    h->slot_capacity = slot_capacity;
+    h->slot_stride = stride;
+    h->latest_seq.store(0, std::memory_order_relaxed);
+    h->writer_alive.store(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        SlotHeader* s = new (region_.data() + sizeof(RingHeader) + stride * i) SlotHeader();
+        s->lock.store(0, std::memory_order_relaxed);
+        s->frame_seq.store(0, std::memory_order_relaxed);
+        s->size.store(0, std::memory_order_relaxed);
+        s->captured_us.store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = kMagic;
+
+    published_ = 0;
+    oversized_ = 0;
+    return true;
+}
+
+void Writer::Close() {
+    if (region_.is_open()) {
+        header()->writer_alive.store(0, std::memory_order_release);
+    }
+    region_.Close();
+}
+
+SlotHeader* Writer::slot(uint32_t index) const {
+    return reinterpret_cast<SlotHeader*>(region_.data() + sizeof(RingHeader) + header()->slot_stride * index);
+}
+
+bool Writer::Publish(const uint8_t* data, size_t size, uint64_t sequence, uint64_t captured_us) {
+    if (!region_.is_open() || !data || sequence == 0) {
+        return false;
+    }
+    RingHeader* h = header();
+    if (size > h->slot_capacity) {
+        ++oversized_;
+        return false;
+    }
+
+    SlotHeader* s = slot(static_cast<uint32_t>(sequence % h->slot_count));
+    const uint64_t lock = s->lock.load(std::memory_order_relaxed);
+    s->lock.store(lock + 1, std::memory_order_relaxed);  // odd: writing
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s->frame_seq.store(sequence, std::memory_order_relaxed);
+    s->size.store(size, std::memory_order_relaxed);
+    s->captured_us.store(captured_us, std::memory_order_relaxed);
+    memcpy(reinterpret_cast<uint8_t*>(s) + sizeof(SlotHeader), data, size);
+
+    s->lock.store(lock + 2, std::memory_order_release);  // even: stable
+    h->latest_seq.store(sequence, std::memory_order_release);
+    ++published_;
+    return true;
+}
+
+bool Reader::Open(const std::string& name) {
+    if (!region_.OpenReadOnly(name)) {
+        return false;
+    }
+    const RingHeader* h = header();
+    const bool valid = region_.size() >= sizeof(RingHeader) && h->magic == kMagic && h->version == kVersion &&
+                       h->slot_count >= 2 &&
+                       sizeof(RingHeader) + h->slot_stride * h->slot_count <= region_.size();
+    if (!valid) {
+        region_.Close();
+        return false;
+    }
+    return true;
+}
+
+bool Reader::writer_alive() const {
+    return region_.is_open() && header()->writer_alive.load(std::memory_order_acquire) != 0;
+}
+
+const SlotHeader* Reader::slot(uint32_t index) const {
+    return reinterpret_cast<const SlotHeader*>(region_.data() + sizeof(RingHeader) + header()->slot_stride * index);
+}
+
+bool Reader::Latest(FrameView& view, uint64_t newer_than) const {
+    if (!region_.is_open()) {
+        return false;
+    }
+    const RingHeader* h = header();
+
+    // A few tries in case the writer laps us between reading latest_seq and
+    // the slot; each try costs only a handful of loads.
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const uint64_t seq = h->latest_seq.load(std::memory_order_acquire);
+        if (seq == 0 || seq <= newer_than) {
+            return false;
+        }
+        const uint32_t index = static_cast<uint32_t>(seq % h->slot_count);
+        const SlotHeader* s = slot(index);
+        const uint64_t lock = s->lock.load(std::memory_order_acquire);
+        if (lock & 1) {
+            continue;
+        }
+        const uint64_t frame_seq = s->frame_seq.load(std::memory_order_relaxed);
+        const uint64_t size = s->size.load(std::memory_order_relaxed);
+        const uint64_t captured_us = s->captured_us.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s->lock.load(std::memory_order_relaxed) != lock || frame_seq != seq || size > h->slot_capacity) {
+            continue;
+        }
+
+        view.data = reinterpret_cast<const uint8_t*>(s) + sizeof(SlotHeader);
+        view.size = size;
+        view.sequence = seq;
+        view.captured_us = captured_us;
+        view.slot = index;
+        view.lock = lock;
+        return true;
+    }
+    return false;
+}
+
+bool Reader::StillValid(const FrameView& view) const {
+    if (!region_.is_open() || !view.data) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot(view.slot)->lock.load(std::memory_order_relaxed) == view.lock;
+}
+
+bool Reader::CopyLatest(std::vector<uint8_t>& out, uint64_t* sequence, uint64_t newer_than) const {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        FrameView view;
+        if (!Latest(view, newer_than)) {
+            return false;
+        }
+        out.assign(view.data, view.data + view.size);
+        if (StillValid(view)) {
+            if (sequence) {
+                *sequence = view.sequence;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace frame_shm
@@ -0,0 +1,99 @@
+#pragma once
+#include "shm_region.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Live view frames published into named shared memory, so other local
+// processes (second-screen mirror, analytics) can follow the camera without
+// opening it. One writer (camera_ffi), any number of readers.
+//
+// Layout: RingHeader, then `slot_count` slots of `slot_stride` bytes, each a
+// SlotHeader followed by up to `slot_capacity` JPEG bytes. Frame n goes to
+// slot n % slot_count under a per-slot seqlock (odd while being written), so
+// readers never block the writer and can use a frame in place: take a view,
+// use it, then check it is still valid. A slot is only rewritten every
+// slot_count frames, which gives in-place readers that many frame periods.
+namespace frame_shm {
+
+constexpr uint32_t kMagic = 0x56454653;  // "SFEV"
+constexpr uint32_t kVersion = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+
+struct alignas(64) RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t slot_capacity;               // max JPEG bytes per slot
+    uint64_t slot_stride;                 // bytes from one slot to the next
+    std::atomic<uint64_t> latest_seq;     // 0 until the first frame
+    std::atomic<uint64_t> writer_alive;   // cleared when the writer closes
+};
+
+struct alignas(64) SlotHeader {
+    std::atomic<uint64_t> lock;           // seqlock
+    std::atomic<uint64_t> frame_seq;
+    std::atomic<uint64_t> size;
+    std::atomic<uint64_t> captured_us;    // writer's steady clock
+};
+
+// A frame inside shared memory. Only trust `data` while StillValid().
+struct FrameView {
+    const uint8_t* data = nullptr;
+    uint64_t size = 0;
+    uint64_t sequence = 0;
+    uint64_t captured_us = 0;
+    uint32_t slot = 0;
+    uint64_t lock = 0;
+};
+
+class Writer {
+public:
+    // Fails if `name` is already taken by anything but a ring of the same
+    // layout (which is then reset and reused).
+    bool Create(const std::string& name, uint32_t slot_count, uint64_t slot_capacity);
+    void Close();
+    bool is_open() const { return region_.is_open(); }
+
+    // `sequence` must increase by one per published frame.
+    // Returns false (and skips the frame) if it does not fit a slot.
+    bool Publish(const uint8_t* data, size_t size, uint64_t sequence, uint64_t captured_us);
+
+    uint64_t frames_published() const { return published_; }
+    uint64_t frames_oversized() const { return oversized_; }
+
+private:
+    RingHeader* header() const { return reinterpret_cast<RingHeader*>(region_.data()); }
+    SlotHeader* slot(uint32_t index) const;
+
+    SharedMemoryRegion region_;
+    uint64_t published_ = 0;
+    uint64_t oversized_ = 0;
+};
+
+class Reader {
+public:
+    bool Open(const std::string& name);
+    void Close() { region_.Close(); }
+    bool is_open() const { return region_.is_open(); }
+    bool writer_alive() const;
+
+    // Latest frame newer than `newer_than`, in place (zero copy).
+    bool Latest(FrameView& view, uint64_t newer_than = 0) const;
+    // True while the writer has not started overwriting the view's slot.
+    bool StillValid(const FrameView& view) const;
+    // Latest frame copied out, validated after the copy.
+    bool CopyLatest(std::vector<uint8_t>& out, uint64_t* sequence, uint64_t newer_than = 0) const;
+
+private:
+    const RingHeader* header() const { return reinterpret_cast<const RingHeader*>(region_.data()); }
+    const SlotHeader* slot(uint32_t index) const;
+
+    SharedMemoryRegion region_;
+};
+
+}  // namespace frame_shm
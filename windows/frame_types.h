@@ -0,0 +1,20 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One EVF frame as the camera sent it. Shared, immutable: the capture thread
+// allocates it once and every consumer (latest-frame slot, pre-roll ring,
+// recorder, ...) holds a reference instead of a copy.
+using JpegBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+// What the capture thread recorded about a published frame.
+struct FrameInfo {
+    uint64_t sequence = 0;
+    std::chrono::steady_clock::time_point captured_at{};  // download finished
+    uint64_t download_us = 0;
+    int width = 0;       // from the JPEG header, 0 if it could not be parsed
+    int height = 0;
+    uint32_t flags = 0;  // CAMERA_FRAME_FLAG_* (camera_ffi.h)
+};
@@ -0,0 +1,386 @@
+#include "gif_encoder.h"
+#include <algorithm>
+#include <cstring>
+
+static inline int Rgb555(int r, int g, int b) {
+    return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+}
+
+static inline int Expand5(int v) {
+    return (v << 3) | (v >> 2);
+}
+
+void GifHistogram::Add(const uint8_t* bgra, int width, int height, int stride, int step) {
+    step = std::max(1, step);
+    for (int y = 0; y < height; y += step) {
+        const uint8_t* p = bgra + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < width; x += step) {
+            const uint8_t* px = p + x * 4;
+            bins[Rgb555(px[2], px[1], px[0])]++;
+        }
+    }
+}
+
+void GifHistogram::Merge(const GifHistogram& other) {
+    for (size_t i = 0; i < bins.size(); ++i) {
+        bins[i] += other.bins[i];
+    }
+}
+
+namespace {
+
+struct HistColor {
+    uint8_t c[3];  // r5, g5, b5
+    uint32_t count;
+};
+
+struct Box {
+    size_t begin, end;  // range in the colour array
+    uint64_t count;
+    int lo[3], hi[3];
+};
+
+void FitBox(const std::vector<HistColor>& colors, Box& box) {
+    box.count = 0;
+    for (int a = 0; a < 3; ++a) {
+        box.lo[a] = 31;
+        box.hi[a] = 0;
+    }
+    for (size_t i = box.begin; i < box.end; ++i) {
+        box.count += colors[i].count;
+        for (int a = 0; a < 3; ++a) {
+            box.lo[a] = std::min<int>(box.lo[a], colors[i].c[a]);
+            box.hi[a] = std::max<int>(box.hi[a], colors[i].c[a]);
+        }
+    }
+}
+
+int LongestAxis(const Box& box) {
+    int axis = 0;
+    for (int a = 1; a < 3; ++a) {
+        if (box.hi[a] - box.lo[a] > box.hi[axis] - box.lo[axis]) {
+            axis = a;
+        }
+    }
+    return axis;
+}
+
+}  // namespace
+
+void BuildPalette(const GifHistogram& histogram, int max_colors, GifPalette& palette) {
+    max_colors = std::clamp(max_colors, 2, 256);
+
+    std::vector<HistColor> colors;
+    for (int i = 0; i < 32768; ++i) {
+        if (histogram.bins[i]) {
+            colors.push_back(HistColor{{static_cast<uint8_t>(i >> 10), static_cast<uint8_t>((i >> 5) & 31),
+                                        static_cast<uint8_t>(i & 31)},
+                                       histogram.bins[i]});
+        }
+    }
+
+    std::memset(palette.rgb, 0, sizeof(palette.rgb));
+    palette.size = 0;
+    if (colors.empty()) {
+        palette.size = 2;
+        palette.rgb[3] = palette.rgb[4] = palette.rgb[5] = 255;
+        return;
+    }
+
+    std::vector<Box> boxes;
+    Box all{0, colors.size(), 0, {}, {}};
+    FitBox(colors, all);
+    boxes.push_back(all);
+
+    while (static_cast<int>(boxes.size()) < max_colors) {
+        // Split the most populated box that still spans more than one colour,
+        // weighted by its extent so large flat areas don't hog the palette.
+        int pick = -1;
+        uint64_t best = 0;
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const Box& b = boxes[i];
+            const int axis = LongestAxis(b);
+            const int extent = b.hi[axis] - b.lo[axis];
+            if (b.end - b.begin < 2 || extent == 0) {
+                continue;
+            }
+            const uint64_t score = b.count * static_cast<uint64_t>(extent);
+            if (score > best) {
+                best = score;
+                pick = static_cast<int>(i);
+            }
+        }
+        if (pick < 0) {
+            break;
+        }
+
+        Box box = boxes[pick];
+        const int axis = LongestAxis(box);
+        std::sort(colors.begin() + box.begin, colors.begin() + box.end,
+                  [axis](const HistColor& a, const HistColor& b) { return a.c[axis] < b.c[axis]; });
+
+        uint64_t acc = 0;
+        size_t split = box.begin + 1;
+        for (size_t i = box.begin; i < box.end - 1; ++i) {
+            acc += colors[i].count;
+            split = i + 1;
+            if (acc * 2 >= box.count) {
+                break;
+            }
+        }
+
+        Box left{box.begin, split, 0, {}, {}};
+        Box right{split, box.end, 0, {}, {}};
+        FitBox(colors, left);
+        FitBox(colors, right);
+        boxes[pick] = left;
+        boxes.push_back(right);
+    }
+
+    for (const Box& b : boxes) {
+        uint64_t sum[3] = {0, 0, 0};
+        for (size_t i = b.begin; i < b.end; ++i) {
+            for (int a = 0; a < 3; ++a) {
+                sum[a] += static_cast<uint64_t>(Expand5(colors[i].c[a])) * colors[i].count;
+            }
+        }
+        uint8_t* out = palette.rgb + palette.size * 3;
+        for (int a = 0; a < 3; ++a) {
+            out[a] = static_cast<uint8_t>(b.count ? (sum[a] + b.count / 2) / b.count : 0);
+        }
+        palette.size++;
+    }
+    if (palette.size < 2) {
+        palette.size = 2;  // GIF needs at least a 2-entry table
+    }
+}
+
+void FillPaletteLut(GifPalette& palette, int begin, int end) {
+    begin = std::max(begin, 0);
+    end = std::min(end, 32768);
+    for (int i = begin; i < end; ++i) {
+        const int r = Expand5(i >> 10);
+        const int g = Expand5((i >> 5) & 31);
+        const int b = Expand5(i & 31);
+        int best = 0;
+        int best_dist = 1 << 30;
+        for (int p = 0; p < palette.size; ++p) {
+            const uint8_t* c = palette.rgb + p * 3;
+            const int dr = r - c[0], dg = g - c[1], db = b - c[2];
+            const int dist = dr * dr * 2 + dg * dg * 4 + db * db * 3;
+            if (dist < best_dist) {
+                best_dist = dist;
+                best = p;
+                if (dist == 0) break;
+            }
+        }
+        palette.lut[i] = static_cast<uint8_t>(best);
+    }
+}
+
+void MapToPalette(const uint8_t* bgra, int width, int height, int stride,
+                  const GifPalette& palette, bool dither, std::vector<uint8_t>& indices) {
+    static const int kBayer4[4][4] = {
+        {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+    indices.resize(static_cast<size_t>(width) * height);
+    uint8_t* out = indices.data();
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* p = bgra + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < width; ++x, p += 4) {
+            int b = p[0], g = p[1], r = p[2];
+            if (dither) {
+                const int d = kBayer4[y & 3][x & 3] - 8;
+                b = std::clamp(b + d, 0, 255);
+                g = std::clamp(g + d, 0, 255);
+                r = std::clamp(r + d, 0, 255);
+            }
+            *out++ = palette.lut[Rgb555(r, g, b)];
+        }
+    }
+}
+
+namespace {
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+    void Write(uint32_t code, int bits) {
+        acc_ |= code << count_;
+        count_ += bits;
+        while (count_ >= 8) {
+            out_.push_back(static_cast<uint8_t>(acc_ & 0xFF));
+            acc_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void Flush() {
+        if (count_ > 0) {
+            out_.push_back(static_cast<uint8_t>(acc_ & 0xFF));
+        }
+        acc_ = 0;
+        count_ = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+    uint32_t acc_ = 0;
+    int count_ = 0;
+};
+
+// (prefix code, next index) -> code, open addressing. At most 4096 live
+// entries, so 8192 slots keep probes short.
+class LzwTable {
+public:
+    LzwTable() : keys_(kSlots), codes_(kSlots) { Clear(); }
+
+    void Clear() { std::fill(keys_.begin(), keys_.end(), -1); }
+
+    int Find(int key) const {
+        for (int slot = Hash(key);; slot = (slot + 1) & (kSlots - 1)) {
+            if (keys_[slot] == key) return codes_[slot];
+            if (keys_[slot] < 0) return -1;
+        }
+    }
+
+    void Insert(int key, int code) {
+        int slot = Hash(key);
+        while (keys_[slot] >= 0) {
+            slot = (slot + 1) & (kSlots - 1);
+        }
+        keys_[slot] = key;
+        codes_[slot] = static_cast<uint16_t>(code);
+    }
+
+private:
+    static constexpr int kSlots = 8192;
+    static int Hash(int key) { return static_cast<int>((static_cast<uint32_t>(key) * 2654435761u) >> 19); }
+
+    std::vector<int32_t> keys_;
+    std::vector<uint16_t> codes_;
+};
+
+}  // namespace
+
+std::vector<uint8_t> LzwEncodeFrame(const uint8_t* indices, size_t count) {
+    const int min_code_size = 8;
+    const int clear_code = 1 << min_code_size;
+    const int eoi_code = clear_code + 1;
+
+    std::vector<uint8_t> raw;
+    raw.reserve(count / 2 + 16);
+    BitWriter bits(raw);
+    LzwTable table;
+
+    int code_size = min_code_size + 1;
+    int max_code = eoi_code;
+    bits.Write(clear_code, code_size);
+
+    int current = -1;
+    for (size_t i = 0; i < count; ++i) {
+        const int next = indices[i];
+        if (current < 0) {
+            current = next;
+            continue;
+        }
+        const int key = (current << 8) | next;
+        const int found = table.Find(key);
+        if (found >= 0) {
+            current = found;
+            continue;
+        }
+
+        bits.Write(current, code_size);
+        table.Insert(key, ++max_code);
+        if (max_code >= (1 << code_size)) {
+            code_size++;
+        }
+        if (max_code == 4095) {
+            // Table full: the clear goes out at the current (12-bit) width,
+            // then both sides restart at min_code_size + 1
+            bits.Write(clear_code, code_size);
+            table.Clear();
+            code_size = min_code_size + 1;
+            max_code = eoi_code;
+        }
+        current = next;
+    }
+    if (current >= 0) {
+        bits.Write(current, code_size);
+        // The decoder's table runs one code behind: reading this code adds
+        // the entry the encoder would add next, and widens the codes if that
+        // fills the current width. The closing clear must be at that width.
+        if (++max_code >= (1 << code_size) && code_size < 12) {
+            code_size++;
+        }
+    }
+    bits.Write(clear_code, code_size);
+    bits.Write(eoi_code, min_code_size + 1);
+    bits.Flush();
+
+    // Image data: min code size, then <= 255-byte sub-blocks, then terminator.
+    std::vector<uint8_t> out;
+    out.reserve(raw.size() + raw.size() / 255 + 3);
+    out.push_back(static_cast<uint8_t>(min_code_size));
+    for (size_t pos = 0; pos < raw.size(); pos += 255) {
+        const size_t n = std::min<size_t>(255, raw.size() - pos);
+        out.push_back(static_cast<uint8_t>(n));
+        out.insert(out.end(), raw.begin() + pos, raw.begin() + pos + n);
+    }
+    out.push_back(0);
+    return out;
+}
+
+static void Put16(std::ostream& out, int v) {
+    out.put(static_cast<char>(v & 0xFF));
+    out.put(static_cast<char>((v >> 8) & 0xFF));
+}
+
+bool WriteGif(std::ostream& out, int width, int height, const GifPalette& palette,
+              const std::vector<const std::vector<uint8_t>*>& frames,
+              const std::vector<int>& delays_cs) {
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF ||
+        frames.empty() || frames.size() != delays_cs.size()) {
+        return false;
+    }
+
+    out.write("GIF89a", 6);
+    Put16(out, width);
+    Put16(out, height);
+    out.put(static_cast<char>(0xF7));  // global colour table, 8 bits, 256 entries
+    out.put(0);                        // background colour
+    out.put(0);                        // pixel aspect ratio
+    out.write(reinterpret_cast<const char*>(palette.rgb), 256 * 3);
+
+    // NETSCAPE2.0: loop forever
+    static const unsigned char kLoop[] = {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E',
+                                          '2', '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00};
+    out.write(reinterpret_cast<const char*>(kLoop), sizeof(kLoop));
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        // Graphic control extension: keep previous frame, no transparency
+        out.put(0x21);
+        out.put(static_cast<char>(0xF9));
+        out.put(0x04);
+        out.put(0x04);
+        Put16(out, std::max(2, delays_cs[i]));
+        out.put(0);
+        out.put(0);
+
+        // Image descriptor: full canvas, global palette
+        out.put(0x2C);
+        Put16(out, 0);
+        Put16(out, 0);
+        Put16(out, width);
+        Put16(out, height);
+        out.put(0);
+
+        out.write(reinterpret_cast<const char*>(frames[i]->data()),
+                  static_cast<std::streamsize>(frames[i]->size()));
+    }
+
+    out.put(0x3B);
+    return static_cast<bool>(out);
+}
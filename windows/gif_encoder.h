@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Building blocks for animated GIF output. Every stage works on independent
+// pieces (histogram slices, LUT ranges, whole frames) so callers can spread
+// them across worker threads and only the final WriteGif() is sequential.
+
+// Colour histogram over RGB555 (32768 bins).
+struct GifHistogram {
+    std::vector<uint32_t> bins = std::vector<uint32_t>(32768, 0);
+
+    // Sample every `step`-th pixel of a BGRA image.
+    void Add(const uint8_t* bgra, int width, int height, int stride, int step);
+    void Merge(const GifHistogram& other);
+};
+
+struct GifPalette {
+    uint8_t rgb[256 * 3] = {};
+    int size = 0;
+    std::vector<uint8_t> lut = std::vector<uint8_t>(32768, 0);  // RGB555 -> index
+};
+
+// Median-cut palette (<= max_colors entries). The LUT is left empty; fill it
+// with FillPaletteLut, in one go or in ranges on several threads.
+void BuildPalette(const GifHistogram& histogram, int max_colors, GifPalette& palette);
+void FillPaletteLut(GifPalette& palette, int begin, int end);
+
+// Map a BGRA image to palette indices, optionally with 4x4 ordered dithering.
+void MapToPalette(const uint8_t* bgra, int width, int height, int stride,
+                  const GifPalette& palette, bool dither, std::vector<uint8_t>& indices);
+
+// LZW-compress one frame of 8-bit indices into GIF image data
+// (minimum code size byte, 255-byte sub-blocks and block terminator).
+std::vector<uint8_t> LzwEncodeFrame(const uint8_t* indices, size_t count);
+
+// Assemble a looping GIF89a. `frames[i]` is LzwEncodeFrame output shown for
+// `delays_cs[i]` hundredths of a second; entries may repeat the same data.
+bool WriteGif(std::ostream& out, int width, int height, const GifPalette& palette,
+              const std::vector<const std::vector<uint8_t>*>& frames,
+              const std::vector<int>& delays_cs);
@@ -0,0 +1,387 @@
+#include "image_decode.h"
+#include <algorithm>
+#include <cmath>
+
+template <typename T>
+static void SafeRelease(T*& p) {
+    if (p) {
+        p->Release();
+        p = nullptr;
+    }
+}
+
+static int ChannelsOf(const WICPixelFormatGUID& fmt) {
+    if (fmt == GUID_WICPixelFormat8bppGray) return 1;
+    if (fmt == GUID_WICPixelFormat24bppBGR) return 3;
+    if (fmt == GUID_WICPixelFormat32bppBGR || fmt == GUID_WICPixelFormat32bppBGRA) return 4;
+    return 0;
+}
+
+// BT.601 luma from B, G, R bytes
+static inline uint8_t Luma(const uint8_t* bgr) {
+    return static_cast<uint8_t>((29 * bgr[0] + 150 * bgr[1] + 77 * bgr[2]) >> 8);
+}
+
+static void ConvertRow(const uint8_t* s, int src_channels, int width, int channels, uint8_t* d) {
+    if (src_channels == channels) {
+        std::copy(s, s + static_cast<size_t>(width) * channels, d);
+    } else if (channels == 1) {
+        for (int x = 0; x < width; ++x, s += src_channels) {
+            d[x] = src_channels == 1 ? s[0] : Luma(s);
+        }
+    } else {
+        for (int x = 0; x < width; ++x, s += src_channels, d += 4) {
+            if (src_channels == 1) {
+                d[0] = d[1] = d[2] = s[0];
+            } else {
+                d[0] = s[0];
+                d[1] = s[1];
+                d[2] = s[2];
+            }
+            d[3] = 255;
+        }
+    }
+}
+
+// Copies decoder rows into `out`, converting channels and applying the
+// transform on the way (one pass either way).
+static void ConvertRows(const uint8_t* src, int src_stride, int src_channels,
+                        int width, int height, int channels, int transform, DecodedImage& out) {
+    TransformedSize(transform, width, height, out.width, out.height);
+    out.channels = channels;
+    out.stride = out.width * channels;
+    out.pixels.resize(static_cast<size_t>(out.stride) * out.height);
+
+    if (transform == kRotate0) {
+        for (int y = 0; y < height; ++y) {
+            ConvertRow(src + static_cast<size_t>(y) * src_stride, src_channels, width, channels,
+                       out.pixels.data() + static_cast<size_t>(y) * out.stride);
+        }
+        return;
+    }
+
+    std::vector<uint8_t> row(src_channels == channels ? 0 : static_cast<size_t>(width) * channels);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* s = src + static_cast<size_t>(y) * src_stride;
+        if (!row.empty()) {
+            ConvertRow(s, src_channels, width, channels, row.data());
+            s = row.data();
+        }
+        PlaceTransformedRow(s, y, width, height, channels, transform, out.pixels.data(), out.stride);
+    }
+}
+
+// Size a decode capped at `max_side` (<= 0: full size) asks the codec for
+static void ScaledSize(UINT w, UINT h, int max_side, UINT& tw, UINT& th) {
+    tw = w;
+    th = h;
+    const UINT longest = std::max(w, h);
+    if (max_side > 0 && longest > static_cast<UINT>(max_side)) {
+        const double scale = static_cast<double>(max_side) / longest;
+        tw = std::max<UINT>(1, static_cast<UINT>(std::lround(w * scale)));
+        th = std::max<UINT>(1, static_cast<UINT>(std::lround(h * scale)));
+    }
+}
+
+WicRowReader::~WicRowReader() {
+    Reset();
+}
+
+void WicRowReader::Reset() {
+    SafeRelease(source_);
+    SafeRelease(source_transform_);
+    SafeRelease(frame_);
+    SafeRelease(decoder_);
+    SafeRelease(stream_);
+    width_ = height_ = src_channels_ = 0;
+    raw_.clear();
+}
+
+bool WicRowReader::ReadRows(int x, int y, int width, int rows, uint8_t* dst, int dst_stride) {
+    if (!dst || width <= 0 || rows <= 0 || x < 0 || y < 0 || x + width > width_ || y + rows > height_) {
+        return false;
+    }
+    // The rectangle is in scaled coordinates; mirrored, the columns come from
+    // the other side and each row is turned around below
+    const WICRect rect = {mirror_ ? width_ - x - width : x, y, width, rows};
+
+    if (source_transform_) {
+        const UINT stride = (static_cast<UINT>(width) * src_channels_ + 3) & ~3u;
+        raw_.resize(static_cast<size_t>(stride) * rows + static_cast<size_t>(width) * 4);
+        uint8_t* row = raw_.data() + static_cast<size_t>(stride) * rows;
+        if (FAILED(source_transform_->CopyPixels(&rect, static_cast<UINT>(width_), static_cast<UINT>(height_),
+                                                 &format_, WICBitmapTransformRotate0, stride,
+                                                 stride * static_cast<UINT>(rows), raw_.data()))) {
+            return false;
+        }
+        for (int r = 0; r < rows; ++r) {
+            uint8_t* d = dst + static_cast<size_t>(r) * dst_stride;
+            ConvertRow(raw_.data() + static_cast<size_t>(r) * stride, src_channels_, width, 4, mirror_ ? row : d);
+            if (mirror_) {
+                PlaceTransformedRow(row, 0, width, 1, 4, kMirror, d, dst_stride);
+            }
+        }
+        return true;
+    }
+
+    if (!mirror_) {
+        return SUCCEEDED(source_->CopyPixels(&rect, static_cast<UINT>(dst_stride),
+                                             static_cast<UINT>(dst_stride) * (rows - 1) + width * 4, dst));
+    }
+    const UINT stride = static_cast<UINT>(width) * 4;
+    raw_.resize(static_cast<size_t>(stride) * rows);
+    if (FAILED(source_->CopyPixels(&rect, stride, static_cast<UINT>(raw_.size()), raw_.data()))) {
+        return false;
+    }
+    for (int r = 0; r < rows; ++r) {
+        PlaceTransformedRow(raw_.data() + static_cast<size_t>(r) * stride, 0, width, 1, 4, kMirror,
+                            dst + static_cast<size_t>(r) * dst_stride, dst_stride);
+    }
+    return true;
+}
+
+WicDecoder::WicDecoder() {
+    HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                  IID_PPV_ARGS(&factory_));
+    if (FAILED(hr)) {
+        factory_ = nullptr;
+    }
+}
+
+WicDecoder::~WicDecoder() {
+    SafeRelease(factory_);
+}
+
+IWICBitmapFrameDecode* WicDecoder::OpenFrame(const uint8_t* data, size_t len,
+                                             IWICStream** stream, IWICBitmapDecoder** decoder) {
+    *stream = nullptr;
+    *decoder = nullptr;
+    if (!factory_ || !data || len == 0) {
+        return nullptr;
+    }
+
+    IWICBitmapFrameDecode* frame = nullptr;
+    if (FAILED(factory_->CreateStream(stream)) ||
+        FAILED((*stream)->InitializeFromMemory(const_cast<BYTE*>(data), static_cast<DWORD>(len))) ||
+        FAILED(factory_->CreateDecoderFromStream(*stream, nullptr, WICDecodeMetadataCacheOnDemand, decoder)) ||
+        FAILED((*decoder)->GetFrame(0, &frame))) {
+        SafeRelease(frame);
+        SafeRelease(*decoder);
+        SafeRelease(*stream);
+        return nullptr;
+    }
+    return frame;
+}
+
+bool WicDecoder::GetSize(const uint8_t* data, size_t len, int& width, int& height) {
+    width = height = 0;
+    IWICStream* stream = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = OpenFrame(data, len, &stream, &decoder);
+    if (!frame) {
+        return false;
+    }
+    UINT w = 0, h = 0;
+    const bool ok = SUCCEEDED(frame->GetSize(&w, &h));
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    SafeRelease(frame);
+    SafeRelease(decoder);
+    SafeRelease(stream);
+    return ok;
+}
+
+bool WicDecoder::DecodeGray(const uint8_t* data, size_t len, int max_side, DecodedImage& out,
+                            int transform) {
+    return Decode(data, len, max_side, 1, transform, out);
+}
+
+bool WicDecoder::DecodeBgra(const uint8_t* data, size_t len, int max_side, DecodedImage& out,
+                            int transform) {
+    return Decode(data, len, max_side, 4, transform, out);
+}
+
+bool WicDecoder::DecodePremultiplied(const uint8_t* data, size_t len, DecodedImage& out) {
+    IWICStream* stream = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = OpenFrame(data, len, &stream, &decoder);
+    if (!frame) {
+        return false;
+    }
+
+    bool done = false;
+    IWICFormatConverter* converter = nullptr;
+    if (SUCCEEDED(factory_->CreateFormatConverter(&converter)) &&
+        SUCCEEDED(converter->Initialize(frame, GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr,
+                                        0.0, WICBitmapPaletteTypeCustom))) {
+        UINT w = 0, h = 0;
+        converter->GetSize(&w, &h);
+        out.width = static_cast<int>(w);
+        out.height = static_cast<int>(h);
+        out.channels = 4;
+        out.stride = static_cast<int>(w) * 4;
+        out.pixels.resize(static_cast<size_t>(out.stride) * h);
+        done = w > 0 && h > 0 &&
+               SUCCEEDED(converter->CopyPixels(nullptr, static_cast<UINT>(out.stride),
+                                               static_cast<UINT>(out.pixels.size()), out.pixels.data()));
+    }
+    SafeRelease(converter);
+    SafeRelease(frame);
+    SafeRelease(decoder);
+    SafeRelease(stream);
+    return done;
+}
+
+bool WicDecoder::Decode(const uint8_t* data, size_t len, int max_side, int channels, int transform,
+                        DecodedImage& out) {
+    IWICStream* stream = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = OpenFrame(data, len, &stream, &decoder);
+    if (!frame) {
+        return false;
+    }
+
+    UINT w = 0, h = 0;
+    frame->GetSize(&w, &h);
+    UINT tw = 0, th = 0;
+    ScaledSize(w, h, max_side, tw, th);
+
+    bool done = false;
+
+    // Fast path: let the codec scale while decoding.
+    IWICBitmapSourceTransform* source_transform = nullptr;
+    if (SUCCEEDED(frame->QueryInterface(IID_PPV_ARGS(&source_transform))) && source_transform) {
+        UINT cw = tw, ch = th;
+        WICPixelFormatGUID fmt = channels == 1 ? GUID_WICPixelFormat8bppGray : GUID_WICPixelFormat24bppBGR;
+        if (SUCCEEDED(source_transform->GetClosestSize(&cw, &ch)) &&
+            SUCCEEDED(source_transform->GetClosestPixelFormat(&fmt))) {
+            const int src_channels = ChannelsOf(fmt);
+            if (src_channels > 0) {
+                const UINT stride = (cw * src_channels + 3) & ~3u;
+                std::vector<uint8_t> raw(static_cast<size_t>(stride) * ch);
+                if (SUCCEEDED(source_transform->CopyPixels(nullptr, cw, ch, &fmt, WICBitmapTransformRotate0,
+                                                           stride, static_cast<UINT>(raw.size()), raw.data()))) {
+                    ConvertRows(raw.data(), static_cast<int>(stride), src_channels,
+                                static_cast<int>(cw), static_cast<int>(ch), channels, transform, out);
+                    done = true;
+                }
+            }
+        }
+        SafeRelease(source_transform);
+    }
+
+    // Generic path: scaler + format converter.
+    if (!done) {
+        IWICBitmapSource* source = frame;
+        source->AddRef();
+
+        IWICBitmapScaler* scaler = nullptr;
+        if ((tw != w || th != h) && SUCCEEDED(factory_->CreateBitmapScaler(&scaler)) &&
+            SUCCEEDED(scaler->Initialize(source, tw, th, WICBitmapInterpolationModeFant))) {
+            SafeRelease(source);
+            source = scaler;
+            scaler = nullptr;
+        }
+        SafeRelease(scaler);
+
+        IWICFormatConverter* converter = nullptr;
+        const WICPixelFormatGUID target = channels == 1 ? GUID_WICPixelFormat8bppGray : GUID_WICPixelFormat32bppBGRA;
+        if (SUCCEEDED(factory_->CreateFormatConverter(&converter)) &&
+            SUCCEEDED(converter->Initialize(source, target, WICBitmapDitherTypeNone, nullptr, 0.0,
+                                            WICBitmapPaletteTypeCustom))) {
+            UINT cw = 0, ch = 0;
+            converter->GetSize(&cw, &ch);
+            const int stride = static_cast<int>(cw) * channels;
+            if (transform == kRotate0) {
+                out.width = static_cast<int>(cw);
+                out.height = static_cast<int>(ch);
+                out.channels = channels;
+                out.stride = stride;
+                out.pixels.resize(static_cast<size_t>(stride) * ch);
+                done = SUCCEEDED(converter->CopyPixels(nullptr, static_cast<UINT>(stride),
+                                                       static_cast<UINT>(out.pixels.size()), out.pixels.data()));
+            } else {
+                // Non-JPEG sources only; the converter has no row callback to hook
+                std::vector<uint8_t> raw(static_cast<size_t>(stride) * ch);
+                done = SUCCEEDED(converter->CopyPixels(nullptr, static_cast<UINT>(stride),
+                                                       static_cast<UINT>(raw.size()), raw.data()));
+                if (done) {
+                    ConvertRows(raw.data(), stride, channels, static_cast<int>(cw), static_cast<int>(ch),
+                                channels, transform, out);
+                }
+            }
+        }
+        SafeRelease(converter);
+        SafeRelease(source);
+    }
+
+    SafeRelease(frame);
+    SafeRelease(decoder);
+    SafeRelease(stream);
+    return done;
+}
+
+bool WicDecoder::OpenRows(const uint8_t* data, size_t len, int max_side, int transform, WicRowReader& out) {
+    out.Reset();
+    if (transform != kRotate0 && transform != kMirror) {
+        return false;
+    }
+    out.frame_ = OpenFrame(data, len, &out.stream_, &out.decoder_);
+    if (!out.frame_) {
+        return false;
+    }
+    out.mirror_ = transform == kMirror;
+
+    UINT w = 0, h = 0;
+    out.frame_->GetSize(&w, &h);
+    UINT tw = 0, th = 0;
+    ScaledSize(w, h, max_side, tw, th);
+
+    // Fast path: the codec scales while decoding, as in Decode
+    if (SUCCEEDED(out.frame_->QueryInterface(IID_PPV_ARGS(&out.source_transform_))) && out.source_transform_) {
+        UINT cw = tw, ch = th;
+        WICPixelFormatGUID fmt = GUID_WICPixelFormat24bppBGR;
+        if (SUCCEEDED(out.source_transform_->GetClosestSize(&cw, &ch)) &&
+            SUCCEEDED(out.source_transform_->GetClosestPixelFormat(&fmt)) && ChannelsOf(fmt) > 0) {
+            out.format_ = fmt;
+            out.src_channels_ = ChannelsOf(fmt);
+            out.width_ = static_cast<int>(cw);
+            out.height_ = static_cast<int>(ch);
+            return true;
+        }
+        SafeRelease(out.source_transform_);
+    }
+
+    // Generic path: scaler + format converter, read by rectangle
+    IWICBitmapSource* source = out.frame_;
+    source->AddRef();
+    IWICBitmapScaler* scaler = nullptr;
+    if ((tw != w || th != h) && SUCCEEDED(factory_->CreateBitmapScaler(&scaler)) &&
+        SUCCEEDED(scaler->Initialize(source, tw, th, WICBitmapInterpolationModeFant))) {
+        SafeRelease(source);
+        source = scaler;
+        scaler = nullptr;
+    }
+    SafeRelease(scaler);
+
+    IWICFormatConverter* converter = nullptr;
+    if (SUCCEEDED(factory_->CreateFormatConverter(&converter)) &&
+        SUCCEEDED(converter->Initialize(source, GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone, nullptr,
+                                        0.0, WICBitmapPaletteTypeCustom))) {
+        UINT cw = 0, ch = 0;
+        converter->GetSize(&cw, &ch);
+        if (cw > 0 && ch > 0) {
+            out.source_ = converter;
+            out.width_ = static_cast<int>(cw);
+            out.height_ = static_cast<int>(ch);
+            converter = nullptr;
+        }
+    }
+    SafeRelease(converter);
+    SafeRelease(source);
+    if (!out.source_) {
+        out.Reset();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <Windows.h>
+#include <wincodec.h>
+#include "pixel_kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels produced by WicDecoder.
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int stride = 0;    // bytes per row
+    int channels = 0;  // 1 = 8-bit luma, 4 = BGRA
+    std::vector<uint8_t> pixels;
+};
+
+// One scaled decode read a few rows at a time, top to bottom, so a large photo
+// never has to be held whole (print sheets render band by band). Opened by
+// WicDecoder::OpenRows; the encoded data must outlive it. Use it from one
+// thread at a time, with COM initialized for the multithreaded apartment.
+class WicRowReader {
+public:
+    WicRowReader() = default;
+    ~WicRowReader();
+    WicRowReader(const WicRowReader&) = delete;
+    WicRowReader& operator=(const WicRowReader&) = delete;
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Rows [y, y + rows), columns [x, x + width) as BGRA. Reading rows in
+    // increasing order lets the codec decode forward instead of restarting.
+    bool ReadRows(int x, int y, int width, int rows, uint8_t* dst, int dst_stride);
+
+private:
+    friend class WicDecoder;
+    void Reset();
+
+    IWICStream* stream_ = nullptr;
+    IWICBitmapDecoder* decoder_ = nullptr;
+    IWICBitmapFrameDecode* frame_ = nullptr;
+    IWICBitmapSourceTransform* source_transform_ = nullptr;  // codec scaling, `format_` rows
+    IWICBitmapSource* source_ = nullptr;                      // or scaler + converter, BGRA rows
+    WICPixelFormatGUID format_ = {};
+    int src_channels_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    bool mirror_ = false;
+    std::vector<uint8_t> raw_;
+};
+
+// Thin WIC wrapper for the native pipeline. Create one per thread; COM must
+// already be initialized on that thread.
+//
+// Scaled decodes go through IWICBitmapSourceTransform when the codec offers
+// it, so the JPEG decoder scales in the DCT domain (1/2, 1/4, 1/8) instead of
+// producing full-size pixels first. The result is the nearest native scale at
+// or above the requested size; callers that need an exact size resample after.
+//
+// `transform` (PixelTransform: rotation and/or selfie mirror) is applied in
+// the pass that copies decoded rows into the output, so an oriented decode
+// costs the same memory traffic as a plain one. width/height in the result
+// are after the transform.
+class WicDecoder {
+public:
+    WicDecoder();
+    ~WicDecoder();
+    WicDecoder(const WicDecoder&) = delete;
+    WicDecoder& operator=(const WicDecoder&) = delete;
+
+    bool ok() const { return factory_ != nullptr; }
+
+    bool GetSize(const uint8_t* data, size_t len, int& width, int& height);
+
+    // max_side <= 0 decodes at full size.
+    bool DecodeGray(const uint8_t* data, size_t len, int max_side, DecodedImage& out,
+                    int transform = kRotate0);
+    bool DecodeBgra(const uint8_t* data, size_t len, int max_side, DecodedImage& out,
+                    int transform = kRotate0);
+
+    // Full-size premultiplied BGRA with the source alpha kept, for overlay
+    // artwork (PNG frames and stickers). Always the generic converter path:
+    // the DCT fast path has no alpha to keep.
+    bool DecodePremultiplied(const uint8_t* data, size_t len, DecodedImage& out);
+
+    // DecodeBgra's scaling, but read band by band through `out`. Only for
+    // transforms that keep the top row on top (kRotate0, kMirror): any other
+    // would need the last source row first. False for those; decode whole.
+    bool OpenRows(const uint8_t* data, size_t len, int max_side, int transform, WicRowReader& out);
+
+private:
+    bool Decode(const uint8_t* data, size_t len, int max_side, int channels, int transform,
+                DecodedImage& out);
+    IWICBitmapFrameDecode* OpenFrame(const uint8_t* data, size_t len,
+                                     IWICStream** stream, IWICBitmapDecoder** decoder);
+
+    IWICImagingFactory* factory_ = nullptr;
+};
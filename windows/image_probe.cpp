@@ -0,0 +1,318 @@
+#include "image_probe.h"
+#include <cstring>
+
+static inline int ReadBE16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+static inline int ReadTiff16(const uint8_t* p, bool le) {
+    return le ? (p[0] | (p[1] << 8)) : ReadBE16(p);
+}
+
+static inline uint32_t ReadTiff32(const uint8_t* p, bool le) {
+    return le ? (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24))
+              : ((static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+bool ProbeJpegSize(const uint8_t* data, size_t len, int& width, int& height) {
+    width = height = 0;
+    if (!data || len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return false;
+    }
+
+    size_t pos = 2;
+    while (pos + 4 <= len) {
+        if (data[pos] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {  // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;  // standalone markers
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            return false;  // EOI / SOS before any frame header
+        }
+
+        const int seg_len = ReadBE16(data + pos + 2);
+        if (seg_len < 2 || pos + 2 + seg_len > len) {
+            return false;
+        }
+
+        // SOF0..SOF15 except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (seg_len < 7) {
+                return false;
+            }
+            height = ReadBE16(data + pos + 5);
+            width = ReadBE16(data + pos + 7);
+            return width > 0 && height > 0;
+        }
+        pos += 2 + seg_len;
+    }
+    return false;
+}
+
+int ProbeJpegOrientation(const uint8_t* data, size_t len) {
+    if (!data || len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return 0;
+    }
+
+    size_t pos = 2;
+    while (pos + 4 <= len && data[pos] == 0xFF && data[pos + 1] >= 0xE0 && data[pos + 1] <= 0xEF) {
+        const size_t seg_len = static_cast<size_t>(ReadBE16(data + pos + 2));
+        if (seg_len < 2 || pos + 2 + seg_len > len) {
+            return 0;
+        }
+        const uint8_t* seg = data + pos + 4;
+        const size_t n = seg_len - 2;
+        if (data[pos + 1] == 0xE1 && n >= 14 && seg[0] == 'E' && seg[1] == 'x' && seg[2] == 'i' &&
+            seg[3] == 'f' && seg[4] == 0 && seg[5] == 0) {
+            // TIFF header, then IFD0 entries of 12 bytes: tag, type, count, value
+            const uint8_t* tiff = seg + 6;
+            const size_t tiff_len = n - 6;
+            const bool le = tiff[0] == 'I';
+            if ((tiff[0] != 'I' && tiff[0] != 'M') || tiff[1] != tiff[0]) {
+                return 0;
+            }
+            // Offsets are attacker-controlled 32-bit values: widen before adding
+            const size_t ifd = static_cast<size_t>(ReadTiff32(tiff + 4, le));
+            if (ifd + 2 > tiff_len) {
+                return 0;
+            }
+            const int entries = ReadTiff16(tiff + ifd, le);
+            for (int i = 0; i < entries; ++i) {
+                const size_t e = ifd + 2 + static_cast<size_t>(i) * 12;
+                if (e + 12 > tiff_len) {
+                    return 0;
+                }
+                if (ReadTiff16(tiff + e, le) == 0x0112 && ReadTiff16(tiff + e + 2, le) == 3) {
+                    const int value = ReadTiff16(tiff + e + 8, le);
+                    return value >= 1 && value <= 8 ? value : 0;
+                }
+            }
+            return 0;
+        }
+        pos += 2 + seg_len;
+    }
+    return 0;
+}
+
+static inline uint32_t ReadBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline bool IsSofMarker(uint8_t marker) {
+    return marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+static ImageCheck ValidateJpeg(const uint8_t* data, size_t len, bool verify, int& width, int& height) {
+    // Encoders may pad after EOI; look this far back for it
+    constexpr size_t kMaxTrailer = 64 * 1024;
+
+    bool frame = false;
+    size_t pos = 2;
+    for (;;) {
+        if (pos + 2 > len) {
+            return kImageTruncated;
+        }
+        if (data[pos] != 0xFF) {
+            return kImageMalformed;
+        }
+        const uint8_t marker = data[pos + 1];
+        if (marker == 0xFF) {  // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0xD9) {
+            return frame ? kImageOk : kImageMalformed;
+        }
+        if (marker == 0xD8 || marker == 0x00) {
+            return kImageMalformed;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            pos += 2;
+            continue;
+        }
+
+        if (pos + 4 > len) {
+            return kImageTruncated;
+        }
+        const size_t seg_len = static_cast<size_t>(ReadBE16(data + pos + 2));
+        if (seg_len < 2) {
+            return kImageMalformed;
+        }
+        if (pos + 2 + seg_len > len) {
+            return kImageTruncated;
+        }
+
+        if (IsSofMarker(marker)) {
+            if (seg_len < 8 || frame) {
+                return kImageMalformed;
+            }
+            height = ReadBE16(data + pos + 5);
+            width = ReadBE16(data + pos + 7);
+            if (width <= 0 || height <= 0) {
+                return kImageMalformed;
+            }
+            frame = true;
+        }
+        pos += 2 + seg_len;
+        if (marker != 0xDA) {
+            continue;
+        }
+
+        // Start of scan: entropy-coded data follows
+        if (!frame) {
+            return kImageMalformed;
+        }
+        if (!verify) {
+            const size_t floor = len - pos > kMaxTrailer ? len - kMaxTrailer : pos;
+            for (size_t i = len; i >= floor + 2; --i) {
+                if (data[i - 2] == 0xFF && data[i - 1] == 0xD9) {
+                    return kImageOk;
+                }
+            }
+            return kImageTruncated;
+        }
+        // Stuffed zeros, restart markers and fill bytes stay in the scan;
+        // anything else ends it
+        for (;;) {
+            const void* hit = std::memchr(data + pos, 0xFF, len - pos);
+            if (!hit) {
+                return kImageTruncated;
+            }
+            pos = static_cast<size_t>(static_cast<const uint8_t*>(hit) - data);
+            if (pos + 1 >= len) {
+                return kImageTruncated;
+            }
+            const uint8_t next = data[pos + 1];
+            if (next == 0x00 || (next >= 0xD0 && next <= 0xD7)) {
+                pos += 2;
+            } else if (next == 0xFF) {
+                ++pos;
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+// CRC-32 (ISO-HDLC, as used by PNG and zlib), sliced by 8
+struct CrcTables {
+    uint32_t t[8][256];
+
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int s = 1; s < 8; ++s) {
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+static const CrcTables kCrc;
+
+static uint32_t Crc32(const uint8_t* p, size_t n) {
+    const auto& t = kCrc.t;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);  // little-endian host
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; n > 0; --n, ++p) {
+        crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static ImageCheck ValidatePng(const uint8_t* data, size_t len, bool verify, int& width, int& height) {
+    bool header = false;
+    bool image_data = false;
+    size_t pos = 8;
+    for (;;) {
+        if (pos + 12 > len) {
+            return kImageTruncated;
+        }
+        const uint32_t length = ReadBE32(data + pos);
+        const uint8_t* type = data + pos + 4;
+        if (length > 0x7FFFFFFFu) {
+            return kImageMalformed;
+        }
+        if (len - pos - 12 < length) {
+            return kImageTruncated;
+        }
+        for (int i = 0; i < 4; ++i) {
+            const uint8_t c = type[i] | 0x20;
+            if (c < 'a' || c > 'z') {
+                return kImageMalformed;
+            }
+        }
+        if (verify && Crc32(type, length + 4) != ReadBE32(type + 4 + length)) {
+            return kImageBadCrc;
+        }
+
+        if (std::memcmp(type, "IHDR", 4) == 0) {
+            if (header || length != 13) {
+                return kImageMalformed;
+            }
+            const uint32_t w = ReadBE32(type + 4);
+            const uint32_t h = ReadBE32(type + 8);
+            const int depth = type[12];
+            const int color = type[13];
+            // Allowed bit depths per colour type (PNG spec table 11.1)
+            const bool valid_depth =
+                (color == 0 && (depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16)) ||
+                (color == 3 && (depth == 1 || depth == 2 || depth == 4 || depth == 8)) ||
+                ((color == 2 || color == 4 || color == 6) && (depth == 8 || depth == 16));
+            if (w == 0 || h == 0 || w > 0x7FFFFFFFu || h > 0x7FFFFFFFu || !valid_depth) {
+                return kImageMalformed;
+            }
+            width = static_cast<int>(w);
+            height = static_cast<int>(h);
+            header = true;
+        } else if (!header) {
+            return kImageMalformed;  // IHDR must come first
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            image_data = true;
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            return image_data && length == 0 ? kImageOk : kImageMalformed;
+        }
+        pos += 12 + length;
+    }
+}
+
+ImageCheck ValidateImage(const uint8_t* data, size_t len, bool verify, ImageFormat& format, int& width,
+                         int& height) {
+    static const uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    format = kImageUnknown;
+    width = height = 0;
+    if (!data) {
+        return kImageUnsupported;
+    }
+    if (len >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
+        format = kImageJpeg;
+        return ValidateJpeg(data, len, verify, width, height);
+    }
+    if (len >= 8 && std::memcmp(data, kPngSignature, 8) == 0) {
+        format = kImagePng;
+        return ValidatePng(data, len, verify, width, height);
+    }
+    return kImageUnsupported;
+}
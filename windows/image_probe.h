@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Header-level image inspection: walks container structure without decoding
+// any pixels.
+
+// Width/height from the first SOFn marker of a JPEG stream.
+bool ProbeJpegSize(const uint8_t* data, size_t len, int& width, int& height);
+
+// EXIF Orientation (1-8) from the APP1 segment of a JPEG stream, or 0 if the
+// stream has no EXIF orientation. Stops at the first non-APPn segment.
+int ProbeJpegOrientation(const uint8_t* data, size_t len);
+
+enum ImageFormat : int {
+    kImageUnknown = 0,
+    kImageJpeg = 1,
+    kImagePng = 2,
+};
+
+enum ImageCheck : int {
+    kImageOk = 0,
+    kImageUnsupported,   // neither JPEG nor PNG
+    kImageTruncated,     // ends before EOI / IEND
+    kImageMalformed,     // broken marker or chunk structure, bad header
+    kImageBadCrc,        // PNG chunk CRC mismatch (verify only)
+};
+
+// Structural check of a JPEG or PNG without decoding pixels. JPEG: marker
+// walk up to the first scan, a frame header (SOFn) with dimensions, and EOI
+// at the end of the stream. PNG: signature, IHDR first, the chunk chain,
+// IDAT and IEND.
+//
+// With `verify`, also scans the JPEG entropy-coded data for every marker
+// (so a file cut between progressive scans is caught) and checks the CRC-32
+// of every PNG chunk. That reads the whole file; without it only the headers
+// and the tail are touched.
+ImageCheck ValidateImage(const uint8_t* data, size_t len, bool verify, ImageFormat& format, int& width,
+                         int& height);
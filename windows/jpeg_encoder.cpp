@@ -0,0 +1,713 @@
+#include "jpeg_encoder.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+constexpr int kDefaultSegments = 32;  // enough to keep a dozen workers busy
+constexpr int kMaxDimension = 65535;
+constexpr int kMaxCodeLength = 16;
+
+// Natural (row-major) index of each zigzag position
+constexpr uint8_t kZigzag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// ITU T.81 Annex K.1 quantisation tables, natural order
+constexpr uint8_t kLumaQuant[64] = {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+                                    14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+                                    18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+                                    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+constexpr uint8_t kChromaQuant[64] = {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+                                      24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+// Annex K.3 Huffman tables: code counts per length 1-16, then the symbols
+constexpr uint8_t kDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr uint8_t kAcLumaValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71,
+    0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+constexpr uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr uint8_t kAcChromaValues[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22,
+    0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+    0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36,
+    0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+// Huffman tables by index: DC luma, DC chroma, AC luma, AC chroma
+constexpr int kTables = 4;
+using Histogram = std::array<uint64_t, 256>;
+
+struct HuffmanSpec {
+    uint8_t bits[kMaxCodeLength + 1] = {};  // codes per length, [1..16]
+    std::vector<uint8_t> values;
+};
+
+struct HuffmanCodes {
+    uint16_t code[256] = {};
+    uint8_t size[256] = {};  // 0: symbol not in the table
+};
+
+struct HuffmanTables {
+    HuffmanSpec spec[kTables];
+    HuffmanCodes codes[kTables];
+};
+
+// Divides a coefficient (x 8, see StoreBlock) by 8 x the table entry, rounded,
+// as a multiply: the ceiling reciprocal in 2^-32 is exact for these ranges.
+struct QuantTable {
+    uint8_t values[64];  // zigzag order, as in DQT
+    uint32_t half[64];
+    uint64_t reciprocal[64];
+};
+
+// Image and segment geometry. An MCU is 16 x 16 pixels (four Y blocks, one
+// Cb, one Cr) with 4:2:0, 8 x 8 (one block each) with 4:4:4.
+struct Frame {
+    const uint8_t* bgra;
+    int width;
+    int height;
+    int stride;
+    bool subsample;
+    int mcu_size;
+    int mcus_x;
+    int mcu_rows;
+    int blocks_per_mcu;
+    int segment_rows;  // MCU rows per restart interval
+    int segments;
+
+    int RowBegin(int segment) const { return segment * segment_rows; }
+    int RowEnd(int segment) const { return std::min(mcu_rows, (segment + 1) * segment_rows); }
+    size_t Blocks(int segment) const {
+        return static_cast<size_t>(RowEnd(segment) - RowBegin(segment)) * mcus_x * blocks_per_mcu;
+    }
+};
+
+HuffmanSpec MakeSpec(const uint8_t* bits, const uint8_t* values, size_t count) {
+    HuffmanSpec spec;
+    std::copy(bits, bits + kMaxCodeLength, spec.bits + 1);
+    spec.values.assign(values, values + count);
+    return spec;
+}
+
+// Canonical codes of T.81 Annex C
+HuffmanCodes MakeCodes(const HuffmanSpec& spec) {
+    HuffmanCodes codes;
+    uint32_t code = 0;
+    size_t k = 0;
+    for (int length = 1; length <= kMaxCodeLength; ++length) {
+        for (int i = 0; i < spec.bits[length]; ++i, ++k) {
+            codes.code[spec.values[k]] = static_cast<uint16_t>(code++);
+            codes.size[spec.values[k]] = static_cast<uint8_t>(length);
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+// Code lengths for the symbol counts, limited to 16 bits (T.81 Annex K.2,
+// as libjpeg's jpeg_gen_optimal_table). A reserved symbol with count 1 keeps
+// any code from being all 1-bits.
+HuffmanSpec OptimalSpec(const Histogram& counts) {
+    constexpr int kSymbols = 257;
+    uint64_t freq[kSymbols];
+    std::copy(counts.begin(), counts.end(), freq);
+    freq[256] = 1;
+    int code_size[kSymbols] = {};
+    int others[kSymbols];
+    std::fill(others, others + kSymbols, -1);
+
+    for (;;) {
+        // The two least frequent live entries; on ties, the higher symbol
+        int c1 = -1;
+        int c2 = -1;
+        for (int i = 0; i < kSymbols; ++i) {
+            if (freq[i] && (c1 < 0 || freq[i] <= freq[c1])) {
+                c1 = i;
+            }
+        }
+        for (int i = 0; i < kSymbols; ++i) {
+            if (freq[i] && i != c1 && (c2 < 0 || freq[i] <= freq[c2])) {
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+        freq[c1] += freq[c2];
+        freq[c2] = 0;
+        for (++code_size[c1]; others[c1] >= 0; ++code_size[c1]) {
+            c1 = others[c1];
+        }
+        others[c1] = c2;
+        for (++code_size[c2]; others[c2] >= 0; ++code_size[c2]) {
+            c2 = others[c2];
+        }
+    }
+
+    int bits[kSymbols + 1] = {};
+    for (int i = 0; i < kSymbols; ++i) {
+        if (code_size[i]) {
+            ++bits[code_size[i]];
+        }
+    }
+    // Too-long codes: a pair at the bottom moves up one level, and the
+    // shallowest deeper-level code splits to take its sibling
+    for (int i = kSymbols; i > kMaxCodeLength; --i) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) {
+                --j;
+            }
+            bits[i] -= 2;
+            bits[i - 1] += 1;
+            bits[j + 1] += 2;
+            bits[j] -= 1;
+        }
+    }
+    // Drop the reserved symbol: it holds one of the longest codes
+    for (int i = kMaxCodeLength; i > 0; --i) {
+        if (bits[i] > 0) {
+            --bits[i];
+            break;
+        }
+    }
+
+    HuffmanSpec spec;
+    for (int i = 1; i <= kMaxCodeLength; ++i) {
+        spec.bits[i] = static_cast<uint8_t>(bits[i]);
+    }
+    for (int length = 1; length <= kSymbols; ++length) {
+        for (int s = 0; s < 256; ++s) {
+            if (code_size[s] == length) {
+                spec.values.push_back(static_cast<uint8_t>(s));
+            }
+        }
+    }
+    return spec;
+}
+
+HuffmanTables StandardTables() {
+    HuffmanTables tables;
+    tables.spec[0] = MakeSpec(kDcLumaBits, kDcValues, sizeof(kDcValues));
+    tables.spec[1] = MakeSpec(kDcChromaBits, kDcValues, sizeof(kDcValues));
+    tables.spec[2] = MakeSpec(kAcLumaBits, kAcLumaValues, sizeof(kAcLumaValues));
+    tables.spec[3] = MakeSpec(kAcChromaBits, kAcChromaValues, sizeof(kAcChromaValues));
+    for (int t = 0; t < kTables; ++t) {
+        tables.codes[t] = MakeCodes(tables.spec[t]);
+    }
+    return tables;
+}
+
+// IJG quality scaling of the Annex K tables, clamped to baseline's 8 bits
+void MakeQuantTables(int quality, QuantTable (&tables)[2]) {
+    const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    const uint8_t* bases[2] = {kLumaQuant, kChromaQuant};
+    for (int t = 0; t < 2; ++t) {
+        for (int k = 0; k < 64; ++k) {
+            const int value = std::clamp((bases[t][kZigzag[k]] * scale + 50) / 100, 1, 255);
+            const uint64_t divisor = static_cast<uint64_t>(value) * 8;
+            tables[t].values[k] = static_cast<uint8_t>(value);
+            tables[t].half[k] = static_cast<uint32_t>(divisor / 2);
+            tables[t].reciprocal[k] = ((uint64_t{1} << 32) + divisor - 1) / divisor;
+        }
+    }
+}
+
+// Float AAN forward DCT (libjpeg's jfdctflt.c): in place on a level-shifted
+// block, rows then columns. Output k is the true coefficient x 8 x aan[u] x aan[v].
+void ForwardDct(float* data) {
+    for (int pass = 0; pass < 2; ++pass) {
+        const int step = pass == 0 ? 1 : 8;   // along the line
+        const int next = pass == 0 ? 8 : 1;   // to the next line
+        for (int line = 0; line < 8; ++line) {
+            float* p = data + line * next;
+            const float tmp0 = p[0] + p[7 * step];
+            const float tmp7 = p[0] - p[7 * step];
+            const float tmp1 = p[step] + p[6 * step];
+            const float tmp6 = p[step] - p[6 * step];
+            const float tmp2 = p[2 * step] + p[5 * step];
+            const float tmp5 = p[2 * step] - p[5 * step];
+            const float tmp3 = p[3 * step] + p[4 * step];
+            const float tmp4 = p[3 * step] - p[4 * step];
+
+            float tmp10 = tmp0 + tmp3;  // even part
+            const float tmp13 = tmp0 - tmp3;
+            float tmp11 = tmp1 + tmp2;
+            float tmp12 = tmp1 - tmp2;
+            p[0] = tmp10 + tmp11;
+            p[4 * step] = tmp10 - tmp11;
+            const float z1 = (tmp12 + tmp13) * 0.707106781f;
+            p[2 * step] = tmp13 + z1;
+            p[6 * step] = tmp13 - z1;
+
+            tmp10 = tmp4 + tmp5;  // odd part
+            tmp11 = tmp5 + tmp6;
+            tmp12 = tmp6 + tmp7;
+            const float z5 = (tmp10 - tmp12) * 0.382683433f;
+            const float z2 = 0.541196100f * tmp10 + z5;
+            const float z4 = 1.306562965f * tmp12 + z5;
+            const float z3 = tmp11 * 0.707106781f;
+            const float z11 = tmp7 + z3;
+            const float z13 = tmp7 - z3;
+            p[5 * step] = z13 + z2;
+            p[3 * step] = z13 - z2;
+            p[step] = z11 + z4;
+            p[7 * step] = z11 - z4;
+        }
+    }
+}
+
+// 1 / (aan[u] x aan[v]) per zigzag position: DCT output to true coefficient x 8
+const std::array<float, 64>& DctDescale() {
+    static const std::array<float, 64> descale = [] {
+        constexpr double kAan[8] = {1.0,         1.387039845, 1.306562965, 1.175875602,
+                                    1.0,         0.785694958, 0.541196100, 0.275899379};
+        std::array<float, 64> table{};
+        for (int k = 0; k < 64; ++k) {
+            table[k] = static_cast<float>(1.0 / (kAan[kZigzag[k] / 8] * kAan[kZigzag[k] % 8]));
+        }
+        return table;
+    }();
+    return descale;
+}
+
+// Transforms an 8 x 8 block from `plane` and stores its coefficients, in
+// zigzag order, as the true DCT x 8 rounded: quantisation can then run at
+// any quality without the DCT, to within 1/16 of a quantisation step.
+void StoreBlock(const float* plane, int plane_stride, int16_t* out) {
+    float block[64];
+    for (int r = 0; r < 8; ++r) {
+        std::copy(plane + r * plane_stride, plane + r * plane_stride + 8, block + r * 8);
+    }
+    ForwardDct(block);
+    const std::array<float, 64>& descale = DctDescale();
+    for (int k = 0; k < 64; ++k) {
+        const float v = block[kZigzag[k]] * descale[k];
+        out[k] = static_cast<int16_t>(std::clamp(v + (v < 0.0f ? -0.5f : 0.5f), -32767.0f, 32767.0f));
+    }
+}
+
+// Colour conversion (JFIF YCbCr, level-shifted to be centred on 0), chroma
+// downsampling and DCT of one segment. Edge MCUs repeat the last column and row.
+void TransformSegment(const Frame& f, int segment, std::vector<int16_t>& coefs) {
+    const int m = f.mcu_size;
+    const int sub = f.subsample ? 2 : 1;
+    const int padded = f.mcus_x * m;
+    const int chroma_stride = padded / sub;
+    std::vector<float> y(static_cast<size_t>(padded) * m);
+    std::vector<float> cb(y.size());
+    std::vector<float> cr(y.size());
+    coefs.resize(f.Blocks(segment) * 64);
+    int16_t* out = coefs.data();
+
+    for (int row = f.RowBegin(segment); row < f.RowEnd(segment); ++row) {
+        for (int i = 0; i < m; ++i) {
+            const uint8_t* p = f.bgra + static_cast<size_t>(std::min(row * m + i, f.height - 1)) * f.stride;
+            float* py = y.data() + static_cast<size_t>(i) * padded;
+            float* pcb = cb.data() + static_cast<size_t>(i) * padded;
+            float* pcr = cr.data() + static_cast<size_t>(i) * padded;
+            for (int x = 0; x < f.width; ++x, p += 4) {
+                const float b = p[0];
+                const float g = p[1];
+                const float r = p[2];
+                py[x] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                pcb[x] = -0.168735892f * r - 0.331264108f * g + 0.5f * b;
+                pcr[x] = 0.5f * r - 0.418687589f * g - 0.081312411f * b;
+            }
+            std::fill(py + f.width, py + padded, py[f.width - 1]);
+            std::fill(pcb + f.width, pcb + padded, pcb[f.width - 1]);
+            std::fill(pcr + f.width, pcr + padded, pcr[f.width - 1]);
+        }
+        if (sub == 2) {
+            // 2 x 2 box average, in place: each output lies before its inputs
+            for (float* plane : {cb.data(), cr.data()}) {
+                for (int i = 0; i < m / 2; ++i) {
+                    const float* top = plane + static_cast<size_t>(2 * i) * padded;
+                    const float* bottom = top + padded;
+                    float* dst = plane + static_cast<size_t>(i) * chroma_stride;
+                    for (int x = 0; x < chroma_stride; ++x) {
+                        dst[x] = 0.25f * (top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1]);
+                    }
+                }
+            }
+        }
+        for (int mx = 0; mx < f.mcus_x; ++mx) {
+            for (int by = 0; by < m; by += 8) {
+                for (int bx = 0; bx < m; bx += 8, out += 64) {
+                    StoreBlock(y.data() + static_cast<size_t>(by) * padded + mx * m + bx, padded, out);
+                }
+            }
+            StoreBlock(cb.data() + mx * 8, chroma_stride, out);
+            out += 64;
+            StoreBlock(cr.data() + mx * 8, chroma_stride, out);
+            out += 64;
+        }
+    }
+}
+
+// Magnitude categories of F.1.2.1 (bits of |value|) up to the 11 bits of a
+// DC difference
+const std::array<uint8_t, 2048>& BitLengths() {
+    static const std::array<uint8_t, 2048> lengths = [] {
+        std::array<uint8_t, 2048> table{};
+        for (int v = 1; v < 2048; ++v) {
+            table[v] = static_cast<uint8_t>(table[v / 2] + 1);
+        }
+        return table;
+    }();
+    return lengths;
+}
+
+// Quantises and codes one block into `sink`: Put(table, symbol, extra value,
+// extra bits), the value already in the form of F.1.2.1 (negatives minus 1).
+template <class Sink>
+void CodeBlock(const int16_t* coefs, const QuantTable& quant, int& dc_pred, int dc_table, Sink& sink) {
+    const std::array<uint8_t, 2048>& bit_length = BitLengths();
+    int q[64];
+    for (int k = 0; k < 64; ++k) {
+        const int c = coefs[k];
+        const uint64_t magnitude = static_cast<uint32_t>(std::abs(c)) + quant.half[k];
+        const int v = static_cast<int>((magnitude * quant.reciprocal[k]) >> 32);
+        q[k] = c < 0 ? -v : v;
+    }
+
+    const int diff = q[0] - dc_pred;
+    dc_pred = q[0];
+    const int dc_bits = bit_length[std::min(std::abs(diff), 2047)];
+    sink.Put(dc_table, dc_bits, diff < 0 ? diff - 1 : diff, dc_bits);
+
+    const int ac_table = dc_table + 2;
+    int run = 0;
+    for (int k = 1; k < 64; ++k) {
+        if (q[k] == 0) {
+            ++run;
+            continue;
+        }
+        for (; run > 15; run -= 16) {
+            sink.Put(ac_table, 0xF0, 0, 0);  // ZRL: 16 zeros
+        }
+        const int v = std::clamp(q[k], -1023, 1023);  // baseline's 10-bit range
+        const int bits = bit_length[std::abs(v)];
+        sink.Put(ac_table, run << 4 | bits, v < 0 ? v - 1 : v, bits);
+        run = 0;
+    }
+    if (run > 0) {
+        sink.Put(ac_table, 0x00, 0, 0);  // EOB
+    }
+}
+
+// One restart interval; the DC predictions start from 0
+template <class Sink>
+void CodeSegment(const Frame& f, const std::vector<int16_t>& coefs, const QuantTable (&quant)[2], Sink& sink) {
+    int dc_pred[3] = {0, 0, 0};
+    const int luma_blocks = f.blocks_per_mcu - 2;
+    const int16_t* block = coefs.data();
+    const size_t mcus = coefs.size() / 64 / f.blocks_per_mcu;
+    for (size_t mcu = 0; mcu < mcus; ++mcu) {
+        for (int i = 0; i < luma_blocks; ++i, block += 64) {
+            CodeBlock(block, quant[0], dc_pred[0], 0, sink);
+        }
+        CodeBlock(block, quant[1], dc_pred[1], 1, sink);
+        block += 64;
+        CodeBlock(block, quant[1], dc_pred[2], 1, sink);
+        block += 64;
+    }
+}
+
+struct SymbolCounter {
+    Histogram counts[kTables] = {};
+    uint64_t extra_bits = 0;
+
+    void Put(int table, int symbol, int, int bits) {
+        ++counts[table][symbol];
+        extra_bits += static_cast<uint64_t>(bits);
+    }
+
+    uint64_t Bits(const HuffmanTables& tables) const {
+        uint64_t total = extra_bits;
+        for (int t = 0; t < kTables; ++t) {
+            for (int s = 0; s < 256; ++s) {
+                total += counts[t][s] * tables.codes[t].size[s];
+            }
+        }
+        return total;
+    }
+};
+
+// Entropy-coded data with byte stuffing (0xFF is followed by 0x00). Bits
+// are gathered into 32-bit words, and a word without an 0xFF byte, almost
+// all of them, is appended in one go.
+class BitWriter {
+public:
+    BitWriter(const HuffmanTables& tables, std::vector<uint8_t>& out) : codes_(tables.codes), out_(out) {}
+
+    void Put(int table, int symbol, int value, int bits) {
+        const HuffmanCodes& codes = codes_[table];
+        acc_ = acc_ << (codes.size[symbol] + bits) | static_cast<uint64_t>(codes.code[symbol]) << bits |
+               (static_cast<uint32_t>(value) & ((1u << bits) - 1));
+        count_ += codes.size[symbol] + bits;  // at most 31 + 16 + 11
+        if (count_ >= 32) {
+            count_ -= 32;
+            const uint32_t word = static_cast<uint32_t>(acc_ >> count_);
+            if ((~word - 0x01010101u) & word & 0x80808080u) {  // some byte of ~word is 0
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    PutByte(static_cast<uint8_t>(word >> shift));
+                }
+            } else {
+                const uint8_t bytes[4] = {static_cast<uint8_t>(word >> 24), static_cast<uint8_t>(word >> 16),
+                                          static_cast<uint8_t>(word >> 8), static_cast<uint8_t>(word)};
+                out_.insert(out_.end(), bytes, bytes + 4);
+            }
+        }
+    }
+
+    // Writes the bits left, the last byte padded with 1-bits as a segment must end
+    void Finish() {
+        const int pad = (8 - count_ % 8) % 8;
+        acc_ = acc_ << pad | ((1u << pad) - 1);
+        for (count_ += pad; count_ > 0;) {
+            count_ -= 8;
+            PutByte(static_cast<uint8_t>(acc_ >> count_));
+        }
+    }
+
+private:
+    void PutByte(uint8_t byte) {
+        out_.push_back(byte);
+        if (byte == 0xFF) {
+            out_.push_back(0x00);
+        }
+    }
+
+    const HuffmanCodes* codes_;
+    std::vector<uint8_t>& out_;
+    uint64_t acc_ = 0;
+    int count_ = 0;
+};
+
+void Put16(std::vector<uint8_t>& out, int value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutMarker(std::vector<uint8_t>& out, uint8_t marker, int length) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    if (length > 0) {
+        Put16(out, length);
+    }
+}
+
+// SOI through SOS
+void WriteHeaders(const Frame& f, const QuantTable (&quant)[2], const HuffmanTables& tables, int dpi,
+                  std::vector<uint8_t>& out) {
+    PutMarker(out, 0xD8, 0);  // SOI
+
+    PutMarker(out, 0xE0, 16);  // APP0 JFIF 1.01
+    out.insert(out.end(), {'J', 'F', 'I', 'F', 0, 1, 1});
+    const int density = dpi > 0 ? std::min(dpi, 65535) : 1;
+    out.push_back(dpi > 0 ? 1 : 0);  // units: dots per inch, or aspect ratio only
+    Put16(out, density);
+    Put16(out, density);
+    out.insert(out.end(), {0, 0});  // no thumbnail
+
+    PutMarker(out, 0xDB, 2 + 2 * 65);  // DQT
+    for (int t = 0; t < 2; ++t) {
+        out.push_back(static_cast<uint8_t>(t));
+        out.insert(out.end(), quant[t].values, quant[t].values + 64);
+    }
+
+    PutMarker(out, 0xC0, 17);  // SOF0: baseline, 8-bit, three components
+    out.push_back(8);
+    Put16(out, f.height);
+    Put16(out, f.width);
+    out.insert(out.end(), {3, 1, static_cast<uint8_t>(f.subsample ? 0x22 : 0x11), 0, 2, 0x11, 1, 3, 0x11, 1});
+
+    int dht_length = 2;
+    for (const HuffmanSpec& spec : tables.spec) {
+        dht_length += 1 + kMaxCodeLength + static_cast<int>(spec.values.size());
+    }
+    PutMarker(out, 0xC4, dht_length);  // DHT
+    constexpr uint8_t kTableIds[kTables] = {0x00, 0x01, 0x10, 0x11};  // class << 4 | id
+    for (int t = 0; t < kTables; ++t) {
+        out.push_back(kTableIds[t]);
+        out.insert(out.end(), tables.spec[t].bits + 1, tables.spec[t].bits + 1 + kMaxCodeLength);
+        out.insert(out.end(), tables.spec[t].values.begin(), tables.spec[t].values.end());
+    }
+
+    if (f.segments > 1) {
+        PutMarker(out, 0xDD, 4);  // DRI, in MCUs
+        Put16(out, f.segment_rows * f.mcus_x);
+    }
+
+    PutMarker(out, 0xDA, 12);  // SOS: Y with tables 0, Cb and Cr with tables 1
+    out.insert(out.end(), {3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0});
+}
+
+}  // namespace
+
+bool EncodeJpegBgra(const uint8_t* bgra, int width, int height, int stride, const JpegEncodeOptions& options,
+                    std::vector<uint8_t>& out, JpegEncodeStats* stats) {
+    if (!bgra || width <= 0 || height <= 0 || width > kMaxDimension || height > kMaxDimension ||
+        stride < width * 4) {
+        return false;
+    }
+    const auto started = std::chrono::steady_clock::now();
+
+    Frame f{};
+    f.bgra = bgra;
+    f.width = width;
+    f.height = height;
+    f.stride = stride;
+    f.subsample = options.subsample_chroma;
+    f.mcu_size = f.subsample ? 16 : 8;
+    f.mcus_x = (width + f.mcu_size - 1) / f.mcu_size;
+    f.mcu_rows = (height + f.mcu_size - 1) / f.mcu_size;
+    f.blocks_per_mcu = f.subsample ? 6 : 3;
+    const int rows = options.restart_rows > 0 ? options.restart_rows
+                                              : (f.mcu_rows + kDefaultSegments - 1) / kDefaultSegments;
+    f.segment_rows = std::clamp(rows, 1, kMaxDimension / f.mcus_x);  // DRI is 16-bit
+    f.segments = (f.mcu_rows + f.segment_rows - 1) / f.segment_rows;
+
+    JpegEncodeStats local;
+    JpegEncodeStats& s = stats ? *stats : local;
+    s = JpegEncodeStats{};
+    s.segments = f.segments;
+    int quality = std::clamp(options.quality, 1, 100);
+    TaskScheduler& pool = options.pool ? *options.pool : TaskScheduler::Instance();
+
+    // Optimised tables and size targeting look at the coefficients more than
+    // once, so the DCT output is kept. A plain encode goes in one pass.
+    const bool keep = options.optimize_huffman || options.target_bytes > 0;
+    std::vector<std::vector<int16_t>> coefs(keep ? f.segments : 0);
+    if (keep) {
+        pool.ParallelFor(f.segments, TaskScheduler::kNormal, [&](int i) { TransformSegment(f, i, coefs[i]); });
+    }
+
+    std::vector<SymbolCounter> counters;
+    const auto count = [&](const QuantTable (&quant)[2]) {
+        counters.assign(f.segments, SymbolCounter{});
+        pool.ParallelFor(f.segments, TaskScheduler::kNormal,
+                         [&](int i) { CodeSegment(f, coefs[i], quant, counters[i]); });
+    };
+    const auto optimal_tables = [&] {
+        HuffmanTables tables;
+        for (int t = 0; t < kTables; ++t) {
+            Histogram merged{};
+            for (const SymbolCounter& counter : counters) {
+                for (int sym = 0; sym < 256; ++sym) {
+                    merged[sym] += counter.counts[t][sym];
+                }
+            }
+            tables.spec[t] = OptimalSpec(merged);
+            tables.codes[t] = MakeCodes(tables.spec[t]);
+        }
+        return tables;
+    };
+
+    if (options.target_bytes > 0) {
+        // Bytes at a quality, from the symbol statistics alone: the coded bits
+        // of each segment, its padding, about one stuffed byte in 256, the
+        // markers and the headers
+        const auto estimate = [&](int q) {
+            ++s.trials;
+            QuantTable quant[2];
+            MakeQuantTables(q, quant);
+            count(quant);
+            const HuffmanTables tables = options.optimize_huffman ? optimal_tables() : StandardTables();
+            std::vector<uint8_t> headers;
+            WriteHeaders(f, quant, tables, options.dpi, headers);
+            uint64_t data = 0;
+            for (const SymbolCounter& counter : counters) {
+                data += (counter.Bits(tables) + 7) / 8;
+            }
+            return headers.size() + data + data / 256 + 2 * static_cast<uint64_t>(f.segments);
+        };
+        // Highest quality that fits; the size grows with the quality
+        if (estimate(quality) > options.target_bytes) {
+            int low = 1;
+            int high = quality - 1;
+            while (low < high) {
+                const int mid = (low + high + 1) / 2;
+                if (estimate(mid) <= options.target_bytes) {
+                    low = mid;
+                } else {
+                    high = mid - 1;
+                }
+            }
+            quality = low;
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> parts(f.segments);
+    for (;;) {
+        QuantTable quant[2];
+        MakeQuantTables(quality, quant);
+        HuffmanTables tables;
+        if (options.optimize_huffman) {
+            count(quant);
+            tables = optimal_tables();
+        } else {
+            tables = StandardTables();
+        }
+
+        pool.ParallelFor(f.segments, TaskScheduler::kNormal, [&](int i) {
+            std::vector<int16_t> transformed;
+            if (!keep) {
+                TransformSegment(f, i, transformed);
+            }
+            parts[i].clear();
+            BitWriter writer(tables, parts[i]);
+            CodeSegment(f, keep ? coefs[i] : transformed, quant, writer);
+            writer.Finish();
+        });
+
+        size_t total = 1024;
+        for (const std::vector<uint8_t>& part : parts) {
+            total += part.size() + 2;
+        }
+        out.clear();
+        out.reserve(total);
+        WriteHeaders(f, quant, tables, options.dpi, out);
+        for (int i = 0; i < f.segments; ++i) {
+            if (i > 0) {
+                PutMarker(out, static_cast<uint8_t>(0xD0 + (i - 1) % 8), 0);  // RSTn
+            }
+            out.insert(out.end(), parts[i].begin(), parts[i].end());
+        }
+        PutMarker(out, 0xD9, 0);  // EOI
+
+        // The estimate can miss by a few bytes; the next step down fits
+        if (options.target_bytes == 0 || out.size() <= options.target_bytes || quality == 1) {
+            break;
+        }
+        --quality;
+    }
+
+    s.quality = quality;
+    s.target_met = options.target_bytes == 0 || out.size() <= options.target_bytes;
+    s.encode_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class TaskScheduler;
+
+// Baseline JPEG encoder for composed photos (uploads, print files).
+//
+// The image is cut into restart-interval segments of whole MCU rows. Each
+// segment is converted, transformed and entropy coded on its own worker of
+// the shared pool into its own buffer, and the buffers are joined with RSTn
+// markers, so encoding scales with the cores where a single-stream encoder
+// runs on one. The markers cost two bytes per segment, and every baseline
+// decoder handles them. The segment layout depends only on the image, so the
+// bytes do not depend on the number of workers.
+struct JpegEncodeOptions {
+    int quality = 90;               // IJG scale, 1-100; the upper bound with target_bytes
+    bool optimize_huffman = false;  // tables fitted to the image: 2-8% smaller, one more pass
+    bool subsample_chroma = true;   // 4:2:0; false keeps full-resolution chroma (4:4:4)
+    uint64_t target_bytes = 0;      // > 0: the highest quality whose file fits
+    int restart_rows = 0;           // MCU rows per segment, 0 = about 32 segments
+    int dpi = 0;                    // JFIF density, 0 = none
+    TaskScheduler* pool = nullptr;  // workers for the segments, nullptr = TaskScheduler::Instance()
+};
+
+struct JpegEncodeStats {
+    int quality = 0;  // used, after size targeting
+    int segments = 0;
+    int trials = 0;   // size estimates made for target_bytes
+    bool target_met = true;  // false: even quality 1 is over target_bytes
+    uint64_t encode_us = 0;
+};
+
+// Encodes a BGRA image (alpha ignored, top row first) into `out`. Fails on
+// empty or oversized (> 65535) images. A target_bytes that quality 1 cannot
+// meet still leaves that (smallest) file in `out`, with stats->target_met
+// false; callers that need the size limit must check it.
+bool EncodeJpegBgra(const uint8_t* bgra, int width, int height, int stride, const JpegEncodeOptions& options,
+                    std::vector<uint8_t>& out, JpegEncodeStats* stats = nullptr);
@@ -0,0 +1,364 @@
+#include "mjpeg_recorder.h"
+#include "image_probe.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// RIFF + hdrl(avih, strl(strh, strf)) + "LIST....movi"
+static constexpr uint32_t kHeaderBytes = 12 + 8 + 192 + 12;
+
+static void PutFourCC(std::vector<uint8_t>& out, const char* cc) {
+    out.insert(out.end(), cc, cc + 4);
+}
+
+static void Put32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+static void Put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+static bool SeekTo(HANDLE file, uint64_t pos) {
+    LARGE_INTEGER li;
+    li.QuadPart = static_cast<LONGLONG>(pos);
+    return SetFilePointerEx(file, li, nullptr, FILE_BEGIN) != 0;
+}
+
+static bool WriteAll(HANDLE file, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 64 * 1024 * 1024));
+        DWORD written = 0;
+        if (!WriteFile(file, data, chunk, &written, nullptr) || written == 0) {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+MjpegRecorder::~MjpegRecorder() {
+    Stop();
+}
+
+bool MjpegRecorder::Start(const std::wstring& path, int fps) {
+    if (running_) {
+        return false;
+    }
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
+
+    file_ = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        std::cerr << "[ERR] MJPEG recorder: cannot create output file\n";
+        return false;
+    }
+
+    // Reserve the first chunk of disk space up front so the filesystem does
+    // not have to grow the file on every write.
+    allocated_ = kPreallocBytes;
+    if (!SeekTo(file_, allocated_) || !SetEndOfFile(file_) || !SeekTo(file_, 0)) {
+        allocated_ = 0;
+        SeekTo(file_, 0);
+    }
+
+    buffer_.clear();
+    buffer_.reserve(kWriteBufferBytes);
+    index_.clear();
+    fps_ = std::clamp(fps, 1, 120);
+    width_ = height_ = 0;
+    max_chunk_ = 0;
+    next_slot_ = 0;
+    failed_ = false;
+    finalized_ok_ = false;
+
+    // Placeholder headers; rewritten with the real values on Stop().
+    buffer_.assign(kHeaderBytes, 0);
+    file_pos_ = kHeaderBytes;
+    movi_fourcc_pos_ = kHeaderBytes - 4;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        stats_ = Stats{};
+        stop_requested_ = false;
+    }
+    running_ = true;
+    io_thread_ = std::thread(&MjpegRecorder::IoLoop, this);
+    return true;
+}
+
+void MjpegRecorder::Push(const JpegBytes& jpeg, Clock::time_point captured_at) {
+    if (!running_ || !jpeg || jpeg->empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_requested_) {
+            return;
+        }
+        if (queue_.size() >= kMaxQueuedFrames) {
+            stats_.frames_dropped++;
+            return;
+        }
+        queue_.push_back(Pending{jpeg, captured_at});
+    }
+    cv_.notify_one();
+}
+
+bool MjpegRecorder::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return false;
+        }
+        stop_requested_ = true;
+    }
+    cv_.notify_one();
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
+    running_ = false;
+    return finalized_ok_;
+}
+
+MjpegRecorder::Stats MjpegRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MjpegRecorder::IoLoop() {
+    for (;;) {
+        std::deque<Pending> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_requested_ || !queue_.empty(); });
+            batch.swap(queue_);
+            if (batch.empty() && stop_requested_) {
+                break;
+            }
+        }
+        for (const Pending& frame : batch) {
+            if (!failed_ && !WriteFrame(frame)) {
+                failed_ = true;
+                std::cerr << "[ERR] MJPEG recorder: write failed, recording stopped\n";
+            }
+        }
+    }
+
+    finalized_ok_ = !failed_ && Finalize();
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool MjpegRecorder::WriteFrame(const Pending& frame) {
+    const std::vector<uint8_t>& jpeg = *frame.jpeg;
+
+    if (index_.empty()) {
+        if (!ProbeJpegSize(jpeg.data(), jpeg.size(), width_, height_)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.frames_dropped++;
+            return true;
+        }
+        first_at_ = frame.captured_at;
+    }
+
+    const double elapsed = std::chrono::duration<double>(frame.captured_at - first_at_).count();
+    const int64_t slot = static_cast<int64_t>(std::llround(elapsed * fps_));
+
+    // Each chunk costs its payload plus an 8-byte header and a 16-byte index entry.
+    const uint64_t empty_cost = 8 + 16;
+    const uint64_t gap = slot > next_slot_ ? static_cast<uint64_t>(slot - next_slot_) : 0;
+    const uint64_t needed = gap * empty_cost + jpeg.size() + 1 + empty_cost;
+    if (slot < next_slot_ || file_pos_ + (index_.size() * 16) + needed > kMaxFileBytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.frames_dropped++;
+        return true;
+    }
+
+    uint64_t repeated = 0;
+    while (next_slot_ < slot) {
+        if (!WriteChunk(nullptr, 0, false)) return false;
+        next_slot_++;
+        repeated++;
+    }
+    if (!WriteChunk(jpeg.data(), static_cast<uint32_t>(jpeg.size()), true)) {
+        return false;
+    }
+    next_slot_++;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_written++;
+    stats_.frames_repeated += repeated;
+    stats_.bytes_written = file_pos_;
+    return true;
+}
+
+bool MjpegRecorder::WriteChunk(const uint8_t* data, uint32_t size, bool key) {
+    index_.push_back(IndexEntry{static_cast<uint32_t>(file_pos_ - movi_fourcc_pos_), size, key});
+    max_chunk_ = std::max(max_chunk_, size);
+
+    uint8_t header[8] = {'0', '0', 'd', 'c',
+                         static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+                         static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 24)};
+    if (!Append(header, sizeof(header))) return false;
+    if (size > 0 && !Append(data, size)) return false;
+    if (size & 1) {
+        const uint8_t pad = 0;
+        if (!Append(&pad, 1)) return false;
+    }
+    return true;
+}
+
+bool MjpegRecorder::Append(const void* data, size_t size) {
+    if (buffer_.size() + size > kWriteBufferBytes && !FlushBuffer()) {
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    if (size >= kWriteBufferBytes) {
+        // Larger than the buffer: write straight through.
+        if (file_pos_ + size > allocated_) {
+            buffer_.insert(buffer_.end(), bytes, bytes + size);
+            file_pos_ += size;
+            return FlushBuffer();
+        }
+        file_pos_ += size;
+        return WriteAll(file_, bytes, size);
+    }
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+    file_pos_ += size;
+    return true;
+}
+
+bool MjpegRecorder::FlushBuffer() {
+    if (buffer_.empty()) {
+        return true;
+    }
+    if (file_pos_ > allocated_) {
+        // Grow the preallocation in big steps, then return to the write position.
+        const uint64_t write_pos = file_pos_ - buffer_.size();
+        while (allocated_ < file_pos_) {
+            allocated_ += kPreallocBytes;
+        }
+        if (!SeekTo(file_, allocated_) || !SetEndOfFile(file_) || !SeekTo(file_, write_pos)) {
+            return false;
+        }
+    }
+    const bool ok = WriteAll(file_, buffer_.data(), buffer_.size());
+    buffer_.clear();
+    return ok;
+}
+
+bool MjpegRecorder::Finalize() {
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    const uint64_t idx1_pos = file_pos_;
+    std::vector<uint8_t> idx;
+    idx.reserve(8 + index_.size() * 16);
+    PutFourCC(idx, "idx1");
+    Put32(idx, static_cast<uint32_t>(index_.size() * 16));
+    for (const IndexEntry& e : index_) {
+        PutFourCC(idx, "00dc");
+        Put32(idx, e.key ? 0x10 : 0);  // AVIIF_KEYFRAME
+        Put32(idx, e.offset);
+        Put32(idx, e.size);
+    }
+    if (!Append(idx.data(), idx.size()) || !FlushBuffer()) {
+        return false;
+    }
+
+    const uint64_t final_size = file_pos_;
+    const std::vector<uint8_t> header = BuildHeader(static_cast<uint32_t>(final_size - 8),
+                                                    static_cast<uint32_t>(idx1_pos - movi_fourcc_pos_));
+    if (!SeekTo(file_, 0) || !WriteAll(file_, header.data(), header.size())) {
+        return false;
+    }
+
+    // Drop the unused preallocated tail.
+    if (!SeekTo(file_, final_size) || !SetEndOfFile(file_)) {
+        return false;
+    }
+    return !index_.empty();
+}
+
+std::vector<uint8_t> MjpegRecorder::BuildHeader(uint32_t riff_size, uint32_t movi_size) const {
+    const uint32_t frames = static_cast<uint32_t>(index_.size());
+    const uint32_t usec_per_frame = static_cast<uint32_t>(1000000 / fps_);
+    const uint32_t suggested = max_chunk_ + 8;
+
+    std::vector<uint8_t> h;
+    h.reserve(kHeaderBytes);
+    PutFourCC(h, "RIFF");
+    Put32(h, riff_size);
+    PutFourCC(h, "AVI ");
+
+    PutFourCC(h, "LIST");
+    Put32(h, 192);
+    PutFourCC(h, "hdrl");
+
+    // MainAVIHeader
+    PutFourCC(h, "avih");
+    Put32(h, 56);
+    Put32(h, usec_per_frame);
+    Put32(h, suggested * static_cast<uint32_t>(fps_));  // dwMaxBytesPerSec
+    Put32(h, 0);                                        // dwPaddingGranularity
+    Put32(h, 0x10);                                     // AVIF_HASINDEX
+    Put32(h, frames);                                   // dwTotalFrames
+    Put32(h, 0);                                        // dwInitialFrames
+    Put32(h, 1);                                        // dwStreams
+    Put32(h, suggested);
+    Put32(h, static_cast<uint32_t>(width_));
+    Put32(h, static_cast<uint32_t>(height_));
+    for (int i = 0; i < 4; ++i) Put32(h, 0);
+
+    PutFourCC(h, "LIST");
+    Put32(h, 116);
+    PutFourCC(h, "strl");
+
+    // AVIStreamHeader
+    PutFourCC(h, "strh");
+    Put32(h, 56);
+    PutFourCC(h, "vids");
+    PutFourCC(h, "MJPG");
+    Put32(h, 0);  // dwFlags
+    Put16(h, 0);  // wPriority
+    Put16(h, 0);  // wLanguage
+    Put32(h, 0);  // dwInitialFrames
+    Put32(h, 1);  // dwScale
+    Put32(h, static_cast<uint32_t>(fps_));  // dwRate
+    Put32(h, 0);       // dwStart
+    Put32(h, frames);  // dwLength
+    Put32(h, suggested);
+    Put32(h, 0xFFFFFFFF);  // dwQuality
+    Put32(h, 0);           // dwSampleSize
+    Put16(h, 0);
+    Put16(h, 0);
+    Put16(h, static_cast<uint16_t>(width_));
+    Put16(h, static_cast<uint16_t>(height_));
+
+    // BITMAPINFOHEADER
+    PutFourCC(h, "strf");
+    Put32(h, 40);
+    Put32(h, 40);
+    Put32(h, static_cast<uint32_t>(width_));
+    Put32(h, static_cast<uint32_t>(height_));
+    Put16(h, 1);
+    Put16(h, 24);
+    PutFourCC(h, "MJPG");
+    Put32(h, static_cast<uint32_t>(width_ * height_ * 3));
+    for (int i = 0; i < 4; ++i) Put32(h, 0);
+
+    PutFourCC(h, "LIST");
+    Put32(h, movi_size);
+    PutFourCC(h, "movi");
+    return h;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "frame_types.h"
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records live view to an MJPEG AVI without re-encoding: the EVF JPEGs are
+// written as-is into the 'movi' list.
+//
+// Push() only queues a shared reference and never blocks; an I/O thread does
+// all file work with large buffered writes into a file preallocated in
+// chunks (truncated to the real size on Stop()). The stream uses a fixed
+// timebase; a frame is placed at round(elapsed * fps) and the gaps are filled
+// with empty '00dc' chunks, which players treat as "repeat previous frame",
+// so playback timing follows capture time even though EVF rate varies.
+//
+// Plain AVI 1.0 (idx1 index), so a recording is capped at kMaxFileBytes.
+class MjpegRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t frames_written = 0;
+        uint64_t frames_repeated = 0;  // empty chunks inserted for timing
+        uint64_t frames_dropped = 0;   // queue overflow, too-early or size limit
+        uint64_t bytes_written = 0;
+    };
+
+    static constexpr uint64_t kMaxFileBytes = 1000ull * 1024 * 1024;
+
+    MjpegRecorder() = default;
+    ~MjpegRecorder();
+    MjpegRecorder(const MjpegRecorder&) = delete;
+    MjpegRecorder& operator=(const MjpegRecorder&) = delete;
+
+    bool Start(const std::wstring& path, int fps);
+    void Push(const JpegBytes& jpeg, Clock::time_point captured_at);
+    // Drains the queue, writes index and final headers. Returns false if the
+    // file could not be completed.
+    bool Stop();
+
+    bool recording() const { return running_; }
+    Stats stats() const;
+
+private:
+    struct Pending {
+        JpegBytes jpeg;
+        Clock::time_point captured_at;
+    };
+    struct IndexEntry {
+        uint32_t offset;  // from the 'movi' fourcc
+        uint32_t size;
+        bool key;
+    };
+
+    void IoLoop();
+    bool WriteFrame(const Pending& frame);
+    bool WriteChunk(const uint8_t* data, uint32_t size, bool key);
+    bool Append(const void* data, size_t size);
+    bool FlushBuffer();
+    bool Finalize();
+    std::vector<uint8_t> BuildHeader(uint32_t riff_size, uint32_t movi_size) const;
+
+    static constexpr size_t kWriteBufferBytes = 4 * 1024 * 1024;
+    static constexpr uint64_t kPreallocBytes = 64ull * 1024 * 1024;
+    static constexpr size_t kMaxQueuedFrames = 120;
+
+    // Queue shared with the capture thread
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> queue_;
+    std::atomic<bool> running_{false};
+    bool stop_requested_ = false;
+    std::thread io_thread_;
+    Stats stats_;
+
+    // Owned by the I/O thread
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    std::vector<uint8_t> buffer_;
+    uint64_t file_pos_ = 0;       // logical end of data written so far
+    uint64_t allocated_ = 0;      // preallocated file size
+    uint64_t movi_fourcc_pos_ = 0;
+    std::vector<IndexEntry> index_;
+    int fps_ = 30;
+    int width_ = 0;
+    int height_ = 0;
+    uint32_t max_chunk_ = 0;
+    int64_t next_slot_ = 0;
+    Clock::time_point first_at_{};
+    bool failed_ = false;
+    bool finalized_ok_ = false;
+};
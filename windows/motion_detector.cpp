@@ -0,0 +1,162 @@
+#include "motion_detector.h"
+#include <algorithm>
+#include <cstdlib>
+
+void MotionDetector::Configure(int cell_threshold, int min_changed_permille) {
+    cell_threshold_ = std::clamp(cell_threshold, 1, 255);
+    min_changed_permille_ = std::clamp(min_changed_permille, 1, 1000);
+}
+
+void MotionDetector::Reset() {
+    previous_.clear();
+}
+
+bool MotionDetector::Update(const uint8_t* luma, int width, int height, int stride) {
+    if (!luma || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Box-average onto the fixed grid.
+    uint32_t sums[kGridW * kGridH] = {};
+    uint32_t counts[kGridW * kGridH] = {};
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = luma + static_cast<size_t>(y) * stride;
+        const int cy = y * kGridH / height;
+        uint32_t* sum_row = sums + cy * kGridW;
+        uint32_t* count_row = counts + cy * kGridW;
+        for (int x = 0; x < width; ++x) {
+            const int cx = x * kGridW / width;
+            sum_row[cx] += row[x];
+            count_row[cx]++;
+        }
+    }
+
+    grid_.resize(kGridW * kGridH);
+    for (int i = 0; i < kGridW * kGridH; ++i) {
+        grid_[i] = static_cast<uint16_t>(counts[i] ? sums[i] / counts[i] : 0);
+    }
+
+    if (previous_.size() != grid_.size()) {
+        previous_.swap(grid_);
+        return true;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < kGridW * kGridH; ++i) {
+        if (std::abs(static_cast<int>(grid_[i]) - static_cast<int>(previous_[i])) > cell_threshold_) {
+            ++changed;
+        }
+    }
+    previous_.swap(grid_);
+
+    return changed * 1000 >= min_changed_permille_ * kGridW * kGridH;
+}
+
+void IdleMonitor::Configure(bool enabled, int idle_after_ms, int trickle_interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    idle_after_ms_ = std::max(1, idle_after_ms);
+    trickle_interval_ms_ = std::max(1, trickle_interval_ms);
+    if (!enabled_ && idle_) {
+        idle_ = false;
+        stats_.idle_ms_total += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - idle_since_).count());
+    }
+    last_motion_ = Clock::now();
+}
+
+void IdleMonitor::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_ = false;
+    just_woke_ = false;
+    last_motion_ = Clock::now();
+    stats_ = Stats{};
+}
+
+bool IdleMonitor::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+bool IdleMonitor::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_;
+}
+
+int IdleMonitor::trickle_interval_ms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return trickle_interval_ms_;
+}
+
+bool IdleMonitor::OnFrame(bool motion, Clock::time_point captured_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_captured++;
+
+    if (!enabled_) {
+        stats_.frames_published++;
+        return true;
+    }
+
+    if (motion) {
+        last_motion_ = captured_at;
+    }
+
+    if (idle_) {
+        if (!motion) {
+            stats_.frames_skipped++;
+            return false;
+        }
+        idle_ = false;
+        just_woke_ = true;
+        stats_.wake_count++;
+        stats_.idle_ms_total += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(captured_at - idle_since_).count());
+        stats_.frames_published++;
+        return true;
+    }
+
+    if (captured_at - last_motion_ > std::chrono::milliseconds(idle_after_ms_)) {
+        idle_ = true;
+        idle_since_ = captured_at;
+        stats_.frames_skipped++;
+        return false;
+    }
+
+    stats_.frames_published++;
+    return true;
+}
+
+void IdleMonitor::Wake() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+    last_motion_ = now;
+    if (!idle_) {
+        return;
+    }
+    idle_ = false;
+    just_woke_ = true;
+    stats_.wake_count++;
+    stats_.idle_ms_total += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - idle_since_).count());
+}
+
+bool IdleMonitor::OnWakePublished(Clock::time_point captured_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!just_woke_) {
+        return false;
+    }
+    just_woke_ = false;
+    stats_.last_wake_latency_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - captured_at).count());
+    return true;
+}
+
+IdleMonitor::Stats IdleMonitor::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    if (idle_) {
+        s.idle_ms_total += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - idle_since_).count());
+    }
+    return s;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Cheap frame-to-frame motion test on a downscaled luma image.
+// The input (any size, typically a 1/8-scale JPEG decode) is box-averaged
+// onto a fixed grid; motion is reported when enough cells change brightness
+// by more than a threshold. Averaging over cells makes it robust to sensor
+// noise and JPEG block artifacts without any per-pixel work on full frames.
+class MotionDetector {
+public:
+    static constexpr int kGridW = 32;
+    static constexpr int kGridH = 24;
+
+    // cell_threshold: mean luma delta (0..255) for a cell to count as changed.
+    // min_changed_permille: changed cells (per 1000) needed to report motion.
+    void Configure(int cell_threshold, int min_changed_permille);
+    void Reset();
+
+    // Returns true when `luma` differs enough from the previous call.
+    // The first frame after Reset() always counts as motion.
+    bool Update(const uint8_t* luma, int width, int height, int stride);
+
+private:
+    std::vector<uint16_t> grid_;
+    std::vector<uint16_t> previous_;
+    int cell_threshold_ = 10;
+    int min_changed_permille_ = 8;
+};
+
+// Active/idle state machine driven by motion results. Thread-safe: the capture
+// thread feeds frames while the UI may call Wake() or read stats().
+class IdleMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t frames_captured = 0;
+        uint64_t frames_published = 0;
+        uint64_t frames_skipped = 0;   // captured while idle, not decoded or delivered
+        uint64_t wake_count = 0;
+        uint64_t idle_ms_total = 0;    // including the current idle period
+        uint64_t last_wake_latency_us = 0;
+    };
+
+    void Configure(bool enabled, int idle_after_ms, int trickle_interval_ms);
+    void Reset();
+
+    bool enabled() const;
+    bool idle() const;
+    int trickle_interval_ms() const;
+
+    // Feed one captured frame. `captured_at` is when its download finished.
+    // Returns true if the frame should be published to consumers.
+    bool OnFrame(bool motion, Clock::time_point captured_at);
+    // Leave idle immediately (e.g. the screen was touched).
+    void Wake();
+    // Record how long a waking frame took from capture to publication.
+    // Returns true if this was the first frame published after a wake.
+    bool OnWakePublished(Clock::time_point captured_at);
+
+    Stats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    bool enabled_ = false;
+    bool idle_ = false;
+    bool just_woke_ = false;
+    int idle_after_ms_ = 30000;
+    int trickle_interval_ms_ = 1000;
+    Clock::time_point last_motion_{};
+    Clock::time_point idle_since_{};
+    Stats stats_;
+};
@@ -0,0 +1,331 @@
+#include "overlay_template.h"
+#include "content_hash.h"
+#include "pixel_kernels.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+constexpr size_t kPlacedSizes = 4;
+constexpr double kPi = 3.14159265358979323846;
+
+// Row bands of `rows` rows over the shared pool, two per worker
+template <typename Fn>
+void ForBands(int rows, Fn fn) {
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int bands = std::min(rows, pool.worker_count() * 2);
+    if (bands <= 0) {
+        return;
+    }
+    pool.ParallelFor(bands, TaskScheduler::kHigh, [&](int band) {
+        fn(rows * band / bands, rows * (band + 1) / bands);
+    });
+}
+
+// Lanczos rings past the alpha edge; keep every pixel valid premultiplied
+// (colour <= alpha) so the blend cannot overflow, and fold in the opacity.
+void FinishPixels(std::vector<uint8_t>& pixels, double opacity) {
+    const int scale = static_cast<int>(std::lround(std::clamp(opacity, 0.0, 1.0) * 255.0));
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        uint8_t* p = &pixels[i];
+        const uint8_t a = p[3];
+        p[0] = std::min(p[0], a);
+        p[1] = std::min(p[1], a);
+        p[2] = std::min(p[2], a);
+        if (scale < 255) {
+            for (int c = 0; c < 4; ++c) {
+                p[c] = static_cast<uint8_t>((p[c] * scale + 127) / 255);
+            }
+        }
+    }
+}
+
+// Bilinear turn of a w x h premultiplied layer by `degrees` clockwise about
+// the centre of the box (bx, by, bw, bh) it fills, into the axis-aligned
+// pixel rectangle around the result. Outside the layer is transparent, which
+// is what anti-aliases the rotated edges.
+PlacedOverlay::Layer RotateLayer(const std::vector<uint8_t>& src, int w, int h, double bx, double by, double bw,
+                                 double bh, double degrees) {
+    const double rad = degrees * kPi / 180.0;
+    const double c = std::cos(rad);
+    const double s = std::sin(rad);
+    const double cx = bx + bw / 2;
+    const double cy = by + bh / 2;
+    const double ex = (std::abs(c) * bw + std::abs(s) * bh) / 2;
+    const double ey = (std::abs(s) * bw + std::abs(c) * bh) / 2;
+
+    PlacedOverlay::Layer out;
+    out.x = static_cast<int>(std::floor(cx - ex));
+    out.y = static_cast<int>(std::floor(cy - ey));
+    out.width = static_cast<int>(std::ceil(cx + ex)) - out.x;
+    out.height = static_cast<int>(std::ceil(cy + ey)) - out.y;
+    out.pixels.assign(static_cast<size_t>(out.width) * out.height * 4, 0);
+
+    const double fx_scale = w / bw;
+    const double fy_scale = h / bh;
+    auto texel = [&](int x, int y, int ch) -> double {
+        return x < 0 || y < 0 || x >= w || y >= h ? 0.0 : src[(static_cast<size_t>(y) * w + x) * 4 + ch];
+    };
+    ForBands(out.height, [&](int row_begin, int row_end) {
+        for (int py = row_begin; py < row_end; ++py) {
+            uint8_t* dst = out.pixels.data() + static_cast<size_t>(py) * out.width * 4;
+            const double dy = out.y + py + 0.5 - cy;
+            for (int px = 0; px < out.width; ++px, dst += 4) {
+                // Back into the unrotated box, then into layer pixels
+                const double dx = out.x + px + 0.5 - cx;
+                const double fx = (dx * c + dy * s + bw / 2) * fx_scale - 0.5;
+                const double fy = (-dx * s + dy * c + bh / 2) * fy_scale - 0.5;
+                if (fx <= -1 || fy <= -1 || fx >= w || fy >= h) {
+                    continue;
+                }
+                const int x0 = static_cast<int>(std::floor(fx));
+                const int y0 = static_cast<int>(std::floor(fy));
+                const double wx = fx - x0;
+                const double wy = fy - y0;
+                for (int ch = 0; ch < 4; ++ch) {
+                    const double top = texel(x0, y0, ch) * (1 - wx) + texel(x0 + 1, y0, ch) * wx;
+                    const double bottom = texel(x0, y0 + 1, ch) * (1 - wx) + texel(x0 + 1, y0 + 1, ch) * wx;
+                    dst[ch] = static_cast<uint8_t>(std::lround(top * (1 - wy) + bottom * wy));
+                }
+            }
+        }
+    });
+    return out;
+}
+
+// Drops what falls outside a width x height image. False when nothing is left.
+bool ClipLayer(PlacedOverlay::Layer& layer, int width, int height) {
+    const int x0 = std::max(0, layer.x);
+    const int y0 = std::max(0, layer.y);
+    const int x1 = std::min(width, layer.x + layer.width);
+    const int y1 = std::min(height, layer.y + layer.height);
+    if (x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+    if (x0 == layer.x && y0 == layer.y && x1 - x0 == layer.width && y1 - y0 == layer.height) {
+        return true;
+    }
+    const size_t row_bytes = static_cast<size_t>(x1 - x0) * 4;
+    std::vector<uint8_t> clipped(row_bytes * (y1 - y0));
+    for (int y = y0; y < y1; ++y) {
+        std::memcpy(clipped.data() + (y - y0) * row_bytes,
+                    layer.pixels.data() + (static_cast<size_t>(y - layer.y) * layer.width + (x0 - layer.x)) * 4,
+                    row_bytes);
+    }
+    layer.x = x0;
+    layer.y = y0;
+    layer.width = x1 - x0;
+    layer.height = y1 - y0;
+    layer.pixels.swap(clipped);
+    return true;
+}
+
+}  // namespace
+
+void PlacedOverlay::ApplyRows(uint8_t* rows, int stride, int row_begin, int row_end) const {
+    for (const Layer& layer : layers_) {
+        const int r0 = std::max(row_begin, layer.y);
+        const int r1 = std::min(row_end, layer.y + layer.height);
+        if (r0 >= r1) {
+            continue;
+        }
+        uint8_t* dst = rows + static_cast<size_t>(r0 - row_begin) * stride + static_cast<size_t>(layer.x) * 4;
+        BlendOver(layer.pixels.data() + static_cast<size_t>(r0 - layer.y) * layer.width * 4, layer.width, r1 - r0,
+                  layer.width * 4, dst, stride);
+    }
+}
+
+void PlacedOverlay::Apply(uint8_t* bgra, int stride) const {
+    ForBands(height_, [&](int row_begin, int row_end) {
+        ApplyRows(bgra + static_cast<size_t>(row_begin) * stride, stride, row_begin, row_end);
+    });
+}
+
+bool OverlayTemplate::SetCanvas(double width, double height) {
+    if (!(width > 0) || !(height > 0)) {
+        return false;
+    }
+    canvas_width_ = width;
+    canvas_height_ = height;
+    std::lock_guard<std::mutex> lock(mutex_);
+    placed_.clear();
+    return true;
+}
+
+bool OverlayTemplate::AddLayer(const uint8_t* data, size_t len, const OverlayPlacement& placement,
+                               WicDecoder& decoder, TemplateAssetCache* assets) {
+    if (!(placement.width > 0) || !(placement.height > 0) || !std::isfinite(placement.x) ||
+        !std::isfinite(placement.y) || !std::isfinite(placement.rotation) || !(placement.opacity >= 0)) {
+        return false;
+    }
+    Source source;
+    if (assets) {
+        source.image = assets->Get(data, len, decoder);
+    } else {
+        DecodedImage decoded;
+        if (decoder.DecodePremultiplied(data, len, decoded)) {
+            source.image = TileImage::FromPixels(decoded, HashBytes(data, len));
+        }
+    }
+    if (!source.image) {
+        return false;
+    }
+    source.placement = placement;
+    sources_.push_back(std::move(source));
+    std::lock_guard<std::mutex> lock(mutex_);
+    placed_.clear();
+    return true;
+}
+
+bool OverlayTemplate::Load(const std::wstring& path, WicDecoder& decoder, TemplateAssetCache* assets) {
+    namespace fs = std::filesystem;
+
+    canvas_width_ = canvas_height_ = 0;
+    sources_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        placed_.clear();
+    }
+
+    std::ifstream in{fs::path(path)};
+    if (!in) {
+        std::cerr << "[ERR] Overlay template not readable\n";
+        return false;
+    }
+    const fs::path base = fs::path(path).parent_path();
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number) {
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        bool ok = false;
+        if (keyword == "canvas") {
+            double width = 0, height = 0;
+            ok = static_cast<bool>(fields >> width >> height) && SetCanvas(width, height);
+        } else if (keyword == "layer") {
+            std::string file;
+            OverlayPlacement placement;
+            if (fields >> std::quoted(file) >> placement.x >> placement.y >> placement.width >> placement.height) {
+                double value = 0;
+                if (fields >> value) {
+                    placement.rotation = value;
+                    if (fields >> value) {
+                        placement.opacity = value;
+                    }
+                }
+                std::ifstream image(base / fs::u8path(file), std::ios::binary);
+                const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(image)),
+                                                 std::istreambuf_iterator<char>());
+                ok = !bytes.empty() && AddLayer(bytes.data(), bytes.size(), placement, decoder, assets);
+            }
+        }
+        if (!ok) {
+            std::cerr << "[ERR] Overlay template line " << number << " rejected: " << line << "\n";
+            return false;
+        }
+    }
+    if (empty()) {
+        std::cerr << "[ERR] Overlay template needs a canvas and at least one layer\n";
+        return false;
+    }
+    std::cout << "[OK] Overlay template loaded with " << sources_.size() << " layers\n";
+    return true;
+}
+
+uint64_t OverlayTemplate::id() const {
+    if (empty()) {
+        return 0;
+    }
+    const double canvas[2] = {canvas_width_, canvas_height_};
+    uint64_t hash = HashBytes(canvas, sizeof(canvas));
+    for (const Source& source : sources_) {
+        const uint64_t artwork = source.image->source_hash();
+        hash = HashBytes(&artwork, sizeof(artwork), hash);
+        hash = HashBytes(&source.placement, sizeof(source.placement), hash);
+    }
+    return hash;
+}
+
+std::shared_ptr<const PlacedOverlay> OverlayTemplate::Place(int width, int height) {
+    if (empty() || width <= 0 || height <= 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < placed_.size(); ++i) {
+        if (placed_[i]->width() == width && placed_[i]->height() == height) {
+            std::rotate(placed_.begin(), placed_.begin() + i, placed_.begin() + i + 1);
+            return placed_.front();
+        }
+    }
+
+    auto placed = std::make_shared<PlacedOverlay>();
+    placed->width_ = width;
+    placed->height_ = height;
+    const double sx = width / canvas_width_;
+    const double sy = height / canvas_height_;
+    for (const Source& source : sources_) {
+        const OverlayPlacement& p = source.placement;
+        const double bx = p.x * sx;
+        const double by = p.y * sy;
+        const double bw = p.width * sx;
+        const double bh = p.height * sy;
+        const double turns = p.rotation / 90.0;
+        const bool square = std::abs(turns - std::round(turns)) < 1e-9;
+        const int quarter = square ? ((static_cast<int>(std::lround(turns)) % 4) + 4) % 4 : 0;
+
+        // Scale to the box (before any turn), premultiplied all the way
+        const int w = std::max(1, static_cast<int>(std::lround(bw)));
+        const int h = std::max(1, static_cast<int>(std::lround(bh)));
+        const TileImage& image = *source.image;
+        std::vector<uint8_t> scaled(static_cast<size_t>(image.width()) * image.height() * 4);
+        image.CopyTo(scaled.data(), image.width() * 4);
+        if (w != image.width() || h != image.height()) {
+            std::vector<uint8_t> full;
+            full.swap(scaled);
+            scaled.resize(static_cast<size_t>(w) * h * 4);
+            ForBands(h, [&](int row_begin, int row_end) {
+                ResizeLanczosBgraRows(full.data(), image.width(), image.height(), image.width() * 4,
+                                      scaled.data() + static_cast<size_t>(row_begin) * w * 4, w, h, w * 4,
+                                      row_begin, row_end);
+            });
+        }
+        FinishPixels(scaled, p.opacity);
+
+        PlacedOverlay::Layer layer;
+        if (!square) {
+            layer = RotateLayer(scaled, w, h, bx, by, bw, bh, p.rotation);
+        } else if (quarter == kRotate0) {
+            layer.x = static_cast<int>(std::lround(bx));
+            layer.y = static_cast<int>(std::lround(by));
+            layer.width = w;
+            layer.height = h;
+            layer.pixels.swap(scaled);
+        } else {
+            // Quarter turns stay exact
+            TransformedSize(quarter, w, h, layer.width, layer.height);
+            layer.x = static_cast<int>(std::lround(bx + bw / 2 - layer.width / 2.0));
+            layer.y = static_cast<int>(std::lround(by + bh / 2 - layer.height / 2.0));
+            layer.pixels.resize(scaled.size());
+            TransformImage(scaled.data(), w, h, w * 4, 4, quarter, layer.pixels.data(), layer.width * 4);
+        }
+        if (ClipLayer(layer, width, height)) {
+            placed->layers_.push_back(std::move(layer));
+        }
+    }
+
+    placed_.insert(placed_.begin(), placed);
+    if (placed_.size() > kPlacedSizes) {
+        placed_.pop_back();
+    }
+    return placed;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "image_decode.h"
+#include "template_assets.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where one layer sits on the template canvas, in canvas units.
+struct OverlayPlacement {
+    double x = 0;         // top-left of the unrotated layer box
+    double y = 0;
+    double width = 0;
+    double height = 0;
+    double rotation = 0;  // degrees clockwise about the box centre
+    double opacity = 1;
+};
+
+// A template's layers rendered for one output size: premultiplied BGRA at
+// their final position, clipped to the image. Immutable once built, so any
+// number of bands and threads can share one.
+class PlacedOverlay {
+public:
+    // One layer's premultiplied pixels and its position in the image
+    struct Layer {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;  // stride width * 4
+    };
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Composites the layers over output rows [row_begin, row_end) of a BGRA
+    // image of this size. `rows` points at row row_begin.
+    void ApplyRows(uint8_t* rows, int stride, int row_begin, int row_end) const;
+
+    // Whole image, in row bands over the shared worker pool.
+    void Apply(uint8_t* bgra, int stride) const;
+
+private:
+    friend class OverlayTemplate;
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<Layer> layers_;
+};
+
+// Frame and sticker artwork composited over photos: PNG layers, each placed,
+// scaled, rotated and faded on a canvas, drawn in order.
+//
+// The artwork is decoded and premultiplied once when the template loads,
+// or, with a TemplateAssetCache, once ever: later loads map the converted
+// tiles instead of decoding. Scaling and rotating for an output size happens
+// once per size (Place) and is kept for the next photo, so per photo only the
+// blend runs, and that is the SIMD `over` kernel with transparent and opaque
+// runs short-circuited.
+//
+// Canvas units map to the output by stretching each axis independently, so
+// a 6 x 4 canvas fits any 3:2 page. Place is thread-safe; Load, SetCanvas
+// and AddLayer are not and belong before the template is shared.
+class OverlayTemplate {
+public:
+    OverlayTemplate() = default;
+    OverlayTemplate(const OverlayTemplate&) = delete;
+    OverlayTemplate& operator=(const OverlayTemplate&) = delete;
+
+    // Reads a UTF-8 template file:
+    //
+    //   # photo booth frame, 6 x 4 in
+    //   canvas 6 4
+    //   layer frame.png 0 0 6 4
+    //   layer "party hat.png" 4.2 0.3 1.2 1.2 15 0.9
+    //
+    // layer <image> <x> <y> <width> <height> [<rotation> [<opacity>]], images
+    // relative to the template file. `decoder` is only used during the call;
+    // `assets` (optional) supplies and keeps the converted artwork.
+    bool Load(const std::wstring& path, WicDecoder& decoder, TemplateAssetCache* assets = nullptr);
+
+    bool SetCanvas(double width, double height);
+    bool AddLayer(const uint8_t* data, size_t len, const OverlayPlacement& placement, WicDecoder& decoder,
+                  TemplateAssetCache* assets = nullptr);
+
+    int layer_count() const { return static_cast<int>(sources_.size()); }
+    bool empty() const { return sources_.empty() || canvas_width_ <= 0; }
+
+    // Content hash of the canvas, artwork and placements (0 when empty), for
+    // caches of composited output.
+    uint64_t id() const;
+
+    // The layers rendered for a width x height output, built on first use
+    // and reused after (the last few sizes are kept). Null when empty.
+    std::shared_ptr<const PlacedOverlay> Place(int width, int height);
+
+private:
+    struct Source {
+        std::shared_ptr<const TileImage> image;  // premultiplied, full size
+        OverlayPlacement placement;
+    };
+
+    double canvas_width_ = 0;
+    double canvas_height_ = 0;
+    std::vector<Source> sources_;
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<const PlacedOverlay>> placed_;  // most recent first
+};
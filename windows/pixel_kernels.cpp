@@ -0,0 +1,603 @@
+#include "pixel_kernels.h"
+#include "pixel_kernels_impl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#if PIXEL_KERNELS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar reference rows
+
+static void SwizzleScalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i, src += 4, dst += 4) {
+        const uint8_t c0 = src[0];
+        const uint8_t c2 = src[2];
+        dst[0] = c2;
+        dst[1] = src[1];
+        dst[2] = c0;
+        dst[3] = src[3];
+    }
+}
+
+// round(x * a / 255) for all 8-bit x and a
+static inline uint8_t MulDiv255(int x, int a) {
+    const int t = x * a + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+static void PremultiplyScalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i, src += 4, dst += 4) {
+        const int a = src[3];
+        dst[0] = MulDiv255(src[0], a);
+        dst[1] = MulDiv255(src[1], a);
+        dst[2] = MulDiv255(src[2], a);
+        dst[3] = static_cast<uint8_t>(a);
+    }
+}
+
+static void Mirror8Scalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = src[count - 1 - i];
+    }
+}
+
+static void Mirror32Scalar(const uint8_t* src, uint8_t* dst, int count) {
+    // Rows need not be 4-byte aligned (odd strides, sub-rectangles)
+    for (int i = 0; i < count; ++i) {
+        std::memcpy(dst + i * 4, src + (count - 1 - i) * 4, 4);
+    }
+}
+
+static void BgraToGrayScalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i, src += 4) {
+        dst[i] = static_cast<uint8_t>((29 * src[0] + 150 * src[1] + 77 * src[2]) >> 8);
+    }
+}
+
+static void BgraToBgrScalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i, src += 4, dst += 3) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+static void OverScalar(const uint8_t* src, uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i, src += 4, dst += 4) {
+        const int inv = 255 - src[3];
+        for (int c = 0; c < 4; ++c) {
+            dst[c] = static_cast<uint8_t>(std::min(255, src[c] + MulDiv255(dst[c], inv)));
+        }
+    }
+}
+
+static void Lut3dScalar(const uint8_t* src, uint8_t* dst, int count, const Lut3dGrid& lut) {
+    const int last = lut.n - 2;
+    const int step[3] = {4, lut.n * 4, lut.n * lut.n * 4};  // r, g, b, in int16s
+    const int diagonal = step[0] + step[1] + step[2];
+    for (int i = 0; i < count; ++i, src += 4, dst += 4) {
+        int f[3];
+        int base = 0;
+        for (int c = 0; c < 3; ++c) {
+            const int p = (src[2 - c] * lut.position_scale + 32768) >> 16;
+            const int cell = std::min(p >> 8, last);
+            f[c] = p - cell * 256;
+            base += cell * step[c];
+        }
+        const int hi = f[0] >= f[1] ? (f[0] >= f[2] ? 0 : 2) : (f[1] >= f[2] ? 1 : 2);
+        const int lo = f[0] < f[1] ? (f[0] < f[2] ? 0 : 2) : (f[1] < f[2] ? 1 : 2);
+        const int mid = 3 - hi - lo;
+        const int16_t* c0 = lut.entries + base;
+        const int16_t* c1 = c0 + step[hi];
+        const int16_t* c2 = c0 + diagonal - step[lo];
+        const int16_t* c3 = c0 + diagonal;
+        const int w0 = 256 - f[hi];
+        const int w1 = f[hi] - f[mid];
+        const int w2 = f[mid] - f[lo];
+        const int w3 = f[lo];
+        const uint8_t a = src[3];
+        for (int c = 0; c < 3; ++c) {
+            dst[c] = static_cast<uint8_t>(
+                (w0 * c0[c] + w1 * c1[c] + w2 * c2[c] + w3 * c3[c] + lut3d::kRound) >> lut3d::kShift);
+        }
+        dst[3] = a;
+    }
+}
+
+static inline uint8_t Clamp255(int v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+template <bool kBgra>
+static void YCbCrScalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                        uint8_t* dst, int count, int chroma_shift) {
+    for (int i = 0; i < count; ++i, dst += 4) {
+        const int yy = y[i];
+        const int u = cb[i >> chroma_shift] - 128;
+        const int v = cr[i >> chroma_shift] - 128;
+        const uint8_t r = Clamp255(yy + ((ycc::kCrR * v + ycc::kRound) >> ycc::kShift));
+        const uint8_t g = Clamp255(yy + ((ycc::kCbG * u + ycc::kCrG * v + ycc::kRound) >> ycc::kShift));
+        const uint8_t b = Clamp255(yy + ((ycc::kCbB * u + ycc::kRound) >> ycc::kShift));
+        dst[0] = kBgra ? b : r;
+        dst[1] = g;
+        dst[2] = kBgra ? r : b;
+        dst[3] = 255;
+    }
+}
+
+static void BlendRowsScalar(const uint8_t* r0, const uint8_t* r1, int wy, uint16_t* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = static_cast<uint16_t>(r0[i] * (256 - wy) + r1[i] * wy);
+    }
+}
+
+static void BilinearH32Scalar(const uint16_t* v, const int* x0, const int* x1, const int* wx,
+                              uint8_t* dst, int dst_w) {
+    for (int x = 0; x < dst_w; ++x, dst += 4) {
+        const uint16_t* a = v + x0[x] * 4;
+        const uint16_t* b = v + x1[x] * 4;
+        const int w = wx[x];
+        for (int c = 0; c < 4; ++c) {
+            dst[c] = static_cast<uint8_t>((a[c] * (256 - w) + b[c] * w + 32768) >> 16);
+        }
+    }
+}
+
+static void LanczosH32Scalar(const uint8_t* src, const int* starts, const int16_t* weights, int taps,
+                             int16_t* dst, int dst_w) {
+    for (int x = 0; x < dst_w; ++x, dst += 4, weights += taps) {
+        const uint8_t* s = src + starts[x] * 4;
+        int sum[4] = {0, 0, 0, 0};
+        for (int k = 0; k < taps; ++k, s += 4) {
+            for (int c = 0; c < 4; ++c) {
+                sum[c] += weights[k] * s[c];
+            }
+        }
+        for (int c = 0; c < 4; ++c) {
+            dst[c] = static_cast<int16_t>((sum[c] + 128) >> 8);
+        }
+    }
+}
+
+static void LanczosVScalar(const int16_t* const* rows, const int16_t* weights, int taps,
+                           uint8_t* dst, int count) {
+    for (int i = 0; i < count; ++i) {
+        int sum = 0;
+        for (int k = 0; k < taps; ++k) {
+            sum += weights[k] * rows[k][i];
+        }
+        dst[i] = Clamp255((sum + (1 << 19)) >> 20);
+    }
+}
+
+const PixelKernelTable* ScalarPixelKernels() {
+    static const PixelKernelTable table = {
+        PixelIsa::kScalar,
+        SwizzleScalar,
+        PremultiplyScalar,
+        Mirror8Scalar,
+        Mirror32Scalar,
+        BgraToGrayScalar,
+        BgraToBgrScalar,
+        OverScalar,
+        Lut3dScalar,
+        YCbCrScalar<true>,
+        YCbCrScalar<false>,
+        BlendRowsScalar,
+        BilinearH32Scalar,
+        LanczosH32Scalar,
+        LanczosVScalar,
+    };
+    return &table;
+}
+
+// ---------------------------------------------------------------------------
+// Dispatch
+
+#if PIXEL_KERNELS_X86
+static unsigned long long ReadXcr0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+int SupportedPixelKernels(const PixelKernelTable** out, int capacity) {
+    int n = 0;
+    if (n < capacity) out[n++] = ScalarPixelKernels();
+
+#if PIXEL_KERNELS_X86
+    int regs[4] = {0, 0, 0, 0};
+#ifdef _MSC_VER
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+    __cpuid(regs, 1);
+#else
+    const int max_leaf = static_cast<int>(__get_cpuid_max(0, nullptr));
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    const bool sse41 = (regs[2] & (1 << 19)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if (osxsave && avx && max_leaf >= 7) {
+        // The OS must save the YMM state as well
+        const unsigned long long xcr0 = ReadXcr0();
+        if ((xcr0 & 6) == 6) {
+#ifdef _MSC_VER
+            __cpuidex(regs, 7, 0);
+#else
+            __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+            avx2 = (regs[1] & (1 << 5)) != 0;
+        }
+    }
+
+    if (sse41 && Sse41PixelKernels() && n < capacity) out[n++] = Sse41PixelKernels();
+    if (sse41 && avx2 && Avx2PixelKernels() && n < capacity) out[n++] = Avx2PixelKernels();
+#endif
+    return n;
+}
+
+static const PixelKernelTable* SelectPixelKernels() {
+    const PixelKernelTable* tables[3];
+    const int n = SupportedPixelKernels(tables, 3);
+    return tables[n - 1];
+}
+
+// Chosen once when the library is loaded
+static const PixelKernelTable* const g_kernels = SelectPixelKernels();
+
+PixelIsa ActivePixelIsa() {
+    return g_kernels->isa;
+}
+
+const char* PixelIsaName(PixelIsa isa) {
+    switch (isa) {
+    case PixelIsa::kAvx2: return "AVX2";
+    case PixelIsa::kSse41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Image-level entry points
+
+void ResizeBilinearBgraWith(const PixelKernelTable& k, const uint8_t* src, int src_w, int src_h,
+                            int src_stride, uint8_t* dst, int dst_w, int dst_h, int dst_stride) {
+    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) {
+        return;
+    }
+
+    // 16.16 source positions of pixel centres, and 8-bit blend weights.
+    std::vector<int> x0(dst_w), x1(dst_w), wx(dst_w);
+    for (int x = 0; x < dst_w; ++x) {
+        const int64_t fx = ((2LL * x + 1) * src_w * 65536LL) / (2LL * dst_w) - 32768;
+        const int ix = static_cast<int>(std::clamp<int64_t>(fx >> 16, 0, src_w - 1));
+        x0[x] = ix;
+        x1[x] = std::min(ix + 1, src_w - 1);
+        wx[x] = fx < 0 || ix >= src_w - 1 ? 0 : static_cast<int>((fx >> 8) & 0xFF);
+    }
+
+    // Blending the two source rows first is exact (no rounding until the
+    // end), so the result matches a per-pixel 2x2 blend bit for bit.
+    std::vector<uint16_t> rows(static_cast<size_t>(src_w) * 4);
+    for (int y = 0; y < dst_h; ++y) {
+        const int64_t fy = ((2LL * y + 1) * src_h * 65536LL) / (2LL * dst_h) - 32768;
+        const int iy = static_cast<int>(std::clamp<int64_t>(fy >> 16, 0, src_h - 1));
+        const int wy = fy < 0 || iy >= src_h - 1 ? 0 : static_cast<int>((fy >> 8) & 0xFF);
+        const uint8_t* r0 = src + static_cast<size_t>(iy) * src_stride;
+        const uint8_t* r1 = src + static_cast<size_t>(std::min(iy + 1, src_h - 1)) * src_stride;
+
+        k.blend_rows(r0, r1, wy, rows.data(), src_w * 4);
+        k.bilinear_h32(rows.data(), x0.data(), x1.data(), wx.data(),
+                       dst + static_cast<size_t>(y) * dst_stride, dst_w);
+    }
+}
+
+void ResizeBilinearBgra(const uint8_t* src, int src_w, int src_h, int src_stride,
+                        uint8_t* dst, int dst_w, int dst_h, int dst_stride) {
+    ResizeBilinearBgraWith(*g_kernels, src, src_w, src_h, src_stride, dst, dst_w, dst_h, dst_stride);
+}
+
+// Lanczos-3 taps for one axis. Every output pixel reads `taps` consecutive
+// source pixels (edge samples folded onto the border pixel), with Q14
+// weights summing to exactly 16384.
+struct LanczosAxis {
+    int taps = 0;
+    std::vector<int> starts;
+    std::vector<int16_t> weights;
+};
+
+static double Lanczos3(double x) {
+    if (x == 0.0) return 1.0;
+    if (x <= -3.0 || x >= 3.0) return 0.0;
+    const double pi_x = 3.14159265358979323846 * x;
+    return 3.0 * std::sin(pi_x) * std::sin(pi_x / 3.0) / (pi_x * pi_x);
+}
+
+static int LanczosTaps(int src, int dst) {
+    const double support = 3.0 * std::max(1.0, static_cast<double>(src) / dst);
+    int taps = std::min(static_cast<int>(std::ceil(2.0 * support)) + 1, src);
+    // A multiple of 4 lets the SIMD rows run without a tail
+    if (((taps + 3) & ~3) <= src) taps = (taps + 3) & ~3;
+    return taps;
+}
+
+// First source sample of output `o`'s window of `taps`
+static int LanczosStart(int src, int dst, int taps, int o) {
+    const double scale = static_cast<double>(src) / dst;
+    const double support = 3.0 * std::max(1.0, scale);
+    const double center = (o + 0.5) * scale - 0.5;
+    return std::clamp(static_cast<int>(std::floor(center - support)) + 1, 0, src - taps);
+}
+
+static LanczosAxis BuildLanczosAxis(int src, int dst) {
+    LanczosAxis axis;
+    const double scale = static_cast<double>(src) / dst;
+    const double stretch = std::max(1.0, scale);  // widen the filter when reducing
+    const double support = 3.0 * stretch;
+
+    const int taps = LanczosTaps(src, dst);
+    axis.taps = taps;
+    axis.starts.resize(dst);
+    axis.weights.assign(static_cast<size_t>(dst) * taps, 0);
+
+    std::vector<double> w(taps);
+    for (int o = 0; o < dst; ++o) {
+        const double center = (o + 0.5) * scale - 0.5;
+        const int lo = static_cast<int>(std::floor(center - support)) + 1;
+        const int hi = static_cast<int>(std::floor(center + support));
+        const int start = LanczosStart(src, dst, taps, o);
+        axis.starts[o] = start;
+
+        std::fill(w.begin(), w.end(), 0.0);
+        double total = 0.0;
+        for (int p = lo; p <= hi; ++p) {
+            const double v = Lanczos3((p - center) / stretch);
+            w[std::clamp(p, 0, src - 1) - start] += v;
+            total += v;
+        }
+
+        int16_t* q = &axis.weights[static_cast<size_t>(o) * taps];
+        int sum = 0;
+        int peak = 0;
+        for (int k = 0; k < taps; ++k) {
+            q[k] = static_cast<int16_t>(std::lround(w[k] / total * 16384.0));
+            sum += q[k];
+            if (q[k] > q[peak]) peak = k;
+        }
+        q[peak] = static_cast<int16_t>(q[peak] + 16384 - sum);
+    }
+    return axis;
+}
+
+// `src` starts at source row `src_first`; rows above it are never read.
+static void LanczosRows(const PixelKernelTable& k, const uint8_t* src, int src_first, int src_w, int src_h,
+                        int src_stride, uint8_t* dst, int dst_w, int dst_h, int dst_stride, int row_begin,
+                        int row_end) {
+    row_begin = std::max(row_begin, 0);
+    row_end = std::min(row_end, dst_h);
+    if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0 || row_begin >= row_end) {
+        return;
+    }
+    const LanczosAxis h = BuildLanczosAxis(src_w, dst_w);
+    const LanczosAxis v = BuildLanczosAxis(src_h, dst_h);
+
+    // Horizontally filtered source rows, kept in a ring of v.taps rows: the
+    // vertical windows only move forward, so each row is filtered once.
+    const size_t row_values = static_cast<size_t>(dst_w) * 4;
+    std::vector<int16_t> ring(row_values * v.taps);
+    std::vector<int> ring_row(v.taps, -1);
+    std::vector<const int16_t*> rows(v.taps);
+
+    for (int y = row_begin; y < row_end; ++y) {
+        const int start = v.starts[y];
+        for (int t = 0; t < v.taps; ++t) {
+            const int sy = start + t;
+            const int slot = sy % v.taps;
+            int16_t* row = &ring[row_values * slot];
+            if (ring_row[slot] != sy) {
+                k.lanczos_h32(src + static_cast<size_t>(sy - src_first) * src_stride, h.starts.data(),
+                              h.weights.data(), h.taps, row, dst_w);
+                ring_row[slot] = sy;
+            }
+            rows[t] = row;
+        }
+        k.lanczos_v(rows.data(), &v.weights[static_cast<size_t>(y) * v.taps], v.taps,
+                    dst + static_cast<size_t>(y - row_begin) * dst_stride, static_cast<int>(row_values));
+    }
+}
+
+void ResizeLanczosBgraWith(const PixelKernelTable& k, const uint8_t* src, int src_w, int src_h,
+                           int src_stride, uint8_t* dst, int dst_w, int dst_h, int dst_stride) {
+    LanczosRows(k, src, 0, src_w, src_h, src_stride, dst, dst_w, dst_h, dst_stride, 0, dst_h);
+}
+
+void ResizeLanczosBgraRows(const uint8_t* src, int src_w, int src_h, int src_stride,
+                           uint8_t* dst, int dst_w, int dst_h, int dst_stride, int row_begin, int row_end) {
+    LanczosRows(*g_kernels, src, 0, src_w, src_h, src_stride, dst, dst_w, dst_h, dst_stride, row_begin, row_end);
+}
+
+void LanczosSourceRows(int src_h, int dst_h, int row_begin, int row_end, int& first, int& last) {
+    row_begin = std::max(row_begin, 0);
+    row_end = std::min(row_end, dst_h);
+    if (src_h <= 0 || row_begin >= row_end) {
+        first = last = 0;
+        return;
+    }
+    const int taps = LanczosTaps(src_h, dst_h);
+    first = LanczosStart(src_h, dst_h, taps, row_begin);
+    last = LanczosStart(src_h, dst_h, taps, row_end - 1) + taps;
+}
+
+void ResizeLanczosBgraWindow(const uint8_t* src, int src_first, int src_w, int src_h, int src_stride,
+                             uint8_t* dst, int dst_w, int dst_h, int dst_stride, int row_begin, int row_end) {
+    LanczosRows(*g_kernels, src, src_first, src_w, src_h, src_stride, dst, dst_w, dst_h, dst_stride, row_begin,
+                row_end);
+}
+
+void ResizeLanczosBgra(const uint8_t* src, int src_w, int src_h, int src_stride,
+                       uint8_t* dst, int dst_w, int dst_h, int dst_stride) {
+    ResizeLanczosBgraWith(*g_kernels, src, src_w, src_h, src_stride, dst, dst_w, dst_h, dst_stride);
+}
+
+void BgraToGray(const uint8_t* src, int width, int height, int src_stride,
+                uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        g_kernels->bgra_to_gray(src + static_cast<size_t>(y) * src_stride,
+                                dst + static_cast<size_t>(y) * dst_stride, width);
+    }
+}
+
+void BgraToBgr(const uint8_t* src, int width, int height, int src_stride,
+               uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        g_kernels->bgra_to_bgr(src + static_cast<size_t>(y) * src_stride,
+                               dst + static_cast<size_t>(y) * dst_stride, width);
+    }
+}
+
+void SwizzleRedBlue(const uint8_t* src, int width, int height, int src_stride,
+                    uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        g_kernels->swizzle_rb(src + static_cast<size_t>(y) * src_stride,
+                              dst + static_cast<size_t>(y) * dst_stride, width);
+    }
+}
+
+void PremultiplyAlpha(const uint8_t* src, int width, int height, int src_stride,
+                      uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        g_kernels->premultiply(src + static_cast<size_t>(y) * src_stride,
+                               dst + static_cast<size_t>(y) * dst_stride, width);
+    }
+}
+
+void BlendOver(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        g_kernels->over(src + static_cast<size_t>(y) * src_stride, dst + static_cast<size_t>(y) * dst_stride,
+                        width);
+    }
+}
+
+void ApplyLut3dBgra(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst, int dst_stride,
+                    const int16_t* lut, int n) {
+    if (!lut || n < lut3d::kMinSize || n > lut3d::kMaxSize) {
+        return;
+    }
+    const Lut3dGrid grid = {lut, n, lut3d::PositionScale(n)};
+    for (int y = 0; y < height; ++y) {
+        g_kernels->lut3d(src + static_cast<size_t>(y) * src_stride, dst + static_cast<size_t>(y) * dst_stride,
+                         width, grid);
+    }
+}
+
+void MirrorHorizontal(const uint8_t* src, int width, int height, int src_stride, int channels,
+                      uint8_t* dst, int dst_stride) {
+    auto row = channels == 1 ? g_kernels->mirror8 : g_kernels->mirror32;
+    for (int y = 0; y < height; ++y) {
+        row(src + static_cast<size_t>(y) * src_stride, dst + static_cast<size_t>(y) * dst_stride, width);
+    }
+}
+
+void YCbCrToRgb(const uint8_t* y, int y_stride, const uint8_t* cb, const uint8_t* cr, int c_stride,
+                int width, int height, int chroma_shift_x, int chroma_shift_y,
+                PixelOrder order, uint8_t* dst, int dst_stride) {
+    auto row = order == PixelOrder::kBgra ? g_kernels->ycbcr_to_bgra : g_kernels->ycbcr_to_rgba;
+    for (int r = 0; r < height; ++r) {
+        const size_t c_off = static_cast<size_t>(r >> chroma_shift_y) * c_stride;
+        row(y + static_cast<size_t>(r) * y_stride, cb + c_off, cr + c_off,
+            dst + static_cast<size_t>(r) * dst_stride, width, chroma_shift_x);
+    }
+}
+
+void TransformedSize(int transform, int width, int height, int& out_width, int& out_height) {
+    const bool quarter = (transform & 1) != 0;
+    out_width = quarter ? height : width;
+    out_height = quarter ? width : height;
+}
+
+// Transforms are (mirror m, turns r) acting as M^m R^r; mirroring reverses
+// the direction of rotation (M R = R^-1 M), and every mirrored one is its
+// own inverse.
+int RelativeTransform(int from, int to) {
+    const int fm = (from & kMirror) ? 1 : 0, fr = from & 3;
+    const int tm = (to & kMirror) ? 1 : 0, tr = to & 3;
+    // to * from^-1
+    const int im = fm, ir = fm ? fr : (4 - fr) & 3;
+    const int m = tm ^ im;
+    const int r = im ? (ir - tr) & 3 : (tr + ir) & 3;
+    return r | (m ? kMirror : 0);
+}
+
+int ComposeTransform(int first, int then) {
+    // then * first = then * (first^-1)^-1
+    return RelativeTransform(RelativeTransform(first, kRotate0), then);
+}
+
+int TransformFromExif(int orientation) {
+    static const int kFromExif[9] = {
+        kRotate0, kRotate0, kMirror, kRotate180, kRotate180 | kMirror,
+        kRotate90 | kMirror, kRotate90, kRotate270 | kMirror, kRotate270,
+    };
+    return orientation >= 1 && orientation <= 8 ? kFromExif[orientation] : kRotate0;
+}
+
+void PlaceTransformedRow(const uint8_t* row, int y, int src_width, int src_height, int channels,
+                         int transform, uint8_t* dst, int dst_stride) {
+    const int turns = transform & 3;
+    const bool mirror = (transform & kMirror) != 0;
+
+    if ((turns & 1) == 0) {
+        // Row stays a row: straight copy or reversed
+        const int dy = turns == 0 ? y : src_height - 1 - y;
+        uint8_t* d = dst + static_cast<size_t>(dy) * dst_stride;
+        if ((turns == 2) != mirror) {
+            (channels == 1 ? g_kernels->mirror8 : g_kernels->mirror32)(row, d, src_width);
+        } else {
+            std::memcpy(d, row, static_cast<size_t>(src_width) * channels);
+        }
+        return;
+    }
+
+    // Row becomes a column, top-down for 90 and bottom-up for 270
+    const int col = (turns == 1) != mirror ? src_height - 1 - y : y;
+    ptrdiff_t step = dst_stride;
+    uint8_t* d = dst + static_cast<size_t>(col) * channels;
+    if (turns == 3) {
+        d += static_cast<ptrdiff_t>(src_width - 1) * dst_stride;
+        step = -step;
+    }
+    if (channels == 1) {
+        for (int x = 0; x < src_width; ++x, d += step) {
+            *d = row[x];
+        }
+    } else {
+        for (int x = 0; x < src_width; ++x, d += step) {
+            std::memcpy(d, row + x * 4, 4);
+        }
+    }
+}
+
+void TransformImage(const uint8_t* src, int width, int height, int src_stride, int channels,
+                    int transform, uint8_t* dst, int dst_stride) {
+    for (int y = 0; y < height; ++y) {
+        PlaceTransformedRow(src + static_cast<size_t>(y) * src_stride, y, width, height, channels,
+                            transform, dst, dst_stride);
+    }
+}
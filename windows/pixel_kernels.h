@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+
+// Pixel helpers shared by the preview, animation and print paths.
+// All images are tightly described by (pointer, width, height, stride in bytes).
+//
+// Each kernel has scalar, SSE4.1 and AVX2 versions; the best one the CPU
+// supports is picked once when the library loads (CPUID), so a Celeron
+// without AVX2 and a current Core i7 run the same binary. All versions give
+// bit-identical results; test/pixel_kernels_test.cpp checks that.
+
+enum class PixelIsa { kScalar = 0, kSse41 = 1, kAvx2 = 2 };
+
+PixelIsa ActivePixelIsa();
+const char* PixelIsaName(PixelIsa isa);
+
+// Bilinear resample of a 4-channel (BGRA) image to dst_w x dst_h.
+void ResizeBilinearBgra(const uint8_t* src, int src_w, int src_h, int src_stride,
+                        uint8_t* dst, int dst_w, int dst_h, int dst_stride);
+
+// Lanczos-3 resample of a 4-channel image; sharper than bilinear for large
+// reductions (prints, thumbnails of stills). Slower, so not for live view.
+void ResizeLanczosBgra(const uint8_t* src, int src_w, int src_h, int src_stride,
+                       uint8_t* dst, int dst_w, int dst_h, int dst_stride);
+
+// Only output rows [row_begin, row_end) of the above, written from the top of
+// dst (dst row 0 is output row row_begin), so one large resize can be split
+// across threads or rendered band by band. Identical output.
+void ResizeLanczosBgraRows(const uint8_t* src, int src_w, int src_h, int src_stride,
+                           uint8_t* dst, int dst_w, int dst_h, int dst_stride, int row_begin, int row_end);
+
+// Source rows [first, last) that output rows [row_begin, row_end) read, so a
+// caller decoding band by band only needs that window of the source.
+void LanczosSourceRows(int src_h, int dst_h, int row_begin, int row_end, int& first, int& last);
+
+// ResizeLanczosBgraRows on such a window: `src` holds source rows from
+// `src_first` on (at least up to `last` above).
+void ResizeLanczosBgraWindow(const uint8_t* src, int src_first, int src_w, int src_h, int src_stride,
+                             uint8_t* dst, int dst_w, int dst_h, int dst_stride, int row_begin, int row_end);
+
+// BT.601 luma of a BGRA image into an 8-bit single-channel image.
+void BgraToGray(const uint8_t* src, int width, int height, int src_stride,
+                uint8_t* dst, int dst_stride);
+
+// BGRA to packed 24-bit BGR (DIB order), alpha dropped.
+void BgraToBgr(const uint8_t* src, int width, int height, int src_stride,
+               uint8_t* dst, int dst_stride);
+
+// RGBA <-> BGRA (swap bytes 0 and 2 of every pixel). src may equal dst.
+void SwizzleRedBlue(const uint8_t* src, int width, int height, int src_stride,
+                    uint8_t* dst, int dst_stride);
+
+// Multiply colour by alpha (byte 3), rounded. Works for BGRA and RGBA.
+// src may equal dst.
+void PremultiplyAlpha(const uint8_t* src, int width, int height, int src_stride,
+                      uint8_t* dst, int dst_stride);
+
+// Premultiplied `src` composited over `dst` in place (Porter-Duff over),
+// both 4-channel in the same channel order. dst may be opaque or
+// premultiplied. Fully transparent and fully opaque runs are cheap, so
+// frame artwork that is mostly empty costs little beyond the read.
+void BlendOver(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst, int dst_stride);
+
+// 3D colour lookup (grading) of a BGRA image with tetrahedral interpolation,
+// alpha kept. `lut` is n x n x n entries of four int16 (B, G, R, 0), each an
+// 8-bit value times 16, red index changing fastest; n is 2 to 65. ColorLut
+// (color_lut.h) builds these from .cube files. src may equal dst.
+void ApplyLut3dBgra(const uint8_t* src, int width, int height, int src_stride, uint8_t* dst, int dst_stride,
+                    const int16_t* lut, int n);
+
+// Left-right mirror of a 1- or 4-channel image. src must not equal dst.
+void MirrorHorizontal(const uint8_t* src, int width, int height, int src_stride, int channels,
+                      uint8_t* dst, int dst_stride);
+
+// Output orientation: clockwise quarter turns, then optionally a left-right
+// mirror of the rotated image (the selfie view), e.g. kRotate90 | kMirror.
+enum PixelTransform : int {
+    kRotate0 = 0,
+    kRotate90 = 1,
+    kRotate180 = 2,
+    kRotate270 = 3,
+    kMirror = 4,
+};
+
+// Size of a width x height image after `transform`.
+void TransformedSize(int transform, int width, int height, int& out_width, int& out_height);
+
+// The transform that turns an image already in orientation `from` into `to`.
+int RelativeTransform(int from, int to);
+
+// `first`, then `then`, as one transform.
+int ComposeTransform(int first, int then);
+
+// The transform a viewer applies for EXIF Orientation 1-8 (0 = none).
+int TransformFromExif(int orientation);
+
+// Writes source row `y` of a src_width x src_height image (1 or 4 channels)
+// to where `transform` puts it in dst. Lets a decoder or converter that
+// already produces rows one at a time orient them on the way out.
+void PlaceTransformedRow(const uint8_t* row, int y, int src_width, int src_height, int channels,
+                         int transform, uint8_t* dst, int dst_stride);
+
+// Whole-image version of the above. src must not equal dst.
+void TransformImage(const uint8_t* src, int width, int height, int src_stride, int channels,
+                    int transform, uint8_t* dst, int dst_stride);
+
+// Planar JFIF YCbCr (as JPEG stores it) to BGRA or RGBA with A = 255.
+// chroma_shift_x/y are 1 for subsampled chroma (4:2:0 = 1/1, 4:2:2 = 1/0).
+enum class PixelOrder { kBgra, kRgba };
+void YCbCrToRgb(const uint8_t* y, int y_stride, const uint8_t* cb, const uint8_t* cr, int c_stride,
+                int width, int height, int chroma_shift_x, int chroma_shift_y,
+                PixelOrder order, uint8_t* dst, int dst_stride);
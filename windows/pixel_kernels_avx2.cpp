@@ -0,0 +1,393 @@
+// AVX2 rows for pixel_kernels. This file is the only one built with
+// /arch:AVX2 and it is only used when CPUID and the OS report AVX2 support.
+// Keep it free of standard library templates: an inline function
+// instantiated here could be picked by the linker for the whole library and
+// fault on CPUs without AVX2.
+#include "pixel_kernels_impl.h"
+
+#if PIXEL_KERNELS_X86
+#include <immintrin.h>
+#include <cstring>
+
+static inline __m256i PairWeights(int16_t a, int16_t b) {
+    return _mm256_set1_epi32(static_cast<int>(static_cast<uint16_t>(a) |
+                                              (static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16)));
+}
+
+static void SwizzleAvx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+    }
+    Sse41PixelKernels()->swizzle_rb(src + i * 4, dst + i * 4, count - i);
+}
+
+static inline __m256i Premultiply4(__m256i px16) {
+    const __m256i alpha_mask = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1,
+                                                6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+    const __m256i alpha_255 = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+    const __m256i a = _mm256_or_si256(_mm256_shuffle_epi8(px16, alpha_mask), alpha_255);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px16, a), _mm256_set1_epi16(128));
+    t = _mm256_add_epi16(t, _mm256_srli_epi16(t, 8));
+    return _mm256_srli_epi16(t, 8);
+}
+
+static void PremultiplyAvx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // unpack/pack work per 128-bit lane, so the lanes stay in order
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        const __m256i lo = Premultiply4(_mm256_unpacklo_epi8(v, zero));
+        const __m256i hi = Premultiply4(_mm256_unpackhi_epi8(v, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    Sse41PixelKernels()->premultiply(src + i * 4, dst + i * 4, count - i);
+}
+
+static inline __m256i MulInv4(__m256i dst16, __m256i inv, __m256i pick) {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(dst16, _mm256_shuffle_epi8(inv, pick)), _mm256_set1_epi16(128));
+    t = _mm256_add_epi16(t, _mm256_srli_epi16(t, 8));
+    return _mm256_srli_epi16(t, 8);
+}
+
+static void OverAvx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m256i pick_lo = _mm256_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+                                             3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m256i pick_hi = _mm256_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+                                             11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        if (_mm256_testz_si256(s, s)) {
+            continue;
+        }
+        __m256i* d = reinterpret_cast<__m256i*>(dst + i * 4);
+        if (_mm256_testc_si256(s, alpha)) {
+            _mm256_storeu_si256(d, s);
+            continue;
+        }
+        const __m256i v = _mm256_loadu_si256(d);
+        const __m256i inv = _mm256_xor_si256(s, _mm256_set1_epi8(-1));
+        const __m256i lo = MulInv4(_mm256_unpacklo_epi8(v, zero), inv, pick_lo);
+        const __m256i hi = MulInv4(_mm256_unpackhi_epi8(v, zero), inv, pick_hi);
+        _mm256_storeu_si256(d, _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi)));
+    }
+    Sse41PixelKernels()->over(src + i * 4, dst + i * 4, count - i);
+}
+
+// Two pixels' corner pairs (c_a, c_b interleaved per channel, one pixel per
+// 128-bit lane) weighted by the (w_a, w_b) pairs of those pixels.
+static inline __m256i Lut3dPair(__m256i ca, __m256i cb, bool high, __m256i weights, __m256i pick) {
+    const __m256i pairs = high ? _mm256_unpackhi_epi16(ca, cb) : _mm256_unpacklo_epi16(ca, cb);
+    return _mm256_madd_epi16(pairs, _mm256_permutevar8x32_epi32(weights, pick));
+}
+
+// Eight pixels at a time; corners are gathered four entries per instruction.
+// Entries are 8 bytes, so a gather index is the entry number.
+static void Lut3dAvx2(const uint8_t* src, uint8_t* dst, int count, const Lut3dGrid& lut) {
+    const int n = lut.n;
+    const long long* entries = reinterpret_cast<const long long*>(lut.entries);
+    const __m256i scale = _mm256_set1_epi32(lut.position_scale);
+    const __m256i half = _mm256_set1_epi32(32768);
+    const __m256i last = _mm256_set1_epi32(n - 2);
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256i one = _mm256_set1_epi32(256);
+    const __m256i step_r = _mm256_set1_epi32(1);
+    const __m256i step_g = _mm256_set1_epi32(n);
+    const __m256i step_b = _mm256_set1_epi32(n * n);
+    const __m256i diagonal = _mm256_set1_epi32(1 + n + n * n);
+    const __m256i round = _mm256_set1_epi32(lut3d::kRound);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    // Lane sources for the unpacked pixel pairs: (0, 2), (1, 3), (4, 6), (5, 7)
+    const __m256i pick[4] = {
+        _mm256_setr_epi32(0, 0, 0, 0, 2, 2, 2, 2),
+        _mm256_setr_epi32(1, 1, 1, 1, 3, 3, 3, 3),
+        _mm256_setr_epi32(4, 4, 4, 4, 6, 6, 6, 6),
+        _mm256_setr_epi32(5, 5, 5, 5, 7, 7, 7, 7),
+    };
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        const __m256i pr = _mm256_srli_epi32(_mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(px, 16), byte), scale), half), 16);
+        const __m256i pg = _mm256_srli_epi32(_mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_and_si256(_mm256_srli_epi32(px, 8), byte), scale), half), 16);
+        const __m256i pb = _mm256_srli_epi32(_mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_and_si256(px, byte), scale), half), 16);
+        const __m256i cr = _mm256_min_epi32(_mm256_srli_epi32(pr, 8), last);
+        const __m256i cg = _mm256_min_epi32(_mm256_srli_epi32(pg, 8), last);
+        const __m256i cb = _mm256_min_epi32(_mm256_srli_epi32(pb, 8), last);
+        const __m256i fr = _mm256_sub_epi32(pr, _mm256_slli_epi32(cr, 8));
+        const __m256i fg = _mm256_sub_epi32(pg, _mm256_slli_epi32(cg, 8));
+        const __m256i fb = _mm256_sub_epi32(pb, _mm256_slli_epi32(cb, 8));
+        const __m256i fmax = _mm256_max_epi32(_mm256_max_epi32(fr, fg), fb);
+        const __m256i fmin = _mm256_min_epi32(_mm256_min_epi32(fr, fg), fb);
+        const __m256i fmid =
+            _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(fr, fg), fb), _mm256_add_epi32(fmax, fmin));
+        const __m256i hi_step = _mm256_blendv_epi8(_mm256_blendv_epi8(step_b, step_g, _mm256_cmpeq_epi32(fg, fmax)),
+                                                   step_r, _mm256_cmpeq_epi32(fr, fmax));
+        const __m256i lo_step = _mm256_blendv_epi8(_mm256_blendv_epi8(step_b, step_g, _mm256_cmpeq_epi32(fg, fmin)),
+                                                   step_r, _mm256_cmpeq_epi32(fr, fmin));
+        const __m256i w01 =
+            _mm256_or_si256(_mm256_sub_epi32(one, fmax), _mm256_slli_epi32(_mm256_sub_epi32(fmax, fmid), 16));
+        const __m256i w23 = _mm256_or_si256(_mm256_sub_epi32(fmid, fmin), _mm256_slli_epi32(fmin, 16));
+
+        const __m256i e0 = _mm256_add_epi32(_mm256_add_epi32(cr, _mm256_mullo_epi32(cg, step_g)),
+                                            _mm256_mullo_epi32(cb, step_b));
+        const __m256i corner[4] = {
+            e0,
+            _mm256_add_epi32(e0, hi_step),
+            _mm256_sub_epi32(_mm256_add_epi32(e0, diagonal), lo_step),
+            _mm256_add_epi32(e0, diagonal),
+        };
+        __m256i sums[2];
+        for (int half_index = 0; half_index < 2; ++half_index) {
+            __m256i c[4];
+            for (int k = 0; k < 4; ++k) {
+                const __m128i idx = half_index ? _mm256_extracti128_si256(corner[k], 1)
+                                               : _mm256_castsi256_si128(corner[k]);
+                c[k] = _mm256_i32gather_epi64(entries, idx, 8);
+            }
+            // unpacklo holds pixels (0, 2) of these four, unpackhi (1, 3)
+            __m256i lo = _mm256_add_epi32(Lut3dPair(c[0], c[1], false, w01, pick[half_index * 2]),
+                                          Lut3dPair(c[2], c[3], false, w23, pick[half_index * 2]));
+            __m256i hi = _mm256_add_epi32(Lut3dPair(c[0], c[1], true, w01, pick[half_index * 2 + 1]),
+                                          Lut3dPair(c[2], c[3], true, w23, pick[half_index * 2 + 1]));
+            lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), lut3d::kShift);
+            hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), lut3d::kShift);
+            sums[half_index] = _mm256_packs_epi32(lo, hi);  // pixels (0, 1 | 2, 3)
+        }
+        // packus gives (0, 1, 4, 5 | 2, 3, 6, 7)
+        const __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi16(sums[0], sums[1]), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_blendv_epi8(out, px, alpha));
+    }
+    Sse41PixelKernels()->lut3d(src + i * 4, dst + i * 4, count - i, lut);
+}
+
+static void Mirror8Avx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + count - 32 - i));
+        const __m256i r = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reverse), 0x4E);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+    // The remaining middle part mirrors like a row of its own
+    Sse41PixelKernels()->mirror8(src, dst + i, count - i);
+}
+
+static void Mirror32Avx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (count - 8 - i) * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_permutevar8x32_epi32(v, reverse));
+    }
+    Sse41PixelKernels()->mirror32(src, dst + i * 4, count - i);
+}
+
+static void BgraToGrayAvx2(const uint8_t* src, uint8_t* dst, int count) {
+    const __m256i weights = _mm256_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0,
+                                              29, 150, 77, 0, 29, 150, 77, 0);
+    const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16));
+        // Lanes hold pixels 0-1 | 2-3 and 4-5 | 6-7; hadd interleaves them
+        const __m256i m0 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(v0), weights);
+        const __m256i m1 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(v1), weights);
+        const __m256i sums = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(m0, m1), order);
+        const __m256i y32 = _mm256_srli_epi32(sums, 8);
+        const __m128i y16 = _mm_packus_epi32(_mm256_castsi256_si128(y32), _mm256_extracti128_si256(y32, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(y16, y16));
+    }
+    Sse41PixelKernels()->bgra_to_gray(src + i * 4, dst + i, count - i);
+}
+
+template <bool kBgra>
+static void YCbCrAvx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                      uint8_t* dst, int count, int chroma_shift) {
+    const __m256i k_r = PairWeights(0, ycc::kCrR);
+    const __m256i k_g = PairWeights(ycc::kCbG, ycc::kCrG);
+    const __m256i k_b = PairWeights(ycc::kCbB, 0);
+    const __m256i round = _mm256_set1_epi32(ycc::kRound);
+    const __m256i bias = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi8(static_cast<char>(-1));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i u, v;
+        if (chroma_shift) {
+            u = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb + (i >> 1)));
+            v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr + (i >> 1)));
+            u = _mm_unpacklo_epi8(u, u);
+            v = _mm_unpacklo_epi8(v, v);
+        } else {
+            u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cb + i));
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cr + i));
+        }
+        const __m256i y16 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+        const __m256i u16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(u), bias);
+        const __m256i v16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(v), bias);
+
+        // Per 128-bit lane: lo = pixels 0-3 | 8-11, hi = 4-7 | 12-15, and the
+        // packs below put them back in order.
+        const __m256i uv_lo = _mm256_unpacklo_epi16(u16, v16);
+        const __m256i uv_hi = _mm256_unpackhi_epi16(u16, v16);
+        const __m256i y_lo = _mm256_unpacklo_epi16(y16, zero);
+        const __m256i y_hi = _mm256_unpackhi_epi16(y16, zero);
+        auto channel = [&](__m256i k) {
+            const __m256i lo = _mm256_add_epi32(
+                y_lo, _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(uv_lo, k), round), ycc::kShift));
+            const __m256i hi = _mm256_add_epi32(
+                y_hi, _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(uv_hi, k), round), ycc::kShift));
+            const __m256i c16 = _mm256_packs_epi32(lo, hi);
+            return _mm256_packus_epi16(c16, c16);  // bytes 0-7 | 8-15 in each lane's low half
+        };
+        const __m256i r8 = channel(k_r);
+        const __m256i g8 = channel(k_g);
+        const __m256i b8 = channel(k_b);
+
+        const __m256i c0g = _mm256_unpacklo_epi8(kBgra ? b8 : r8, g8);
+        const __m256i c2a = _mm256_unpacklo_epi8(kBgra ? r8 : b8, alpha);
+        const __m256i px_lo = _mm256_unpacklo_epi16(c0g, c2a);  // 0-3 | 8-11
+        const __m256i px_hi = _mm256_unpackhi_epi16(c0g, c2a);  // 4-7 | 12-15
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_permute2x128_si256(px_lo, px_hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4 + 32), _mm256_permute2x128_si256(px_lo, px_hi, 0x31));
+    }
+    auto tail = kBgra ? Sse41PixelKernels()->ycbcr_to_bgra : Sse41PixelKernels()->ycbcr_to_rgba;
+    tail(y + i, cb + (i >> chroma_shift), cr + (i >> chroma_shift), dst + i * 4, count - i, chroma_shift);
+}
+
+static void BlendRowsAvx2(const uint8_t* r0, const uint8_t* r1, int wy, uint16_t* out, int count) {
+    const __m256i w0 = _mm256_set1_epi16(static_cast<short>(256 - wy));
+    const __m256i w1 = _mm256_set1_epi16(static_cast<short>(wy));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i)));
+        const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i)));
+        const __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(a, w0), _mm256_mullo_epi16(b, w1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+    Sse41PixelKernels()->blend_rows(r0 + i, r1 + i, wy, out + i, count - i);
+}
+
+static void LanczosH32Avx2(const uint8_t* src, const int* starts, const int16_t* weights, int taps,
+                           int16_t* dst, int dst_w) {
+    // Four taps per madd: lane 0 holds pixels k, k+1 and lane 1 pixels
+    // k+2, k+3, each rearranged into (c of p, c of p+1) pairs.
+    const __m256i pair = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+                                          0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    const __m128i round = _mm_set1_epi32(128);
+    for (int x = 0; x < dst_w; ++x, weights += taps) {
+        const uint8_t* s = src + starts[x] * 4;
+        __m256i acc = _mm256_setzero_si256();
+        int k = 0;
+        for (; k + 4 <= taps; k += 4) {
+            const __m256i px = _mm256_shuffle_epi8(
+                _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k * 4))), pair);
+            const __m256i w = _mm256_setr_m128i(
+                _mm256_castsi256_si128(PairWeights(weights[k], weights[k + 1])),
+                _mm256_castsi256_si128(PairWeights(weights[k + 2], weights[k + 3])));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(px, w));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        for (; k < taps; ++k) {
+            int p;
+            memcpy(&p, s + k * 4, sizeof(p));
+            const __m128i px = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(p));
+            sum = _mm_add_epi32(sum, _mm_mullo_epi32(px, _mm_set1_epi32(weights[k])));
+        }
+        const __m128i q = _mm_srai_epi32(_mm_add_epi32(sum, round), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packs_epi32(q, q));
+    }
+}
+
+static void LanczosVAvx2(const int16_t* const* rows, const int16_t* weights, int taps,
+                         uint8_t* dst, int count) {
+    const __m256i round = _mm256_set1_epi32(1 << 19);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        int k = 0;
+        for (; k + 2 <= taps; k += 2) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k + 1] + i));
+            const __m256i w = PairWeights(weights[k], weights[k + 1]);
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+        }
+        for (; k < taps; ++k) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+            const __m256i w = PairWeights(weights[k], 0);
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, zero), w));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, zero), w));
+        }
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), 20);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), 20);
+        // Lane order comes back after the per-lane unpack/pack pair
+        const __m256i v16 = _mm256_packs_epi32(lo, hi);
+        const __m256i v8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(v16, v16), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(v8));
+    }
+    if (i < count) {
+        // Shift the row pointers by hand; the SSE4.1 row takes care of the rest
+        const int16_t* shifted[256];
+        if (taps <= 256) {
+            for (int k = 0; k < taps; ++k) shifted[k] = rows[k] + i;
+            Sse41PixelKernels()->lanczos_v(shifted, weights, taps, dst + i, count - i);
+            return;
+        }
+        for (; i < count; ++i) {
+            int sum = 0;
+            for (int k = 0; k < taps; ++k) {
+                sum += weights[k] * rows[k][i];
+            }
+            sum = (sum + (1 << 19)) >> 20;
+            dst[i] = static_cast<uint8_t>(sum < 0 ? 0 : sum > 255 ? 255 : sum);
+        }
+    }
+}
+
+static PixelKernelTable MakeAvx2Table() {
+    // Kernels without a wider version keep the SSE4.1 rows
+    PixelKernelTable table = *Sse41PixelKernels();
+    table.isa = PixelIsa::kAvx2;
+    table.swizzle_rb = SwizzleAvx2;
+    table.premultiply = PremultiplyAvx2;
+    table.mirror8 = Mirror8Avx2;
+    table.mirror32 = Mirror32Avx2;
+    table.bgra_to_gray = BgraToGrayAvx2;
+    table.over = OverAvx2;
+    table.lut3d = Lut3dAvx2;
+    table.ycbcr_to_bgra = YCbCrAvx2<true>;
+    table.ycbcr_to_rgba = YCbCrAvx2<false>;
+    table.blend_rows = BlendRowsAvx2;
+    table.lanczos_h32 = LanczosH32Avx2;
+    table.lanczos_v = LanczosVAvx2;
+    return table;
+}
+
+const PixelKernelTable* Avx2PixelKernels() {
+    static const PixelKernelTable table = MakeAvx2Table();
+    return &table;
+}
+
+#else
+
+const PixelKernelTable* Avx2PixelKernels() {
+    return nullptr;
+}
+
+#endif
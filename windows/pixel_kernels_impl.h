@@ -0,0 +1,102 @@
+#pragma once
+#include "pixel_kernels.h"
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_KERNELS_X86 1
+#else
+#define PIXEL_KERNELS_X86 0
+#endif
+
+// A 3D LUT as the kernels take it: n^3 entries of four int16 (B, G, R, 0),
+// each an 8-bit value times lut3d::kEntryScale, red index fastest.
+struct Lut3dGrid {
+    const int16_t* entries;
+    int n;
+    int position_scale;  // lut3d::PositionScale(n), passed in so ISA files need no helpers
+};
+
+// Row-level kernels behind the pixel_kernels.h API, one table per
+// instruction set. pixel_kernels.cpp owns the image loops, weight tables and
+// the CPUID dispatch; the ISA files only implement these rows, and every
+// variant must produce exactly the scalar table's output.
+struct PixelKernelTable {
+    PixelIsa isa;
+
+    // `count` pixels. swizzle/premultiply may run in place, mirror may not.
+    void (*swizzle_rb)(const uint8_t* src, uint8_t* dst, int count);
+    void (*premultiply)(const uint8_t* src, uint8_t* dst, int count);
+    void (*mirror8)(const uint8_t* src, uint8_t* dst, int count);
+    void (*mirror32)(const uint8_t* src, uint8_t* dst, int count);
+    void (*bgra_to_gray)(const uint8_t* src, uint8_t* dst, int count);
+    void (*bgra_to_bgr)(const uint8_t* src, uint8_t* dst, int count);  // drops alpha
+    // Premultiplied src over dst, in place: dst = min(255, src + dst * (255 - src.a) / 255)
+    // per channel, the product rounded like premultiply.
+    void (*over)(const uint8_t* src, uint8_t* dst, int count);
+    // 3D LUT on BGRA, tetrahedral (see lut3d below); alpha kept, may run in place.
+    void (*lut3d)(const uint8_t* src, uint8_t* dst, int count, const Lut3dGrid& lut);
+
+    // JFIF YCbCr to 32-bit pixels; chroma_shift 1 = horizontally subsampled
+    // chroma (4:2:x), 0 = full resolution.
+    void (*ycbcr_to_bgra)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                          uint8_t* dst, int count, int chroma_shift);
+    void (*ycbcr_to_rgba)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                          uint8_t* dst, int count, int chroma_shift);
+
+    // Bilinear: out[i] = r0[i] * (256 - wy) + r1[i] * wy over `count` bytes,
+    // then per output pixel (v[x0] * (256 - w) + v[x1] * w + 32768) >> 16.
+    void (*blend_rows)(const uint8_t* r0, const uint8_t* r1, int wy, uint16_t* out, int count);
+    void (*bilinear_h32)(const uint16_t* v, const int* x0, const int* x1, const int* wx,
+                         uint8_t* dst, int dst_w);
+
+    // Lanczos, Q14 weights over a window of `taps` source pixels starting at
+    // starts[x]. Horizontal: (sum + 128) >> 8 into Q6 int16 per channel.
+    // Vertical: clamp((sum + (1 << 19)) >> 20) from `taps` Q6 rows.
+    void (*lanczos_h32)(const uint8_t* src, const int* starts, const int16_t* weights, int taps,
+                        int16_t* dst, int dst_w);
+    void (*lanczos_v)(const int16_t* const* rows, const int16_t* weights, int taps,
+                      uint8_t* dst, int count);
+};
+
+const PixelKernelTable* ScalarPixelKernels();
+// Null when the build has no such variant; the CPU is not checked here.
+const PixelKernelTable* Sse41PixelKernels();
+const PixelKernelTable* Avx2PixelKernels();
+
+// Tables this CPU can run, best last (scalar always first).
+int SupportedPixelKernels(const PixelKernelTable** out, int capacity);
+
+// The resamplers on an explicit table (the public versions use the active one)
+void ResizeBilinearBgraWith(const PixelKernelTable& k, const uint8_t* src, int src_w, int src_h,
+                            int src_stride, uint8_t* dst, int dst_w, int dst_h, int dst_stride);
+void ResizeLanczosBgraWith(const PixelKernelTable& k, const uint8_t* src, int src_w, int src_h,
+                           int src_stride, uint8_t* dst, int dst_w, int dst_h, int dst_stride);
+
+// JFIF YCbCr -> RGB, Q14. Shared so every variant rounds identically.
+namespace ycc {
+constexpr int kCrR = 22970;   // 1.402
+constexpr int kCbG = -5638;   // -0.344136
+constexpr int kCrG = -11700;  // -0.714136
+constexpr int kCbB = 29032;   // 1.772
+constexpr int kRound = 8192;
+constexpr int kShift = 14;
+}  // namespace ycc
+
+// 3D LUT interpolation, shared so every variant rounds identically. A channel
+// value v sits at grid position p = (v * PositionScale(n) + 32768) >> 16 in
+// Q8 (exact at 0 and 255), in cell i = min(p >> 8, n - 2) at fraction
+// f = p - i * 256, so 255 is fraction 256 of the last cell. Ordering the three
+// fractions picks the tetrahedron: corners c0, c0 + step(largest),
+// c0 + all steps - step(smallest) and c0 + all steps, weighted
+// 256 - f_max, f_max - f_mid, f_mid - f_min and f_min. Tied fractions give a
+// zero weight to the corner they disagree on, so ties may break either way.
+namespace lut3d {
+constexpr int kMinSize = 2;
+constexpr int kMaxSize = 65;
+constexpr int kEntryScale = 16;
+constexpr int kRound = 1 << 11;  // output = (weighted sum + kRound) >> kShift
+constexpr int kShift = 12;
+constexpr int PositionScale(int n) {
+    return static_cast<int>(((n - 1) * 16777216.0) / 255.0 + 0.5);
+}
+}  // namespace lut3d
@@ -0,0 +1,389 @@
+// SSE4.1 rows for pixel_kernels. Only picked when CPUID reports SSE4.1.
+// Tails shorter than a vector go through the scalar table.
+#include "pixel_kernels_impl.h"
+
+#if PIXEL_KERNELS_X86
+#include <smmintrin.h>
+#include <cstring>
+
+static const PixelKernelTable& Scalar() {
+    return *ScalarPixelKernels();
+}
+
+static inline __m128i Load32(const uint8_t* p) {
+    int v;
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtsi32_si128(v);
+}
+
+// (a, b) in every 32-bit lane, for madd over interleaved pairs
+static inline __m128i PairWeights(int16_t a, int16_t b) {
+    return _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(a) |
+                                           (static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16)));
+}
+
+static void SwizzleSse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(v, mask));
+    }
+    Scalar().swizzle_rb(src + i * 4, dst + i * 4, count - i);
+}
+
+static void BgraToBgrSse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)), pack);
+        // 12 bytes out; a full store would run past the row
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 3), v);
+        const int tail = _mm_extract_epi32(v, 2);
+        memcpy(dst + i * 3 + 8, &tail, sizeof(tail));
+    }
+    Scalar().bgra_to_bgr(src + i * 4, dst + i * 3, count - i);
+}
+
+// Two pixels as 16-bit lanes: round(c * a / 255), alpha kept.
+static inline __m128i Premultiply2(__m128i px16) {
+    const __m128i alpha_mask = _mm_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+    const __m128i alpha_255 = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    const __m128i a = _mm_or_si128(_mm_shuffle_epi8(px16, alpha_mask), alpha_255);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(px16, a), _mm_set1_epi16(128));
+    t = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+    return _mm_srli_epi16(t, 8);
+}
+
+static void PremultiplySse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i lo = Premultiply2(_mm_unpacklo_epi8(v, zero));
+        const __m128i hi = Premultiply2(_mm_unpackhi_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    Scalar().premultiply(src + i * 4, dst + i * 4, count - i);
+}
+
+// dst * (255 - src.a) / 255 for two pixels in 16-bit lanes; `inv` holds
+// 255 - src.a in the byte picked by `pick` for each lane.
+static inline __m128i MulInv2(__m128i dst16, __m128i inv, __m128i pick) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(dst16, _mm_shuffle_epi8(inv, pick)), _mm_set1_epi16(128));
+    t = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+    return _mm_srli_epi16(t, 8);
+}
+
+static void OverSse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128i pick_lo = _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+    const __m128i pick_hi = _mm_setr_epi8(11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        if (_mm_testz_si128(s, s)) {
+            continue;  // transparent: dst unchanged
+        }
+        __m128i* d = reinterpret_cast<__m128i*>(dst + i * 4);
+        if (_mm_testc_si128(s, alpha)) {
+            _mm_storeu_si128(d, s);  // opaque: src replaces dst
+            continue;
+        }
+        const __m128i v = _mm_loadu_si128(d);
+        const __m128i inv = _mm_xor_si128(s, _mm_set1_epi8(-1));
+        const __m128i lo = MulInv2(_mm_unpacklo_epi8(v, zero), inv, pick_lo);
+        const __m128i hi = MulInv2(_mm_unpackhi_epi8(v, zero), inv, pick_hi);
+        _mm_storeu_si128(d, _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+    }
+    Scalar().over(src + i * 4, dst + i * 4, count - i);
+}
+
+// Four pixels at a time: grid cells, fractions, tetrahedron and weights in
+// 32-bit lanes, then per pixel the four corners weighted with two madds.
+static void Lut3dSse41(const uint8_t* src, uint8_t* dst, int count, const Lut3dGrid& lut) {
+    const int n = lut.n;
+    const __m128i scale = _mm_set1_epi32(lut.position_scale);
+    const __m128i half = _mm_set1_epi32(32768);
+    const __m128i last = _mm_set1_epi32(n - 2);
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128i one = _mm_set1_epi32(256);
+    const __m128i step_r = _mm_set1_epi32(4);
+    const __m128i step_g = _mm_set1_epi32(n * 4);
+    const __m128i step_b = _mm_set1_epi32(n * n * 4);
+    const __m128i round = _mm_set1_epi32(lut3d::kRound);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const int diagonal = 4 + n * 4 + n * n * 4;
+    alignas(16) int32_t base[4], hi_step[4], lo_step[4], w01[4], w23[4];
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i pr = _mm_srli_epi32(_mm_add_epi32(
+            _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(px, 16), byte), scale), half), 16);
+        const __m128i pg = _mm_srli_epi32(_mm_add_epi32(
+            _mm_mullo_epi32(_mm_and_si128(_mm_srli_epi32(px, 8), byte), scale), half), 16);
+        const __m128i pb = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_and_si128(px, byte), scale), half), 16);
+        const __m128i cr = _mm_min_epi32(_mm_srli_epi32(pr, 8), last);
+        const __m128i cg = _mm_min_epi32(_mm_srli_epi32(pg, 8), last);
+        const __m128i cb = _mm_min_epi32(_mm_srli_epi32(pb, 8), last);
+        const __m128i fr = _mm_sub_epi32(pr, _mm_slli_epi32(cr, 8));
+        const __m128i fg = _mm_sub_epi32(pg, _mm_slli_epi32(cg, 8));
+        const __m128i fb = _mm_sub_epi32(pb, _mm_slli_epi32(cb, 8));
+        const __m128i fmax = _mm_max_epi32(_mm_max_epi32(fr, fg), fb);
+        const __m128i fmin = _mm_min_epi32(_mm_min_epi32(fr, fg), fb);
+        const __m128i fmid = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(fr, fg), fb), _mm_add_epi32(fmax, fmin));
+        _mm_store_si128(reinterpret_cast<__m128i*>(base),
+                        _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(cr, 2), _mm_mullo_epi32(cg, step_g)),
+                                      _mm_mullo_epi32(cb, step_b)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(hi_step),
+                        _mm_blendv_epi8(_mm_blendv_epi8(step_b, step_g, _mm_cmpeq_epi32(fg, fmax)), step_r,
+                                        _mm_cmpeq_epi32(fr, fmax)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lo_step),
+                        _mm_blendv_epi8(_mm_blendv_epi8(step_b, step_g, _mm_cmpeq_epi32(fg, fmin)), step_r,
+                                        _mm_cmpeq_epi32(fr, fmin)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(w01),
+                        _mm_or_si128(_mm_sub_epi32(one, fmax), _mm_slli_epi32(_mm_sub_epi32(fmax, fmid), 16)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(w23),
+                        _mm_or_si128(_mm_sub_epi32(fmid, fmin), _mm_slli_epi32(fmin, 16)));
+
+        __m128i sum[4];
+        for (int k = 0; k < 4; ++k) {
+            const int16_t* c0 = lut.entries + base[k];
+            const __m128i pair01 = _mm_unpacklo_epi16(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c0)),
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c0 + hi_step[k])));
+            const __m128i pair23 = _mm_unpacklo_epi16(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c0 + diagonal - lo_step[k])),
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(c0 + diagonal)));
+            const __m128i s = _mm_add_epi32(_mm_madd_epi16(pair01, _mm_set1_epi32(w01[k])),
+                                            _mm_madd_epi16(pair23, _mm_set1_epi32(w23[k])));
+            sum[k] = _mm_srai_epi32(_mm_add_epi32(s, round), lut3d::kShift);
+        }
+        const __m128i out = _mm_packus_epi16(_mm_packs_epi32(sum[0], sum[1]), _mm_packs_epi32(sum[2], sum[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_blendv_epi8(out, px, alpha));
+    }
+    Scalar().lut3d(src + i * 4, dst + i * 4, count - i, lut);
+}
+
+static void Mirror8Sse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + count - 16 - i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, reverse));
+    }
+    for (; i < count; ++i) {
+        dst[i] = src[count - 1 - i];
+    }
+}
+
+static void Mirror32Sse41(const uint8_t* src, uint8_t* dst, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (count - 4 - i) * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi32(v, 0x1B));
+    }
+    for (; i < count; ++i) {
+        std::memcpy(dst + i * 4, src + (count - 1 - i) * 4, 4);
+    }
+}
+
+static void BgraToGraySse41(const uint8_t* src, uint8_t* dst, int count) {
+    const __m128i weights = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16));
+        // (29b + 150g, 77r) per pixel, then one sum per pixel
+        const __m128i s0 = _mm_hadd_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(v0, zero), weights),
+                                          _mm_madd_epi16(_mm_unpackhi_epi8(v0, zero), weights));
+        const __m128i s1 = _mm_hadd_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(v1, zero), weights),
+                                          _mm_madd_epi16(_mm_unpackhi_epi8(v1, zero), weights));
+        const __m128i y16 = _mm_packus_epi32(_mm_srli_epi32(s0, 8), _mm_srli_epi32(s1, 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(y16, y16));
+    }
+    Scalar().bgra_to_gray(src + i * 4, dst + i, count - i);
+}
+
+// 8 pixels of Y (16-bit) and centred Cb/Cr (16-bit) -> 8 bytes each of R, G, B
+static inline void YCbCr8(__m128i y16, __m128i u16, __m128i v16, __m128i& r8, __m128i& g8, __m128i& b8) {
+    const __m128i k_r = _mm_setr_epi16(0, ycc::kCrR, 0, ycc::kCrR, 0, ycc::kCrR, 0, ycc::kCrR);
+    const __m128i k_g = _mm_setr_epi16(ycc::kCbG, ycc::kCrG, ycc::kCbG, ycc::kCrG,
+                                       ycc::kCbG, ycc::kCrG, ycc::kCbG, ycc::kCrG);
+    const __m128i k_b = _mm_setr_epi16(ycc::kCbB, 0, ycc::kCbB, 0, ycc::kCbB, 0, ycc::kCbB, 0);
+    const __m128i round = _mm_set1_epi32(ycc::kRound);
+    const __m128i zero = _mm_setzero_si128();
+
+    const __m128i uv_lo = _mm_unpacklo_epi16(u16, v16);
+    const __m128i uv_hi = _mm_unpackhi_epi16(u16, v16);
+    const __m128i y_lo = _mm_unpacklo_epi16(y16, zero);
+    const __m128i y_hi = _mm_unpackhi_epi16(y16, zero);
+
+    auto channel = [&](__m128i k) {
+        const __m128i lo = _mm_add_epi32(y_lo, _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(uv_lo, k), round), ycc::kShift));
+        const __m128i hi = _mm_add_epi32(y_hi, _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(uv_hi, k), round), ycc::kShift));
+        const __m128i c16 = _mm_packs_epi32(lo, hi);
+        return _mm_packus_epi16(c16, c16);
+    };
+    r8 = channel(k_r);
+    g8 = channel(k_g);
+    b8 = channel(k_b);
+}
+
+template <bool kBgra>
+static void YCbCrSse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                       uint8_t* dst, int count, int chroma_shift) {
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i alpha = _mm_set1_epi8(static_cast<char>(-1));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i u, v;
+        if (chroma_shift) {
+            u = Load32(cb + (i >> 1));
+            v = Load32(cr + (i >> 1));
+            u = _mm_unpacklo_epi8(u, u);
+            v = _mm_unpacklo_epi8(v, v);
+        } else {
+            u = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cb + i));
+            v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cr + i));
+        }
+        const __m128i y16 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i)));
+        const __m128i u16 = _mm_sub_epi16(_mm_cvtepu8_epi16(u), bias);
+        const __m128i v16 = _mm_sub_epi16(_mm_cvtepu8_epi16(v), bias);
+
+        __m128i r8, g8, b8;
+        YCbCr8(y16, u16, v16, r8, g8, b8);
+        const __m128i c0g = _mm_unpacklo_epi8(kBgra ? b8 : r8, g8);
+        const __m128i c2a = _mm_unpacklo_epi8(kBgra ? r8 : b8, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(c0g, c2a));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(c0g, c2a));
+    }
+    // i is even here, so the chroma index of the tail stays aligned
+    auto tail = kBgra ? Scalar().ycbcr_to_bgra : Scalar().ycbcr_to_rgba;
+    tail(y + i, cb + (i >> chroma_shift), cr + (i >> chroma_shift), dst + i * 4, count - i, chroma_shift);
+}
+
+static void BlendRowsSse41(const uint8_t* r0, const uint8_t* r1, int wy, uint16_t* out, int count) {
+    const __m128i w0 = _mm_set1_epi16(static_cast<short>(256 - wy));
+    const __m128i w1 = _mm_set1_epi16(static_cast<short>(wy));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0 + i)));
+        const __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1 + i)));
+        // <= 255 * 256 in total, so 16-bit lanes cannot wrap
+        const __m128i v = _mm_add_epi16(_mm_mullo_epi16(a, w0), _mm_mullo_epi16(b, w1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+    Scalar().blend_rows(r0 + i, r1 + i, wy, out + i, count - i);
+}
+
+static void BilinearH32Sse41(const uint16_t* v, const int* x0, const int* x1, const int* wx,
+                             uint8_t* dst, int dst_w) {
+    const __m128i round = _mm_set1_epi32(32768);
+    int x = 0;
+    for (; x + 2 <= dst_w; x += 2) {
+        __m128i out[2];
+        for (int j = 0; j < 2; ++j) {
+            const __m128i a = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x0[x + j] * 4)));
+            const __m128i b = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x1[x + j] * 4)));
+            const __m128i w = _mm_set1_epi32(wx[x + j]);
+            const __m128i sum = _mm_add_epi32(_mm_mullo_epi32(a, _mm_sub_epi32(_mm_set1_epi32(256), w)),
+                                              _mm_mullo_epi32(b, w));
+            out[j] = _mm_srli_epi32(_mm_add_epi32(sum, round), 16);
+        }
+        const __m128i px16 = _mm_packus_epi32(out[0], out[1]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(px16, px16));
+    }
+    Scalar().bilinear_h32(v, x0 + x, x1 + x, wx + x, dst + x * 4, dst_w - x);
+}
+
+static void LanczosH32Sse41(const uint8_t* src, const int* starts, const int16_t* weights, int taps,
+                            int16_t* dst, int dst_w) {
+    // Two taps per madd: pixels p, p+1 rearranged as (c of p, c of p+1) pairs
+    const __m128i pair = _mm_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    const __m128i round = _mm_set1_epi32(128);
+    for (int x = 0; x < dst_w; ++x, weights += taps) {
+        const uint8_t* s = src + starts[x] * 4;
+        __m128i sum = _mm_setzero_si128();
+        int k = 0;
+        for (; k + 2 <= taps; k += 2) {
+            const __m128i px = _mm_shuffle_epi8(
+                _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + k * 4))), pair);
+            const __m128i w = PairWeights(weights[k], weights[k + 1]);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(px, w));
+        }
+        for (; k < taps; ++k) {
+            const __m128i px = _mm_cvtepu8_epi32(Load32(s + k * 4));
+            sum = _mm_add_epi32(sum, _mm_mullo_epi32(px, _mm_set1_epi32(weights[k])));
+        }
+        const __m128i q = _mm_srai_epi32(_mm_add_epi32(sum, round), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packs_epi32(q, q));
+    }
+}
+
+static void LanczosVSse41(const int16_t* const* rows, const int16_t* weights, int taps,
+                          uint8_t* dst, int count) {
+    const __m128i round = _mm_set1_epi32(1 << 19);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        int k = 0;
+        for (; k + 2 <= taps; k += 2) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + i));
+            const __m128i w = PairWeights(weights[k], weights[k + 1]);
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+        for (; k < taps; ++k) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+            const __m128i w = PairWeights(weights[k], 0);
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, _mm_setzero_si128()), w));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, _mm_setzero_si128()), w));
+        }
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 20);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 20);
+        const __m128i v16 = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(v16, v16));
+    }
+    for (; i < count; ++i) {
+        int sum = 0;
+        for (int k = 0; k < taps; ++k) {
+            sum += weights[k] * rows[k][i];
+        }
+        sum = (sum + (1 << 19)) >> 20;
+        dst[i] = static_cast<uint8_t>(sum < 0 ? 0 : sum > 255 ? 255 : sum);
+    }
+}
+
+const PixelKernelTable* Sse41PixelKernels() {
+    static const PixelKernelTable table = {
+        PixelIsa::kSse41,
+        SwizzleSse41,
+        PremultiplySse41,
+        Mirror8Sse41,
+        Mirror32Sse41,
+        BgraToGraySse41,
+        BgraToBgrSse41,
+        OverSse41,
+        Lut3dSse41,
+        YCbCrSse41<true>,
+        YCbCrSse41<false>,
+        BlendRowsSse41,
+        BilinearH32Sse41,
+        LanczosH32Sse41,
+        LanczosVSse41,
+    };
+    return &table;
+}
+
+#else
+
+const PixelKernelTable* Sse41PixelKernels() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "precise_timer.h"
+#include <Windows.h>
+#include <thread>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace {
+
+// One timer per thread, created on first use.
+struct ThreadTimer {
+    HANDLE handle = nullptr;
+    bool high_resolution = false;
+
+    ThreadTimer() {
+        handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        high_resolution = handle != nullptr;
+        if (!handle) {
+            handle = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+        }
+    }
+    ~ThreadTimer() {
+        if (handle) {
+            CloseHandle(handle);
+        }
+    }
+};
+
+}  // namespace
+
+void SleepUntil(std::chrono::steady_clock::time_point deadline) {
+    using namespace std::chrono;
+    thread_local ThreadTimer timer;
+
+    // How early the coarse wait must end to leave room for wake-up jitter.
+    const auto spin_window = timer.high_resolution ? microseconds(1500) : microseconds(16000);
+
+    const auto remaining = deadline - steady_clock::now();
+    if (timer.handle && remaining > spin_window) {
+        LARGE_INTEGER due;
+        // Relative due time, in 100 ns units
+        due.QuadPart = -static_cast<LONGLONG>(duration_cast<nanoseconds>(remaining - spin_window).count() / 100);
+        if (SetWaitableTimer(timer.handle, &due, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(timer.handle, INFINITE);
+        }
+    }
+
+    while (steady_clock::now() < deadline) {
+        YieldProcessor();
+    }
+}
+
+std::chrono::microseconds ThreadCpuTime() {
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) {
+        return std::chrono::microseconds(0);
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    // FILETIME is in 100 ns units
+    return std::chrono::microseconds((k.QuadPart + u.QuadPart) / 10);
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <chrono>
+
+// Sleep until `deadline` with sub-millisecond accuracy. A high-resolution
+// waitable timer (Windows 10 1803+, plain waitable timer before that) covers
+// most of the wait; the last stretch is spun so the wake-up does not depend
+// on the scheduler tick.
+void SleepUntil(std::chrono::steady_clock::time_point deadline);
+
+// CPU time (kernel + user) the calling thread has used so far.
+std::chrono::microseconds ThreadCpuTime();
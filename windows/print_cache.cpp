@@ -0,0 +1,252 @@
+#include "print_cache.h"
+#include "disk_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43504653;  // "SFPC"
+constexpr uint32_t kVersion = 4;
+constexpr wchar_t kExtension[] = L".praster";
+
+struct CacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    PrintCacheKey key;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    uint32_t reserved;
+    uint64_t pixel_bytes;
+};
+
+void MixFnv(uint64_t& hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 0x100000001B3ull;
+    }
+}
+
+}  // namespace
+
+uint64_t PrintCache::KeyId(const PrintCacheKey& key) {
+    uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a
+    MixFnv(hash, key.source_hash);
+    MixFnv(hash, key.profile);
+    MixFnv(hash, key.look);
+    MixFnv(hash, key.overlay);
+    MixFnv(hash, static_cast<uint32_t>(key.width));
+    MixFnv(hash, static_cast<uint32_t>(key.height));
+    MixFnv(hash, static_cast<uint32_t>(key.dpi_x));
+    MixFnv(hash, static_cast<uint32_t>(key.dpi_y));
+    MixFnv(hash, static_cast<uint32_t>(key.auto_rotate));
+    MixFnv(hash, static_cast<uint32_t>(key.dither));
+    return hash;
+}
+
+std::wstring PrintCache::PathFor(uint64_t id) const {
+    return DiskCachePath(dir_, id, kExtension);
+}
+
+bool PrintCache::Configure(const std::wstring& directory, uint64_t max_bytes) {
+    std::vector<std::wstring> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dir_.clear();
+        lru_.clear();
+        index_.clear();
+        total_bytes_ = 0;
+        if (directory.empty()) {
+            return true;
+        }
+
+        if (!PrepareDiskCacheDirectory(directory)) {
+            return false;
+        }
+        dir_ = directory;
+        max_bytes_ = max_bytes;
+
+        // Pick up what a previous run left, most recently used first
+        struct Found {
+            uint64_t id;
+            uint64_t bytes;
+            fs::file_time_type used;
+        };
+        std::vector<Found> found;
+        std::error_code ec;
+        for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            uint64_t id = 0;
+            if (!ParseDiskCacheName(it->path(), kExtension, id)) {
+                continue;
+            }
+            std::error_code entry_ec;
+            const uint64_t bytes = it->file_size(entry_ec);
+            const fs::file_time_type used = it->last_write_time(entry_ec);
+            if (entry_ec) {
+                continue;
+            }
+            found.push_back({id, bytes, used});
+        }
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.used > b.used; });
+        for (const Found& f : found) {
+            lru_.push_back({f.id, f.bytes, next_generation_++});
+            index_[f.id] = std::prev(lru_.end());
+            total_bytes_ += f.bytes;
+        }
+        EvictLocked(doomed);
+    }
+    RemoveFiles(doomed);
+    return true;
+}
+
+bool PrintCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !dir_.empty();
+}
+
+void PrintCache::EraseLocked(std::list<Entry>::iterator it, std::vector<std::wstring>& doomed) {
+    doomed.push_back(PathFor(it->id));
+    total_bytes_ -= it->bytes;
+    index_.erase(it->id);
+    lru_.erase(it);
+}
+
+void PrintCache::EvictLocked(std::vector<std::wstring>& doomed) {
+    while (total_bytes_ > max_bytes_ && !lru_.empty()) {
+        EraseLocked(std::prev(lru_.end()), doomed);
+    }
+}
+
+void PrintCache::RemoveFiles(const std::vector<std::wstring>& paths) {
+    for (const std::wstring& path : paths) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+bool PrintCache::Lookup(const PrintCacheKey& key, PrintRaster& out) {
+    const uint64_t id = KeyId(key);
+    std::wstring path;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dir_.empty()) {
+            return false;
+        }
+        auto found = index_.find(id);
+        if (found == index_.end()) {
+            ++misses_;
+            return false;
+        }
+        path = PathFor(id);
+        generation = found->second->generation;
+    }
+
+    std::ifstream in(fs::path(path), std::ios::binary);
+    CacheFileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    bool valid = in && header.magic == kMagic && header.version == kVersion && header.key == key &&
+                 header.width > 0 && header.height > 0 && header.stride >= header.width * 3 &&
+                 header.pixel_bytes == static_cast<uint64_t>(header.stride) * header.height;
+    if (valid) {
+        out.width = header.width;
+        out.height = header.height;
+        out.stride = header.stride;
+        out.pixels.resize(static_cast<size_t>(header.pixel_bytes));
+        in.read(reinterpret_cast<char*>(out.pixels.data()), static_cast<std::streamsize>(header.pixel_bytes));
+        valid = static_cast<bool>(in);
+    }
+    in.close();
+
+    // Only the entry that was read is touched or dropped: another thread may
+    // have replaced or evicted it meanwhile
+    std::vector<std::wstring> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(id);
+        const bool same = found != index_.end() && found->second->generation == generation;
+        if (!valid) {
+            // Truncated, foreign or colliding: drop it and render again
+            if (same) {
+                EraseLocked(found->second, doomed);
+            }
+            ++misses_;
+        } else {
+            if (same) {
+                lru_.splice(lru_.begin(), lru_, found->second);
+            }
+            ++hits_;
+        }
+    }
+    if (!valid) {
+        RemoveFiles(doomed);
+        return false;
+    }
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool PrintCache::Store(const PrintCacheKey& key, const PrintRaster& raster) {
+    const uint64_t id = KeyId(key);
+    const uint64_t bytes = sizeof(CacheFileHeader) + raster.pixels.size();
+    std::wstring path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dir_.empty() || raster.pixels.empty() || bytes > max_bytes_) {
+            return false;
+        }
+        path = PathFor(id);
+    }
+
+    CacheFileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.key = key;
+    header.width = raster.width;
+    header.height = raster.height;
+    header.stride = raster.stride;
+    header.pixel_bytes = raster.pixels.size();
+
+    if (!WriteDiskCacheEntry(path, {{&header, sizeof(header)}, {raster.pixels.data(), raster.pixels.size()}})) {
+        return false;  // an older entry under this key, if any, is still intact
+    }
+
+    std::vector<std::wstring> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (PathFor(id) != path) {
+            return false;  // reconfigured meanwhile; the file is picked up with its directory
+        }
+        auto existing = index_.find(id);
+        if (existing != index_.end()) {
+            total_bytes_ -= existing->second->bytes;
+            lru_.erase(existing->second);
+            index_.erase(existing);
+        }
+
+        lru_.push_front({id, bytes, next_generation_++});
+        index_[id] = lru_.begin();
+        total_bytes_ += bytes;
+        EvictLocked(doomed);
+    }
+    RemoveFiles(doomed);
+    return true;
+}
+
+PrintCache::Stats PrintCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.entries = lru_.size();
+    s.bytes = total_bytes_;
+    return s;
+}
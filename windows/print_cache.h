@@ -0,0 +1,92 @@
+#pragma once
+#include "print_raster.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Everything a finished print raster depends on. Two prints with the same
+// key produce the same bytes, so the raster can be reused as is.
+struct PrintCacheKey {
+    uint64_t source_hash = 0;   // HashBytes of the encoded photo
+    uint64_t profile = 0;       // colour profile id, 0 = none
+    uint64_t look = 0;          // ColorLut::id of the grade, 0 = none
+    uint64_t overlay = 0;       // OverlayTemplate::id, 0 = none
+    int width = 0;              // page in device pixels (layout x DPI)
+    int height = 0;
+    int dpi_x = 0;
+    int dpi_y = 0;
+    int auto_rotate = 0;
+    int dither = 0;             // DitherSettings::id, 0 = none
+
+    bool operator==(const PrintCacheKey& other) const {
+        return source_hash == other.source_hash && profile == other.profile && look == other.look &&
+               overlay == other.overlay &&
+               width == other.width && height == other.height && dpi_x == other.dpi_x && dpi_y == other.dpi_y &&
+               auto_rotate == other.auto_rotate && dither == other.dither;
+    }
+};
+
+// Content-addressed store of finished print rasters on disk, bounded in
+// size with least-recently-used eviction. A reprint of the same photo on the
+// same page is read back and spooled without decoding or resampling.
+//
+// One file per raster, named after the hash of its key, with the key stored
+// in the header so a hash collision is a miss rather than a wrong print.
+// Recency survives restarts through the file modification time. Thread-safe:
+// the lock only covers the index, and rasters are read, written and removed
+// outside it, so probes never wait on another thread's disk I/O. Writes land
+// by rename, so a reader sees a whole file or none. If a thread loses a race
+// on the same key, the cost is one miss.
+class PrintCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    PrintCache() = default;
+    PrintCache(const PrintCache&) = delete;
+    PrintCache& operator=(const PrintCache&) = delete;
+
+    // Use `directory` (created if needed), holding at most `max_bytes`.
+    // Existing entries are kept. Empty disables the cache.
+    bool Configure(const std::wstring& directory, uint64_t max_bytes);
+    bool enabled() const;
+
+    bool Lookup(const PrintCacheKey& key, PrintRaster& out);
+    // Rasters larger than the whole budget are not stored.
+    bool Store(const PrintCacheKey& key, const PrintRaster& raster);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        uint64_t id;
+        uint64_t bytes;
+        uint64_t generation;  // changes whenever the file is replaced
+    };
+
+    static uint64_t KeyId(const PrintCacheKey& key);
+    std::wstring PathFor(uint64_t id) const;
+    // Index updates; the files of dropped entries are added to `doomed`, to
+    // be removed (RemoveFiles) once the lock is released.
+    void EraseLocked(std::list<Entry>::iterator it, std::vector<std::wstring>& doomed);
+    void EvictLocked(std::vector<std::wstring>& doomed);
+    static void RemoveFiles(const std::vector<std::wstring>& paths);
+
+    mutable std::mutex mutex_;
+    std::wstring dir_;
+    uint64_t max_bytes_ = 0;
+    uint64_t total_bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t next_generation_ = 1;
+    std::list<Entry> lru_;  // most recent first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
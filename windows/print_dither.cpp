@@ -0,0 +1,212 @@
+#include "print_dither.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr int kMaskSize = 64;  // power of two
+constexpr int kMaskPixels = kMaskSize * kMaskSize;
+constexpr int kScale = 16;     // Floyd-Steinberg works in 1/16 gray steps
+constexpr int kMaxValue = 255 * kScale;
+constexpr int kChunk = 64;     // pixels between progress updates of a diffused row
+
+int Gray(const uint8_t* bgr) {
+    return (29 * bgr[0] + 150 * bgr[1] + 77 * bgr[2]) >> 8;  // as BgraToGray
+}
+
+// Void-and-cluster (Ulichney 1993) on a torus: every threshold rank is placed
+// where the pattern of the ranks below it has its largest gap, so each
+// threshold level is an even, structureless scatter of dots.
+std::array<uint16_t, kMaskPixels> BuildBlueNoise() {
+    constexpr int kRadius = 6;
+    constexpr float kSigma = 1.5f;
+    float kernel[2 * kRadius + 1][2 * kRadius + 1];
+    for (int dy = -kRadius; dy <= kRadius; ++dy) {
+        for (int dx = -kRadius; dx <= kRadius; ++dx) {
+            kernel[dy + kRadius][dx + kRadius] = std::exp(-(dx * dx + dy * dy) / (2.0f * kSigma * kSigma));
+        }
+    }
+
+    std::vector<float> energy(kMaskPixels, 0.0f);
+    std::vector<uint8_t> on(kMaskPixels, 0);
+    const auto toggle = [&](int p, bool set) {
+        on[p] = set;
+        const float sign = set ? 1.0f : -1.0f;
+        const int px = p % kMaskSize;
+        const int py = p / kMaskSize;
+        for (int dy = -kRadius; dy <= kRadius; ++dy) {
+            float* row = energy.data() + ((py + dy) & (kMaskSize - 1)) * kMaskSize;
+            for (int dx = -kRadius; dx <= kRadius; ++dx) {
+                row[(px + dx) & (kMaskSize - 1)] += sign * kernel[dy + kRadius][dx + kRadius];
+            }
+        }
+    };
+    // Tightest cluster: the set pixel with the most set neighbours. Largest
+    // void: the clear pixel with the fewest. Past half full, the largest void
+    // is also the tightest cluster of clear pixels, so one rule fills the mask.
+    const auto find = [&](bool set) {
+        int best = -1;
+        for (int p = 0; p < kMaskPixels; ++p) {
+            if (on[p] == set && (best < 0 || (set ? energy[p] > energy[best] : energy[p] < energy[best]))) {
+                best = p;
+            }
+        }
+        return best;
+    };
+
+    // Initial pattern: random dots, relaxed until moving the tightest
+    // cluster into the largest void changes nothing
+    std::mt19937 rng(0x5F3759DF);
+    int ones = 0;
+    while (ones < kMaskPixels / 10) {
+        const int p = static_cast<int>(rng() % kMaskPixels);
+        if (!on[p]) {
+            toggle(p, true);
+            ++ones;
+        }
+    }
+    for (int i = 0; i < kMaskPixels; ++i) {
+        const int cluster = find(true);
+        toggle(cluster, false);
+        const int gap = find(false);
+        toggle(gap, true);
+        if (gap == cluster) {
+            break;
+        }
+    }
+
+    std::array<uint16_t, kMaskPixels> rank{};
+    const std::vector<float> prototype_energy = energy;
+    const std::vector<uint8_t> prototype = on;
+    for (int r = ones - 1; r >= 0; --r) {
+        const int cluster = find(true);
+        toggle(cluster, false);
+        rank[cluster] = static_cast<uint16_t>(r);
+    }
+    energy = prototype_energy;
+    on = prototype;
+    for (int r = ones; r < kMaskPixels; ++r) {
+        const int gap = find(false);
+        toggle(gap, true);
+        rank[gap] = static_cast<uint16_t>(r);
+    }
+
+    // Rank to a threshold in (0, 1) in Q16: (rank + 0.5) / pixels
+    for (uint16_t& t : rank) {
+        t = static_cast<uint16_t>((2 * t + 1) * (65536 / (2 * kMaskPixels)));
+    }
+    return rank;
+}
+
+// Built on first use (some tens of milliseconds, once per process)
+const std::array<uint16_t, kMaskPixels>& BlueNoise() {
+    static const std::array<uint16_t, kMaskPixels> mask = BuildBlueNoise();
+    return mask;
+}
+
+}  // namespace
+
+PrintDither::PrintDither(const DitherSettings& settings, int width)
+    : settings_(settings), width_(std::max(width, 0)) {
+    settings_.bits = std::clamp(settings_.bits, 1, 4);
+    levels_ = 1 << settings_.bits;
+    for (int q = 0; q < levels_; ++q) {
+        level_values_[q] = static_cast<uint8_t>((q * 255 + (levels_ - 1) / 2) / (levels_ - 1));
+    }
+    if (settings_.mode == DitherMode::kFloydSteinberg) {
+        carry_.assign(static_cast<size_t>(width_) + 2, 0);
+        nearest_.resize(kMaxValue + 1);
+        for (int v = 0; v <= kMaxValue; ++v) {
+            nearest_[v] = level_values_[(v * (levels_ - 1) + kMaxValue / 2) / kMaxValue];
+        }
+    }
+}
+
+void PrintDither::Process(uint8_t* bgr, int stride, int rows) {
+    if (!bgr || rows <= 0 || width_ == 0) {
+        return;
+    }
+    if (settings_.mode == DitherMode::kFloydSteinberg) {
+        DiffuseRows(bgr, stride, rows);
+    } else if (settings_.mode == DitherMode::kBlueNoise) {
+        OrderedRows(bgr, stride, rows);
+    }
+    y_ += rows;
+}
+
+void PrintDither::OrderedRows(uint8_t* bgr, int stride, int rows) {
+    const std::array<uint16_t, kMaskPixels>& mask = BlueNoise();
+    int scaled[256];  // gray to levels in Q16; 255 is exactly the top level
+    for (int g = 0; g < 256; ++g) {
+        scaled[g] = (g * (levels_ - 1) * 65536 + 127) / 255;
+    }
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int bands = std::min(rows, pool.worker_count() * 2);
+    pool.ParallelFor(bands, TaskScheduler::kHigh, [&](int band) {
+        const int begin = rows * band / bands;
+        const int end = rows * (band + 1) / bands;
+        for (int y = begin; y < end; ++y) {
+            uint8_t* p = bgr + static_cast<size_t>(y) * stride;
+            const uint16_t* thresholds = mask.data() + ((y_ + y) & (kMaskSize - 1)) * kMaskSize;
+            for (int x = 0; x < width_; ++x, p += 3) {
+                const int q = (scaled[Gray(p)] + thresholds[x & (kMaskSize - 1)]) >> 16;
+                p[0] = p[1] = p[2] = level_values_[q];
+            }
+        }
+    });
+}
+
+// Rows are claimed in order by the workers. Row y only reads error that
+// row y - 1 pushed down, and pixel x needs row y - 1 finished through x + 1,
+// so each row waits on the published progress of the row above, a chunk at
+// a time. The row above is always held by a running worker, so waiting
+// cannot deadlock, and the result is exactly that of a serial pass.
+void PrintDither::DiffuseRows(uint8_t* bgr, int stride, int rows) {
+    const size_t plane_stride = static_cast<size_t>(width_) + 2;
+    std::vector<int16_t> errors(plane_stride * (rows + 1));
+    std::copy(carry_.begin(), carry_.end(), errors.begin());
+    std::vector<std::atomic<int>> progress(rows);
+
+    TaskScheduler::Instance().ParallelFor(rows, TaskScheduler::kHigh, [&](int y) {
+        const int16_t* in = errors.data() + plane_stride * y + 1;  // indices -1 .. width
+        int16_t* out = errors.data() + plane_stride * (y + 1) + 1;
+        out[-1] = out[0] = 0;  // the rest is set before it is added to
+        uint8_t* p = bgr + static_cast<size_t>(y) * stride;
+        int right = 0;
+        for (int x0 = 0; x0 < width_; x0 += kChunk) {
+            const int x1 = std::min(width_, x0 + kChunk);
+            if (y > 0) {
+                const int needed = std::min(width_, x1 + 1);
+                while (progress[y - 1].load(std::memory_order_acquire) < needed) {
+                    std::this_thread::yield();
+                }
+            }
+            for (int x = x0; x < x1; ++x, p += 3) {
+                const int v = std::clamp(Gray(p) * kScale + in[x] + right, 0, kMaxValue);
+                const uint8_t gray = nearest_[v];
+                p[0] = p[1] = p[2] = gray;
+                // 7/16 right, 3/16 down-left, 5/16 down, 1/16 down-right
+                const int e = v - gray * kScale;
+                const int e7 = (e * 7 + 8) >> 4;
+                const int e3 = (e * 3 + 8) >> 4;
+                const int e5 = (e * 5 + 8) >> 4;
+                right = e7;
+                out[x - 1] = static_cast<int16_t>(out[x - 1] + e3);
+                out[x] = static_cast<int16_t>(out[x] + e5);
+                out[x + 1] = static_cast<int16_t>(e - e7 - e3 - e5);
+            }
+            progress[y].store(x1, std::memory_order_release);
+        }
+    });
+    std::copy(errors.end() - plane_stride, errors.end(), carry_.begin());
+}
+
+void DitherBgr(const DitherSettings& settings, uint8_t* bgr, int width, int height, int stride) {
+    PrintDither dither(settings, width);
+    dither.Process(bgr, stride, height);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Gray dithering for printers that take 1- to 4-bit input (thermal sticker
+// and receipt printers). The page is reduced to 2^bits gray levels before it
+// reaches the driver, so the driver's own (slow, coarse) halftoning has
+// nothing left to do: a 1-bit page is already pure black and white.
+enum class DitherMode : int {
+    kNone = 0,
+    kFloydSteinberg = 1,  // error diffusion: finest detail, best for photos
+    kBlueNoise = 2,       // ordered with a 64 x 64 blue-noise mask: no worm artefacts, stable between prints
+};
+
+struct DitherSettings {
+    DitherMode mode = DitherMode::kNone;
+    int bits = 1;  // output levels 2^bits, 1-4
+
+    bool enabled() const { return mode != DitherMode::kNone; }
+    // For cache keys; 0 when off.
+    int id() const { return enabled() ? static_cast<int>(mode) | bits << 8 : 0; }
+};
+
+// Dithers a 24-bit BGR page (DIB rows) in place, top to bottom, in as many
+// calls as the page has bands. Every pixel becomes the BT.601 gray level
+// nearest after dithering, written to all three channels.
+//
+// Both modes run on the shared worker pool. Blue noise has no dependencies
+// between pixels and is split in row bands. Floyd-Steinberg is
+// row-pipelined: rows are taken in order by the workers and each follows
+// the row above it a few pixels behind, so every worker is busy after the
+// first rows while the output stays identical to a serial pass.
+class PrintDither {
+public:
+    PrintDither(const DitherSettings& settings, int width);
+
+    // The next `rows` rows of the page. Error diffusion continues from the
+    // previous call, so a page in bands matches the page in one go.
+    void Process(uint8_t* bgr, int stride, int rows);
+
+private:
+    void DiffuseRows(uint8_t* bgr, int stride, int rows);
+    void OrderedRows(uint8_t* bgr, int stride, int rows);
+
+    DitherSettings settings_;
+    int width_;
+    int levels_;
+    int y_ = 0;                     // page row of the next call
+    std::vector<int16_t> carry_;    // Floyd-Steinberg error into the next row
+    std::vector<uint8_t> nearest_;  // gray x 16 -> nearest level's gray
+    uint8_t level_values_[16];      // output gray of each level
+};
+
+// Whole-image form of the above.
+void DitherBgr(const DitherSettings& settings, uint8_t* bgr, int width, int height, int stride);
@@ -0,0 +1,236 @@
+#include "print_layout.h"
+#include "color_lut.h"
+#include "image_decode.h"
+#include "overlay_template.h"
+#include "pixel_kernels.h"
+#include "print_dither.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t MicrosSince(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+namespace {
+
+// A cell's photo while bands cross it: read band-wise into `window` (crop rows
+// [window_first, window_last)), or decoded whole when it has to be turned
+struct CellState {
+    SheetCell cell;
+    std::unique_ptr<CoverRows> rows;
+    std::vector<uint8_t> window;
+    int window_first = 0;
+    int window_last = 0;
+    std::unique_ptr<CoverImage> cover;
+    bool released = false;
+};
+
+}  // namespace
+
+// Slides the cell's window down to the crop rows that sheet rows [top, bottom)
+// resample from, keeping the overlap and reading only the rows below it
+static bool AdvanceWindow(CellState& state, int top, int bottom) {
+    const SheetCell& c = state.cell;
+    CoverRows& src = *state.rows;
+    int first = 0, last = 0;
+    LanczosSourceRows(src.crop_height, c.height, std::max(top, c.y) - c.y, std::min(bottom, c.y + c.height) - c.y,
+                      first, last);
+    if (first >= last) {
+        return false;
+    }
+    const size_t stride = static_cast<size_t>(src.crop_width) * 4;
+    const int kept = first < state.window_last ? state.window_last - first : 0;
+    if (kept > 0) {
+        std::memmove(state.window.data(), state.window.data() + (first - state.window_first) * stride,
+                     kept * stride);
+    }
+    state.window.resize((last - first) * stride);
+    state.window_first = first;
+    state.window_last = last;
+    return kept == last - first ||
+           src.reader.ReadRows(src.crop_x, src.crop_y + first + kept, src.crop_width, last - first - kept,
+                               state.window.data() + kept * stride, static_cast<int>(stride));
+}
+
+static void FillBackground(uint8_t* dst, int width, int rows, const uint8_t bgr[3]) {
+    const uint8_t pixel[4] = {bgr[0], bgr[1], bgr[2], 255};
+    for (int x = 0; x < width; ++x) {
+        std::memcpy(dst + static_cast<size_t>(x) * 4, pixel, 4);
+    }
+    const size_t row_bytes = static_cast<size_t>(width) * 4;
+    for (int y = 1; y < rows; ++y) {
+        std::memcpy(dst + y * row_bytes, dst, row_bytes);
+    }
+}
+
+bool RenderSheet(const SheetLayout& layout, const std::vector<SheetSource>& sources, bool auto_rotate,
+                 int band_rows, const SheetBandSink& sink, SheetRenderStats& stats,
+                 const PrintStages& stages) {
+    const int width = layout.width;
+    const int height = layout.height;
+    const PlacedOverlay* overlay = stages.overlay;
+    if (width <= 0 || height <= 0 || !sink ||
+        (overlay && (overlay->width() != width || overlay->height() != height))) {
+        return false;
+    }
+    if (band_rows <= 0) {
+        band_rows = 64;
+    }
+
+    std::vector<CellState> cells;
+    cells.reserve(layout.cells.size());
+    for (const SheetCell& cell : layout.cells) {
+        if (cell.width <= 0 || cell.height <= 0 || cell.x < 0 || cell.y < 0 || cell.x + cell.width > width ||
+            cell.y + cell.height > height || cell.source < 0 || cell.source >= static_cast<int>(sources.size()) ||
+            !sources[cell.source].data || sources[cell.source].len == 0) {
+            return false;
+        }
+        cells.emplace_back().cell = cell;
+    }
+
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int bands = (height + band_rows - 1) / band_rows;
+    const int window = std::clamp(pool.worker_count(), 1, bands);
+    const size_t bgra_stride = static_cast<size_t>(width) * 4;
+    const int bgr_stride = (width * 3 + 3) & ~3;
+    const size_t bgra_band = bgra_stride * band_rows;
+    const size_t bgr_band = static_cast<size_t>(bgr_stride) * band_rows;
+    std::vector<uint8_t> bgra(bgra_band * window);
+    std::vector<uint8_t> bgr(bgr_band * window);
+    const uint64_t buffer_bytes = bgra.size() + bgr.size();
+
+    PrintDither dither(stages.dither, width);
+
+    stats = SheetRenderStats{};
+    stats.bands = bands;
+    stats.peak_bytes = buffer_bytes;
+
+    for (int first = 0; first < bands; first += window) {
+        const int count = std::min(window, bands - first);
+        const int top = first * band_rows;
+        const int bottom = std::min(height, (first + count) * band_rows);
+
+        // Open the cells this window reaches for the first time, and read the
+        // rows this window resamples from the band-wise ones
+        std::vector<int> active;
+        for (int i = 0; i < static_cast<int>(cells.size()); ++i) {
+            const SheetCell& c = cells[i].cell;
+            if (!cells[i].released && c.y < bottom && c.y + c.height > top) {
+                active.push_back(i);
+            }
+        }
+        if (!active.empty()) {
+            auto started = Clock::now();
+            std::atomic<bool> failed{false};
+            pool.ParallelFor(static_cast<int>(active.size()), TaskScheduler::kHigh, [&](int a) {
+                CellState& state = cells[active[a]];
+                if (!state.rows && !state.cover) {
+                    const SheetSource& source = sources[state.cell.source];
+                    WicDecoder decoder;  // pool workers run with COM initialized
+                    auto rows = std::make_unique<CoverRows>();
+                    auto cover = std::make_unique<CoverImage>();
+                    if (decoder.ok() && OpenCoverRows(decoder, source.data, source.len, state.cell.width,
+                                                      state.cell.height, auto_rotate, *rows)) {
+                        state.rows = std::move(rows);
+                    } else if (decoder.ok() && DecodeCover(decoder, source.data, source.len, state.cell.width,
+                                                           state.cell.height, auto_rotate, *cover)) {
+                        state.cover = std::move(cover);
+                    } else {
+                        failed = true;
+                        return;
+                    }
+                }
+                if (state.rows && !AdvanceWindow(state, top, bottom)) {
+                    failed = true;
+                }
+            });
+            stats.decode_us += MicrosSince(started);
+            if (failed) {
+                return false;
+            }
+        }
+
+        uint64_t live = buffer_bytes;
+        for (const CellState& state : cells) {
+            live += state.cover ? state.cover->image.pixels.size() : state.window.capacity();
+        }
+        stats.peak_bytes = std::max(stats.peak_bytes, live);
+
+        // One band per task: background, every cell crossing it (graded), the overlay,
+        // then the whole band to printer colours
+        auto started = Clock::now();
+        pool.ParallelFor(count, TaskScheduler::kHigh, [&](int i) {
+            const int y0 = (first + i) * band_rows;
+            const int y1 = std::min(height, y0 + band_rows);
+            uint8_t* band = bgra.data() + bgra_band * i;
+            FillBackground(band, width, y1 - y0, layout.background);
+            for (const CellState& state : cells) {
+                const SheetCell& c = state.cell;
+                const int r0 = std::max(y0, c.y);
+                const int r1 = std::min(y1, c.y + c.height);
+                if ((!state.rows && !state.cover) || r0 >= r1) {
+                    continue;
+                }
+                uint8_t* rows = band + (r0 - y0) * bgra_stride + static_cast<size_t>(c.x) * 4;
+                if (state.rows) {
+                    const CoverRows& src = *state.rows;
+                    ResizeLanczosBgraWindow(state.window.data(), state.window_first, src.crop_width,
+                                            src.crop_height, src.crop_width * 4, rows, c.width, c.height,
+                                            static_cast<int>(bgra_stride), r0 - c.y, r1 - c.y);
+                } else {
+                    const CoverImage& cover = *state.cover;
+                    ResizeLanczosBgraRows(cover.crop(), cover.crop_width, cover.crop_height, cover.image.stride,
+                                          rows, c.width, c.height, static_cast<int>(bgra_stride), r0 - c.y,
+                                          r1 - c.y);
+                }
+                if (stages.look) {
+                    stages.look->ApplyRows(rows, c.width, r1 - r0, static_cast<int>(bgra_stride), rows,
+                                           static_cast<int>(bgra_stride));
+                }
+            }
+            if (overlay) {
+                overlay->ApplyRows(band, static_cast<int>(bgra_stride), y0, y1);
+            }
+            if (stages.printer) {
+                stages.printer->ApplyRows(band, width, y1 - y0, static_cast<int>(bgra_stride), band,
+                                          static_cast<int>(bgra_stride));
+            }
+            BgraToBgr(band, width, y1 - y0, static_cast<int>(bgra_stride), bgr.data() + bgr_band * i, bgr_stride);
+        });
+        stats.render_us += MicrosSince(started);
+
+        // Bands of a window are contiguous in `bgr`, so the window dithers in one pass
+        if (stages.dither.enabled()) {
+            started = Clock::now();
+            dither.Process(bgr.data(), bgr_stride, bottom - top);
+            stats.dither_us += MicrosSince(started);
+        }
+
+        started = Clock::now();
+        for (int i = 0; i < count; ++i) {
+            const int y0 = (first + i) * band_rows;
+            if (!sink(bgr.data() + bgr_band * i, bgr_stride, y0, std::min(height, y0 + band_rows) - y0)) {
+                return false;
+            }
+        }
+        stats.sink_us += MicrosSince(started);
+
+        // Cells entirely above the next window are done
+        for (CellState& state : cells) {
+            if (!state.released && state.cell.y + state.cell.height <= bottom) {
+                state.rows.reset();
+                state.cover.reset();
+                std::vector<uint8_t>().swap(state.window);
+                state.released = true;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "print_raster.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// One photo slot on a sheet, in sheet pixels. The photo fills it (cover).
+struct SheetCell {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int source = 0;  // index into the sources passed to RenderSheet
+};
+
+// A multi-up print sheet (photo strip, 4-up grid, ...) in device pixels.
+struct SheetLayout {
+    int width = 0;
+    int height = 0;
+    uint8_t background[3] = {255, 255, 255};  // B, G, R behind and between cells
+    std::vector<SheetCell> cells;
+};
+
+struct SheetSource {
+    const uint8_t* data = nullptr;  // encoded photo (JPEG, PNG, anything WIC reads)
+    size_t len = 0;
+};
+
+// Receives the finished sheet top to bottom: `rows` rows of 24-bit BGR
+// (stride padded to 4 bytes) starting at sheet row `y`. Return false to stop.
+using SheetBandSink = std::function<bool(const uint8_t* bgr, int stride, int y, int rows)>;
+
+struct SheetRenderStats {
+    uint64_t decode_us = 0;   // wall time spent decoding cells
+    uint64_t render_us = 0;   // resample, composite and BGR conversion
+    uint64_t sink_us = 0;
+    uint64_t dither_us = 0;
+    uint64_t peak_bytes = 0;  // high-water mark of decoded cells + band buffers
+    int bands = 0;
+};
+
+// Renders a sheet in horizontal bands of `band_rows` rows (<= 0: 64), so a
+// 300 dpi A4 sheet never exists as one canvas:
+//
+// - Bands are rendered a window at a time, one band per worker of the shared
+//   pool, then handed to `sink` in order.
+// - A cell's photo is EXIF-oriented, DCT-scaled to just cover the cell and
+//   turned to the cell's orientation with auto_rotate. When that leaves its
+//   rows top to bottom (no turn, at most a mirror), it is decoded band-wise:
+//   each window reads only the crop rows its bands resample from, and the
+//   rows are dropped once the window has moved past them. A photo that has
+//   to be turned or flipped is decoded whole when the first window reaches
+//   its cell and released after the last band it touches. Cells in the same
+//   window are read in parallel.
+//
+// Peak memory is the window's band buffers, plus for each band-wise cell
+// crossing the window the crop rows under it (DCT scaling decodes at most
+// twice the cell size per side, plus the Lanczos taps), plus every turned
+// photo whose cell crosses it, whole. With upright photos that is
+// independent of sheet height; a full-page turned photo costs its whole
+// decode. Later cells draw over earlier ones. The look in `stages` grades
+// each cell's photo (not the background), an overlay placed for the sheet
+// size goes over everything, and the printer transform converts the whole
+// band, background included. Dithering runs on each window of bands in page
+// order, carrying its error across band edges, so the sheet dithers as if it
+// were one image.
+bool RenderSheet(const SheetLayout& layout, const std::vector<SheetSource>& sources, bool auto_rotate,
+                 int band_rows, const SheetBandSink& sink, SheetRenderStats& stats,
+                 const PrintStages& stages = {});
@@ -0,0 +1,141 @@
+#include "print_raster.h"
+#include "color_lut.h"
+#include "image_probe.h"
+#include "overlay_template.h"
+#include "pixel_kernels.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t MicrosSince(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+// Orientation and decode size for covering a width x height area: EXIF first,
+// then turned to fit the area with auto_rotate; decoded no larger than needed
+static bool PlanCover(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height,
+                      bool auto_rotate, int& transform, int& max_side) {
+    if (!data || len == 0 || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    int src_w = 0, src_h = 0;
+    if (!ProbeJpegSize(data, len, src_w, src_h) && !decoder.GetSize(data, len, src_w, src_h)) {
+        return false;
+    }
+    transform = TransformFromExif(ProbeJpegOrientation(data, len));
+    int oriented_w = 0, oriented_h = 0;
+    TransformedSize(transform, src_w, src_h, oriented_w, oriented_h);
+    if (auto_rotate && oriented_w != oriented_h && width != height &&
+        (oriented_w > oriented_h) != (width > height)) {
+        transform = ComposeTransform(transform, kRotate90);
+        std::swap(oriented_w, oriented_h);
+    }
+
+    const double cover = std::max(static_cast<double>(width) / oriented_w,
+                                  static_cast<double>(height) / oriented_h);
+    max_side = cover >= 1.0
+        ? 0
+        : static_cast<int>(std::ceil(std::max(oriented_w, oriented_h) * cover)) + 1;
+    return true;
+}
+
+// Centre crop of a decoded_w x decoded_h image to the area's aspect
+static void CropCover(int decoded_w, int decoded_h, int width, int height, int& crop_x, int& crop_y,
+                      int& crop_width, int& crop_height) {
+    crop_width = decoded_w;
+    crop_height = decoded_h;
+    if (static_cast<int64_t>(decoded_w) * height > static_cast<int64_t>(decoded_h) * width) {
+        crop_width = std::clamp(
+            static_cast<int>(std::lround(static_cast<double>(decoded_h) * width / height)), 1, decoded_w);
+    } else {
+        crop_height = std::clamp(
+            static_cast<int>(std::lround(static_cast<double>(decoded_w) * height / width)), 1, decoded_h);
+    }
+    crop_x = (decoded_w - crop_width) / 2;
+    crop_y = (decoded_h - crop_height) / 2;
+}
+
+bool DecodeCover(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height, bool auto_rotate,
+                 CoverImage& out) {
+    int transform = kRotate0, max_side = 0;
+    if (!PlanCover(decoder, data, len, width, height, auto_rotate, transform, max_side)) {
+        return false;
+    }
+    DecodedImage& decoded = out.image;
+    if (!decoder.DecodeBgra(data, len, max_side, decoded, transform)) {
+        return false;
+    }
+    CropCover(decoded.width, decoded.height, width, height, out.crop_x, out.crop_y, out.crop_width,
+              out.crop_height);
+    return true;
+}
+
+bool OpenCoverRows(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height, bool auto_rotate,
+                   CoverRows& out) {
+    int transform = kRotate0, max_side = 0;
+    if (!PlanCover(decoder, data, len, width, height, auto_rotate, transform, max_side) ||
+        !decoder.OpenRows(data, len, max_side, transform, out.reader)) {
+        return false;
+    }
+    CropCover(out.reader.width(), out.reader.height(), width, height, out.crop_x, out.crop_y, out.crop_width,
+              out.crop_height);
+    return true;
+}
+
+bool RenderPrintRaster(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height,
+                       bool auto_rotate, PrintRaster& out, PrintRenderTimings& timings,
+                       const PrintStages& stages) {
+    // 1-2) Oriented, DCT-scaled decode and the centre crop to the page aspect
+    auto started = Clock::now();
+    CoverImage source;
+    if (!DecodeCover(decoder, data, len, width, height, auto_rotate, source)) {
+        return false;
+    }
+    timings.decode_us = MicrosSince(started);
+
+    // 3) Resampled straight from the decode, in row bands, graded, overlay on top,
+    //    then to printer colours
+    started = Clock::now();
+    std::vector<uint8_t> page(static_cast<size_t>(width) * height * 4);
+    TaskScheduler& pool = TaskScheduler::Instance();
+    const int bands = std::min(height, pool.worker_count() * 2);
+    pool.ParallelFor(bands, TaskScheduler::kHigh, [&](int band) {
+        const int begin = height * band / bands;
+        const int end = height * (band + 1) / bands;
+        uint8_t* rows = page.data() + static_cast<size_t>(begin) * width * 4;
+        ResizeLanczosBgraRows(source.crop(), source.crop_width, source.crop_height, source.image.stride,
+                              rows, width, height, width * 4, begin, end);
+        if (stages.look) {
+            stages.look->ApplyRows(rows, width, end - begin, width * 4, rows, width * 4);
+        }
+        if (stages.overlay) {
+            stages.overlay->ApplyRows(rows, width * 4, begin, end);
+        }
+        if (stages.printer) {
+            stages.printer->ApplyRows(rows, width, end - begin, width * 4, rows, width * 4);
+        }
+    });
+    timings.resample_us = MicrosSince(started);
+
+    // 4) BGR DIB for the spooler
+    started = Clock::now();
+    out.width = width;
+    out.height = height;
+    out.stride = (width * 3 + 3) & ~3;
+    out.pixels.assign(static_cast<size_t>(out.stride) * height, 0);
+    BgraToBgr(page.data(), width, height, width * 4, out.pixels.data(), out.stride);
+    timings.convert_us = MicrosSince(started);
+
+    // 5) Gray levels for low-bit printers
+    if (stages.dither.enabled()) {
+        started = Clock::now();
+        DitherBgr(stages.dither, out.pixels.data(), width, height, out.stride);
+        timings.dither_us = MicrosSince(started);
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "image_decode.h"
+#include "print_dither.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A finished print page: 24-bit BGR, top-down, rows padded to 4 bytes. That
+// is what StretchDIBits and a BMP file take, so spooling copies nothing.
+struct PrintRaster {
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct PrintRenderTimings {
+    uint64_t decode_us = 0;
+    uint64_t resample_us = 0;
+    uint64_t convert_us = 0;
+    uint64_t dither_us = 0;
+};
+
+class ColorLut;
+class PlacedOverlay;
+
+// Optional stages run on every band right after it is resampled, while it
+// is still in cache, in this order: the colour grade (the photo only), then
+// the overlay on top, so frame artwork keeps its own colours, and last the
+// printer's colour transform over the finished band. `dither` then reduces
+// the BGR output for low-bit printers.
+struct PrintStages {
+    const ColorLut* look = nullptr;
+    const PlacedOverlay* overlay = nullptr;  // placed for the page size
+    const ColorLut* printer = nullptr;       // sRGB -> printer ICC profile (PrinterColorTransforms)
+    DitherSettings dither;
+};
+
+// A photo decoded just large enough to cover a width x height area, and the
+// centred part of it with that area's aspect (what "cover" fills it with).
+struct CoverImage {
+    DecodedImage image;
+    int crop_x = 0;
+    int crop_y = 0;
+    int crop_width = 0;
+    int crop_height = 0;
+
+    const uint8_t* crop() const {
+        return image.pixels.data() + static_cast<size_t>(crop_y) * image.stride + static_cast<size_t>(crop_x) * 4;
+    }
+};
+
+// Steps 1 and 2 of RenderPrintRaster below, for one width x height area: the
+// oriented, DCT-scaled BGRA decode and its cover crop.
+bool DecodeCover(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height, bool auto_rotate,
+                 CoverImage& out);
+
+// The same cover crop read band by band (see WicRowReader) instead of decoded
+// whole: crop row r is reader row crop_y + r.
+struct CoverRows {
+    WicRowReader reader;
+    int crop_x = 0;
+    int crop_y = 0;
+    int crop_width = 0;
+    int crop_height = 0;
+};
+
+// DecodeCover's band-wise counterpart. False as well when the photo has to be
+// turned or flipped vertically to cover the area (WicDecoder::OpenRows); use
+// DecodeCover for those.
+bool OpenCoverRows(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height, bool auto_rotate,
+                   CoverRows& out);
+
+// Renders an encoded photo (JPEG, PNG, anything WIC reads) as a borderless
+// page of width x height device pixels:
+//
+// - EXIF orientation is honoured, and with auto_rotate the photo is turned
+//   90 degrees when it and the page differ in orientation. Both are applied
+//   during decode.
+// - The JPEG is DCT-scaled while decoding to the smallest size that still
+//   covers the page, so a 24 MP still is never decoded at full size for a
+//   1800 x 1200 print.
+// - The page is filled edge to edge (cover): the centre is cropped to the
+//   page aspect and Lanczos-resampled, split in row bands over the shared
+//   worker pool.
+// - `stages` grade the page, composite an overlay on it and convert it to the
+//   printer's colours, band by band, and dither the finished page.
+//
+// `decoder` must belong to the calling thread.
+bool RenderPrintRaster(WicDecoder& decoder, const uint8_t* data, size_t len, int width, int height,
+                       bool auto_rotate, PrintRaster& out, PrintRenderTimings& timings,
+                       const PrintStages& stages = {});
@@ -0,0 +1,237 @@
+#include "print_spool.h"
+#include <algorithm>
+#include <cmath>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+PrinterPage::~PrinterPage() {
+    Close();
+}
+
+void PrinterPage::Close() {
+    if (dc_) {
+        DeleteDC(dc_);
+        dc_ = nullptr;
+    }
+    devmode_.clear();
+    width_ = height_ = 0;
+}
+
+bool PrinterPage::Open(const std::wstring& printer, double width_in, double height_in) {
+    Close();
+
+    std::wstring name = printer;
+    if (name.empty()) {
+        DWORD size = 0;
+        GetDefaultPrinterW(nullptr, &size);
+        if (size == 0) {
+            return false;
+        }
+        name.resize(size);
+        if (!GetDefaultPrinterW(&name[0], &size)) {
+            return false;
+        }
+        name.resize(size - 1);
+    }
+
+    // Driver defaults with the paper size and orientation replaced. Paper
+    // width/length are the portrait dimensions in tenths of a millimetre.
+    std::vector<uint8_t> devmode;
+    DEVMODEW* dm = nullptr;
+    HANDLE handle = nullptr;
+    if (OpenPrinterW(const_cast<LPWSTR>(name.c_str()), &handle, nullptr)) {
+        const LONG size = DocumentPropertiesW(nullptr, handle, const_cast<LPWSTR>(name.c_str()),
+                                              nullptr, nullptr, 0);
+        if (size > 0) {
+            devmode.resize(static_cast<size_t>(size));
+            dm = reinterpret_cast<DEVMODEW*>(devmode.data());
+            if (DocumentPropertiesW(nullptr, handle, const_cast<LPWSTR>(name.c_str()), dm, nullptr,
+                                    DM_OUT_BUFFER) == IDOK) {
+                dm->dmPaperWidth = static_cast<short>(std::lround(std::min(width_in, height_in) * 254.0));
+                dm->dmPaperLength = static_cast<short>(std::lround(std::max(width_in, height_in) * 254.0));
+                dm->dmOrientation = width_in > height_in ? DMORIENT_LANDSCAPE : DMORIENT_PORTRAIT;
+                dm->dmFields |= DM_PAPERWIDTH | DM_PAPERLENGTH | DM_ORIENTATION;
+                DocumentPropertiesW(nullptr, handle, const_cast<LPWSTR>(name.c_str()), dm, dm,
+                                    DM_IN_BUFFER | DM_OUT_BUFFER);
+            } else {
+                dm = nullptr;
+            }
+        }
+        ClosePrinter(handle);
+    }
+
+    dc_ = CreateDCW(L"WINSPOOL", name.c_str(), nullptr, dm);
+    if (!dc_) {
+        return false;
+    }
+    name_ = name;
+    if (dm) {
+        devmode_.swap(devmode);
+    }
+    dpi_x_ = GetDeviceCaps(dc_, LOGPIXELSX);
+    dpi_y_ = GetDeviceCaps(dc_, LOGPIXELSY);
+    width_ = GetDeviceCaps(dc_, PHYSICALWIDTH);
+    height_ = GetDeviceCaps(dc_, PHYSICALHEIGHT);
+    offset_x_ = GetDeviceCaps(dc_, PHYSICALOFFSETX);
+    offset_y_ = GetDeviceCaps(dc_, PHYSICALOFFSETY);
+    return width_ > 0 && height_ > 0 && dpi_x_ > 0 && dpi_y_ > 0;
+}
+
+std::wstring PrinterPage::color_profile() const {
+    DWORD size = 0;
+    if (!dc_) {
+        return {};
+    }
+    GetICMProfileW(dc_, &size, nullptr);
+    if (size == 0) {
+        return {};
+    }
+    std::wstring path(size, L'\0');
+    if (!GetICMProfileW(dc_, &size, &path[0])) {
+        return {};
+    }
+    path.resize(wcsnlen(path.c_str(), path.size()));
+    // Printers without a profile of their own report the sRGB one
+    if (std::filesystem::path(path).filename() == L"sRGB Color Space Profile.icm") {
+        return {};
+    }
+    return path;
+}
+
+bool PrinterPage::DisableDriverColor() {
+    if (!dc_ || devmode_.empty()) {
+        return false;
+    }
+    DEVMODEW* dm = reinterpret_cast<DEVMODEW*>(devmode_.data());
+    dm->dmICMMethod = DMICMMETHOD_NONE;
+    dm->dmFields |= DM_ICMMETHOD;
+    return ResetDCW(dc_, dm) != nullptr;
+}
+
+static void FillBitmapInfo(int width, int height, BITMAPINFOHEADER& header) {
+    header = {};
+    header.biSize = sizeof(BITMAPINFOHEADER);
+    header.biWidth = width;
+    header.biHeight = -height;  // top-down
+    header.biPlanes = 1;
+    header.biBitCount = 24;
+    header.biCompression = BI_RGB;
+    header.biSizeImage = static_cast<DWORD>(static_cast<size_t>((width * 3 + 3) & ~3) * height);
+}
+
+bool PrinterPage::BeginPage(const std::wstring& document_name) {
+    if (!dc_) {
+        return false;
+    }
+    DOCINFOW doc = {};
+    doc.cbSize = sizeof(doc);
+    doc.lpszDocName = document_name.c_str();
+    if (StartDocW(dc_, &doc) <= 0) {
+        return false;
+    }
+    if (StartPage(dc_) <= 0) {
+        AbortDoc(dc_);
+        return false;
+    }
+    SetStretchBltMode(dc_, COLORONCOLOR);
+    return true;
+}
+
+bool PrinterPage::DrawBand(const uint8_t* bgr, int stride, int sheet_width, int sheet_height, int y, int rows) {
+    if (!dc_ || !bgr || rows <= 0 || sheet_height <= 0 || stride != ((sheet_width * 3 + 3) & ~3)) {
+        return false;
+    }
+    BITMAPINFO info = {};
+    FillBitmapInfo(sheet_width, rows, info.bmiHeader);
+    // The printable area starts at the physical offset; draw from the paper
+    // edge instead. Band edges are rounded the same way on both sides so
+    // neighbouring bands meet without a gap.
+    const int top = static_cast<int>(static_cast<int64_t>(y) * height_ / sheet_height);
+    const int bottom = static_cast<int>(static_cast<int64_t>(y + rows) * height_ / sheet_height);
+    const int lines = StretchDIBits(dc_, -offset_x_, top - offset_y_, width_, bottom - top,
+                                    0, 0, sheet_width, rows, bgr, &info, DIB_RGB_COLORS, SRCCOPY);
+    return lines > 0;  // 0 or GDI_ERROR (-1) on failure
+}
+
+bool PrinterPage::FinishPage(bool ok) {
+    if (!dc_) {
+        return false;
+    }
+    ok = EndPage(dc_) > 0 && ok;
+    if (ok) {
+        ok = EndDoc(dc_) > 0;
+    } else {
+        AbortDoc(dc_);
+    }
+    return ok;
+}
+
+bool PrinterPage::Spool(const PrintRaster& raster, const std::wstring& document_name) {
+    if (raster.pixels.empty() || !BeginPage(document_name)) {
+        return false;
+    }
+    const bool ok = DrawBand(raster.pixels.data(), raster.stride, raster.width, raster.height, 0, raster.height);
+    return FinishPage(ok);
+}
+
+bool PrintBmpWriter::Open(const std::wstring& path, int width, int height, int dpi) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    width_ = width;
+    height_ = height;
+    written_ = 0;
+
+    BITMAPINFOHEADER header;
+    FillBitmapInfo(width, height, header);
+    header.biXPelsPerMeter = header.biYPelsPerMeter = static_cast<LONG>(std::lround(dpi / 0.0254));
+
+    BITMAPFILEHEADER file = {};
+    file.bfType = 0x4D42;  // "BM"
+    file.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+    file.bfSize = file.bfOffBits + header.biSizeImage;
+
+    out_.open(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    out_.write(reinterpret_cast<const char*>(&file), sizeof(file));
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return static_cast<bool>(out_);
+}
+
+bool PrintBmpWriter::Write(const uint8_t* bgr, int stride, int rows) {
+    const int row_bytes = (width_ * 3 + 3) & ~3;
+    if (!out_.is_open() || stride < row_bytes || written_ + rows > height_) {
+        return false;
+    }
+    if (stride == row_bytes) {
+        out_.write(reinterpret_cast<const char*>(bgr), static_cast<std::streamsize>(row_bytes) * rows);
+    } else {
+        for (int y = 0; y < rows; ++y) {
+            out_.write(reinterpret_cast<const char*>(bgr + static_cast<size_t>(y) * stride), row_bytes);
+        }
+    }
+    written_ += rows;
+    return static_cast<bool>(out_);
+}
+
+bool PrintBmpWriter::Close() {
+    if (!out_.is_open()) {
+        return false;
+    }
+    const bool ok = static_cast<bool>(out_) && written_ == height_;
+    out_.close();
+    return ok && !out_.fail();
+}
+
+bool WritePrintBmp(const std::wstring& path, const PrintRaster& raster, int dpi) {
+    if (raster.pixels.empty()) {
+        return false;
+    }
+    PrintBmpWriter writer;
+    if (!writer.Open(path, raster.width, raster.height, dpi)) {
+        return false;
+    }
+    const bool ok = writer.Write(raster.pixels.data(), raster.stride, raster.height);
+    return writer.Close() && ok;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "print_raster.h"
+#include <Windows.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One borderless page on a Windows printer, through GDI and the spooler.
+//
+// Open() asks the driver for the paper size and reports the page in device
+// pixels. Render the raster at exactly that size: Spool() then hands it to
+// the driver 1:1 across the whole physical page (margins included, which
+// borderless drivers expect), so nothing is resampled again downstream.
+class PrinterPage {
+public:
+    PrinterPage() = default;
+    ~PrinterPage();
+    PrinterPage(const PrinterPage&) = delete;
+    PrinterPage& operator=(const PrinterPage&) = delete;
+
+    // `printer` empty = the default printer. Landscape when width > height.
+    bool Open(const std::wstring& printer, double width_in, double height_in);
+    void Close();
+
+    const std::wstring& printer_name() const { return name_; }
+    int width() const { return width_; }    // physical page, device pixels
+    int height() const { return height_; }
+    int dpi_x() const { return dpi_x_; }
+    int dpi_y() const { return dpi_y_; }
+
+    // The ICC profile Windows associates with this printer (full path), or
+    // empty if there is none beyond the sRGB fallback.
+    std::wstring color_profile() const;
+
+    // For pages already converted to the printer's profile: turns the
+    // driver's own colour matching off so nothing is corrected twice. Call
+    // after Open() and before BeginPage().
+    bool DisableDriverColor();
+
+    bool Spool(const PrintRaster& raster, const std::wstring& document_name);
+
+    // The same page handed over band by band, top to bottom, so the whole
+    // raster never has to exist at once: BeginPage(), DrawBand() for each
+    // band of a sheet_width x sheet_height BGR image, then FinishPage()
+    // (ok = false aborts the document).
+    bool BeginPage(const std::wstring& document_name);
+    bool DrawBand(const uint8_t* bgr, int stride, int sheet_width, int sheet_height, int y, int rows);
+    bool FinishPage(bool ok);
+
+private:
+    HDC dc_ = nullptr;
+    std::vector<uint8_t> devmode_;  // what dc_ was created with, empty for driver defaults
+    std::wstring name_;
+    int width_ = 0;
+    int height_ = 0;
+    int offset_x_ = 0;
+    int offset_y_ = 0;
+    int dpi_x_ = 0;
+    int dpi_y_ = 0;
+};
+
+// File backend, for tests and for checking output without paper: the raster
+// as a 24-bit BMP tagged with `dpi`.
+bool WritePrintBmp(const std::wstring& path, const PrintRaster& raster, int dpi);
+
+// The same file written band by band, top to bottom.
+class PrintBmpWriter {
+public:
+    bool Open(const std::wstring& path, int width, int height, int dpi);
+    bool Write(const uint8_t* bgr, int stride, int rows);
+    // False if anything failed or fewer rows than `height` were written.
+    bool Close();
+
+private:
+    std::ofstream out_;
+    int width_ = 0;
+    int height_ = 0;
+    int written_ = 0;
+};
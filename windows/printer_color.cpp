@@ -0,0 +1,174 @@
+#include "printer_color.h"
+#include "content_hash.h"
+#include "disk_cache.h"
+#include <Windows.h>
+#include <icm.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kGridSize = 52;         // 255 / 51: nodes on 8-bit values
+constexpr uint32_t kBakeVersion = 1;  // bump when the baking changes
+constexpr size_t kRecent = 4;
+constexpr size_t kMaxProfileBytes = 16u << 20;
+constexpr wchar_t kExtension[] = L".sflut";
+constexpr wchar_t kSrgbProfile[] = L"sRGB Color Space Profile.icm";  // in the system colour directory
+
+struct BakeTag {
+    uint32_t version;
+    int32_t grid;
+    int32_t intent;
+};
+
+bool ReadProfile(const std::wstring& path, std::vector<uint8_t>& out) {
+    std::ifstream in(fs::path(path), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return out.size() <= kMaxProfileBytes;
+}
+
+// The table maps to the printer's device RGB, so a CMYK or gray profile has
+// nothing to give the RGB spooling path.
+bool IsRgbProfile(const std::vector<uint8_t>& profile) {
+    return profile.size() >= 128 && std::memcmp(profile.data() + 16, "RGB ", 4) == 0;
+}
+
+// Runs every grid node through ICM: one (size^2 x size) bitmap, red fastest
+// along a row and blue down the rows, which is the table's own order.
+bool BakeTransform(const std::vector<uint8_t>& profile, int intent, ColorLut& out) {
+    PROFILE source{};
+    source.dwType = PROFILE_FILENAME;
+    source.pProfileData = const_cast<wchar_t*>(kSrgbProfile);
+    source.cbDataSize = sizeof(kSrgbProfile);
+    PROFILE target{};
+    target.dwType = PROFILE_MEMBUFFER;
+    target.pProfileData = const_cast<uint8_t*>(profile.data());
+    target.cbDataSize = static_cast<DWORD>(profile.size());
+
+    HPROFILE profiles[2] = {OpenColorProfileW(&source, PROFILE_READ, FILE_SHARE_READ, OPEN_EXISTING),
+                            OpenColorProfileW(&target, PROFILE_READ, FILE_SHARE_READ, OPEN_EXISTING)};
+    HTRANSFORM transform = nullptr;
+    if (profiles[0] && profiles[1]) {
+        DWORD intents[1] = {static_cast<DWORD>(intent)};
+        transform = CreateMultiProfileTransform(profiles, 2, intents, 1, BEST_MODE, INDEX_DONT_CARE);
+    }
+
+    bool ok = false;
+    if (transform) {
+        const int n = kGridSize;
+        const int width = n * n;
+        const DWORD stride = static_cast<DWORD>(width * 3);
+        std::vector<uint8_t> nodes(static_cast<size_t>(stride) * n);
+        for (int b = 0; b < n; ++b) {
+            uint8_t* row = nodes.data() + static_cast<size_t>(b) * stride;
+            for (int x = 0; x < width; ++x) {
+                // BM_RGBTRIPLETS is the DIB byte order: B, G, R
+                row[x * 3 + 0] = static_cast<uint8_t>(b * 255 / (n - 1));
+                row[x * 3 + 1] = static_cast<uint8_t>(x / n * 255 / (n - 1));
+                row[x * 3 + 2] = static_cast<uint8_t>(x % n * 255 / (n - 1));
+            }
+        }
+        std::vector<uint8_t> mapped(nodes.size());
+        if (TranslateBitmapBits(transform, nodes.data(), BM_RGBTRIPLETS, width, n, stride, mapped.data(),
+                                BM_RGBTRIPLETS, stride, nullptr, 0)) {
+            std::vector<float> rgb(static_cast<size_t>(width) * n * 3);
+            for (size_t i = 0; i < rgb.size(); i += 3) {
+                rgb[i + 0] = mapped[i + 2] / 255.0f;
+                rgb[i + 1] = mapped[i + 1] / 255.0f;
+                rgb[i + 2] = mapped[i + 0] / 255.0f;
+            }
+            ok = out.Build(n, rgb);
+        }
+        DeleteColorTransform(transform);
+    }
+    for (HPROFILE handle : profiles) {
+        if (handle) {
+            CloseColorProfile(handle);
+        }
+    }
+    return ok;
+}
+
+}  // namespace
+
+bool PrinterColorTransforms::Configure(const std::wstring& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_.clear();
+    if (directory.empty()) {
+        return true;
+    }
+
+    if (!PrepareDiskCacheDirectory(directory)) {
+        return false;
+    }
+    dir_ = directory;
+    return true;
+}
+
+std::shared_ptr<const ColorLut> PrinterColorTransforms::Get(const std::wstring& profile_path, int intent) {
+    if (intent < kPerceptual || intent > kAbsoluteColorimetric) {
+        return nullptr;
+    }
+    std::vector<uint8_t> profile;
+    if (!ReadProfile(profile_path, profile) || !IsRgbProfile(profile)) {
+        std::cerr << "[ERR] Printer profile is not a readable RGB ICC profile\n";
+        return nullptr;
+    }
+    const BakeTag tag{kBakeVersion, kGridSize, intent};
+    const uint64_t key = HashBytes(&tag, sizeof(tag), HashBytes(profile.data(), profile.size()));
+
+    std::wstring path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < recent_.size(); ++i) {
+            if (recent_[i].key == key) {
+                std::rotate(recent_.begin(), recent_.begin() + i, recent_.begin() + i + 1);
+                ++stats_.memory_hits;
+                return recent_.front().lut;
+            }
+        }
+        if (!dir_.empty()) {
+            path = DiskCachePath(dir_, key, kExtension);
+        }
+    }
+
+    auto lut = std::make_shared<ColorLut>();
+    bool from_disk = !path.empty() && lut->Load(path);
+    if (!from_disk) {
+        const auto started = std::chrono::steady_clock::now();
+        if (!BakeTransform(profile, intent, *lut)) {
+            std::cerr << "[ERR] ICM could not build the printer colour transform\n";
+            return nullptr;
+        }
+        const auto ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+        std::cout << "[OK] Printer colour transform baked: intent " << intent << ", " << ms << " ms\n";
+
+        if (!path.empty()) {
+            ReplaceDiskCacheEntry(path, [&](const std::wstring& temp) { return lut->Save(temp); });
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++(from_disk ? stats_.disk_hits : stats_.baked);
+    recent_.insert(recent_.begin(), Entry{key, lut});
+    if (recent_.size() > kRecent) {
+        recent_.pop_back();
+    }
+    return lut;
+}
+
+PrinterColorTransforms::Stats PrinterColorTransforms::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "color_lut.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// sRGB -> printer ICC profile transforms, baked into 3D LUTs.
+//
+// Windows colour management (ICM) builds the transform from the two
+// profiles; it is then evaluated once per grid node and kept as a ColorLut,
+// so a print only pays for one pass of the SIMD lut3d kernel (a few ms for a
+// 4 x 6 page) instead of the CMM per pixel. The grid has 52 points per axis,
+// so every node sits on an 8-bit value (0, 5, ..., 255).
+//
+// Baked tables are kept in memory and, once Configure()d, as files keyed by
+// the profile's content and the rendering intent: the next run, or another
+// booth with the same profile, reads about 1 MB instead of running the CMM.
+// A changed profile hashes differently, so stale tables are never used.
+// Thread-safe.
+class PrinterColorTransforms {
+public:
+    // ICC rendering intents, in the profile header's numbering
+    enum Intent { kPerceptual = 0, kRelativeColorimetric = 1, kSaturation = 2, kAbsoluteColorimetric = 3 };
+
+    struct Stats {
+        uint64_t baked = 0;        // built through ICM
+        uint64_t disk_hits = 0;
+        uint64_t memory_hits = 0;
+    };
+
+    PrinterColorTransforms() = default;
+    PrinterColorTransforms(const PrinterColorTransforms&) = delete;
+    PrinterColorTransforms& operator=(const PrinterColorTransforms&) = delete;
+
+    // Keep baked tables in `directory` (created if needed). Empty keeps them
+    // in memory only.
+    bool Configure(const std::wstring& directory);
+
+    // The transform for an .icc / .icm file, or null if the profile cannot be
+    // read or ICM rejects it.
+    std::shared_ptr<const ColorLut> Get(const std::wstring& profile_path, int intent);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const ColorLut> lut;
+    };
+
+    mutable std::mutex mutex_;
+    std::wstring dir_;
+    std::vector<Entry> recent_;  // most recent first
+    Stats stats_;
+};
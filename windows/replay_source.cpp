@@ -0,0 +1,82 @@
+#include "replay_source.h"
+#include <algorithm>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+bool ReplaySource::Open(const std::wstring& directory, int frame_interval_ms) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(fs::path(directory), ec)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::wstring ext = entry.path().extension().wstring();
+        std::transform(ext.begin(), ext.end(), ext.begin(), std::towlower);
+        if (ext == L".jpg" || ext == L".jpeg") {
+            files.push_back(entry.path());
+        }
+    }
+    if (ec || files.empty()) {
+        std::cerr << "[ERR] Replay directory has no JPEG frames\n";
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::vector<unsigned char>> frames;
+    frames.reserve(files.size());
+    for (const auto& path : files) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)),
+                                         std::istreambuf_iterator<char>());
+        if (!bytes.empty()) {
+            frames.push_back(std::move(bytes));
+        }
+    }
+    if (frames.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_.swap(frames);
+    cursor_ = 0;
+    served_ = 0;
+    interval_ = std::chrono::milliseconds(std::max(1, frame_interval_ms));
+    next_ready_ = std::chrono::steady_clock::now();
+    std::cout << "[OK] Replay source loaded " << frames_.size() << " frames\n";
+    return true;
+}
+
+size_t ReplaySource::frame_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_.size();
+}
+
+uint64_t ReplaySource::frames_served() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return served_;
+}
+
+bool ReplaySource::Next(std::vector<unsigned char>& out) {
+    std::chrono::steady_clock::time_point ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (frames_.empty()) {
+            return false;
+        }
+        ready = next_ready_;
+    }
+    std::this_thread::sleep_until(ready);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out = frames_[cursor_];
+    cursor_ = (cursor_ + 1) % frames_.size();
+    served_++;
+    next_ready_ = std::max(next_ready_ + interval_, std::chrono::steady_clock::now());
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Camera-less EVF source: replays a directory of JPEG frames (e.g. a recorded
+// live view session) at a fixed pace, so the capture pipeline, idle mode and
+// consumers can be exercised and benchmarked without a Canon body attached.
+class ReplaySource {
+public:
+    // Loads every .jpg/.jpeg in `directory`, sorted by file name.
+    // frame_interval_ms emulates how often the camera has a new EVF frame.
+    bool Open(const std::wstring& directory, int frame_interval_ms);
+
+    size_t frame_count() const;
+    uint64_t frames_served() const;
+
+    // Copies the next frame into `out`, blocking until it is "ready" like
+    // EdsDownloadEvfImage would. Loops back to the first frame at the end.
+    bool Next(std::vector<unsigned char>& out);
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::vector<unsigned char>> frames_;
+    size_t cursor_ = 0;
+    uint64_t served_ = 0;
+    std::chrono::milliseconds interval_{33};
+    std::chrono::steady_clock::time_point next_ready_{};
+};
@@ -0,0 +1,250 @@
+#include "shm_region.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#endif
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    Close();
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+static std::wstring MappingName(const std::string& name) {
+    std::wstring wide = L"Local\\";
+    wide.append(name.begin(), name.end());  // identifiers are ASCII
+    return wide;
+}
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size) {
+    Close();
+    const unsigned long long size64 = size;
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64),
+                                        MappingName(name).c_str());
+    if (!mapping) {
+        return false;
+    }
+    // An existing section keeps its own size, whatever was asked for: map all
+    // of it and report that
+    const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, existed ? 0 : size);
+    size_t mapped = size;
+    if (view && existed) {
+        MEMORY_BASIC_INFORMATION info = {};
+        mapped = VirtualQuery(view, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+    }
+    if (!view || mapped < size) {
+        if (view) UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = static_cast<uint8_t*>(view);
+    size_ = mapped;
+    owner_ = !existed;
+    existed_ = existed;
+    name_ = name;
+    return true;
+}
+
+bool SharedMemoryRegion::OpenReadOnly(const std::string& name) {
+    Close();
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, MappingName(name).c_str());
+    if (!mapping) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (!view || VirtualQuery(view, &info, sizeof(info)) == 0) {
+        if (view) UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = static_cast<uint8_t*>(view);
+    size_ = info.RegionSize;
+    owner_ = false;
+    name_ = name;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        // The section goes away with its last handle.
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    size_ = 0;
+    owner_ = false;
+    existed_ = false;
+}
+
+bool MappedFile::Open(const std::wstring& path) {
+    Close();
+    // Others may read and delete (prune) the file while it is mapped
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_) {
+        CloseHandle(file_);
+        file_ = nullptr;
+    }
+    size_ = 0;
+}
+
+#else
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size) {
+    Close();
+    const std::string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    const bool existed = fd < 0 && errno == EEXIST;
+    if (existed) {
+        fd = shm_open(path.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    // An existing region keeps its own size; one of ours is sized here
+    size_t mapped = size;
+    struct stat st = {};
+    const bool sized = existed ? fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= size
+                               : ftruncate(fd, static_cast<off_t>(size)) == 0;
+    if (existed && sized) {
+        mapped = static_cast<size_t>(st.st_size);
+    }
+    void* view = sized ? mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (view == MAP_FAILED) {
+        close(fd);
+        if (!existed) {
+            shm_unlink(path.c_str());
+        }
+        return false;
+    }
+    fd_ = fd;
+    data_ = static_cast<uint8_t*>(view);
+    size_ = mapped;
+    owner_ = !existed;
+    existed_ = existed;
+    name_ = name;
+    return true;
+}
+
+bool SharedMemoryRegion::OpenReadOnly(const std::string& name) {
+    Close();
+    const std::string path = "/" + name;
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    data_ = static_cast<uint8_t*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+    owner_ = false;
+    name_ = name;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data_) {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    if (owner_) {
+        // Readers keep their mappings; new readers can no longer attach.
+        shm_unlink(("/" + name_).c_str());
+    }
+    size_ = 0;
+    owner_ = false;
+    existed_ = false;
+}
+
+bool MappedFile::Open(const std::wstring& path) {
+    Close();
+    int fd = open(std::filesystem::path(path).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);  // the mapping keeps the file
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+    }
+    size_ = 0;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Named shared memory, the same on Windows (file mapping in the session's
+// Local\ namespace) and POSIX (shm_open), so the frame ring and its readers
+// can also be exercised on Linux.
+//
+// `name` is a plain identifier such as "sface_evf"; the platform prefix is
+// added here.
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    // Create a region of `size` bytes, mapped read/write. If the name is
+    // already taken, that region is mapped whole instead and existed() is
+    // true: size() is then its own size (page-rounded on Windows), never less
+    // than `size`, and the caller must check what is in it before writing.
+    // Only a region this call created is removed again on Close() (POSIX).
+    bool Create(const std::string& name, size_t size);
+    // Map an existing region read-only; size() reports its full size.
+    bool OpenReadOnly(const std::string& name);
+    void Close();
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return data_ != nullptr; }
+    bool existed() const { return existed_; }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool owner_ = false;
+    bool existed_ = false;
+    std::string name_;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// A whole file mapped read-only. Pages are read from the OS page cache as
+// they are first touched, so opening a large file costs nothing up front.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return data_ != nullptr; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
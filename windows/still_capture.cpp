@@ -0,0 +1,431 @@
+#include "still_capture.h"
+#include "precise_timer.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+static uint64_t MicrosBetween(StillCapture::Clock::time_point from, StillCapture::Clock::time_point to) {
+    if (to <= from) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+StillCapture::~StillCapture() {
+    Detach();
+}
+
+bool StillCapture::Attach(EdsdkBridge* sdk, EdsCameraRef camera, std::mutex* sdk_mutex) {
+    if (sdk_) {
+        return true;
+    }
+    if (!sdk || !camera || !sdk_mutex) {
+        return false;
+    }
+    if (!sdk->EdsSendCommand || !sdk->EdsSetObjectEventHandler || !sdk->EdsGetDirectoryItemInfo ||
+        !sdk->EdsDownload || !sdk->EdsDownloadComplete || !sdk->EdsDownloadCancel) {
+        std::cerr << "[ERR] EDSDK.dll lacks the still transfer functions\n";
+        return false;
+    }
+
+    sdk_ = sdk;
+    camera_ = camera;
+    sdk_mutex_ = sdk_mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+        pending_.clear();
+        transfers_.clear();
+        completed_.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+        EdsUInt32 save_to = kEdsSaveTo_Host;
+        EdsError err = sdk_->EdsSetPropertyData(camera_, kEdsPropID_SaveTo, 0, sizeof(save_to), &save_to);
+        if (err == EDS_ERR_OK && sdk_->EdsSetCapacity) {
+            // With SaveTo=Host the body checks host free space before it
+            // will shoot; report plenty.
+            EdsCapacity capacity = {0x7FFFFFFF, 0x1000, 1};
+            err = sdk_->EdsSetCapacity(camera_, capacity);
+        }
+        if (err == EDS_ERR_OK) {
+            err = sdk_->EdsSetObjectEventHandler(camera_, kEdsObjectEvent_All, &StillCapture::OnObjectEvent,
+                                                 reinterpret_cast<EdsVoid*>(this));
+        }
+        if (err != EDS_ERR_OK) {
+            std::cerr << "[ERR] Still capture setup failed: 0x" << std::hex << (unsigned)err << std::dec << "\n";
+            sdk_ = nullptr;
+            camera_ = nullptr;
+            sdk_mutex_ = nullptr;
+            return false;
+        }
+    }
+
+    worker_ = std::thread(&StillCapture::WorkerLoop, this);
+    return true;
+}
+
+void StillCapture::Detach() {
+    if (!sdk_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+    sdk_->EdsSetObjectEventHandler(camera_, kEdsObjectEvent_All, nullptr, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Transfer& transfer : transfers_) {
+        sdk_->EdsDownloadCancel(transfer.item);
+        sdk_->EdsRelease(transfer.item);
+    }
+    transfers_.clear();
+    pending_.clear();
+    completed_.clear();
+
+    sdk_ = nullptr;
+    camera_ = nullptr;
+    sdk_mutex_ = nullptr;
+}
+
+bool StillCapture::SetSpoolDirectory(const std::wstring& directory) {
+    if (!directory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (!std::filesystem::is_directory(directory, ec)) {
+            std::cerr << "[ERR] Still spool directory is not usable\n";
+            return false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    spool_dir_ = directory;
+    return true;
+}
+
+int64_t StillCapture::TakePicture() {
+    return TakePictureAt(Clock::now(), true, nullptr);
+}
+
+int64_t StillCapture::TakePictureAt(Clock::time_point fire_at, bool autofocus, FireTiming* timing,
+                                    int burst_index) {
+    if (!sdk_) {
+        return -1;
+    }
+
+    // Queue the shot before firing: the transfer event can arrive on another
+    // thread before EdsSendCommand even returns.
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        pending_.push_back({id, fire_at, burst_index});
+    }
+
+    if (fire_at - kLockLead > Clock::now()) {
+        SleepUntil(fire_at - kLockLead);
+    }
+
+    const EdsInt32 press = autofocus ? kEdsCameraCommand_ShutterButton_Completely
+                                     : kEdsCameraCommand_ShutterButton_Completely_NonAF;
+    EdsError err = EDS_ERR_DEVICE_BUSY;
+    Clock::time_point issued_at{};
+    Clock::time_point returned_at{};
+    for (int attempt = 0; attempt < 10 && err == EDS_ERR_DEVICE_BUSY; ++attempt) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+        if (attempt == 0) {
+            SleepUntil(fire_at);
+        }
+        issued_at = Clock::now();
+        err = sdk_->EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, press);
+        returned_at = Clock::now();
+        if (err == EDS_ERR_OK) {
+            sdk_->EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton,
+                                 kEdsCameraCommand_ShutterButton_OFF);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (err != EDS_ERR_OK) {
+        pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                      [id](const Pending& p) { return p.id == id; }),
+                       pending_.end());
+        std::cerr << "[ERR] Shutter command failed: 0x" << std::hex << (unsigned)err << std::dec << "\n";
+        return -3;
+    }
+    for (Pending& pending : pending_) {
+        if (pending.id == id) pending.fired_at = issued_at;
+    }
+    if (timing) {
+        timing->issued_at = issued_at;
+        timing->command_us = MicrosBetween(issued_at, returned_at);
+    }
+    cv_.notify_all();
+    return static_cast<int64_t>(id);
+}
+
+bool StillCapture::PressHalfway() {
+    if (!sdk_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+    return sdk_->EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton,
+                                kEdsCameraCommand_ShutterButton_Halfway) == EDS_ERR_OK;
+}
+
+void StillCapture::ReleaseShutter() {
+    if (!sdk_) {
+        return;
+    }
+    std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+    sdk_->EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+}
+
+bool StillCapture::PopCompleted(Shot& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_.empty()) {
+        return false;
+    }
+    out = std::move(completed_.front());
+    completed_.pop_front();
+    return true;
+}
+
+size_t StillCapture::outstanding() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size() + transfers_.size();
+}
+
+// Called by EDSDK from inside whatever SDK call dispatches events (our
+// EdsGetEvent pump or the UI thread's message loop). Only hands the item over.
+EdsError __stdcall StillCapture::OnObjectEvent(EdsUInt32 event, EdsBaseRef ref, EdsVoid* context) {
+    StillCapture* self = reinterpret_cast<StillCapture*>(context);
+    if (!self || !ref) {
+        return EDS_ERR_OK;
+    }
+
+    if (event == kEdsObjectEvent_DirItemRequestTransfer) {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (!self->stop_) {
+            self->transfers_.push_back({ref, Clock::now()});
+            self->cv_.notify_all();
+            return EDS_ERR_OK;
+        }
+    }
+
+    self->sdk_->EdsRelease(ref);
+    return EDS_ERR_OK;
+}
+
+void StillCapture::PumpEvents() {
+    if (!sdk_->EdsGetEvent) {
+        return;
+    }
+    std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+    sdk_->EdsGetEvent();
+}
+
+void StillCapture::Complete(Shot&& shot) {
+    if (shot.error == 0) {
+        std::cout << "[OK] Still " << shot.id << " (" << shot.file_name
+                  << (shot.path.empty() ? ", in memory" : ", spooled") << ") ready "
+                  << shot.total_us / 1000 << " ms after shutter\n";
+    } else {
+        std::cerr << "[ERR] Still " << shot.id << " failed: " << shot.error << "\n";
+    }
+    completed_.push_back(std::move(shot));
+    // Nobody is collecting; keep memory bounded.
+    while (completed_.size() > kMaxCompleted) {
+        completed_.pop_front();
+    }
+}
+
+void StillCapture::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (!transfers_.empty()) {
+            const Transfer transfer = transfers_.front();
+            transfers_.pop_front();
+
+            Shot shot;
+            Clock::time_point fired_at = transfer.event_at;  // pressed on the body
+            if (!pending_.empty()) {
+                shot.id = pending_.front().id;
+                shot.burst_index = pending_.front().burst_index;
+                fired_at = pending_.front().fired_at;
+                pending_.pop_front();
+            }
+
+            lock.unlock();
+            shot.error = Download(transfer.item, shot);
+            const auto done = Clock::now();
+            shot.shutter_to_event_us = MicrosBetween(fired_at, transfer.event_at);
+            shot.download_us = MicrosBetween(transfer.event_at, done);
+            shot.total_us = MicrosBetween(fired_at, done);
+            lock.lock();
+
+            Complete(std::move(shot));
+            continue;
+        }
+
+        // Shots whose file never showed up (card-less body refused, AF failed)
+        const auto now = Clock::now();
+        while (!pending_.empty() && now - pending_.front().fired_at > kEventTimeout) {
+            Shot shot;
+            shot.id = pending_.front().id;
+            shot.burst_index = pending_.front().burst_index;
+            shot.error = -6;
+            pending_.pop_front();
+            Complete(std::move(shot));
+        }
+
+        if (pending_.empty()) {
+            cv_.wait(lock, [this] { return stop_ || !transfers_.empty() || !pending_.empty(); });
+            continue;
+        }
+
+        // Waiting for a transfer request: make sure events get dispatched
+        // even if no thread of the host app pumps messages.
+        lock.unlock();
+        PumpEvents();
+        lock.lock();
+        cv_.wait_for(lock, kPumpInterval, [this] { return stop_ || !transfers_.empty(); });
+    }
+}
+
+// Spool file for a shot: "<dir>\\000042_IMG_1234.JPG". The id prefix keeps
+// names unique when the body's file counter wraps or a card is swapped.
+static std::filesystem::path SpoolPath(const std::wstring& directory, uint64_t id, const std::string& file_name) {
+    wchar_t prefix[32];
+    swprintf(prefix, 32, L"%06llu_", static_cast<unsigned long long>(id));
+    std::wstring name = prefix;
+    name.append(file_name.begin(), file_name.end());  // camera names are ASCII
+    return std::filesystem::path(directory) / name;
+}
+
+// Pull one file from the camera. The SDK lock is held per chunk only, so EVF
+// downloads interleave with the transfer. Always consumes `item`.
+//
+// With a spool directory the SDK writes each chunk straight to the file, so
+// a shot never sits in the heap no matter how large it is or how many are
+// queued; otherwise it lands in a memory stream.
+int StillCapture::Download(EdsDirectoryItemRef item, Shot& shot) {
+    std::wstring spool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spool = spool_dir_;
+    }
+
+    EdsDirectoryItemInfo info = {};
+    EdsStreamRef stream = nullptr;
+    std::filesystem::path path;
+    {
+        std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+        if (sdk_->EdsGetDirectoryItemInfo(item, &info) != EDS_ERR_OK || info.size == 0) {
+            sdk_->EdsDownloadCancel(item);
+            sdk_->EdsRelease(item);
+            return -4;
+        }
+        shot.file_name.assign(info.szFileName, strnlen(info.szFileName, sizeof(info.szFileName)));
+
+        EdsError err = EDS_ERR_OK;
+        if (spool.empty()) {
+            err = sdk_->EdsCreateMemoryStream(info.size, &stream);
+        } else {
+            path = SpoolPath(spool, shot.id, shot.file_name);
+            if (sdk_->EdsCreateFileStreamEx) {
+                const std::wstring wide = path.wstring();
+                err = sdk_->EdsCreateFileStreamEx(wide.c_str(), kEdsFileCreateDisposition_CreateAlways,
+                                                  kEdsAccess_ReadWrite, &stream);
+            } else if (sdk_->EdsCreateFileStream) {
+                // Pre-Ex SDKs only take ANSI paths
+                try {
+                    const std::string narrow = path.string();
+                    err = sdk_->EdsCreateFileStream(narrow.c_str(), kEdsFileCreateDisposition_CreateAlways,
+                                                    kEdsAccess_ReadWrite, &stream);
+                } catch (const std::exception&) {
+                    // Not representable in the ANSI code page; stream stays null
+                }
+            }
+        }
+        if (err != EDS_ERR_OK || !stream) {
+            sdk_->EdsDownloadCancel(item);
+            sdk_->EdsRelease(item);
+            return -3;
+        }
+    }
+
+    EdsError err = EDS_ERR_OK;
+    EdsUInt64 remaining = info.size;
+    int busy_retries = 0;
+    while (remaining > 0 && err == EDS_ERR_OK) {
+        const EdsUInt64 chunk = std::min(remaining, kChunkBytes);
+        {
+            std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+            err = sdk_->EdsDownload(item, chunk, stream);
+        }
+        if (err == EDS_ERR_DEVICE_BUSY && ++busy_retries < 50) {
+            err = EDS_ERR_OK;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        if (err == EDS_ERR_OK) {
+            remaining -= chunk;
+        }
+        if (stop_) {
+            err = EDS_ERR_DEVICE_BUSY;
+        }
+    }
+
+    int rc = 0;
+    {
+        std::lock_guard<std::mutex> sdk_lock(*sdk_mutex_);
+        if (err == EDS_ERR_OK) {
+            err = sdk_->EdsDownloadComplete(item);
+        } else {
+            sdk_->EdsDownloadCancel(item);
+        }
+
+        if (err != EDS_ERR_OK) {
+            rc = -5;
+        } else if (path.empty()) {
+            EdsVoid* ptr = nullptr;
+            EdsUInt64 len = 0;
+            sdk_->EdsGetPointer(stream, &ptr);
+            sdk_->EdsGetLength(stream, &len);
+            if (!ptr || len == 0) {
+                rc = -6;
+            } else {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(ptr);
+                shot.data = std::make_shared<const std::vector<unsigned char>>(bytes, bytes + len);
+            }
+        }
+
+        // Releasing a file stream closes the file.
+        sdk_->EdsRelease(stream);
+        sdk_->EdsRelease(item);
+    }
+
+    if (!path.empty()) {
+        if (rc == 0) {
+            shot.path = path.wstring();
+        } else {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    }
+    return rc;
+}
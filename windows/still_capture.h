@@ -0,0 +1,113 @@
+#pragma once
+#include "frame_types.h"
+#include "../native_probe/edsdk_bridge.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Still capture with SaveTo=Host. The shutter is fired from the caller's
+// thread; the camera then announces the new file with an object event and a
+// worker thread pulls it over in chunks. The SDK lock is released between
+// chunks so the EVF capture thread keeps getting frames during a transfer.
+//
+// Files are matched to shutter presses in FIFO order (the camera does not
+// tag them), so each finished shot carries its own latency breakdown. A
+// single worker transfers them in arrival order, so shots complete in the
+// order they were fired.
+class StillCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Shot {
+        uint64_t id = 0;           // 0 when the shutter was pressed on the body
+        int error = 0;             // 0 ok, negative on failure (no data)
+        int burst_index = -1;      // position within a burst, -1 for single shots
+        JpegBytes data;            // memory transfer
+        std::wstring path;         // spooled transfer (data stays null)
+        std::string file_name;
+        uint64_t shutter_to_event_us = 0;
+        uint64_t download_us = 0;
+        uint64_t total_us = 0;     // shutter command -> file available on host
+    };
+
+    StillCapture() = default;
+    ~StillCapture();
+    StillCapture(const StillCapture&) = delete;
+    StillCapture& operator=(const StillCapture&) = delete;
+
+    // Route captures to the host and start the transfer worker. `sdk_mutex`
+    // is the lock every EDSDK call on this session is serialized with.
+    bool Attach(EdsdkBridge* sdk, EdsCameraRef camera, std::mutex* sdk_mutex);
+    // Cancels outstanding transfers and unregisters the event handler.
+    // Call before the session is closed.
+    void Detach();
+    bool attached() const { return sdk_ != nullptr; }
+
+    // Transfer stills straight into files under `directory` (created if
+    // needed) instead of heap buffers. Empty switches back to memory.
+    bool SetSpoolDirectory(const std::wstring& directory);
+
+    struct FireTiming {
+        Clock::time_point issued_at{};  // when the release command went out
+        uint64_t command_us = 0;        // release command round trip
+    };
+
+    // Full shutter press (with AF). Returns the shot id (> 0) or a negative
+    // error code if the camera refused the command.
+    int64_t TakePicture();
+    // Full press issued as close to `fire_at` as possible. The SDK lock is
+    // taken shortly before so an EVF download in flight cannot delay it.
+    // Skip AF when the body was already focused with PressHalfway().
+    int64_t TakePictureAt(Clock::time_point fire_at, bool autofocus, FireTiming* timing,
+                          int burst_index = -1);
+
+    // Half-press (AF/AE lock) and release, for prefocusing ahead of a shot.
+    bool PressHalfway();
+    void ReleaseShutter();
+
+    // Oldest finished shot, if any.
+    bool PopCompleted(Shot& out);
+    size_t outstanding() const;
+
+private:
+    struct Pending {
+        uint64_t id;
+        Clock::time_point fired_at;
+        int burst_index;
+    };
+    struct Transfer {
+        EdsDirectoryItemRef item;
+        Clock::time_point event_at;
+    };
+
+    static EdsError __stdcall OnObjectEvent(EdsUInt32 event, EdsBaseRef ref, EdsVoid* context);
+    void WorkerLoop();
+    int Download(EdsDirectoryItemRef item, Shot& shot);
+    void PumpEvents();
+    void Complete(Shot&& shot);
+
+    static constexpr EdsUInt64 kChunkBytes = 1024 * 1024;
+    static constexpr auto kEventTimeout = std::chrono::seconds(20);
+    static constexpr auto kPumpInterval = std::chrono::milliseconds(20);
+    static constexpr auto kLockLead = std::chrono::milliseconds(60);
+    static constexpr size_t kMaxCompleted = 16;
+
+    EdsdkBridge* sdk_ = nullptr;
+    EdsCameraRef camera_ = nullptr;
+    std::mutex* sdk_mutex_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> pending_;      // shutter fired, no file yet
+    std::deque<Transfer> transfers_;   // file announced, not downloaded
+    std::deque<Shot> completed_;
+    std::wstring spool_dir_;
+    uint64_t next_id_ = 1;
+    std::atomic<bool> stop_{false};  // also polled between download chunks
+    std::thread worker_;
+};
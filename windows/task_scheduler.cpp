@@ -0,0 +1,253 @@
+#include "task_scheduler.h"
+#ifdef _WIN32
+#include <Windows.h>
+#include <objbase.h>
+#endif
+#include <iostream>
+
+// Identity of the current thread within a pool (-1: not a worker)
+static thread_local TaskScheduler* t_scheduler = nullptr;
+static thread_local int t_worker = -1;
+
+TaskScheduler& TaskScheduler::Instance() {
+    // Never destroyed: joining threads from a static destructor during DLL
+    // unload would deadlock on the loader lock.
+    static TaskScheduler* instance = new TaskScheduler();
+    return *instance;
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+}
+
+bool TaskScheduler::Configure(int workers) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (started_) {
+        return false;
+    }
+    configured_workers_ = workers;
+    return true;
+}
+
+int TaskScheduler::worker_count() {
+    EnsureStarted();
+    return static_cast<int>(workers_.size());
+}
+
+void TaskScheduler::EnsureStarted() {
+    if (started_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    if (started_) {
+        return;
+    }
+
+    int count = configured_workers_;
+    if (count <= 0) {
+        count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    // The deques must exist before any worker can try to steal from them
+    for (int i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < count; ++i) {
+        workers_[i]->thread = std::thread(&TaskScheduler::WorkerLoop, this, i);
+    }
+    started_ = true;
+}
+
+void TaskScheduler::Submit(std::function<void()> fn, Priority priority, TaskGroup* group) {
+    EnsureStarted();
+    Task task{std::move(fn), group, priority};
+    if (t_scheduler == this && t_worker >= 0) {
+        Worker& self = *workers_[t_worker];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        self.lanes[priority].push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        inject_[priority].push_back(std::move(task));
+    }
+    ++queued_;
+
+    // Taking the lock orders this with a worker checking queued_ before it sleeps
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+}
+
+bool TaskScheduler::FindTask(Priority lowest, Task& out) {
+    const int n = static_cast<int>(workers_.size());
+    const bool is_worker = t_scheduler == this && t_worker >= 0;
+
+    for (int p = kHigh; p <= lowest; ++p) {
+        // Own deque, newest first
+        if (is_worker) {
+            Worker& self = *workers_[t_worker];
+            std::lock_guard<std::mutex> lock(self.mutex);
+            if (!self.lanes[p].empty()) {
+                out = std::move(self.lanes[p].back());
+                self.lanes[p].pop_back();
+                --queued_;
+                return true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(inject_mutex_);
+            if (!inject_[p].empty()) {
+                out = std::move(inject_[p].front());
+                inject_[p].pop_front();
+                --queued_;
+                return true;
+            }
+        }
+        // Steal the oldest task of another worker
+        const int start = is_worker ? t_worker + 1 : 0;
+        for (int k = 0; k < n; ++k) {
+            const int victim = (start + k) % n;
+            if (is_worker && victim == t_worker) {
+                continue;
+            }
+            Worker& w = *workers_[victim];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (!w.lanes[p].empty()) {
+                out = std::move(w.lanes[p].front());
+                w.lanes[p].pop_front();
+                --queued_;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::Execute(Task& task) {
+#ifdef _WIN32
+    static thread_local bool below_normal = false;
+    const bool background = task.priority == kBackground;
+    if (background != below_normal) {
+        SetThreadPriority(GetCurrentThread(),
+                          background ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_NORMAL);
+        below_normal = background;
+    }
+#endif
+
+    try {
+        task.fn();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERR] Exception in native task: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "[ERR] Unknown exception in native task\n";
+    }
+    task.fn = nullptr;
+    if (task.group) {
+        task.group->Done();
+    }
+}
+
+void TaskScheduler::WorkerLoop(int index) {
+    t_scheduler = this;
+    t_worker = index;
+#ifdef _WIN32
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    const bool needUninit = SUCCEEDED(hr);
+#endif
+
+    while (true) {
+        Task task;
+        if (FindTask(kBackground, task)) {
+            Execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_) {
+            break;
+        }
+    }
+
+#ifdef _WIN32
+    if (needUninit) CoUninitialize();
+#endif
+}
+
+void TaskScheduler::TaskGroup::Run(std::function<void()> fn) {
+    ++pending_;
+    scheduler_.Submit(std::move(fn), priority_, this);
+}
+
+void TaskScheduler::TaskGroup::Done() {
+    // Decrement under the lock: once a waiter holds it and sees zero, no
+    // finishing task touches the group any more.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+        cv_.notify_all();
+    }
+}
+
+void TaskScheduler::TaskGroup::Wait() {
+    if (t_scheduler == &scheduler_ && t_worker >= 0) {
+        // A worker keeps working while it waits, otherwise nested groups
+        // could tie up every thread.
+        while (pending_ > 0) {
+            Task task;
+            if (scheduler_.FindTask(priority_, task)) {
+                scheduler_.Execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(1), [this] { return pending_ == 0; });
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+int TaskScheduler::TaskGraph::Add(std::function<void()> fn, const std::vector<int>& deps) {
+    const int id = static_cast<int>(nodes_.size());
+    auto node = std::make_unique<Node>();
+    node->fn = std::move(fn);
+    for (int d : deps) {
+        if (d >= 0 && d < id) {
+            nodes_[d]->successors.push_back(id);
+            ++node->remaining;
+        }
+    }
+    nodes_.push_back(std::move(node));
+    return id;
+}
+
+void TaskScheduler::TaskGraph::Run() {
+    // Collect the roots first: started tasks may already release others
+    std::vector<int> roots;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i]->remaining == 0) {
+            roots.push_back(static_cast<int>(i));
+        }
+    }
+    for (int id : roots) {
+        Start(id);
+    }
+}
+
+void TaskScheduler::TaskGraph::Start(int id) {
+    // Successors are submitted before this task counts as done, so the group
+    // cannot drain early. A task that throws does not release its successors.
+    group_.Run([this, id]() {
+        Node& node = *nodes_[id];
+        node.fn();
+        for (int s : node.successors) {
+            if (--nodes_[s]->remaining == 0) {
+                Start(s);
+            }
+        }
+    });
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The one worker pool of the native layer. Decode, resize, encode and GIF
+// jobs share a bounded set of threads instead of each spawning their own.
+//
+// - Priority lanes: a free worker always takes kHigh work (preview) before
+//   kNormal, and kNormal before kBackground (encodes, clips). Lanes are not
+//   preemptive; a long background task finishes its current chunk first, so
+//   background work should be split into chunks of a few milliseconds.
+// - Work stealing: tasks spawned by a worker go to its own deque (LIFO for
+//   cache locality); idle workers steal the oldest task from the others.
+//   Tasks from other threads go to a shared injection queue.
+// - On Windows, workers run with COM initialized (MTA) so tasks can use WIC
+//   directly, and kBackground tasks run at below-normal thread priority.
+//   Elsewhere (the portable tests) lanes only order the queues.
+//
+// Waiting on a TaskGroup from a worker runs other tasks meanwhile, so nested
+// parallelism cannot deadlock the pool. Other threads simply block.
+class TaskScheduler {
+public:
+    enum Priority { kHigh = 0, kNormal = 1, kBackground = 2 };
+    static constexpr int kLanes = 3;
+
+    // Process-wide pool, started on first use.
+    static TaskScheduler& Instance();
+
+    TaskScheduler() = default;
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Worker count (<= 0: one less than the number of cores). Only takes
+    // effect before the pool has started; returns false afterwards.
+    bool Configure(int workers);
+    int worker_count();
+
+    class TaskGroup;
+
+    // Fire and forget. `group` (optional) is notified on completion.
+    void Submit(std::function<void()> fn, Priority priority, TaskGroup* group = nullptr);
+
+    // Tasks whose completion can be waited for together.
+    class TaskGroup {
+    public:
+        explicit TaskGroup(Priority priority = kNormal, TaskScheduler& scheduler = Instance())
+            : scheduler_(scheduler), priority_(priority) {}
+        ~TaskGroup() { Wait(); }
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Run(std::function<void()> fn);
+        void Wait();
+        Priority priority() const { return priority_; }
+
+    private:
+        friend class TaskScheduler;
+        void Done();
+
+        TaskScheduler& scheduler_;
+        Priority priority_;
+        std::atomic<int> pending_{0};
+        std::mutex mutex_;
+        std::condition_variable cv_;
+    };
+
+    // A set of tasks with dependencies. Build it with Add(), then Run() once;
+    // a task is started as soon as everything it depends on has finished.
+    class TaskGraph {
+    public:
+        explicit TaskGraph(Priority priority = kNormal, TaskScheduler& scheduler = Instance())
+            : group_(priority, scheduler) {}
+
+        // `deps` are ids returned by earlier Add() calls. Returns the task id.
+        int Add(std::function<void()> fn, const std::vector<int>& deps = {});
+        void Run();
+        void Wait() { group_.Wait(); }
+
+    private:
+        struct Node {
+            std::function<void()> fn;
+            std::atomic<int> remaining{0};
+            std::vector<int> successors;
+        };
+        void Start(int id);
+
+        std::vector<std::unique_ptr<Node>> nodes_;
+        TaskGroup group_;  // declared last: waits before the nodes go away
+    };
+
+    // fn(i) for i in [0, count), load-balanced through a shared counter over
+    // at most `max_parallelism` tasks (<= 0: all workers). Returns when done.
+    template <typename Fn>
+    void ParallelFor(int count, Priority priority, Fn fn, int max_parallelism = 0) {
+        if (count <= 0) {
+            return;
+        }
+        int tasks = max_parallelism > 0 ? max_parallelism : worker_count();
+        tasks = std::clamp(tasks, 1, count);
+        auto next = std::make_shared<std::atomic<int>>(0);
+        TaskGroup group(priority, *this);
+        for (int t = 0; t < tasks; ++t) {
+            group.Run([next, count, &fn]() {
+                for (int i = (*next)++; i < count; i = (*next)++) {
+                    fn(i);
+                }
+            });
+        }
+        group.Wait();
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+        Priority priority = kNormal;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> lanes[kLanes];
+        std::thread thread;
+    };
+
+    void EnsureStarted();
+    void WorkerLoop(int index);
+    // Highest-priority runnable task no less urgent than `lowest`.
+    bool FindTask(Priority lowest, Task& out);
+    void Execute(Task& task);
+
+    std::mutex start_mutex_;
+    std::atomic<bool> started_{false};
+    int configured_workers_ = 0;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex inject_mutex_;
+    std::deque<Task> inject_[kLanes];
+
+    std::atomic<int64_t> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stop_ = false;  // guarded by sleep_mutex_
+};
@@ -0,0 +1,279 @@
+#include "template_assets.h"
+#include "content_hash.h"
+#include "disk_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x41544653;  // "SFTA"
+constexpr uint32_t kVersion = 1;
+constexpr wchar_t kExtension[] = L".sfta";
+constexpr size_t kTileAlign = 64;
+constexpr int kMaxSide = 1 << 15;
+constexpr auto kStaleAfter = std::chrono::hours(24 * 30);
+
+struct TileFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    int32_t width;
+    int32_t height;
+    int32_t tile_size;
+    int32_t tiles_x;
+    int32_t tiles_y;
+    uint32_t reserved;
+};
+
+size_t AlignUp(size_t n) {
+    return (n + kTileAlign - 1) & ~(kTileAlign - 1);
+}
+
+}  // namespace
+
+std::shared_ptr<TileImage> TileImage::FromPixels(const DecodedImage& image, uint64_t source_hash) {
+    if (image.channels != 4 || image.width <= 0 || image.height <= 0 || image.width > kMaxSide ||
+        image.height > kMaxSide) {
+        return nullptr;
+    }
+    const int tiles_x = (image.width + kTileSize - 1) / kTileSize;
+    const int tiles_y = (image.height + kTileSize - 1) / kTileSize;
+    const size_t tile_count = static_cast<size_t>(tiles_x) * tiles_y;
+
+    TileFileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.source_hash = source_hash;
+    header.width = image.width;
+    header.height = image.height;
+    header.tile_size = kTileSize;
+    header.tiles_x = tiles_x;
+    header.tiles_y = tiles_y;
+
+    auto out = std::make_shared<TileImage>();
+    std::vector<uint8_t>& bytes = out->owned_;
+    bytes.resize(AlignUp(sizeof(header) + tile_count * sizeof(uint64_t)));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::vector<uint64_t> offsets(tile_count, 0);
+    for (int ty = 0; ty < tiles_y; ++ty) {
+        for (int tx = 0; tx < tiles_x; ++tx) {
+            const int x0 = tx * kTileSize;
+            const int y0 = ty * kTileSize;
+            const int tw = std::min(kTileSize, image.width - x0);
+            const int th = std::min(kTileSize, image.height - y0);
+            const size_t row_bytes = static_cast<size_t>(tw) * 4;
+
+            bool transparent = true;
+            for (int y = 0; y < th && transparent; ++y) {
+                const uint8_t* row = image.pixels.data() + static_cast<size_t>(y0 + y) * image.stride + x0 * 4;
+                transparent = row[0] == 0 && std::memcmp(row, row + 1, row_bytes - 1) == 0;
+            }
+            if (transparent) {
+                continue;
+            }
+
+            const size_t offset = bytes.size();
+            offsets[static_cast<size_t>(ty) * tiles_x + tx] = offset;
+            bytes.resize(AlignUp(offset + row_bytes * th));
+            for (int y = 0; y < th; ++y) {
+                std::memcpy(bytes.data() + offset + y * row_bytes,
+                            image.pixels.data() + static_cast<size_t>(y0 + y) * image.stride + x0 * 4, row_bytes);
+            }
+        }
+    }
+    std::memcpy(bytes.data() + sizeof(header), offsets.data(), tile_count * sizeof(uint64_t));
+
+    if (!out->Attach(bytes.data(), bytes.size(), source_hash)) {
+        return nullptr;
+    }
+    return out;
+}
+
+std::shared_ptr<TileImage> TileImage::Map(const std::wstring& path, uint64_t source_hash) {
+    auto out = std::make_shared<TileImage>();
+    if (!out->mapped_.Open(path) || !out->Attach(out->mapped_.data(), out->mapped_.size(), source_hash)) {
+        return nullptr;
+    }
+    return out;
+}
+
+bool TileImage::Attach(const uint8_t* base, size_t size, uint64_t source_hash) {
+    TileFileHeader header{};
+    if (!base || size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.source_hash != source_hash ||
+        header.tile_size != kTileSize || header.width <= 0 || header.height <= 0 || header.width > kMaxSide ||
+        header.height > kMaxSide || header.tiles_x != (header.width + kTileSize - 1) / kTileSize ||
+        header.tiles_y != (header.height + kTileSize - 1) / kTileSize) {
+        return false;
+    }
+    const size_t tile_count = static_cast<size_t>(header.tiles_x) * header.tiles_y;
+    const size_t index_end = sizeof(header) + tile_count * sizeof(uint64_t);
+    if (size < index_end) {
+        return false;
+    }
+
+    // Every stored tile must lie inside the file, after the index
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(base + sizeof(header));
+    for (int ty = 0; ty < header.tiles_y; ++ty) {
+        for (int tx = 0; tx < header.tiles_x; ++tx) {
+            const uint64_t offset = offsets[static_cast<size_t>(ty) * header.tiles_x + tx];
+            const uint64_t tile_bytes = static_cast<uint64_t>(std::min(kTileSize, header.width - tx * kTileSize)) *
+                                        std::min(kTileSize, header.height - ty * kTileSize) * 4;
+            if (offset != 0 && (offset < index_end || offset > size || size - offset < tile_bytes)) {
+                return false;
+            }
+        }
+    }
+
+    base_ = base;
+    offsets_ = offsets;
+    source_hash_ = source_hash;
+    width_ = header.width;
+    height_ = header.height;
+    tiles_x_ = header.tiles_x;
+    tiles_y_ = header.tiles_y;
+    return true;
+}
+
+const uint8_t* TileImage::tile(int tx, int ty) const {
+    if (tx < 0 || ty < 0 || tx >= tiles_x_ || ty >= tiles_y_) {
+        return nullptr;
+    }
+    const uint64_t offset = offsets_[static_cast<size_t>(ty) * tiles_x_ + tx];
+    return offset ? base_ + offset : nullptr;
+}
+
+void TileImage::CopyTo(uint8_t* dst, int stride) const {
+    for (int ty = 0; ty < tiles_y_; ++ty) {
+        const int y0 = ty * kTileSize;
+        const int th = std::min(kTileSize, height_ - y0);
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            const int x0 = tx * kTileSize;
+            const size_t row_bytes = static_cast<size_t>(std::min(kTileSize, width_ - x0)) * 4;
+            const uint8_t* src = tile(tx, ty);
+            for (int y = 0; y < th; ++y) {
+                uint8_t* row = dst + static_cast<size_t>(y0 + y) * stride + static_cast<size_t>(x0) * 4;
+                if (src) {
+                    std::memcpy(row, src + y * row_bytes, row_bytes);
+                } else {
+                    std::memset(row, 0, row_bytes);
+                }
+            }
+        }
+    }
+}
+
+std::wstring TemplateAssetCache::PathFor(uint64_t hash) const {
+    return DiskCachePath(dir_, hash, kExtension);
+}
+
+bool TemplateAssetCache::Configure(const std::wstring& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dir_.clear();
+    stats_ = Stats{};
+    if (directory.empty()) {
+        return true;
+    }
+
+    if (!PrepareDiskCacheDirectory(directory)) {
+        return false;
+    }
+    dir_ = directory;
+
+    // Artwork of past events: nothing hashes to it any more once unused
+    const auto stale = fs::file_time_type::clock::now() - kStaleAfter;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path& path = it->path();
+        uint64_t hash = 0;
+        if (!ParseDiskCacheName(path, kExtension, hash)) {
+            continue;
+        }
+        std::error_code entry_ec;
+        const uint64_t bytes = it->file_size(entry_ec);
+        const fs::file_time_type used = it->last_write_time(entry_ec);
+        if (entry_ec) {
+            continue;
+        }
+        if (used < stale && fs::remove(path, entry_ec)) {
+            continue;
+        }
+        ++stats_.entries;
+        stats_.bytes += bytes;
+    }
+    return true;
+}
+
+bool TemplateAssetCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !dir_.empty();
+}
+
+std::shared_ptr<const TileImage> TemplateAssetCache::Get(const uint8_t* data, size_t len, WicDecoder& decoder) {
+    if (!data || len == 0) {
+        return nullptr;
+    }
+    const uint64_t hash = HashBytes(data, len);
+    std::wstring path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dir_.empty()) {
+            path = PathFor(hash);
+        }
+    }
+
+    if (!path.empty()) {
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);  // recency for pruning
+        if (!ec) {
+            if (auto mapped = TileImage::Map(path, hash)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++stats_.hits;
+                return mapped;
+            }
+        }
+    }
+
+    DecodedImage decoded;
+    if (!decoder.DecodePremultiplied(data, len, decoded)) {
+        return nullptr;
+    }
+    std::shared_ptr<TileImage> converted = TileImage::FromPixels(decoded, hash);
+    if (!converted) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.misses;
+    }
+    if (path.empty()) {
+        return converted;
+    }
+
+    // Store, then serve from the mapping like any later run. The store fails
+    // e.g. when another process mapped the same entry first
+    const std::vector<uint8_t>& bytes = converted->bytes();
+    if (WriteDiskCacheEntry(path, {{bytes.data(), bytes.size()}})) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.entries;
+        stats_.bytes += bytes.size();
+    }
+    if (auto mapped = TileImage::Map(path, hash)) {
+        return mapped;
+    }
+    return converted;
+}
+
+TemplateAssetCache::Stats TemplateAssetCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "image_decode.h"
+#include "shm_region.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Premultiplied BGRA artwork cut into square tiles. Fully transparent tiles
+// are not stored, so a frame with a clear middle keeps only its border.
+//
+// The same byte layout is used in memory and on disk (TemplateAssetCache),
+// so a cached asset is used straight from the mapped file:
+//
+//   header | tile offsets (uint64 per tile, row-major, 0 = transparent) |
+//   tiles (tile width x tile height x 4 bytes each, rows tight)
+class TileImage {
+public:
+    static constexpr int kTileSize = 256;
+
+    TileImage() = default;
+    TileImage(const TileImage&) = delete;
+    TileImage& operator=(const TileImage&) = delete;
+
+    // Tiles a decoded premultiplied image (kept in memory).
+    static std::shared_ptr<TileImage> FromPixels(const DecodedImage& image, uint64_t source_hash);
+    // Maps a file written from bytes(); null when it is missing, damaged or
+    // not for `source_hash`.
+    static std::shared_ptr<TileImage> Map(const std::wstring& path, uint64_t source_hash);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    uint64_t source_hash() const { return source_hash_; }
+    int tiles_x() const { return tiles_x_; }
+    int tiles_y() const { return tiles_y_; }
+    bool mapped() const { return mapped_.is_open(); }
+
+    // Pixels of tile (tx, ty), stride tile width * 4; null when transparent.
+    const uint8_t* tile(int tx, int ty) const;
+    // The whole image into dst, transparent where tiles are not stored.
+    void CopyTo(uint8_t* dst, int stride) const;
+
+    // The serialized form (what the cache writes); empty when mapped.
+    const std::vector<uint8_t>& bytes() const { return owned_; }
+
+private:
+    bool Attach(const uint8_t* base, size_t size, uint64_t source_hash);
+
+    std::vector<uint8_t> owned_;
+    MappedFile mapped_;
+    const uint8_t* base_ = nullptr;
+    const uint64_t* offsets_ = nullptr;
+    uint64_t source_hash_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int tiles_x_ = 0;
+    int tiles_y_ = 0;
+};
+
+// Template artwork converted once and kept as mapped TileImage files, one per
+// source content hash. Loading a template whose PNGs were seen before reads
+// no pixels and decodes nothing; tiles come in from the page cache when the
+// template is first placed. Changed artwork hashes differently, so stale
+// entries are never used; entries unused for a month are removed when the
+// cache is configured. Thread-safe.
+class TemplateAssetCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;   // decoded and converted
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    TemplateAssetCache() = default;
+    TemplateAssetCache(const TemplateAssetCache&) = delete;
+    TemplateAssetCache& operator=(const TemplateAssetCache&) = delete;
+
+    // Use `directory` (created if needed). Empty turns the cache off; Get
+    // then decodes into memory every time.
+    bool Configure(const std::wstring& directory);
+    bool enabled() const;
+
+    // The tiles of an encoded image (PNG, anything WIC reads). `decoder` is
+    // only used on a miss and must belong to the calling thread.
+    std::shared_ptr<const TileImage> Get(const uint8_t* data, size_t len, WicDecoder& decoder);
+
+    Stats stats() const;
+
+private:
+    std::wstring PathFor(uint64_t hash) const;
+
+    mutable std::mutex mutex_;
+    std::wstring dir_;
+    Stats stats_;
+};
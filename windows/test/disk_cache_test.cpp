@@ -0,0 +1,98 @@
+// Disk cache files: entry names round-trip through their key, leftovers of
+// interrupted writes are swept, and a failed write never damages the entry
+// it was meant to replace.
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include "disk_cache.h"
+#include "test_util.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string ReadAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const fs::path& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+void TestNames(const fs::path& root) {
+    const fs::path path = DiskCachePath(root.wstring(), 0xDEADBEEFull, L".sfx");
+    CHECK(path.filename() == L"00000000deadbeef.sfx");
+    CHECK(path.parent_path() == root);
+
+    uint64_t key = 0;
+    CHECK(ParseDiskCacheName(path, L".sfx", key) && key == 0xDEADBEEFull);
+    CHECK(ParseDiskCacheName(DiskCachePath(root.wstring(), ~0ull, L".sfx"), L".sfx", key) && key == ~0ull);
+    CHECK(!ParseDiskCacheName(root / L"00000000deadbeef.other", L".sfx", key));
+    CHECK(!ParseDiskCacheName(root / L"deadbeef.sfx", L".sfx", key));
+    CHECK(!ParseDiskCacheName(root / L"00000000deadbeez.sfx", L".sfx", key));
+    CHECK(!ParseDiskCacheName(root / L"00000000deadbeef.sfx.tmp", L".sfx", key));
+}
+
+void TestPrepare(const fs::path& root) {
+    const fs::path dir = root / "nested" / "cache";
+    CHECK(PrepareDiskCacheDirectory(dir.wstring()));
+    CHECK(fs::is_directory(dir));
+
+    WriteFile(dir / "00000000000000aa.sfx", "entry");
+    WriteFile(dir / "00000000000000bb.sfx.tmp", "half");
+    CHECK(PrepareDiskCacheDirectory(dir.wstring()));
+    CHECK(fs::exists(dir / "00000000000000aa.sfx"));
+    CHECK(!fs::exists(dir / "00000000000000bb.sfx.tmp"));
+
+    WriteFile(root / "file", "not a directory");
+    CHECK(!PrepareDiskCacheDirectory((root / "file").wstring()));
+}
+
+void TestReplace(const fs::path& root) {
+    const std::wstring path = DiskCachePath(root.wstring(), 42, L".sfx");
+    const char head[] = "head:";
+    const char body[] = "body";
+    CHECK(WriteDiskCacheEntry(path, {{head, 5}, {body, 4}}));
+    CHECK(ReadAll(path) == "head:body");
+    CHECK(WriteDiskCacheEntry(path, {{body, 4}}));
+    CHECK(ReadAll(path) == "body");
+
+    // A writer that fails half-way leaves the previous entry and no temp file
+    CHECK(!ReplaceDiskCacheEntry(path, [](const std::wstring& temp) {
+        WriteFile(temp, "partial");
+        return false;
+    }));
+    CHECK(ReadAll(path) == "body");
+    CHECK(!fs::exists(path + L".tmp"));
+
+    CHECK(ReplaceDiskCacheEntry(path, [](const std::wstring& temp) {
+        WriteFile(temp, "saved");
+        return true;
+    }));
+    CHECK(ReadAll(path) == "saved");
+
+    // Unwritable location: nothing is created
+    const std::wstring missing = DiskCachePath((root / "missing").wstring(), 42, L".sfx");
+    CHECK(!WriteDiskCacheEntry(missing, {{body, 4}}));
+    CHECK(!fs::exists(missing));
+}
+
+}  // namespace
+
+int main() {
+    const fs::path root = fs::temp_directory_path() / "sface_disk_cache_test";
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    fs::create_directories(root, ec);
+
+    TestNames(root);
+    TestPrepare(root);
+    TestReplace(root);
+
+    fs::remove_all(root, ec);
+    return TestResult("disk_cache_test");
+}
@@ -0,0 +1,200 @@
+// Shared-memory frame ring: a writer publishing synthetic frames at full
+// speed while a reader, with its own mapping of the same name, follows it.
+// Every frame the reader accepts must be intact and newer than the last one.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_shm.h"
+#include "shm_region.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr uint32_t kSlots = 4;
+constexpr uint64_t kCapacity = 64 * 1024;
+constexpr uint64_t kFrames = 20000;
+
+// Size and bytes both derive from the sequence, so a torn or stale frame
+// cannot pass for another one.
+std::vector<uint8_t> SyntheticFrame(uint64_t seq) {
+    std::vector<uint8_t> frame(1024 + static_cast<size_t>((seq * 7919) % (kCapacity - 1024)));
+    uint32_t x = static_cast<uint32_t>(seq) * 2654435761u;
+    for (uint8_t& b : frame) {
+        x = x * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(x >> 24);
+    }
+    return frame;
+}
+
+// Distinct per run, so parallel or leftover runs never share a region.
+std::string UniqueName(const char* what) {
+    static const auto run = std::chrono::steady_clock::now().time_since_epoch().count() & 0xffffff;
+    return std::string("sface_test_") + what + "_" + std::to_string(run);
+}
+
+void TestOpenErrors() {
+    frame_shm::Reader reader;
+    CHECK(!reader.Open(UniqueName("missing")));
+    CHECK(!reader.is_open());
+    CHECK(!reader.writer_alive());
+
+    frame_shm::Writer writer;
+    CHECK(!writer.Create(UniqueName("bad"), 1, kCapacity));  // needs two slots
+    CHECK(!writer.Create(UniqueName("bad"), kSlots, 0));
+}
+
+void TestPublishAndRead() {
+    const std::string name = UniqueName("basic");
+    frame_shm::Writer writer;
+    CHECK(writer.Create(name, kSlots, kCapacity));
+
+    frame_shm::Reader reader;
+    CHECK(reader.Open(name));
+    CHECK(reader.writer_alive());
+
+    std::vector<uint8_t> out;
+    uint64_t seq = 0;
+    CHECK(!reader.CopyLatest(out, &seq));  // nothing published yet
+
+    for (uint64_t s = 1; s <= 3; ++s) {
+        const std::vector<uint8_t> frame = SyntheticFrame(s);
+        CHECK(writer.Publish(frame.data(), frame.size(), s, s * 1000));
+    }
+    CHECK(reader.CopyLatest(out, &seq));
+    CHECK(seq == 3);
+    CHECK(out == SyntheticFrame(3));
+    CHECK(!reader.CopyLatest(out, &seq, 3));  // nothing newer
+
+    // A view stays valid until its slot comes round again.
+    frame_shm::FrameView view;
+    CHECK(reader.Latest(view));
+    CHECK(view.sequence == 3 && view.captured_us == 3000);
+    for (uint64_t s = 4; s < 3 + kSlots; ++s) {
+        const std::vector<uint8_t> frame = SyntheticFrame(s);
+        writer.Publish(frame.data(), frame.size(), s, 0);
+    }
+    CHECK(reader.StillValid(view));
+    const std::vector<uint8_t> lap = SyntheticFrame(3 + kSlots);
+    writer.Publish(lap.data(), lap.size(), 3 + kSlots, 0);
+    CHECK(!reader.StillValid(view));
+
+    // Oversized frames are skipped and counted, the ring is unchanged.
+    std::vector<uint8_t> big(kCapacity + 1);
+    CHECK(!writer.Publish(big.data(), big.size(), 4 + kSlots, 0));
+    CHECK(writer.frames_oversized() == 1);
+    CHECK(reader.CopyLatest(out, &seq));
+    CHECK(seq == 3 + kSlots);
+
+    writer.Close();
+    CHECK(!reader.writer_alive());
+    CHECK(reader.CopyLatest(out, &seq));  // the reader's mapping outlives the writer
+    CHECK(out == lap);
+}
+
+void TestConcurrentReader() {
+    const std::string name = UniqueName("race");
+    frame_shm::Writer writer;
+    CHECK(writer.Create(name, kSlots, kCapacity));
+    frame_shm::Reader reader;
+    CHECK(reader.Open(name));
+
+    std::vector<std::vector<uint8_t>> frames;
+    for (uint64_t s = 1; s <= 64; ++s) {
+        frames.push_back(SyntheticFrame(s));
+    }
+
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (uint64_t s = 1; s <= kFrames; ++s) {
+            const std::vector<uint8_t>& frame = frames[(s - 1) % frames.size()];
+            writer.Publish(frame.data(), frame.size(), s, s);
+        }
+        done = true;
+    });
+
+    uint64_t last = 0;
+    uint64_t received = 0;
+    uint64_t torn = 0;
+    std::vector<uint8_t> out;
+    for (;;) {
+        // Read `done` first: once it is set, one more fetch sees the last frame.
+        const bool finished = done;
+        uint64_t seq = 0;
+        if (!reader.CopyLatest(out, &seq, last)) {
+            if (finished) {
+                break;
+            }
+            continue;
+        }
+        CHECK(seq > last);
+        if (out != frames[(seq - 1) % frames.size()]) {
+            ++torn;
+        }
+        last = seq;
+        ++received;
+    }
+    producer.join();
+
+    CHECK(torn == 0);
+    CHECK(received > 0);
+    CHECK(last == kFrames);
+    CHECK(writer.frames_published() == kFrames);
+}
+
+// A name that is already taken is only reused for a ring of the same layout;
+// anything else is left alone and Create fails.
+void TestExistingRegion() {
+    const std::string foreign_name = UniqueName("foreign");
+    SharedMemoryRegion foreign;
+    CHECK(foreign.Create(foreign_name, 1 << 20));
+    CHECK(!foreign.existed());
+    std::vector<uint8_t> pattern(foreign.size());
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        pattern[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    std::copy(pattern.begin(), pattern.end(), foreign.data());
+
+    frame_shm::Writer writer;
+    CHECK(!writer.Create(foreign_name, kSlots, kCapacity));
+    CHECK(!writer.is_open());
+    CHECK(std::equal(pattern.begin(), pattern.end(), foreign.data()));
+
+    // Too small for the ring: not even mapped
+    SharedMemoryRegion small;
+    CHECK(!small.Create(foreign_name, 2 << 20));
+
+    const std::string name = UniqueName("existing");
+    frame_shm::Writer first;
+    CHECK(first.Create(name, kSlots, kCapacity));
+    const std::vector<uint8_t> frame = SyntheticFrame(1);
+    CHECK(first.Publish(frame.data(), frame.size(), 1, 0));
+
+    frame_shm::Writer other;
+    CHECK(!other.Create(name, kSlots + 1, kCapacity));
+    CHECK(!other.Create(name, kSlots, kCapacity / 2));
+    frame_shm::Reader reader;
+    CHECK(reader.Open(name));
+    std::vector<uint8_t> out;
+    uint64_t seq = 0;
+    CHECK(reader.CopyLatest(out, &seq) && seq == 1 && out == frame);
+
+    // Same layout: taken over and reset
+    frame_shm::Writer same;
+    CHECK(same.Create(name, kSlots, kCapacity));
+    CHECK(!reader.CopyLatest(out, &seq));
+}
+
+}  // namespace
+
+int main() {
+    TestOpenErrors();
+    TestPublishAndRead();
+    TestConcurrentReader();
+    TestExistingRegion();
+    return TestResult("frame_shm_test");
+}
@@ -0,0 +1,137 @@
+// GIF LZW: every frame must decode back to its indices, including where the
+// code width grows, where the 4096-entry table fills and is cleared, and where
+// the stream ends right at one of those boundaries.
+#include <cstdint>
+#include <vector>
+
+#include "gif_encoder.h"
+#include "test_util.h"
+
+namespace {
+
+// Decoder with the usual GIF rules: the table grows by one entry per code
+// after the first, and the width grows once the next free code no longer fits
+// (up to 12 bits). Returns false on a code it cannot resolve or a missing EOI.
+bool LzwDecodeFrame(const std::vector<uint8_t>& data, std::vector<uint8_t>& out) {
+    out.clear();
+    if (data.empty()) {
+        return false;
+    }
+    const int min_code_size = data[0];
+    std::vector<uint8_t> raw;
+    size_t pos = 1;
+    while (pos < data.size() && data[pos] != 0) {
+        const size_t n = data[pos];
+        if (pos + 1 + n > data.size()) {
+            return false;
+        }
+        raw.insert(raw.end(), data.begin() + pos + 1, data.begin() + pos + 1 + n);
+        pos += 1 + n;
+    }
+    if (pos + 1 != data.size()) {
+        return false;  // no block terminator, or bytes after it
+    }
+
+    const int clear_code = 1 << min_code_size;
+    const int eoi_code = clear_code + 1;
+    std::vector<int> prefix(4096, -1);
+    std::vector<uint8_t> suffix(4096, 0);
+    std::vector<uint8_t> first(4096, 0);
+    for (int i = 0; i < clear_code; ++i) {
+        suffix[i] = first[i] = static_cast<uint8_t>(i);
+    }
+
+    int code_size = min_code_size + 1;
+    int next_code = eoi_code + 1;
+    int previous = -1;
+    size_t bit = 0;
+    std::vector<uint8_t> string;
+    for (;;) {
+        if (bit + code_size > raw.size() * 8) {
+            return false;
+        }
+        int code = 0;
+        for (int i = 0; i < code_size; ++i, ++bit) {
+            code |= (raw[bit / 8] >> (bit % 8) & 1) << i;
+        }
+        if (code == clear_code) {
+            code_size = min_code_size + 1;
+            next_code = eoi_code + 1;
+            previous = -1;
+            continue;
+        }
+        if (code == eoi_code) {
+            return true;
+        }
+        if (code > next_code || (code == next_code && previous < 0)) {
+            return false;
+        }
+
+        // KwKwK: the code being defined right now
+        const int known = code < next_code ? code : previous;
+        string.clear();
+        for (int c = known; c >= 0; c = prefix[c]) {
+            string.push_back(suffix[c]);
+        }
+        if (code == next_code) {
+            string.insert(string.begin(), first[previous]);
+        }
+        out.insert(out.end(), string.rbegin(), string.rend());
+
+        if (previous >= 0 && next_code < 4096) {
+            prefix[next_code] = previous;
+            suffix[next_code] = string.back();
+            first[next_code] = first[previous];
+            ++next_code;
+            if (next_code == 1 << code_size && code_size < 12) {
+                ++code_size;
+            }
+        }
+        previous = code;
+    }
+}
+
+std::vector<uint8_t> Noise(size_t count, uint32_t seed, int colors) {
+    std::vector<uint8_t> indices(count);
+    for (uint8_t& index : indices) {
+        seed = seed * 1664525u + 1013904223u;
+        index = static_cast<uint8_t>((seed >> 16) % colors);
+    }
+    return indices;
+}
+
+bool RoundTrips(const uint8_t* indices, size_t count) {
+    std::vector<uint8_t> decoded;
+    return LzwDecodeFrame(LzwEncodeFrame(indices, count), decoded) &&
+           decoded == std::vector<uint8_t>(indices, indices + count);
+}
+
+// Every prefix of a noise frame: the stream ends once with each possible
+// table size, so also right at the 9->10, 10->11 and 11->12 bit boundaries
+// and around the clear of the full table
+void TestEveryLength() {
+    const std::vector<uint8_t> noise = Noise(6000, 1, 256);
+    int failures = 0;
+    for (size_t n = 0; n <= noise.size(); ++n) {
+        failures += RoundTrips(noise.data(), n) ? 0 : 1;
+    }
+    CHECK(failures == 0);
+}
+
+// Long frames fill and clear the table many times
+void TestFullTable() {
+    const std::vector<uint8_t> noise = Noise(200000, 2, 256);
+    CHECK(RoundTrips(noise.data(), noise.size()));
+    const std::vector<uint8_t> few = Noise(200000, 3, 4);
+    CHECK(RoundTrips(few.data(), few.size()));
+    const std::vector<uint8_t> flat(300000, 7);
+    CHECK(RoundTrips(flat.data(), flat.size()));
+}
+
+}  // namespace
+
+int main() {
+    TestEveryLength();
+    TestFullTable();
+    return TestResult("gif_encoder_test");
+}
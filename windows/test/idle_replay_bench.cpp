@@ -0,0 +1,259 @@
+// Idle-mode benchmark on the replay backend: how much CPU the capture loop
+// saves while the booth is empty, and how long it takes to show live view
+// again after a touch (camera_wake) or after motion.
+//
+//   idle_replay_bench [frames_dir]
+//
+// Without a directory, synthetic 960x640 EVF frames are generated with
+// camera_encode_jpeg_bgra. With one, its frames should be a still scene (an
+// empty booth); the motion phase always uses synthetic frames.
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera_ffi.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int kWidth = 960;
+constexpr int kHeight = 640;
+constexpr int kFrameIntervalMs = 33;
+constexpr int kIdleAfterMs = 1000;
+constexpr int kTrickleMs = 250;
+constexpr int kWakeTrials = 10;
+
+double ProcessCpuMs() {
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        return 0.0;
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return static_cast<double>(k.QuadPart + u.QuadPart) / 10000.0;
+}
+
+// Gradient background with sensor-like noise; `square_x` >= 0 draws a bright
+// block there, which the motion detector sees as a person walking in.
+bool WriteFrame(const fs::path& path, unsigned seed, int square_x) {
+    std::vector<unsigned char> bgra(static_cast<size_t>(kWidth) * kHeight * 4);
+    for (int y = 0; y < kHeight; ++y) {
+        unsigned char* row = bgra.data() + static_cast<size_t>(y) * kWidth * 4;
+        for (int x = 0; x < kWidth; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>(seed >> 29);  // 0..7
+            const bool lit = square_x >= 0 && x >= square_x && x < square_x + 240 && y >= 160 && y < 480;
+            const int base = lit ? 230 : 40 + (x + y) * 120 / (kWidth + kHeight);
+            row[x * 4 + 0] = static_cast<unsigned char>(base + noise);
+            row[x * 4 + 1] = static_cast<unsigned char>(base + noise);
+            row[x * 4 + 2] = static_cast<unsigned char>(base + noise / 2);
+            row[x * 4 + 3] = 255;
+        }
+    }
+
+    CameraJpegOptions options = {};
+    options.quality = 80;
+    options.subsample_chroma = 1;
+    unsigned char* jpeg = nullptr;
+    unsigned long long size = 0;
+    if (camera_encode_jpeg_bgra(bgra.data(), kWidth, kHeight, kWidth * 4, &options, &jpeg, &size, nullptr) != 0) {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(jpeg), static_cast<std::streamsize>(size));
+    camera_free_buffer(jpeg);
+    return static_cast<bool>(out);
+}
+
+// Static frames only differ by noise; motion frames move the block across.
+bool WriteFrames(const fs::path& dir, int count, bool motion) {
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    for (int i = 0; i < count; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%03d.jpg", i);
+        const int square_x = motion ? (i * 97) % (kWidth - 240) : -1;
+        if (!WriteFrame(dir / name, 0x9e3779b9u + static_cast<unsigned>(i), square_x)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StartReplay(const fs::path& dir) {
+    const int rc = camera_initialize_replay(dir.wstring().c_str(), kFrameIntervalMs);
+    if (rc != 0) {
+        std::fprintf(stderr, "[FAIL] camera_initialize_replay returned %d\n", rc);
+        return false;
+    }
+    return camera_start_liveview() == 0;
+}
+
+void StopReplay() {
+    camera_stop_liveview();
+    camera_terminate();
+}
+
+CameraIdleStats IdleStats() {
+    CameraIdleStats stats = {};
+    camera_get_idle_stats(&stats);
+    return stats;
+}
+
+struct Window {
+    double fps = 0.0;
+    double cpu_percent = 0.0;  // of one core
+};
+
+// Capture rate and process CPU over `duration`. The bench thread only sleeps,
+// so the CPU is the capture loop's (download, motion decode, publish).
+Window Measure(std::chrono::milliseconds duration) {
+    const CameraIdleStats before = IdleStats();
+    const double cpu_before = ProcessCpuMs();
+    const auto started = Clock::now();
+    std::this_thread::sleep_for(duration);
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    const CameraIdleStats after = IdleStats();
+
+    Window w;
+    w.fps = static_cast<double>(after.frames_captured - before.frames_captured) * 1000.0 / wall_ms;
+    w.cpu_percent = (ProcessCpuMs() - cpu_before) * 100.0 / wall_ms;
+    return w;
+}
+
+bool WaitForIdle(std::chrono::milliseconds timeout) {
+    const auto deadline = Clock::now() + timeout;
+    while (Clock::now() < deadline) {
+        if (IdleStats().idle) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+// Sequence of the newest frame, 0 if none yet.
+unsigned long long LatestSequence() {
+    unsigned char* buffer = nullptr;
+    unsigned long long size = 0;
+    CameraFrameDesc desc = {};
+    desc.struct_size = sizeof(desc);
+    if (camera_get_frame_ex(0, 0, &buffer, &size, &desc) != 0) {
+        return 0;
+    }
+    camera_free_buffer(buffer);
+    return desc.sequence;
+}
+
+// camera_wake() -> first frame flagged CAMERA_FRAME_FLAG_WAKE, as a consumer
+// polling camera_get_frame_ex would see it. Negative if none arrived.
+double WakeLatencyMs(unsigned long long last_seq) {
+    const auto woke_at = Clock::now();
+    camera_wake();
+    while (Clock::now() - woke_at < std::chrono::seconds(2)) {
+        unsigned char* buffer = nullptr;
+        unsigned long long size = 0;
+        CameraFrameDesc desc = {};
+        desc.struct_size = sizeof(desc);
+        if (camera_get_frame_ex(0, last_seq, &buffer, &size, &desc) == 0) {
+            camera_free_buffer(buffer);
+            last_seq = desc.sequence;
+            if (desc.flags & CAMERA_FRAME_FLAG_WAKE) {
+                return std::chrono::duration<double, std::milli>(Clock::now() - woke_at).count();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return -1.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const fs::path root = fs::temp_directory_path() / "sface_idle_bench";
+    const fs::path still_dir = argc > 1 ? fs::path(argv[1]) : root / "still";
+    const fs::path motion_dir = root / "motion";
+
+    if (argc <= 1 && !WriteFrames(still_dir, 30, false)) {
+        std::fprintf(stderr, "[FAIL] could not write replay frames to %s\n", still_dir.string().c_str());
+        return 1;
+    }
+    if (!WriteFrames(motion_dir, 30, true)) {
+        std::fprintf(stderr, "[FAIL] could not write replay frames to %s\n", motion_dir.string().c_str());
+        return 1;
+    }
+
+    // 1. Still scene: live rate, then idle rate, then touch-to-frame latency.
+    if (!StartReplay(still_dir)) {
+        return 1;
+    }
+    camera_set_idle_mode(0, kIdleAfterMs, kTrickleMs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const Window active = Measure(std::chrono::seconds(3));
+
+    camera_set_idle_mode(1, kIdleAfterMs, kTrickleMs);
+    if (!WaitForIdle(std::chrono::seconds(5))) {
+        std::fprintf(stderr, "[FAIL] still scene never went idle (lower the motion sensitivity?)\n");
+        StopReplay();
+        return 1;
+    }
+    const Window idle = Measure(std::chrono::seconds(3));
+
+    std::vector<double> wakes;
+    for (int i = 0; i < kWakeTrials; ++i) {
+        if (!WaitForIdle(std::chrono::seconds(5))) {
+            break;
+        }
+        const double ms = WakeLatencyMs(LatestSequence());
+        if (ms >= 0.0) {
+            wakes.push_back(ms);
+        }
+    }
+    const CameraIdleStats still_stats = IdleStats();
+    StopReplay();
+
+    // 2. Motion: every frame differs, so idle mode must never engage.
+    if (!StartReplay(motion_dir)) {
+        return 1;
+    }
+    camera_set_idle_mode(1, kIdleAfterMs, kTrickleMs);
+    const Window moving = Measure(std::chrono::seconds(3));
+    const CameraIdleStats motion_stats = IdleStats();
+    StopReplay();
+
+    std::sort(wakes.begin(), wakes.end());
+    const double saved = active.cpu_percent > 0.0 ? 100.0 * (1.0 - idle.cpu_percent / active.cpu_percent) : 0.0;
+
+    std::printf("replay %dx%d @ %d ms, idle after %d ms, trickle %d ms\n", kWidth, kHeight, kFrameIntervalMs,
+                kIdleAfterMs, kTrickleMs);
+    std::printf("  active        %6.1f fps  %5.1f%% CPU\n", active.fps, active.cpu_percent);
+    std::printf("  idle          %6.1f fps  %5.1f%% CPU  (%.0f%% saved, %llu frames skipped)\n", idle.fps,
+                idle.cpu_percent, saved, still_stats.frames_skipped);
+    std::printf("  motion        %6.1f fps  %5.1f%% CPU  (idle %d)\n", moving.fps, moving.cpu_percent,
+                motion_stats.idle);
+    if (wakes.empty()) {
+        std::printf("  wake          no wake frame observed\n");
+    } else {
+        std::printf("  wake          %.1f ms median, %.1f ms max over %zu touches "
+                    "(last capture->publish %.1f ms)\n",
+                    wakes[wakes.size() / 2], wakes.back(), wakes.size(),
+                    static_cast<double>(still_stats.last_wake_latency_us) / 1000.0);
+    }
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    return wakes.empty() || motion_stats.idle ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+// Image probing: EXIF orientation must come from well-formed IFD entries and
+// every offset read from the file must stay inside the APP1 segment, however
+// large it is.
+#include <cstdint>
+#include <vector>
+
+#include "image_probe.h"
+#include "test_util.h"
+
+namespace {
+
+void Put16(std::vector<uint8_t>& out, uint32_t v, bool le) {
+    if (le) {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    } else {
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+}
+
+void Put32(std::vector<uint8_t>& out, uint32_t v, bool le) {
+    Put16(out, le ? v & 0xFFFF : v >> 16, le);
+    Put16(out, le ? v >> 16 : v & 0xFFFF, le);
+}
+
+// SOI, then an APP1 "Exif" segment whose TIFF header points IFD0 at
+// `ifd_offset`. The IFD itself always sits right after the header (offset 8),
+// with `entries` claimed but one actually present: `tag` (SHORT) holding
+// `orientation`.
+std::vector<uint8_t> ExifJpeg(bool le, uint32_t ifd_offset, uint32_t orientation, uint32_t entries = 1,
+                              uint32_t tag = 0x0112) {
+    std::vector<uint8_t> tiff;
+    tiff.push_back(le ? 'I' : 'M');
+    tiff.push_back(le ? 'I' : 'M');
+    Put16(tiff, 42, le);
+    Put32(tiff, ifd_offset, le);
+    Put16(tiff, entries, le);
+    Put16(tiff, tag, le);
+    Put16(tiff, 3, le);  // SHORT
+    Put32(tiff, 1, le);
+    Put16(tiff, orientation, le);
+    Put16(tiff, 0, le);
+    Put32(tiff, 0, le);  // next IFD
+
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xE1};
+    const size_t seg_len = 2 + 6 + tiff.size();
+    jpeg.push_back(static_cast<uint8_t>(seg_len >> 8));
+    jpeg.push_back(static_cast<uint8_t>(seg_len));
+    const uint8_t exif[6] = {'E', 'x', 'i', 'f', 0, 0};
+    jpeg.insert(jpeg.end(), exif, exif + 6);
+    jpeg.insert(jpeg.end(), tiff.begin(), tiff.end());
+    const uint8_t tail[4] = {0xFF, 0xDA, 0x00, 0x02};  // SOS ends the APPn walk
+    jpeg.insert(jpeg.end(), tail, tail + 4);
+    return jpeg;
+}
+
+int Orientation(const std::vector<uint8_t>& jpeg) {
+    return ProbeJpegOrientation(jpeg.data(), jpeg.size());
+}
+
+void TestOrientation() {
+    CHECK(Orientation(ExifJpeg(true, 8, 6)) == 6);
+    CHECK(Orientation(ExifJpeg(false, 8, 8)) == 8);
+    CHECK(Orientation(ExifJpeg(true, 8, 9)) == 0);  // out of range
+    CHECK(Orientation(ExifJpeg(true, 8, 6, 0)) == 0);  // empty IFD
+
+    const std::vector<uint8_t> no_exif = {0xFF, 0xD8, 0xFF, 0xDA, 0x00, 0x02};
+    CHECK(Orientation(no_exif) == 0);
+    CHECK(ProbeJpegOrientation(nullptr, 0) == 0);
+}
+
+// IFD offsets near 2^32 used to wrap in 32-bit arithmetic, pass the bounds
+// check and read far outside the buffer (ASan catches that here).
+void TestWrappedOffsets() {
+    const uint32_t offsets[] = {0xFFFFFFFEu, 0xFFFFFFFFu, 0xFFFFFFF4u, 0xFFFFFFF0u, 0x80000000u, 30};
+    for (const uint32_t offset : offsets) {
+        CHECK(Orientation(ExifJpeg(true, offset, 6)) == 0);
+        CHECK(Orientation(ExifJpeg(false, offset, 6)) == 0);
+    }
+
+    // An entry count running past the segment stops at its end
+    CHECK(Orientation(ExifJpeg(true, 8, 6, 0xFFFF)) == 6);
+    CHECK(Orientation(ExifJpeg(true, 8, 6, 0xFFFF, 0x0110)) == 0);
+    CHECK(Orientation(ExifJpeg(false, 8, 6, 0xFFFF, 0x0110)) == 0);
+}
+
+}  // namespace
+
+int main() {
+    TestOrientation();
+    TestWrappedOffsets();
+    return TestResult("image_probe_test");
+}
@@ -0,0 +1,436 @@
+// JPEG encoder: every output decodes (restart markers in sequence, Huffman
+// tables that match the data) back to the image, the bytes do not depend on
+// the worker count, and size targeting picks a quality whose file fits or
+// reports a target that even quality 1 misses.
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "image_probe.h"
+#include "jpeg_encoder.h"
+#include "task_scheduler.h"
+#include "test_util.h"
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 480;
+
+// Smooth gradient with noise: compresses, but not to nothing
+std::vector<uint8_t> Photo() {
+    std::vector<uint8_t> bgra(static_cast<size_t>(kWidth) * kHeight * 4);
+    uint32_t seed = 0x2545F491u;
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t* p = &bgra[(static_cast<size_t>(y) * kWidth + x) * 4];
+            p[0] = static_cast<uint8_t>(x * 255 / kWidth + (seed >> 28));
+            p[1] = static_cast<uint8_t>(y * 255 / kHeight + (seed >> 29));
+            p[2] = static_cast<uint8_t>((x + y) * 127 / (kWidth + kHeight) + (seed >> 27));
+            p[3] = 255;
+        }
+    }
+    return bgra;
+}
+
+constexpr uint8_t kZigzag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+int ReadBE16(const uint8_t* p) {
+    return p[0] << 8 | p[1];
+}
+
+// Canonical Huffman table (T.81 F.2.2.3)
+struct HuffmanTable {
+    int maxcode[17] = {};
+    int mincode[17] = {};
+    int valptr[17] = {};
+    std::vector<uint8_t> values;
+};
+
+// Entropy-coded data of one scan, with byte stuffing undone. A marker ends
+// the data of a restart interval; Restart() and End() then check it is the
+// expected one and that the interval was padded with 1-bits.
+class ScanReader {
+public:
+    ScanReader(const std::vector<uint8_t>& data, size_t pos) : data_(data), pos_(pos) {}
+
+    bool failed() const { return failed_; }
+
+    int Bit() {
+        if (count_ == 0) {
+            if (pos_ + 1 >= data_.size() || (data_[pos_] == 0xFF && data_[pos_ + 1] != 0x00)) {
+                failed_ = true;
+                return 0;
+            }
+            byte_ = data_[pos_];
+            pos_ += byte_ == 0xFF ? 2 : 1;
+            count_ = 8;
+        }
+        --count_;
+        return byte_ >> count_ & 1;
+    }
+
+    int Bits(int n) {
+        int v = 0;
+        for (int i = 0; i < n; ++i) {
+            v = v << 1 | Bit();
+        }
+        return v;
+    }
+
+    int Decode(const HuffmanTable& table) {
+        int code = Bit();
+        for (int length = 1; length <= 16; ++length) {
+            if (code <= table.maxcode[length]) {
+                return table.values[table.valptr[length] + code - table.mincode[length]];
+            }
+            code = code << 1 | Bit();
+        }
+        failed_ = true;
+        return 0;
+    }
+
+    bool Restart(int index) { return Marker(static_cast<uint8_t>(0xD0 + index)); }
+
+    bool End() { return Marker(0xD9) && pos_ == data_.size(); }
+
+private:
+    bool Marker(uint8_t marker) {
+        const int pad = (1 << count_) - 1;
+        const bool padded = (byte_ & pad) == pad;
+        count_ = 0;
+        if (failed_ || !padded || pos_ + 1 >= data_.size() || data_[pos_] != 0xFF || data_[pos_ + 1] != marker) {
+            return false;
+        }
+        pos_ += 2;
+        return true;
+    }
+
+    const std::vector<uint8_t>& data_;
+    size_t pos_;
+    int byte_ = 0;
+    int count_ = 0;
+    bool failed_ = false;
+};
+
+int Extend(int v, int bits) {
+    return bits == 0 ? 0 : v < 1 << (bits - 1) ? v - (1 << bits) + 1 : v;
+}
+
+// Dequantised zigzag coefficients to 8x8 samples
+void InverseDct(const float* coefs, uint8_t* out, int stride) {
+    static const auto kBasis = [] {
+        std::vector<float> basis(64);
+        for (int x = 0; x < 8; ++x) {
+            for (int u = 0; u < 8; ++u) {
+                const double scale = u == 0 ? std::sqrt(0.125) : 0.5;
+                basis[x * 8 + u] = static_cast<float>(scale * std::cos((2 * x + 1) * u * 3.14159265358979 / 16));
+            }
+        }
+        return basis;
+    }();
+    float rows[64];
+    for (int v = 0; v < 8; ++v) {
+        for (int x = 0; x < 8; ++x) {
+            float sum = 0;
+            for (int u = 0; u < 8; ++u) {
+                sum += kBasis[x * 8 + u] * coefs[v * 8 + u];
+            }
+            rows[v * 8 + x] = sum;
+        }
+    }
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            float sum = 128;
+            for (int v = 0; v < 8; ++v) {
+                sum += kBasis[y * 8 + v] * rows[v * 8 + x];
+            }
+            out[y * stride + x] = static_cast<uint8_t>(std::lround(std::fmin(std::fmax(sum, 0.0f), 255.0f)));
+        }
+    }
+}
+
+// Baseline decoder for the streams EncodeJpegBgra writes: three components,
+// Y sampled 1x1 or 2x2 and chroma 1x1, 8-bit tables, optional restart
+// intervals. Fails on anything a conforming decoder would reject.
+bool DecodeJpeg(const std::vector<uint8_t>& jpeg, int& width, int& height, std::vector<uint8_t>& bgra) {
+    if (jpeg.size() < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return false;
+    }
+    uint8_t quant[4][64] = {};
+    HuffmanTable tables[2][4];  // [class: DC, AC][id]
+    int sampling[3] = {};
+    int quant_id[3] = {};
+    int dc_id[3] = {};
+    int ac_id[3] = {};
+    int restart_interval = 0;
+    width = height = 0;
+
+    size_t pos = 2;
+    for (;;) {
+        if (pos + 4 > jpeg.size() || jpeg[pos] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = jpeg[pos + 1];
+        const size_t length = static_cast<size_t>(ReadBE16(&jpeg[pos + 2]));
+        if (length < 2 || pos + 2 + length > jpeg.size()) {
+            return false;
+        }
+        const uint8_t* seg = &jpeg[pos + 4];
+        const size_t seg_len = length - 2;
+        pos += 2 + length;
+
+        if (marker == 0xDB) {
+            for (size_t i = 0; i + 65 <= seg_len; i += 65) {
+                if (seg[i] >> 4 != 0) {
+                    return false;  // 16-bit tables are not baseline
+                }
+                std::copy(seg + i + 1, seg + i + 65, quant[seg[i] & 3]);
+            }
+        } else if (marker == 0xC0) {
+            if (seg_len != 15 || seg[0] != 8 || seg[5] != 3) {
+                return false;
+            }
+            height = ReadBE16(seg + 1);
+            width = ReadBE16(seg + 3);
+            for (int c = 0; c < 3; ++c) {
+                sampling[c] = seg[7 + c * 3];
+                quant_id[c] = seg[8 + c * 3] & 3;
+            }
+            if ((sampling[0] != 0x11 && sampling[0] != 0x22) || sampling[1] != 0x11 || sampling[2] != 0x11) {
+                return false;
+            }
+        } else if (marker == 0xC4) {
+            for (size_t i = 0; i + 17 <= seg_len;) {
+                HuffmanTable& table = tables[seg[i] >> 4 & 1][seg[i] & 3];
+                const uint8_t* counts = seg + i + 1;
+                size_t total = 0;
+                int code = 0;
+                for (int length = 1; length <= 16; ++length) {
+                    table.valptr[length] = static_cast<int>(total);
+                    table.mincode[length] = code;
+                    code += counts[length - 1];
+                    total += counts[length - 1];
+                    table.maxcode[length] = counts[length - 1] ? code - 1 : -1;
+                    code <<= 1;
+                }
+                if (i + 17 + total > seg_len) {
+                    return false;
+                }
+                table.values.assign(seg + i + 17, seg + i + 17 + total);
+                i += 17 + total;
+            }
+        } else if (marker == 0xDD) {
+            restart_interval = seg_len == 2 ? ReadBE16(seg) : 0;
+        } else if (marker == 0xDA) {
+            if (seg_len != 10 || seg[0] != 3) {
+                return false;
+            }
+            for (int c = 0; c < 3; ++c) {
+                dc_id[c] = seg[2 + c * 2] >> 4 & 3;
+                ac_id[c] = seg[2 + c * 2] & 3;
+            }
+            break;
+        }
+    }
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+
+    const int h = sampling[0] >> 4;
+    const int mcu_size = 8 * h;
+    const int mcus_x = (width + mcu_size - 1) / mcu_size;
+    const int mcu_rows = (height + mcu_size - 1) / mcu_size;
+    const int plane_w[3] = {mcus_x * mcu_size, mcus_x * 8, mcus_x * 8};
+    const int plane_h[3] = {mcu_rows * mcu_size, mcu_rows * 8, mcu_rows * 8};
+    std::vector<uint8_t> planes[3];
+    for (int c = 0; c < 3; ++c) {
+        planes[c].resize(static_cast<size_t>(plane_w[c]) * plane_h[c]);
+    }
+
+    ScanReader reader(jpeg, pos);
+    int dc_pred[3] = {};
+    int next_restart = 0;
+    const int mcus = mcus_x * mcu_rows;
+    for (int mcu = 0; mcu < mcus; ++mcu) {
+        if (restart_interval > 0 && mcu > 0 && mcu % restart_interval == 0) {
+            if (!reader.Restart(next_restart)) {
+                return false;
+            }
+            next_restart = (next_restart + 1) & 7;
+            dc_pred[0] = dc_pred[1] = dc_pred[2] = 0;
+        }
+        const int mx = mcu % mcus_x;
+        const int my = mcu / mcus_x;
+        for (int c = 0; c < 3; ++c) {
+            const int blocks = c == 0 ? h : 1;
+            for (int by = 0; by < blocks; ++by) {
+                for (int bx = 0; bx < blocks; ++bx) {
+                    const uint8_t* q = quant[quant_id[c]];
+                    float coefs[64] = {};
+                    const int dc_bits = reader.Decode(tables[0][dc_id[c]]);
+                    if (dc_bits > 11) {
+                        return false;
+                    }
+                    dc_pred[c] += Extend(reader.Bits(dc_bits), dc_bits);
+                    coefs[0] = static_cast<float>(dc_pred[c] * q[0]);
+                    for (int k = 1; k < 64; ++k) {
+                        const int rs = reader.Decode(tables[1][ac_id[c]]);
+                        const int run = rs >> 4;
+                        const int bits = rs & 15;
+                        if (bits == 0) {
+                            if (run != 15) {
+                                break;  // end of block
+                            }
+                            k += 15;
+                            continue;
+                        }
+                        k += run;
+                        if (k > 63) {
+                            return false;
+                        }
+                        coefs[kZigzag[k]] = static_cast<float>(Extend(reader.Bits(bits), bits) * q[k]);
+                    }
+                    if (reader.failed()) {
+                        return false;
+                    }
+                    const int x = (mx * blocks + bx) * 8;
+                    const int y = (my * blocks + by) * 8;
+                    InverseDct(coefs, &planes[c][static_cast<size_t>(y) * plane_w[c] + x], plane_w[c]);
+                }
+            }
+        }
+    }
+    if (!reader.End()) {
+        return false;
+    }
+
+    bgra.resize(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const float luma = planes[0][static_cast<size_t>(y) * plane_w[0] + x];
+            const size_t chroma = static_cast<size_t>(y / h) * plane_w[1] + x / h;
+            const float cb = planes[1][chroma] - 128.0f;
+            const float cr = planes[2][chroma] - 128.0f;
+            const float rgb[3] = {luma + 1.402f * cr, luma - 0.344136f * cb - 0.714136f * cr, luma + 1.772f * cb};
+            uint8_t* p = &bgra[(static_cast<size_t>(y) * width + x) * 4];
+            for (int i = 0; i < 3; ++i) {
+                p[2 - i] = static_cast<uint8_t>(std::lround(std::fmin(std::fmax(rgb[i], 0.0f), 255.0f)));
+            }
+            p[3] = 255;
+        }
+    }
+    return true;
+}
+
+// PSNR in dB (B, G and R) of the decoded stream against `bgra`, or 0 if it
+// fails the structural check or does not decode
+double DecodedPsnr(const std::vector<uint8_t>& jpeg, const std::vector<uint8_t>& bgra) {
+    ImageFormat format;
+    int width = 0;
+    int height = 0;
+    if (ValidateImage(jpeg.data(), jpeg.size(), true, format, width, height) != kImageOk || format != kImageJpeg ||
+        width != kWidth || height != kHeight) {
+        return 0;
+    }
+    std::vector<uint8_t> decoded;
+    if (!DecodeJpeg(jpeg, width, height, decoded) || width != kWidth || height != kHeight) {
+        return 0;
+    }
+    double error = 0;
+    for (size_t i = 0; i < bgra.size(); ++i) {
+        if (i % 4 != 3) {
+            const double d = static_cast<double>(decoded[i]) - bgra[i];
+            error += d * d;
+        }
+    }
+    const double mse = error / (static_cast<double>(kWidth) * kHeight * 3);
+    return mse == 0 ? 99 : 10 * std::log10(255.0 * 255.0 / mse);
+}
+
+void TestNoTarget(const std::vector<uint8_t>& bgra) {
+    JpegEncodeOptions options;
+    options.quality = 90;
+    std::vector<uint8_t> jpeg;
+    JpegEncodeStats stats;
+    CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, jpeg, &stats));
+    CHECK(DecodedPsnr(jpeg, bgra) >= 22);
+    CHECK(stats.quality == 90);
+    CHECK(stats.target_met);
+    CHECK(stats.trials == 0);
+
+    // Full-resolution chroma keeps the noise the 4:2:0 file averages away
+    options.subsample_chroma = false;
+    CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, jpeg));
+    CHECK(DecodedPsnr(jpeg, bgra) >= 32);
+}
+
+void TestReachableTarget(const std::vector<uint8_t>& bgra, bool optimize) {
+    JpegEncodeOptions options;
+    options.quality = 95;
+    options.optimize_huffman = optimize;
+    std::vector<uint8_t> full;
+    CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, full));
+
+    options.target_bytes = full.size() / 3;
+    std::vector<uint8_t> jpeg;
+    JpegEncodeStats stats;
+    CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, jpeg, &stats));
+    CHECK(DecodedPsnr(jpeg, bgra) >= 20);
+    CHECK(stats.target_met);
+    CHECK(jpeg.size() <= options.target_bytes);
+    CHECK(stats.quality > 1 && stats.quality < 95);
+    CHECK(stats.trials > 0);
+}
+
+// 1000 bytes cannot hold a 640x480 photo at any quality: the smallest file
+// comes back, flagged
+void TestMissedTarget(const std::vector<uint8_t>& bgra) {
+    JpegEncodeOptions options;
+    options.target_bytes = 1000;
+    std::vector<uint8_t> jpeg;
+    JpegEncodeStats stats;
+    CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, jpeg, &stats));
+    CHECK(DecodedPsnr(jpeg, bgra) >= 15);
+    CHECK(!stats.target_met);
+    CHECK(stats.quality == 1);
+    CHECK(jpeg.size() > options.target_bytes);
+}
+
+// The segment layout depends only on the image: one worker and four write the
+// same bytes, with standard or optimised tables and with size targeting
+void TestWorkerCountIndependent(const std::vector<uint8_t>& bgra) {
+    TaskScheduler one;
+    TaskScheduler four;
+    CHECK(one.Configure(1));
+    CHECK(four.Configure(4));
+    for (int mode = 0; mode < 3; ++mode) {
+        JpegEncodeOptions options;
+        options.optimize_huffman = mode > 0;
+        options.target_bytes = mode == 2 ? 60000 : 0;
+        std::vector<uint8_t> serial;
+        std::vector<uint8_t> parallel;
+        options.pool = &one;
+        CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, serial));
+        options.pool = &four;
+        CHECK(EncodeJpegBgra(bgra.data(), kWidth, kHeight, kWidth * 4, options, parallel));
+        CHECK(!serial.empty() && serial == parallel);
+        CHECK(DecodedPsnr(parallel, bgra) >= 15);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TaskScheduler::Instance().Configure(2);
+    const std::vector<uint8_t> bgra = Photo();
+    TestNoTarget(bgra);
+    TestReachableTarget(bgra, false);
+    TestReachableTarget(bgra, true);
+    TestMissedTarget(bgra);
+    TestWorkerCountIndependent(bgra);
+    return TestResult("jpeg_encoder_test");
+}
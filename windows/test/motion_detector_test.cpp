@@ -0,0 +1,71 @@
+// Idle mode: both ways out of idle (motion and camera_wake) must flag the next
+// published frame as the wake frame, exactly once.
+#include <chrono>
+
+#include "motion_detector.h"
+#include "test_util.h"
+
+namespace {
+
+using Clock = IdleMonitor::Clock;
+
+// Enabled monitor already idle: one still frame past the idle timeout.
+void GoIdle(IdleMonitor& monitor, Clock::time_point& t) {
+    monitor.Configure(true, 100, 1000);
+    monitor.Reset();
+    t = Clock::now();
+    CHECK(monitor.OnFrame(false, t));
+    t += std::chrono::milliseconds(200);
+    CHECK(!monitor.OnFrame(false, t));
+    CHECK(monitor.idle());
+}
+
+void TestMotionWake() {
+    IdleMonitor monitor;
+    Clock::time_point t;
+    GoIdle(monitor, t);
+
+    CHECK(!monitor.OnFrame(false, t += std::chrono::milliseconds(33)));
+    CHECK(monitor.OnFrame(true, t += std::chrono::milliseconds(33)));
+    CHECK(!monitor.idle());
+    CHECK(monitor.OnWakePublished(t));
+    CHECK(!monitor.OnWakePublished(t));
+    CHECK(monitor.stats().wake_count == 1);
+}
+
+void TestTouchWake() {
+    IdleMonitor monitor;
+    Clock::time_point t;
+    GoIdle(monitor, t);
+
+    monitor.Wake();
+    CHECK(!monitor.idle());
+    const Clock::time_point captured = Clock::now();
+    CHECK(monitor.OnFrame(false, captured));
+    CHECK(monitor.OnWakePublished(captured));
+    CHECK(!monitor.OnWakePublished(captured));
+    CHECK(monitor.stats().wake_count == 1);
+
+    // Waking while already live is not a wake
+    monitor.Wake();
+    CHECK(!monitor.OnWakePublished(captured));
+    CHECK(monitor.stats().wake_count == 1);
+}
+
+void TestResetClearsWake() {
+    IdleMonitor monitor;
+    Clock::time_point t;
+    GoIdle(monitor, t);
+    monitor.Wake();
+    monitor.Reset();
+    CHECK(!monitor.OnWakePublished(Clock::now()));
+}
+
+}  // namespace
+
+int main() {
+    TestMotionWake();
+    TestTouchWake();
+    TestResetClearsWake();
+    return TestResult("motion_detector_test");
+}
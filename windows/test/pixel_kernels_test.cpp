@@ -0,0 +1,446 @@
+// Every SIMD kernel table this CPU supports against the scalar reference:
+// exhaustive over the 8-bit inputs where that is feasible, random otherwise,
+// plus all tail lengths and misalignments. With --benchmark, also prints the
+// throughput of every kernel on every table, e.g. on the kiosk hardware:
+//
+//   pixel_kernels_test [--benchmark]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "pixel_kernels.h"
+#include "pixel_kernels_impl.h"
+#include "test_util.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Rng {
+    uint32_t state = 0x12345678u;
+    uint32_t Next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    void Fill(uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(Next() >> 24);
+    }
+};
+
+template <typename T>
+uint64_t Diff(const std::vector<T>& a, const std::vector<T>& b) {
+    uint64_t n = 0;
+    for (size_t i = 0; i < a.size(); ++i) n += a[i] != b[i];
+    return n;
+}
+
+// Row lengths that exercise every vector tail, at every byte misalignment.
+template <typename Fn>
+uint64_t ForTails(int max_len, Fn fn) {
+    uint64_t n = 0;
+    for (int len = 0; len <= max_len; ++len) {
+        for (int offset = 0; offset < 4; ++offset) {
+            n += fn(len, offset);
+        }
+    }
+    return n;
+}
+
+// A 32-bit-per-pixel row kernel (swizzle, premultiply, mirror32, gray, BGR).
+using Row32 = void (*)(const uint8_t*, uint8_t*, int);
+
+uint64_t CheckRow32(Row32 ref, Row32 test, int out_bpp, const std::vector<uint8_t>& exhaustive) {
+    const int count = static_cast<int>(exhaustive.size() / 4);
+    std::vector<uint8_t> a(static_cast<size_t>(count) * out_bpp), b(a.size());
+    ref(exhaustive.data(), a.data(), count);
+    test(exhaustive.data(), b.data(), count);
+    uint64_t n = Diff(a, b);
+
+    Rng rng;
+    n += ForTails(70, [&](int len, int offset) {
+        std::vector<uint8_t> src(static_cast<size_t>(len) * 4 + offset);
+        rng.Fill(src.data(), src.size());
+        std::vector<uint8_t> x(static_cast<size_t>(len) * out_bpp + offset), y(x.size());
+        ref(src.data() + offset, x.data() + offset, len);
+        test(src.data() + offset, y.data() + offset, len);
+        return Diff(x, y);
+    });
+    return n;
+}
+
+uint64_t CheckOver(const PixelKernelTable& ref, const PixelKernelTable& t, const std::vector<uint8_t>& pairs) {
+    // Every (colour, alpha) source over every destination value
+    const int count = static_cast<int>(pairs.size() / 4);
+    std::vector<uint8_t> a(pairs.size()), b(a.size());
+    uint64_t n = 0;
+    for (int d = 0; d < 256; ++d) {
+        std::fill(a.begin(), a.end(), static_cast<uint8_t>(d));
+        std::fill(b.begin(), b.end(), static_cast<uint8_t>(d));
+        ref.over(pairs.data(), a.data(), count);
+        t.over(pairs.data(), b.data(), count);
+        n += Diff(a, b);
+    }
+
+    // Runs of transparent and opaque pixels (the vector shortcuts) between
+    // translucent ones, at every tail
+    Rng rng;
+    n += ForTails(70, [&](int len, int offset) {
+        std::vector<uint8_t> src(static_cast<size_t>(len) * 4 + offset);
+        rng.Fill(src.data(), src.size());
+        for (int i = 0; i < len; ++i) {
+            uint8_t* p = src.data() + offset + i * 4;
+            const int run = (i / 8 + len) % 3;
+            if (run == 0) {
+                p[0] = p[1] = p[2] = p[3] = 0;
+            } else if (run == 1) {
+                p[3] = 255;
+            }
+        }
+        std::vector<uint8_t> x(src.size());
+        rng.Fill(x.data(), x.size());
+        std::vector<uint8_t> y = x;
+        ref.over(src.data() + offset, x.data() + offset, len);
+        t.over(src.data() + offset, y.data() + offset, len);
+        return Diff(x, y);
+    });
+    return n;
+}
+
+// A random n^3 table in the kernels' entry format
+std::vector<int16_t> RandomLut(int n, Rng& rng) {
+    std::vector<int16_t> lut(static_cast<size_t>(n) * n * n * 4, 0);
+    for (size_t i = 0; i < lut.size(); i += 4) {
+        for (int c = 0; c < 3; ++c) {
+            lut[i + c] = static_cast<int16_t>(rng.Next() % (255 * lut3d::kEntryScale + 1));
+        }
+    }
+    return lut;
+}
+
+uint64_t CheckLut3d(const PixelKernelTable& ref, const PixelKernelTable& t, const std::vector<uint8_t>& random) {
+    Rng rng;
+    // Channels from a few values, so fractions tie and land on cell edges often
+    std::vector<uint8_t> ties(random.size() / 4);
+    const uint8_t picks[8] = {0, 1, 8, 127, 128, 191, 254, 255};
+    for (size_t i = 0; i < ties.size(); ++i) {
+        ties[i] = (i & 3) == 3 ? static_cast<uint8_t>(rng.Next()) : picks[rng.Next() % 8];
+    }
+
+    uint64_t n = 0;
+    for (const int size : {lut3d::kMinSize, 17, 33, lut3d::kMaxSize}) {
+        const std::vector<int16_t> lut = RandomLut(size, rng);
+        const Lut3dGrid grid = {lut.data(), size, lut3d::PositionScale(size)};
+        const std::vector<uint8_t>* inputs[] = {&random, &ties};
+        for (const std::vector<uint8_t>* input : inputs) {
+            const int count = static_cast<int>(input->size() / 4);
+            std::vector<uint8_t> a(input->size()), b(a.size());
+            ref.lut3d(input->data(), a.data(), count, grid);
+            t.lut3d(input->data(), b.data(), count, grid);
+            n += Diff(a, b);
+        }
+        // In place, at every tail
+        n += ForTails(70, [&](int len, int offset) {
+            std::vector<uint8_t> x(static_cast<size_t>(len) * 4 + offset);
+            rng.Fill(x.data(), x.size());
+            std::vector<uint8_t> y = x;
+            ref.lut3d(x.data() + offset, x.data() + offset, len, grid);
+            t.lut3d(y.data() + offset, y.data() + offset, len, grid);
+            return Diff(x, y);
+        });
+    }
+    return n;
+}
+
+uint64_t CheckMirror8(const PixelKernelTable& ref, const PixelKernelTable& t) {
+    Rng rng;
+    return ForTails(140, [&](int len, int offset) {
+        std::vector<uint8_t> src(len + offset);
+        rng.Fill(src.data(), src.size());
+        std::vector<uint8_t> x(len + offset), y(x.size());
+        ref.mirror8(src.data() + offset, x.data() + offset, len);
+        t.mirror8(src.data() + offset, y.data() + offset, len);
+        return Diff(x, y);
+    });
+}
+
+uint64_t CheckYCbCr(const PixelKernelTable& ref, const PixelKernelTable& t, bool bgra) {
+    auto ref_row = bgra ? ref.ycbcr_to_bgra : ref.ycbcr_to_rgba;
+    auto test_row = bgra ? t.ycbcr_to_bgra : t.ycbcr_to_rgba;
+
+    // Full resolution chroma: every (Y, Cb, Cr) triple, one Y value per row
+    const int count = 65536;
+    std::vector<uint8_t> y(count), cb(count), cr(count);
+    for (int i = 0; i < count; ++i) {
+        cb[i] = static_cast<uint8_t>(i & 0xFF);
+        cr[i] = static_cast<uint8_t>(i >> 8);
+    }
+    std::vector<uint8_t> a(static_cast<size_t>(count) * 4), b(a.size());
+    uint64_t n = 0;
+    for (int luma = 0; luma < 256; ++luma) {
+        std::fill(y.begin(), y.end(), static_cast<uint8_t>(luma));
+        ref_row(y.data(), cb.data(), cr.data(), a.data(), count, 0);
+        test_row(y.data(), cb.data(), cr.data(), b.data(), count, 0);
+        n += Diff(a, b);
+    }
+
+    // Subsampled chroma, random, all tails
+    Rng rng;
+    for (int shift = 0; shift <= 1; ++shift) {
+        n += ForTails(70, [&](int len, int offset) {
+            const int clen = (len + shift) >> shift;
+            std::vector<uint8_t> ys(len + offset), us(clen + offset), vs(clen + offset);
+            rng.Fill(ys.data(), ys.size());
+            rng.Fill(us.data(), us.size());
+            rng.Fill(vs.data(), vs.size());
+            std::vector<uint8_t> x(static_cast<size_t>(len) * 4), z(x.size());
+            ref_row(ys.data() + offset, us.data() + offset, vs.data() + offset, x.data(), len, shift);
+            test_row(ys.data() + offset, us.data() + offset, vs.data() + offset, z.data(), len, shift);
+            return Diff(x, z);
+        });
+    }
+    return n;
+}
+
+uint64_t CheckBlendRows(const PixelKernelTable& ref, const PixelKernelTable& t) {
+    // Every (r0, r1) pair at every weight
+    const int count = 65536;
+    std::vector<uint8_t> r0(count), r1(count);
+    for (int i = 0; i < count; ++i) {
+        r0[i] = static_cast<uint8_t>(i & 0xFF);
+        r1[i] = static_cast<uint8_t>(i >> 8);
+    }
+    std::vector<uint16_t> a(count), b(count);
+    uint64_t n = 0;
+    for (int wy = 0; wy < 256; ++wy) {
+        ref.blend_rows(r0.data(), r1.data(), wy, a.data(), count);
+        t.blend_rows(r0.data(), r1.data(), wy, b.data(), count);
+        n += Diff(a, b);
+    }
+    Rng rng;
+    n += ForTails(70, [&](int len, int offset) {
+        std::vector<uint8_t> s0(len + offset), s1(len + offset);
+        rng.Fill(s0.data(), s0.size());
+        rng.Fill(s1.data(), s1.size());
+        const int wy = static_cast<int>(rng.Next() & 0xFF);
+        std::vector<uint16_t> x(len), y(len);
+        ref.blend_rows(s0.data() + offset, s1.data() + offset, wy, x.data(), len);
+        t.blend_rows(s0.data() + offset, s1.data() + offset, wy, y.data(), len);
+        return Diff(x, y);
+    });
+    return n;
+}
+
+// Whole resizes over reductions, enlargements and odd sizes
+using Resizer = void (*)(const PixelKernelTable&, const uint8_t*, int, int, int, uint8_t*, int, int, int);
+
+uint64_t CheckResize(const PixelKernelTable& ref, const PixelKernelTable& t, Resizer resize) {
+    static const int kSizes[][4] = {
+        {640, 480, 213, 160}, {97, 61, 13, 9}, {64, 48, 191, 143}, {1, 1, 7, 5},
+        {7, 5, 1, 1}, {33, 17, 33, 17}, {1024, 683, 307, 205}, {300, 200, 301, 199},
+    };
+    Rng rng;
+    uint64_t n = 0;
+    for (const auto& s : kSizes) {
+        const int src_stride = s[0] * 4 + 12;
+        std::vector<uint8_t> src(static_cast<size_t>(src_stride) * s[1]);
+        rng.Fill(src.data(), src.size());
+        std::vector<uint8_t> a(static_cast<size_t>(s[2]) * 4 * s[3]), b(a.size());
+        resize(ref, src.data(), s[0], s[1], src_stride, a.data(), s[2], s[3], s[2] * 4);
+        resize(t, src.data(), s[0], s[1], src_stride, b.data(), s[2], s[3], s[2] * 4);
+        n += Diff(a, b);
+    }
+    return n;
+}
+
+// Band by band from a copy of only the source rows each band reads (as a
+// band-wise decode supplies them) must match the whole resize
+uint64_t CheckLanczosWindows() {
+    static const int kSizes[][5] = {
+        {640, 480, 213, 160, 16}, {97, 61, 13, 9, 4}, {64, 48, 191, 143, 7}, {300, 200, 301, 199, 64},
+        {1024, 683, 307, 205, 1}, {40, 600, 40, 60, 9},
+    };
+    Rng rng;
+    uint64_t n = 0;
+    for (const auto& s : kSizes) {
+        const int src_stride = s[0] * 4;
+        std::vector<uint8_t> src(static_cast<size_t>(src_stride) * s[1]);
+        rng.Fill(src.data(), src.size());
+        std::vector<uint8_t> whole(static_cast<size_t>(s[2]) * 4 * s[3]), banded(whole.size());
+        ResizeLanczosBgra(src.data(), s[0], s[1], src_stride, whole.data(), s[2], s[3], s[2] * 4);
+        for (int y = 0; y < s[3]; y += s[4]) {
+            const int end = std::min(s[3], y + s[4]);
+            int first = 0, last = 0;
+            LanczosSourceRows(s[1], s[3], y, end, first, last);
+            if (first < 0 || last > s[1] || first >= last) {
+                return 1;
+            }
+            const std::vector<uint8_t> window(src.begin() + static_cast<size_t>(first) * src_stride,
+                                              src.begin() + static_cast<size_t>(last) * src_stride);
+            ResizeLanczosBgraWindow(window.data(), first, s[0], s[1], src_stride,
+                                    banded.data() + static_cast<size_t>(y) * s[2] * 4, s[2], s[3], s[2] * 4, y, end);
+        }
+        n += Diff(whole, banded);
+    }
+    return n;
+}
+
+// Megapixels per second over repeated full frames
+template <typename Fn>
+double Throughput(double megapixels, Fn frame) {
+    frame();  // warm caches and page in buffers
+    int frames = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    do {
+        frame();
+        ++frames;
+        elapsed = Clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(200) || frames < 3);
+    return megapixels * frames / std::chrono::duration<double>(elapsed).count();
+}
+
+struct BenchFrames {
+    static constexpr int kW = 1920;
+    static constexpr int kH = 1080;
+    std::vector<uint8_t> bgra = std::vector<uint8_t>(static_cast<size_t>(kW) * kH * 4);
+    std::vector<uint8_t> out = std::vector<uint8_t>(static_cast<size_t>(kW) * kH * 4);
+    std::vector<uint8_t> y = std::vector<uint8_t>(static_cast<size_t>(kW) * kH);
+    std::vector<uint8_t> cb = std::vector<uint8_t>(static_cast<size_t>(kW / 2) * (kH / 2));
+    std::vector<uint8_t> cr = std::vector<uint8_t>(static_cast<size_t>(kW / 2) * (kH / 2));
+    // A 12 MP still for the print-size resampler
+    std::vector<uint8_t> still = std::vector<uint8_t>(static_cast<size_t>(4000) * 3000 * 4);
+    std::vector<uint8_t> print = std::vector<uint8_t>(static_cast<size_t>(1800) * 1200 * 4);
+    // A 33-point grading table, the common .cube size
+    std::vector<int16_t> lut;
+
+    BenchFrames() {
+        Rng rng;
+        lut = RandomLut(33, rng);
+        rng.Fill(bgra.data(), bgra.size());
+        rng.Fill(y.data(), y.size());
+        rng.Fill(cb.data(), cb.size());
+        rng.Fill(cr.data(), cr.size());
+        rng.Fill(still.data(), still.size());
+    }
+
+    template <typename Row>
+    void Rows(Row row) {
+        for (int r = 0; r < kH; ++r) row(r);
+    }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const bool benchmark = argc > 1 && std::strcmp(argv[1], "--benchmark") == 0;
+    const PixelKernelTable* tables[3];
+    const int count = SupportedPixelKernels(tables, 3);
+    const PixelKernelTable& ref = *tables[0];
+
+    // Exhaustive 32-bit inputs: all (colour, alpha) pairs, colour varied per channel
+    std::vector<uint8_t> pairs(65536 * 4);
+    for (int i = 0; i < 65536; ++i) {
+        pairs[i * 4 + 0] = static_cast<uint8_t>(i & 0xFF);
+        pairs[i * 4 + 1] = static_cast<uint8_t>((i & 0xFF) ^ 0x5A);
+        pairs[i * 4 + 2] = static_cast<uint8_t>(255 - (i & 0xFF));
+        pairs[i * 4 + 3] = static_cast<uint8_t>(i >> 8);
+    }
+    // Luma has 2^24 inputs; take a large random sample instead
+    std::vector<uint8_t> random(1 << 22);
+    Rng rng;
+    rng.Fill(random.data(), random.size());
+
+    std::unique_ptr<BenchFrames> bench;
+    if (benchmark) {
+        bench = std::make_unique<BenchFrames>();
+    }
+    const double frame_mp = BenchFrames::kW * BenchFrames::kH / 1e6;
+
+    if (bench) {
+        std::printf("kernel           isa      Mpix/s\n");
+    }
+    for (int i = 0; i < count; ++i) {
+        const PixelKernelTable& t = *tables[i];
+        const bool is_ref = &t == &ref;
+        auto report = [&](const char* name, uint64_t mismatches, double mp, auto frame) {
+            if (mismatches != 0) {
+                std::fprintf(stderr, "[FAIL] %s (%s): %llu bytes differ from scalar\n", name, PixelIsaName(t.isa),
+                             static_cast<unsigned long long>(mismatches));
+                ++TestFailures();
+            }
+            if (bench) {
+                std::printf("%-16s %-6s %8.1f\n", name, PixelIsaName(t.isa), Throughput(mp, frame));
+            }
+        };
+        BenchFrames* b = bench.get();
+        const int w = BenchFrames::kW;
+
+        report("swizzle_rb", is_ref ? 0 : CheckRow32(ref.swizzle_rb, t.swizzle_rb, 4, random), frame_mp, [&] {
+            b->Rows([&](int r) { t.swizzle_rb(&b->bgra[r * w * 4], &b->out[r * w * 4], w); });
+        });
+        report("premultiply", is_ref ? 0 : CheckRow32(ref.premultiply, t.premultiply, 4, pairs), frame_mp, [&] {
+            b->Rows([&](int r) { t.premultiply(&b->bgra[r * w * 4], &b->out[r * w * 4], w); });
+        });
+        report("mirror32", is_ref ? 0 : CheckRow32(ref.mirror32, t.mirror32, 4, random), frame_mp, [&] {
+            b->Rows([&](int r) { t.mirror32(&b->bgra[r * w * 4], &b->out[r * w * 4], w); });
+        });
+        report("mirror8", is_ref ? 0 : CheckMirror8(ref, t), frame_mp, [&] {
+            b->Rows([&](int r) { t.mirror8(&b->y[r * w], &b->out[r * w], w); });
+        });
+        report("bgra_to_gray", is_ref ? 0 : CheckRow32(ref.bgra_to_gray, t.bgra_to_gray, 1, random), frame_mp, [&] {
+            b->Rows([&](int r) { t.bgra_to_gray(&b->bgra[r * w * 4], &b->out[r * w], w); });
+        });
+        report("bgra_to_bgr", is_ref ? 0 : CheckRow32(ref.bgra_to_bgr, t.bgra_to_bgr, 3, random), frame_mp, [&] {
+            b->Rows([&](int r) { t.bgra_to_bgr(&b->bgra[r * w * 4], &b->out[r * w * 3], w); });
+        });
+        report("over", is_ref ? 0 : CheckOver(ref, t, pairs), frame_mp, [&] {
+            b->Rows([&](int r) { t.over(&b->bgra[r * w * 4], &b->out[r * w * 4], w); });
+        });
+        report("lut3d", is_ref ? 0 : CheckLut3d(ref, t, random), frame_mp, [&] {
+            const Lut3dGrid grid = {b->lut.data(), 33, lut3d::PositionScale(33)};
+            b->Rows([&](int r) { t.lut3d(&b->bgra[r * w * 4], &b->out[r * w * 4], w, grid); });
+        });
+        report("ycbcr_to_bgra", is_ref ? 0 : CheckYCbCr(ref, t, true), frame_mp, [&] {
+            b->Rows([&](int r) {
+                const size_t c = static_cast<size_t>(r / 2) * (w / 2);
+                t.ycbcr_to_bgra(&b->y[r * w], &b->cb[c], &b->cr[c], &b->out[r * w * 4], w, 1);
+            });
+        });
+        report("ycbcr_to_rgba", is_ref ? 0 : CheckYCbCr(ref, t, false), frame_mp, [&] {
+            b->Rows([&](int r) {
+                const size_t c = static_cast<size_t>(r / 2) * (w / 2);
+                t.ycbcr_to_rgba(&b->y[r * w], &b->cb[c], &b->cr[c], &b->out[r * w * 4], w, 1);
+            });
+        });
+        report("blend_rows", is_ref ? 0 : CheckBlendRows(ref, t), frame_mp, [&] {
+            b->Rows([&](int r) {
+                t.blend_rows(&b->bgra[r * w * 4], &b->bgra[((r + 1) % BenchFrames::kH) * w * 4], r & 0xFF,
+                             reinterpret_cast<uint16_t*>(b->out.data()), w * 4);
+            });
+        });
+        // Resizers: source megapixels per second
+        report("resize_bilinear", is_ref ? 0 : CheckResize(ref, t, ResizeBilinearBgraWith), frame_mp, [&] {
+            ResizeBilinearBgraWith(t, b->bgra.data(), w, BenchFrames::kH, w * 4,
+                                   b->out.data(), 960, 540, 960 * 4);
+        });
+        report("resize_lanczos", is_ref ? 0 : CheckResize(ref, t, ResizeLanczosBgraWith), 12.0, [&] {
+            ResizeLanczosBgraWith(t, b->still.data(), 4000, 3000, 4000 * 4,
+                                  b->print.data(), 1800, 1200, 1800 * 4);
+        });
+    }
+
+    const uint64_t window_mismatches = CheckLanczosWindows();
+    if (window_mismatches != 0) {
+        std::fprintf(stderr, "[FAIL] resize_lanczos windows: %llu bytes differ from the whole resize\n",
+                     static_cast<unsigned long long>(window_mismatches));
+        ++TestFailures();
+    }
+
+    std::printf("checked %d kernel table(s), active: %s\n", count, PixelIsaName(ActivePixelIsa()));
+    return TestResult("pixel_kernels_test");
+}
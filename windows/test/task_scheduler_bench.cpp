@@ -0,0 +1,85 @@
+// Worker-count scaling of the shared pool on the print path's heaviest job:
+// Lanczos-resizing a batch of camera stills, one task per image and row bands
+// within each. Prints the time and speedup for 1, 2, 4, ... workers.
+//
+//   task_scheduler_bench [images] [max_workers]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "pixel_kernels.h"
+#include "task_scheduler.h"
+
+namespace {
+
+constexpr int kSrcW = 3000;  // a 6 MP still, downscaled for a 4x6" print at 300 dpi
+constexpr int kSrcH = 2000;
+constexpr int kDstW = 1800;
+constexpr int kDstH = 1200;
+constexpr int kBandRows = 64;
+constexpr int kRepeats = 3;
+
+double RunBatch(TaskScheduler& pool, const std::vector<std::vector<uint8_t>>& sources,
+                std::vector<std::vector<uint8_t>>& outputs) {
+    const auto started = std::chrono::steady_clock::now();
+    pool.ParallelFor(static_cast<int>(sources.size()), TaskScheduler::kNormal, [&](int i) {
+        const int bands = (kDstH + kBandRows - 1) / kBandRows;
+        pool.ParallelFor(bands, TaskScheduler::kNormal, [&](int band) {
+            const int begin = band * kBandRows;
+            const int end = std::min(kDstH, begin + kBandRows);
+            ResizeLanczosBgraRows(sources[i].data(), kSrcW, kSrcH, kSrcW * 4,
+                                  outputs[i].data() + static_cast<size_t>(begin) * kDstW * 4, kDstW, kDstH,
+                                  kDstW * 4, begin, end);
+        });
+    });
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int images = argc > 1 ? std::max(1, std::atoi(argv[1])) : 8;
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int max_workers = argc > 2 ? std::max(1, std::atoi(argv[2])) : hardware;
+
+    std::vector<std::vector<uint8_t>> sources(images);
+    uint32_t seed = 0x2545f491u;
+    for (auto& src : sources) {
+        src.resize(static_cast<size_t>(kSrcW) * kSrcH * 4);
+        for (size_t i = 0; i < src.size(); ++i) {
+            // Smooth gradients with noise, closer to a photo than pure noise
+            seed = seed * 1664525u + 1013904223u;
+            src[i] = static_cast<uint8_t>((i / 4 % kSrcW) * 255 / kSrcW + (seed >> 28));
+        }
+    }
+    std::vector<std::vector<uint8_t>> outputs(images, std::vector<uint8_t>(static_cast<size_t>(kDstW) * kDstH * 4));
+
+    std::printf("%d x %dx%d -> %dx%d Lanczos, %s kernels, %d hardware threads\n", images, kSrcW, kSrcH, kDstW,
+                kDstH, PixelIsaName(ActivePixelIsa()), hardware);
+    std::printf("workers      ms   speedup  efficiency\n");
+
+    double baseline = 0.0;
+    for (int workers = 1;; workers = std::min(workers * 2, max_workers)) {
+        TaskScheduler pool;
+        pool.Configure(workers);
+        RunBatch(pool, sources, outputs);  // warm-up: starts the workers, faults in the outputs
+        double best = 0.0;
+        for (int r = 0; r < kRepeats; ++r) {
+            const double ms = RunBatch(pool, sources, outputs);
+            best = r == 0 ? ms : std::min(best, ms);
+        }
+        if (workers == 1) {
+            baseline = best;
+        }
+        const double speedup = baseline / best;
+        std::printf("%7d %7.1f %8.2fx %10.0f%%\n", workers, best, speedup, 100.0 * speedup / workers);
+        if (workers == max_workers) {
+            break;
+        }
+    }
+    return 0;
+}
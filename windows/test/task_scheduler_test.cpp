@@ -0,0 +1,210 @@
+// TaskScheduler: results of parallel work must match the serial ones, graph
+// edges must hold, nested waits must not deadlock a small pool, and a free
+// worker must always take the most urgent lane first.
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "pixel_kernels.h"
+#include "task_scheduler.h"
+#include "test_util.h"
+
+namespace {
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;  // BGRA, tightly packed
+};
+
+Image Synthetic(int width, int height, uint32_t seed) {
+    Image img;
+    img.width = width;
+    img.height = height;
+    img.pixels.resize(static_cast<size_t>(width) * height * 4);
+    for (uint8_t& b : img.pixels) {
+        seed = seed * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(seed >> 24);
+    }
+    return img;
+}
+
+// A burst of stills shrunk for a print sheet: one task per image, each image
+// split again into row bands (nested ParallelFor from inside workers).
+void TestBatchResize(TaskScheduler& pool) {
+    constexpr int kImages = 12;
+    constexpr int kDstW = 160;
+    constexpr int kDstH = 120;
+    constexpr int kBandRows = 16;
+
+    std::vector<Image> sources;
+    for (int i = 0; i < kImages; ++i) {
+        sources.push_back(Synthetic(400 + i * 13, 300 + i * 7, 0x1234u + i));
+    }
+
+    std::vector<std::vector<uint8_t>> expected(kImages);
+    for (int i = 0; i < kImages; ++i) {
+        const Image& s = sources[i];
+        expected[i].resize(static_cast<size_t>(kDstW) * kDstH * 4);
+        ResizeLanczosBgra(s.pixels.data(), s.width, s.height, s.width * 4, expected[i].data(), kDstW, kDstH,
+                          kDstW * 4);
+    }
+
+    std::vector<std::vector<uint8_t>> actual(kImages, std::vector<uint8_t>(static_cast<size_t>(kDstW) * kDstH * 4));
+    pool.ParallelFor(kImages, TaskScheduler::kNormal, [&](int i) {
+        const Image& s = sources[i];
+        const int bands = (kDstH + kBandRows - 1) / kBandRows;
+        pool.ParallelFor(bands, TaskScheduler::kNormal, [&](int band) {
+            const int begin = band * kBandRows;
+            const int end = std::min(kDstH, begin + kBandRows);
+            ResizeLanczosBgraRows(s.pixels.data(), s.width, s.height, s.width * 4,
+                                  actual[i].data() + static_cast<size_t>(begin) * kDstW * 4, kDstW, kDstH,
+                                  kDstW * 4, begin, end);
+        });
+    });
+
+    for (int i = 0; i < kImages; ++i) {
+        CHECK(actual[i] == expected[i]);
+    }
+}
+
+// A -> {B, C} -> D, many times over: B and C only after A, D only after both.
+void TestDiamondGraph(TaskScheduler& pool) {
+    for (int round = 0; round < 500; ++round) {
+        std::atomic<int> clock{0};
+        int a = -1, b = -1, c = -1, d = -1;
+        {
+            TaskScheduler::TaskGraph graph(TaskScheduler::kNormal, pool);
+            const int ta = graph.Add([&] { a = clock++; });
+            const int tb = graph.Add([&] { b = clock++; }, {ta});
+            const int tc = graph.Add([&] { c = clock++; }, {ta});
+            graph.Add([&] { d = clock++; }, {tb, tc});
+            graph.Run();
+            graph.Wait();
+        }
+        CHECK(a == 0);
+        CHECK(b > a && c > a);
+        CHECK(d == 3);
+    }
+
+    // Tasks with no edges all run; an empty graph returns at once.
+    std::atomic<int> ran{0};
+    TaskScheduler::TaskGraph flat(TaskScheduler::kNormal, pool);
+    for (int i = 0; i < 64; ++i) {
+        flat.Add([&] { ++ran; });
+    }
+    flat.Run();
+    flat.Wait();
+    CHECK(ran == 64);
+
+    TaskScheduler::TaskGraph empty(TaskScheduler::kNormal, pool);
+    empty.Run();
+    empty.Wait();
+}
+
+// Three levels of ParallelFor on a two-worker pool: every waiting worker has
+// to run queued tasks itself or the pool deadlocks.
+void TestNestedParallelFor() {
+    TaskScheduler pool;
+    CHECK(pool.Configure(2));
+
+    constexpr int kOuter = 8, kMiddle = 8, kInner = 16;
+    std::vector<std::atomic<int>> hits(kOuter * kMiddle * kInner);
+    for (auto& h : hits) {
+        h = 0;
+    }
+    pool.ParallelFor(kOuter, TaskScheduler::kNormal, [&](int i) {
+        pool.ParallelFor(kMiddle, TaskScheduler::kNormal, [&](int j) {
+            pool.ParallelFor(kInner, TaskScheduler::kNormal, [&](int k) {
+                ++hits[(i * kMiddle + j) * kInner + k];
+            });
+        });
+    });
+    for (auto& h : hits) {
+        CHECK(h == 1);
+    }
+
+    CHECK(!pool.Configure(4));  // too late once started
+    CHECK(pool.worker_count() == 2);
+
+    int calls = 0;
+    pool.ParallelFor(0, TaskScheduler::kNormal, [&](int) { ++calls; });
+    CHECK(calls == 0);
+}
+
+// One worker, held busy while work of all three lanes queues up: once free,
+// it must drain kHigh, then kNormal, then kBackground, whatever the order of
+// submission.
+void TestPriorityOrder() {
+    TaskScheduler pool;
+    CHECK(pool.Configure(1));
+
+    std::atomic<bool> gate_started{false};
+    std::atomic<bool> gate_open{false};
+    std::mutex order_mutex;
+    std::vector<int> order;
+
+    {
+        TaskScheduler::TaskGroup gate(TaskScheduler::kHigh, pool);
+        gate.Run([&] {
+            gate_started = true;
+            while (!gate_open) {
+                std::this_thread::yield();
+            }
+        });
+        while (!gate_started) {
+            std::this_thread::yield();
+        }
+
+        TaskScheduler::TaskGroup background(TaskScheduler::kBackground, pool);
+        TaskScheduler::TaskGroup normal(TaskScheduler::kNormal, pool);
+        TaskScheduler::TaskGroup high(TaskScheduler::kHigh, pool);
+        auto record = [&](int lane) {
+            return [&, lane] {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(lane);
+            };
+        };
+        for (int i = 0; i < 5; ++i) {
+            background.Run(record(TaskScheduler::kBackground));
+            normal.Run(record(TaskScheduler::kNormal));
+            high.Run(record(TaskScheduler::kHigh));
+        }
+        gate_open = true;
+        high.Wait();
+        normal.Wait();
+        background.Wait();
+    }
+
+    CHECK(order.size() == 15);
+    for (size_t i = 1; i < order.size(); ++i) {
+        CHECK(order[i - 1] <= order[i]);
+    }
+}
+
+// An exception in a task is logged and swallowed; the group still completes.
+void TestThrowingTask(TaskScheduler& pool) {
+    std::atomic<int> ran{0};
+    TaskScheduler::TaskGroup group(TaskScheduler::kNormal, pool);
+    group.Run([] { throw std::runtime_error("expected by the test"); });
+    group.Run([&] { ++ran; });
+    group.Wait();
+    CHECK(ran == 1);
+}
+
+}  // namespace
+
+int main() {
+    TaskScheduler pool;
+    pool.Configure(4);
+    TestBatchResize(pool);
+    TestDiamondGraph(pool);
+    TestThrowingTask(pool);
+    TestNestedParallelFor();
+    TestPriorityOrder();
+    return TestResult("task_scheduler_test");
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the native tests: a failed CHECK prints where and keeps
+// going, and main() returns TestResult() so ctest sees the failure.
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                               \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            std::fprintf(stderr, "[FAIL] %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            ++TestFailures();                                                     \
+        }                                                                         \
+    } while (0)
+
+inline int TestResult(const char* name) {
+    if (TestFailures() == 0) {
+        std::printf("[OK] %s\n", name);
+        return 0;
+    }
+    std::fprintf(stderr, "[FAIL] %s: %d check(s) failed\n", name, TestFailures());
+    return 1;
+}